@@ -0,0 +1,120 @@
+#!/usr/bin/env node
+// Compares a benchmark result file against a baseline and fails on
+// regressions. Both files use the schema written by
+// bench/native/slice_bench.cpp and scripts/bench-slicer.js.
+//
+// Runs are matched on (case, preset); repeated iterations are reduced to
+// their median before comparing. Thresholds are relative and can be
+// overridden per metric, e.g. --threshold.wallMs=0.05.
+//
+// Usage: node bench/compare.js <baseline.json> <current.json> [--threshold.METRIC=R] [--json]
+
+const fs = require('fs');
+
+const DEFAULT_THRESHOLDS = {
+  wallMs: 0.10,
+  peakRssBytes: 0.10,
+  peakHeapBytes: 0.10,
+  outputBytes: 0.02,
+};
+
+const args = process.argv.slice(2);
+const positional = args.filter((value) => !value.startsWith('--'));
+if (positional.length !== 2) {
+  console.error('usage: node bench/compare.js <baseline.json> <current.json> [--threshold.METRIC=R] [--json]');
+  process.exit(2);
+}
+const thresholds = { ...DEFAULT_THRESHOLDS };
+for (const arg of args) {
+  const match = /^--threshold\.(\w+)=([0-9.]+)$/.exec(arg);
+  if (match) {
+    thresholds[match[1]] = Number.parseFloat(match[2]);
+  }
+}
+const wantJson = args.includes('--json');
+
+function median(values) {
+  const sorted = values.filter((value) => Number.isFinite(value)).sort((a, b) => a - b);
+  if (sorted.length === 0) {
+    return undefined;
+  }
+  const mid = sorted.length >> 1;
+  return sorted.length % 2 ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2;
+}
+
+function reduce(file) {
+  const document = JSON.parse(fs.readFileSync(file, 'utf-8'));
+  if (document.schema !== 1) {
+    throw new Error(`${file}: unsupported schema ${document.schema}`);
+  }
+  const groups = new Map();
+  for (const result of document.results) {
+    const key = `${result.case}/${result.preset}`;
+    if (!groups.has(key)) {
+      groups.set(key, []);
+    }
+    groups.get(key).push(result);
+  }
+  const reduced = new Map();
+  for (const [key, runs] of groups) {
+    const entry = { ok: runs.every((run) => run.ok) };
+    for (const metric of Object.keys(thresholds)) {
+      entry[metric] = median(runs.map((run) => run[metric]));
+    }
+    reduced.set(key, entry);
+  }
+  return { runner: document.runner, results: reduced };
+}
+
+const baseline = reduce(positional[0]);
+const current = reduce(positional[1]);
+
+const rows = [];
+let regressions = 0;
+for (const [key, now] of current.results) {
+  const before = baseline.results.get(key);
+  if (!before) {
+    rows.push({ key, status: 'new' });
+    continue;
+  }
+  if (before.ok && !now.ok) {
+    regressions += 1;
+    rows.push({ key, status: 'FAILED' });
+    continue;
+  }
+  for (const [metric, limit] of Object.entries(thresholds)) {
+    const a = before[metric];
+    const b = now[metric];
+    if (a === undefined || b === undefined || a === 0) {
+      continue;
+    }
+    const delta = (b - a) / a;
+    const regressed = metric === 'outputBytes' ? Math.abs(delta) > limit : delta > limit;
+    if (regressed) {
+      regressions += 1;
+    }
+    rows.push({ key, metric, baseline: a, current: b, delta, status: regressed ? 'REGRESSED' : 'ok' });
+  }
+}
+for (const key of baseline.results.keys()) {
+  if (!current.results.has(key)) {
+    rows.push({ key, status: 'missing' });
+  }
+}
+
+if (wantJson) {
+  console.log(JSON.stringify({ baseline: baseline.runner, current: current.runner, thresholds, regressions, rows }, null, 2));
+} else {
+  console.log(`baseline: ${positional[0]} (${baseline.runner})  current: ${positional[1]} (${current.runner})`);
+  for (const row of rows) {
+    if (!row.metric) {
+      console.log(`  ${row.key.padEnd(36)} ${row.status}`);
+      continue;
+    }
+    const pct = `${row.delta >= 0 ? '+' : ''}${(row.delta * 100).toFixed(1)}%`;
+    console.log(`  ${row.key.padEnd(36)} ${row.metric.padEnd(14)} ${String(Math.round(row.baseline)).padStart(12)} -> `
+      + `${String(Math.round(row.current)).padStart(12)} ${pct.padStart(8)}  ${row.status}`);
+  }
+  console.log(regressions === 0 ? 'no regressions' : `${regressions} regression(s)`);
+}
+process.exitCode = regressions === 0 ? 0 : 1;
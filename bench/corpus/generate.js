@@ -0,0 +1,196 @@
+#!/usr/bin/env node
+// Generates the procedural meshes listed in bench/corpus/corpus.json as
+// binary STL files. Output is deterministic for a given manifest, so results
+// from different machines slice byte-identical inputs.
+//
+// Usage: node bench/corpus/generate.js [--out=build-bench/corpus] [--manifest=...]
+
+const fs = require('fs');
+const path = require('path');
+
+const args = process.argv.slice(2);
+const argValue = (name, fallback) => {
+  const hit = args.find((value) => value.startsWith(`--${name}=`));
+  return hit ? hit.slice(name.length + 3) : fallback;
+};
+
+const repoRoot = path.resolve(__dirname, '../..');
+const manifestPath = path.resolve(argValue('manifest', path.join(__dirname, 'corpus.json')));
+const outDir = path.resolve(argValue('out', path.join(repoRoot, 'build-bench/corpus')));
+
+// mulberry32: small seeded PRNG so "scan" noise is reproducible.
+function makeRng(seed) {
+  let state = seed >>> 0;
+  return () => {
+    state = (state + 0x6d2b79f5) >>> 0;
+    let t = state;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+class MeshBuilder {
+  constructor() {
+    this.triangles = [];
+  }
+
+  tri(a, b, c) {
+    this.triangles.push([a, b, c]);
+  }
+
+  quad(a, b, c, d) {
+    this.tri(a, b, c);
+    this.tri(a, c, d);
+  }
+
+  translate(dx, dy, dz, fromIndex = 0) {
+    for (let i = fromIndex; i < this.triangles.length; ++i) {
+      this.triangles[i] = this.triangles[i].map(([x, y, z]) => [x + dx, y + dy, z + dz]);
+    }
+  }
+
+  toBinaryStl(label) {
+    const count = this.triangles.length;
+    const buffer = Buffer.alloc(84 + count * 50);
+    buffer.write(label.slice(0, 79), 0, 'ascii');
+    buffer.writeUInt32LE(count, 80);
+    let offset = 84;
+    for (const [a, b, c] of this.triangles) {
+      const u = [b[0] - a[0], b[1] - a[1], b[2] - a[2]];
+      const v = [c[0] - a[0], c[1] - a[1], c[2] - a[2]];
+      const n = [u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]];
+      const length = Math.hypot(n[0], n[1], n[2]) || 1;
+      for (const value of [n[0] / length, n[1] / length, n[2] / length, ...a, ...b, ...c]) {
+        buffer.writeFloatLE(value, offset);
+        offset += 4;
+      }
+      offset += 2; // attribute byte count
+    }
+    return buffer;
+  }
+}
+
+// Closed surface of revolution. `ring(j)` returns { z, radius(theta), twist }
+// for ring j in [0, rings]; caps are fans to the axis at the first and last ring.
+function lathe(mesh, segments, rings, ring) {
+  const grid = [];
+  for (let j = 0; j <= rings; ++j) {
+    const { z, radius, twist = 0 } = ring(j);
+    const row = [];
+    for (let i = 0; i < segments; ++i) {
+      const theta = (2 * Math.PI * i) / segments + twist;
+      const r = radius(theta, i);
+      row.push([r * Math.cos(theta), r * Math.sin(theta), z]);
+    }
+    grid.push(row);
+  }
+  for (let j = 0; j < rings; ++j) {
+    for (let i = 0; i < segments; ++i) {
+      const k = (i + 1) % segments;
+      mesh.quad(grid[j][i], grid[j][k], grid[j + 1][k], grid[j + 1][i]);
+    }
+  }
+  const bottom = [0, 0, grid[0][0][2]];
+  const top = [0, 0, grid[rings][0][2]];
+  for (let i = 0; i < segments; ++i) {
+    const k = (i + 1) % segments;
+    mesh.tri(bottom, grid[0][k], grid[0][i]);
+    mesh.tri(top, grid[rings][i], grid[rings][k]);
+  }
+}
+
+const generators = {
+  vase(mesh, p) {
+    lathe(mesh, p.segments, p.rings, (j) => {
+      const t = j / p.rings;
+      const profile = 0.55 + 0.35 * Math.sin(Math.PI * t * 1.3) + 0.1 * Math.sin(6 * Math.PI * t);
+      return {
+        z: t * p.height,
+        radius: (theta) => p.radius * profile * (1 + 0.04 * Math.sin(12 * theta + 8 * t)),
+      };
+    });
+  },
+
+  scan(mesh, p) {
+    const rng = makeRng(p.seed ?? 1);
+    const noise = Array.from({ length: (p.rings + 1) * p.segments }, () => rng() - 0.5);
+    lathe(mesh, p.segments, p.rings, (j) => {
+      // Sphere-ish blob with a flat base so it sits on the bed.
+      const phi = (Math.PI * (j + p.rings * 0.15)) / (p.rings * 1.15);
+      const base = p.radius * Math.sin(phi);
+      return {
+        z: p.radius * (1 - Math.cos(phi)),
+        radius: (theta, i) => {
+          const lumps = 1 + 0.08 * Math.sin(5 * theta) * Math.sin(3 * phi);
+          const edge = j === 0 || j === p.rings ? 0 : noise[j * p.segments + i] * 0.004 * p.radius;
+          return Math.max(base * lumps + edge, 0.5);
+        },
+      };
+    });
+  },
+
+  islands(mesh, p) {
+    for (let row = 0; row < p.rows; ++row) {
+      for (let column = 0; column < p.columns; ++column) {
+        const first = mesh.triangles.length;
+        lathe(mesh, p.segments, 1, (j) => ({ z: j * p.height, radius: () => p.radius }));
+        mesh.translate(column * p.pitch, row * p.pitch, 0, first);
+      }
+    }
+  },
+
+  tower(mesh, p) {
+    const half = p.width / 2;
+    // Square cross-section expressed as a polar radius so lathe() can twist it.
+    const square = (theta) => half / Math.max(Math.abs(Math.cos(theta)), Math.abs(Math.sin(theta)));
+    lathe(mesh, 64, p.rings, (j) => {
+      const t = j / p.rings;
+      return {
+        z: t * p.height,
+        twist: (t * p.twist * Math.PI) / 180,
+        radius: (theta) => square(theta - (t * p.twist * Math.PI) / 180),
+      };
+    });
+  },
+
+  mushroom(mesh, p) {
+    const total = p.stem_height + p.cap_height;
+    // Ring list: stem base, stem top, flat cap underside, domed cap top.
+    const profile = [
+      [0, p.stem_radius],
+      [p.stem_height, p.stem_radius],
+      [p.stem_height, p.cap_radius],
+    ];
+    const domeRings = 12;
+    for (let k = 1; k <= domeRings; ++k) {
+      const a = (k / domeRings) * (Math.PI / 2);
+      profile.push([p.stem_height + p.cap_height * Math.sin(a), Math.max(p.cap_radius * Math.cos(a), 0.5)]);
+    }
+    lathe(mesh, p.segments, profile.length - 1, (j) => ({
+      z: Math.min(profile[j][0], total),
+      radius: () => profile[j][1],
+    }));
+  },
+};
+
+function main() {
+  const manifest = JSON.parse(fs.readFileSync(manifestPath, 'utf-8'));
+  fs.mkdirSync(outDir, { recursive: true });
+  for (const entry of manifest.cases) {
+    if (!entry.generator) {
+      continue;
+    }
+    const generate = generators[entry.generator.type];
+    if (!generate) {
+      throw new Error(`unknown generator type '${entry.generator.type}' for case ${entry.id}`);
+    }
+    const mesh = new MeshBuilder();
+    generate(mesh, entry.generator);
+    const target = path.join(outDir, `${entry.id}.stl`);
+    fs.writeFileSync(target, mesh.toBinaryStl(`orcaslicer-wasm bench ${entry.id}`));
+    console.log(`[bench-corpus] ${entry.id}: ${mesh.triangles.length} triangles -> ${path.relative(repoRoot, target)}`);
+  }
+}
+
+main();
@@ -0,0 +1,112 @@
+// Indirect-call-heavy phases: virtual calls on ConfigOption and
+// ExtrusionEntity, and std::function invocation. Under
+// -sEMULATE_FUNCTION_POINTER_CASTS every one of these calls goes through a
+// signature-adapting thunk, so building with and without
+// ORC_WASM_EMULATE_FPTR_CASTS measures what the thunks cost. The Fill
+// benchmarks in bench_slicing.cpp dispatch through Fill::fill_surface and
+// belong to the same comparison.
+
+#include "micro_bench.h"
+#include "micro_fixtures.h"
+
+#include <libslic3r/ExtrusionEntity.hpp>
+#include <libslic3r/ExtrusionEntityCollection.hpp>
+#include <libslic3r/PrintConfig.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using orc::micro::State;
+
+namespace {
+
+// One layer's worth of perimeters and infill: short paths, one virtual call
+// per path for each query.
+Slic3r::ExtrusionEntityCollection extrusion_layer(orc::micro::Rng& rng, size_t paths)
+{
+    Slic3r::ExtrusionEntityCollection collection;
+    for (size_t i = 0; i < paths; ++i) {
+        const Slic3r::ExtrusionRole role = (i % 3 == 0) ? Slic3r::erExternalPerimeter :
+                                           (i % 3 == 1) ? Slic3r::erPerimeter : Slic3r::erInternalInfill;
+        Slic3r::ExtrusionPath path(role, rng.uniform(0.02, 0.08), 0.45f, 0.2f);
+        path.polyline = orc::micro::noisy_path(rng, 16, rng.uniform(2., 20.));
+        collection.append(path);
+    }
+    return collection;
+}
+
+} // namespace
+
+// Full-config serialization, as the G-code footer and config fingerprints
+// do it: one virtual serialize() per option.
+static void BM_config_serialize_all(State& state)
+{
+    const Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+    const Slic3r::t_config_option_keys keys = config.keys();
+    for (auto _ : state) {
+        size_t bytes = 0;
+        for (const std::string& key : keys)
+            bytes += config.option(key)->serialize().size();
+        orc::micro::do_not_optimize(bytes);
+    }
+    state.set_items_processed(state.iterations() * keys.size());
+}
+ORC_MICRO_BENCHMARK(BM_config_serialize_all);
+
+// Config diffing (Print::apply): a virtual operator== per option pair.
+static void BM_config_compare_all(State& state)
+{
+    const Slic3r::DynamicPrintConfig a = Slic3r::DynamicPrintConfig::full_print_config();
+    const Slic3r::DynamicPrintConfig b = a;
+    const Slic3r::t_config_option_keys keys = a.keys();
+    for (auto _ : state) {
+        size_t equal = 0;
+        for (const std::string& key : keys)
+            equal += *a.option(key) == *b.option(key);
+        orc::micro::do_not_optimize(equal);
+    }
+    state.set_items_processed(state.iterations() * keys.size());
+}
+ORC_MICRO_BENCHMARK(BM_config_compare_all);
+
+// The per-entity queries GCode and the cooling/flow passes make.
+static void BM_extrusion_entity_queries(State& state)
+{
+    const Slic3r::ExtrusionEntityCollection layer = extrusion_layer(state.rng(), 4096);
+    for (auto _ : state) {
+        double total = layer.total_volume();
+        for (const Slic3r::ExtrusionEntity* entity : layer.entities)
+            total += entity->length() + entity->min_mm3_per_mm() + double(entity->is_loop());
+        orc::micro::do_not_optimize(total);
+    }
+    state.set_items_processed(state.iterations() * layer.entities.size());
+}
+ORC_MICRO_BENCHMARK(BM_extrusion_entity_queries);
+
+// clone() through the base class, as ExtrusionEntityCollection copies do.
+static void BM_extrusion_entity_clone(State& state)
+{
+    const Slic3r::ExtrusionEntityCollection layer = extrusion_layer(state.rng(), 1024);
+    for (auto _ : state) {
+        Slic3r::ExtrusionEntityCollection copy(layer);
+        orc::micro::do_not_optimize(copy.entities.data());
+    }
+    state.set_items_processed(state.iterations() * layer.entities.size());
+}
+ORC_MICRO_BENCHMARK(BM_extrusion_entity_clone);
+
+// Small std::function bodies, the shape of the throw_if_canceled and
+// status callbacks invoked from inner loops.
+static void BM_std_function_call(State& state)
+{
+    size_t counter = 0;
+    const std::function<void(size_t)> fn = [&counter](size_t i) { counter += i & 1; };
+    for (auto _ : state) {
+        for (size_t i = 0; i < 4096; ++i)
+            fn(i);
+        orc::micro::do_not_optimize(counter);
+    }
+    state.set_items_processed(state.iterations() * 4096);
+}
+ORC_MICRO_BENCHMARK(BM_std_function_call);
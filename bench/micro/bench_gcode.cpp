@@ -0,0 +1,120 @@
+// G-code emission: number formatting in GCodeWriter and the CoolingBuffer
+// pass that re-parses every layer it is handed.
+
+#include "micro_bench.h"
+
+#include <libslic3r/GCode.hpp>
+#include <libslic3r/GCode/CoolingBuffer.hpp>
+#include <libslic3r/GCodeWriter.hpp>
+#include <libslic3r/PrintConfig.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using orc::micro::State;
+
+namespace {
+
+struct Move
+{
+    Slic3r::Vec2d xy;
+    double        e;
+};
+
+std::vector<Move> random_moves(orc::micro::Rng& rng, size_t count)
+{
+    std::vector<Move> moves(count);
+    double e = 0.;
+    for (Move& move : moves) {
+        e += rng.uniform(0.001, 0.2);
+        move = Move{Slic3r::Vec2d(rng.uniform(0., 250.), rng.uniform(0., 250.)), e};
+    }
+    return moves;
+}
+
+// One layer in the shape GCode::process_layer hands to CoolingBuffer:
+// travel, speed-set marker, extrusions, end marker, per island.
+std::string synthetic_layer(orc::micro::Rng& rng, size_t islands, size_t moves_per_island)
+{
+    std::string gcode;
+    char line[128];
+    double e = 0.;
+    for (size_t island = 0; island < islands; ++island) {
+        std::snprintf(line, sizeof(line), "G1 X%.3f Y%.3f F12000\n", rng.uniform(0., 250.), rng.uniform(0., 250.));
+        gcode += line;
+        gcode += "G1 F2400;_EXTRUDE_SET_SPEED\n";
+        for (size_t i = 0; i < moves_per_island; ++i) {
+            e += rng.uniform(0.001, 0.05);
+            std::snprintf(line, sizeof(line), "G1 X%.3f Y%.3f E%.5f\n", rng.uniform(0., 250.), rng.uniform(0., 250.), e);
+            gcode += line;
+        }
+        gcode += ";_EXTRUDE_END\n";
+    }
+    return gcode;
+}
+
+} // namespace
+
+// The fixed-point formatter behind every G1 line.
+static void BM_gcode_formatter_g1_xye(State& state)
+{
+    const std::vector<Move> moves = random_moves(state.rng(), 4096);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const Move& move : moves) {
+            Slic3r::GCodeG1Formatter w;
+            w.emit_xy(move.xy);
+            w.emit_axis('E', move.e, Slic3r::GCodeFormatter::E_EXPORT_DIGITS);
+            std::string line = w.string();
+            bytes += line.size();
+            orc::micro::do_not_optimize(line);
+        }
+    }
+    state.set_items_processed(state.iterations() * moves.size());
+    state.set_bytes_processed(bytes);
+}
+ORC_MICRO_BENCHMARK(BM_gcode_formatter_g1_xye);
+
+// snprintf reference for the same lines.
+static void BM_gcode_snprintf_g1_xye(State& state)
+{
+    const std::vector<Move> moves = random_moves(state.rng(), 4096);
+    char buffer[96];
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const Move& move : moves) {
+            const int n = std::snprintf(buffer, sizeof(buffer), "G1 X%.3f Y%.3f E%.5f\n", move.xy.x(), move.xy.y(), move.e);
+            bytes += size_t(n);
+            orc::micro::do_not_optimize(buffer);
+        }
+    }
+    state.set_items_processed(state.iterations() * moves.size());
+    state.set_bytes_processed(bytes);
+}
+ORC_MICRO_BENCHMARK(BM_gcode_snprintf_g1_xye);
+
+// CoolingBuffer::process_layer parses the layer line by line, computes the
+// slowdown and re-emits it. The layer is rebuilt outside the timed region
+// because process_layer consumes its input.
+static void BM_cooling_buffer_process_layer(State& state)
+{
+    Slic3r::PrintConfig config;
+    config.apply(Slic3r::FullPrintConfig::defaults());
+    Slic3r::GCode gcodegen;
+    gcodegen.apply_print_config(config);
+    gcodegen.writer().set_extruders({0});
+    Slic3r::CoolingBuffer cooling(gcodegen);
+
+    const std::string layer = synthetic_layer(state.rng(), 40, 100);
+    size_t layer_id = 1;
+    for (auto _ : state) {
+        state.pause_timing();
+        std::string input = layer;
+        state.resume_timing();
+        std::string output = cooling.process_layer(std::move(input), layer_id++, true);
+        orc::micro::do_not_optimize(output);
+    }
+    state.set_bytes_processed(state.iterations() * layer.size());
+}
+ORC_MICRO_BENCHMARK(BM_cooling_buffer_process_layer);
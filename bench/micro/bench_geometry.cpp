@@ -0,0 +1,148 @@
+// 2D geometry kernels run per layer: Clipper offsets and unions, polyline
+// simplification and line-distance queries.
+
+#include "micro_bench.h"
+#include "micro_fixtures.h"
+
+#include <libslic3r/AABBTreeLines.hpp>
+#include <libslic3r/ClipperUtils.hpp>
+#include <libslic3r/MultiPoint.hpp>
+
+using orc::micro::State;
+
+namespace {
+
+size_t count_points(const Slic3r::Polygons& polygons)
+{
+    size_t n = 0;
+    for (const Slic3r::Polygon& polygon : polygons)
+        n += polygon.points.size();
+    return n;
+}
+
+size_t count_points(const Slic3r::ExPolygons& expolygons)
+{
+    return count_points(Slic3r::to_polygons(expolygons));
+}
+
+} // namespace
+
+// Perimeter generation: one inward offset of a whole layer per wall loop.
+static void BM_clipper_offset_ex_layer(State& state)
+{
+    const Slic3r::ExPolygons layer = orc::micro::island_layer(state.rng(), 36, 256);
+    const float delta = -float(Slic3r::scaled<double>(0.42));
+    for (auto _ : state) {
+        Slic3r::ExPolygons inset = Slic3r::offset_ex(layer, delta);
+        orc::micro::do_not_optimize(inset);
+    }
+    state.set_items_processed(state.iterations() * count_points(layer));
+}
+ORC_MICRO_BENCHMARK(BM_clipper_offset_ex_layer);
+
+// Mitered offset, as used for support and brim outlines.
+static void BM_clipper_offset_miter(State& state)
+{
+    const Slic3r::Polygons polygons = Slic3r::to_polygons(orc::micro::island_layer(state.rng(), 36, 256));
+    const float delta = float(Slic3r::scaled<double>(1.5));
+    for (auto _ : state) {
+        Slic3r::Polygons grown = Slic3r::offset(polygons, delta, ClipperLib::jtMiter, 3.);
+        orc::micro::do_not_optimize(grown);
+    }
+    state.set_items_processed(state.iterations() * count_points(polygons));
+}
+ORC_MICRO_BENCHMARK(BM_clipper_offset_miter);
+
+// Union of heavily overlapping contours, e.g. merging slices of several
+// volumes or closing gaps with a grow/shrink pair.
+static void BM_clipper_union_overlapping(State& state)
+{
+    orc::micro::Rng& rng = state.rng();
+    Slic3r::Polygons polygons;
+    for (size_t i = 0; i < 200; ++i) {
+        const Slic3r::Vec2d center(rng.uniform(20., 180.), rng.uniform(20., 180.));
+        polygons.emplace_back(orc::micro::jittered_circle(rng, center, rng.uniform(3., 15.), 128));
+    }
+    for (auto _ : state) {
+        Slic3r::ExPolygons merged = Slic3r::union_ex(polygons);
+        orc::micro::do_not_optimize(merged);
+    }
+    state.set_items_processed(state.iterations() * count_points(polygons));
+}
+ORC_MICRO_BENCHMARK(BM_clipper_union_overlapping);
+
+static void BM_clipper_diff_layer(State& state)
+{
+    const Slic3r::ExPolygons layer = orc::micro::island_layer(state.rng(), 36, 256);
+    const Slic3r::ExPolygons shifted = Slic3r::offset_ex(layer, -float(Slic3r::scaled<double>(0.8)));
+    for (auto _ : state) {
+        Slic3r::ExPolygons ring = Slic3r::diff_ex(layer, shifted);
+        orc::micro::do_not_optimize(ring);
+    }
+    state.set_items_processed(state.iterations() * count_points(layer));
+}
+ORC_MICRO_BENCHMARK(BM_clipper_diff_layer);
+
+static void BM_multipoint_douglas_peucker(State& state)
+{
+    const Slic3r::Polyline path = orc::micro::noisy_path(state.rng(), 20000);
+    const double tolerance = Slic3r::scaled<double>(0.0125);
+    for (auto _ : state) {
+        Slic3r::Points simplified = Slic3r::MultiPoint::_douglas_peucker(path.points, tolerance);
+        orc::micro::do_not_optimize(simplified);
+    }
+    state.set_items_processed(state.iterations() * path.points.size());
+}
+ORC_MICRO_BENCHMARK(BM_multipoint_douglas_peucker);
+
+static void BM_polygon_simplify_layer(State& state)
+{
+    const Slic3r::Polygons polygons = Slic3r::to_polygons(orc::micro::island_layer(state.rng(), 36, 1024));
+    const double tolerance = Slic3r::scaled<double>(0.05);
+    for (auto _ : state) {
+        Slic3r::Polygons simplified;
+        for (const Slic3r::Polygon& polygon : polygons)
+            Slic3r::append(simplified, polygon.simplify(tolerance));
+        orc::micro::do_not_optimize(simplified);
+    }
+    state.set_items_processed(state.iterations() * count_points(polygons));
+}
+ORC_MICRO_BENCHMARK(BM_polygon_simplify_layer);
+
+// Overhang and seam code measure every point of a layer against the previous
+// layer's perimeter lines.
+static void BM_aabb_lines_distance(State& state)
+{
+    orc::micro::Rng& rng = state.rng();
+    const Slic3r::Polygons prev_layer = Slic3r::to_polygons(orc::micro::island_layer(rng, 36, 256));
+    std::vector<Slic3r::Linef> lines;
+    for (const Slic3r::Polygon& polygon : prev_layer)
+        for (const Slic3r::Line& line : polygon.lines())
+            lines.emplace_back(Slic3r::unscaled(line.a), Slic3r::unscaled(line.b));
+    const Slic3r::AABBTreeLines::LinesDistancer<Slic3r::Linef> distancer(std::move(lines));
+
+    std::vector<Slic3r::Vec2d> queries(4096);
+    for (Slic3r::Vec2d& query : queries)
+        query = Slic3r::Vec2d(rng.uniform(0., 200.), rng.uniform(0., 200.));
+
+    for (auto _ : state) {
+        double sum = 0.;
+        for (const Slic3r::Vec2d& query : queries)
+            sum += distancer.distance_from_lines<false>(query);
+        orc::micro::do_not_optimize(sum);
+    }
+    state.set_items_processed(state.iterations() * queries.size());
+}
+ORC_MICRO_BENCHMARK(BM_aabb_lines_distance);
+
+static void BM_aabb_lines_build(State& state)
+{
+    const Slic3r::Polygons layer = Slic3r::to_polygons(orc::micro::island_layer(state.rng(), 36, 256));
+    const Slic3r::Lines lines = Slic3r::to_lines(layer);
+    for (auto _ : state) {
+        Slic3r::AABBTreeLines::LinesDistancer<Slic3r::Line> distancer(lines);
+        orc::micro::do_not_optimize(distancer);
+    }
+    state.set_items_processed(state.iterations() * lines.size());
+}
+ORC_MICRO_BENCHMARK(BM_aabb_lines_build);
@@ -0,0 +1,131 @@
+// Shim-backed primitives that libslic3r calls in hot paths. In the WASM build
+// these resolve to wasm/wasm_shims; natively they resolve to real Boost,
+// OpenSSL and oneTBB, which gives a reference for each shim. The bridge's
+// orc::hash runs alongside MD5 as the non-cryptographic alternative.
+
+#include "micro_bench.h"
+#include "orc_hash.h"
+
+#include <boost/format.hpp>
+#include <openssl/md5.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using orc::micro::State;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(orc::micro::Rng& rng, size_t size)
+{
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& b : bytes)
+        b = static_cast<uint8_t>(rng.next());
+    return bytes;
+}
+
+} // namespace
+
+// Orca's status and log lines: positional arguments of mixed types.
+static void BM_boost_format(State& state)
+{
+    const double x = state.rng().uniform(0., 250.);
+    const int    layer = 42;
+    for (auto _ : state) {
+        std::string line = (boost::format("Layer %1%: x=%2% mode=%3%") % layer % x % "outer wall").str();
+        orc::micro::do_not_optimize(line);
+    }
+    state.set_items_processed(state.iterations());
+}
+ORC_MICRO_BENCHMARK(BM_boost_format);
+
+// Config and cache fingerprints hash whole meshes; 4 MiB is a mid-size STL.
+static void BM_md5_4MiB(State& state)
+{
+    const std::vector<uint8_t> data = random_bytes(state.rng(), 4u << 20);
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    for (auto _ : state) {
+        MD5(data.data(), data.size(), digest);
+        orc::micro::do_not_optimize(digest);
+    }
+    state.set_bytes_processed(state.iterations() * data.size());
+}
+ORC_MICRO_BENCHMARK(BM_md5_4MiB);
+
+// Preset and file checksums: many short messages through Init/Update/Final.
+static void BM_md5_256B(State& state)
+{
+    const std::vector<uint8_t> data = random_bytes(state.rng(), 256);
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    for (auto _ : state) {
+        MD5(data.data(), data.size(), digest);
+        orc::micro::do_not_optimize(digest);
+    }
+    state.set_bytes_processed(state.iterations() * data.size());
+}
+ORC_MICRO_BENCHMARK(BM_md5_256B);
+
+// The result cache's key hash over the same 4 MiB, for comparison with MD5.
+static void BM_orc_hash128_4MiB(State& state)
+{
+    const std::vector<uint8_t> data = random_bytes(state.rng(), 4u << 20);
+    for (auto _ : state) {
+        orc::micro::do_not_optimize(orc::hash::hash128(data.data(), data.size()));
+    }
+    state.set_bytes_processed(state.iterations() * data.size());
+    state.set_label(orc::hash::backend());
+}
+ORC_MICRO_BENCHMARK(BM_orc_hash128_4MiB);
+
+static void BM_orc_hash128_256B(State& state)
+{
+    const std::vector<uint8_t> data = random_bytes(state.rng(), 256);
+    for (auto _ : state) {
+        orc::micro::do_not_optimize(orc::hash::hash128(data.data(), data.size()));
+    }
+    state.set_bytes_processed(state.iterations() * data.size());
+    state.set_label(orc::hash::backend());
+}
+ORC_MICRO_BENCHMARK(BM_orc_hash128_256B);
+
+// Per-layer fan-out as PrintObject does it: small bodies over a few hundred
+// layers, so dispatch overhead dominates.
+static void BM_tbb_parallel_for_layers(State& state)
+{
+    std::vector<double> layers(800);
+    for (double& v : layers)
+        v = state.rng().uniform();
+    for (auto _ : state) {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, layers.size()), [&layers](const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i < range.end(); ++i)
+                layers[i] = layers[i] * 0.5 + 0.25;
+        });
+        orc::micro::clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * layers.size());
+}
+ORC_MICRO_BENCHMARK(BM_tbb_parallel_for_layers);
+
+static void BM_tbb_parallel_reduce_sum(State& state)
+{
+    std::vector<double> values(1 << 16);
+    for (double& v : values)
+        v = state.rng().uniform();
+    for (auto _ : state) {
+        const double sum = tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(0, values.size()), 0.,
+            [&values](const tbb::blocked_range<size_t>& range, double acc) {
+                for (size_t i = range.begin(); i < range.end(); ++i)
+                    acc += values[i];
+                return acc;
+            },
+            std::plus<double>());
+        orc::micro::do_not_optimize(sum);
+    }
+    state.set_items_processed(state.iterations() * values.size());
+}
+ORC_MICRO_BENCHMARK(BM_tbb_parallel_reduce_sum);
@@ -0,0 +1,177 @@
+// Mesh slicing and infill generation on fixed inputs.
+
+#include "micro_bench.h"
+#include "micro_fixtures.h"
+#include "orc_slice.h"
+
+#include <libslic3r/ClipperUtils.hpp>
+#include <libslic3r/Fill/FillBase.hpp>
+#include <libslic3r/Surface.hpp>
+#include <libslic3r/TriangleMesh.hpp>
+#include <libslic3r/TriangleMeshSlicer.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+
+using orc::micro::State;
+
+namespace {
+
+// Sphere of ~80k triangles, 50 mm radius; sliced at 0.2 mm layer height.
+const indexed_triangle_set& sphere_mesh()
+{
+    static const indexed_triangle_set mesh = Slic3r::its_make_sphere(50., 2. * M_PI / 200.);
+    return mesh;
+}
+
+std::vector<float> layer_heights(float z_min, float z_max, float step)
+{
+    std::vector<float> zs;
+    for (float z = z_min + step * 0.5f; z < z_max; z += step)
+        zs.push_back(z);
+    return zs;
+}
+
+} // namespace
+
+static void BM_mesh_slice_sphere(State& state)
+{
+    const indexed_triangle_set& mesh = sphere_mesh();
+    const std::vector<float> zs = layer_heights(-50.f, 50.f, 0.2f);
+    Slic3r::MeshSlicingParamsEx params;
+    params.closing_radius = 0.0001f;
+    for (auto _ : state) {
+        std::vector<Slic3r::ExPolygons> layers = Slic3r::slice_mesh_ex(mesh, zs, params);
+        orc::micro::do_not_optimize(layers);
+    }
+    state.set_items_processed(state.iterations() * mesh.indices.size());
+    state.set_label(std::to_string(mesh.indices.size()) + " tris, " + std::to_string(zs.size()) + " layers");
+}
+ORC_MICRO_BENCHMARK(BM_mesh_slice_sphere);
+
+// Polygons only (no ExPolygon classification / closing), which isolates the
+// triangle-plane intersection and loop chaining.
+static void BM_mesh_slice_sphere_polygons(State& state)
+{
+    const indexed_triangle_set& mesh = sphere_mesh();
+    const std::vector<float> zs = layer_heights(-50.f, 50.f, 0.2f);
+    Slic3r::MeshSlicingParams params;
+    for (auto _ : state) {
+        std::vector<Slic3r::Polygons> layers = Slic3r::slice_mesh(mesh, zs, params);
+        orc::micro::do_not_optimize(layers);
+    }
+    state.set_items_processed(state.iterations() * mesh.indices.size());
+}
+ORC_MICRO_BENCHMARK(BM_mesh_slice_sphere_polygons);
+
+namespace {
+
+// Spheres of ~80k and ~1.25M triangles (50 mm radius), built once.
+const indexed_triangle_set& sphere_mesh(size_t segments)
+{
+    static std::map<size_t, indexed_triangle_set> meshes;
+    auto it = meshes.find(segments);
+    if (it == meshes.end()) {
+        it = meshes.emplace(segments, Slic3r::its_make_sphere(50., 2. * M_PI / double(segments))).first;
+    }
+    return it->second;
+}
+
+// slice_mesh() against the bridge kernel (orc_slice.h) on the same mesh and
+// planes; `step` 0.2 mm gives 500 layers, 0.05 mm gives 2000.
+void slice_layers(State& state, size_t segments, float step, bool kernel)
+{
+    const indexed_triangle_set& mesh = sphere_mesh(segments);
+    const std::vector<float> zs = layer_heights(-50.f, 50.f, step);
+    if (kernel) {
+        orc::slice::Stats stats;
+        for (auto _ : state) {
+            // Edge index and sweep order are part of the cost, as in a slice.
+            std::vector<Slic3r::Polygons> layers = orc::slice::slice_mesh(mesh, zs, &stats);
+            orc::micro::do_not_optimize(layers);
+        }
+        state.set_label(std::string(orc::slice::simd_backend()) + ", " + std::to_string(mesh.indices.size()) + " tris, "
+                        + std::to_string(zs.size()) + " layers, " + std::to_string(stats.open_chains) + " open");
+    } else {
+        Slic3r::MeshSlicingParams params;
+        for (auto _ : state) {
+            std::vector<Slic3r::Polygons> layers = Slic3r::slice_mesh(mesh, zs, params);
+            orc::micro::do_not_optimize(layers);
+        }
+        state.set_label(std::to_string(mesh.indices.size()) + " tris, " + std::to_string(zs.size()) + " layers");
+    }
+    state.set_items_processed(state.iterations() * mesh.indices.size());
+}
+
+} // namespace
+
+static void BM_slice_80k_500_layers_libslic3r(State& state) { slice_layers(state, 200, 0.2f, false); }
+ORC_MICRO_BENCHMARK(BM_slice_80k_500_layers_libslic3r);
+
+static void BM_slice_80k_500_layers_kernel(State& state) { slice_layers(state, 200, 0.2f, true); }
+ORC_MICRO_BENCHMARK(BM_slice_80k_500_layers_kernel);
+
+static void BM_slice_80k_2000_layers_libslic3r(State& state) { slice_layers(state, 200, 0.05f, false); }
+ORC_MICRO_BENCHMARK(BM_slice_80k_2000_layers_libslic3r);
+
+static void BM_slice_80k_2000_layers_kernel(State& state) { slice_layers(state, 200, 0.05f, true); }
+ORC_MICRO_BENCHMARK(BM_slice_80k_2000_layers_kernel);
+
+static void BM_slice_1m_500_layers_libslic3r(State& state) { slice_layers(state, 1120, 0.2f, false); }
+ORC_MICRO_BENCHMARK(BM_slice_1m_500_layers_libslic3r);
+
+static void BM_slice_1m_500_layers_kernel(State& state) { slice_layers(state, 1120, 0.2f, true); }
+ORC_MICRO_BENCHMARK(BM_slice_1m_500_layers_kernel);
+
+static void BM_slice_1m_2000_layers_libslic3r(State& state) { slice_layers(state, 1120, 0.05f, false); }
+ORC_MICRO_BENCHMARK(BM_slice_1m_2000_layers_libslic3r);
+
+static void BM_slice_1m_2000_layers_kernel(State& state) { slice_layers(state, 1120, 0.05f, true); }
+ORC_MICRO_BENCHMARK(BM_slice_1m_2000_layers_kernel);
+
+namespace {
+
+// Fills the same 36-island layer at 15% density with 0.45 mm lines.
+void fill_layer(State& state, Slic3r::InfillPattern pattern, float density)
+{
+    const Slic3r::ExPolygons layer = orc::micro::island_layer(state.rng(), 36, 256);
+    std::unique_ptr<Slic3r::Fill> fill(Slic3r::Fill::new_from_type(pattern));
+    fill->set_bounding_box(Slic3r::get_extents(layer));
+    fill->spacing = 0.45f;
+    fill->angle = float(M_PI / 4.);
+    fill->z = 10.f;
+    fill->layer_id = 50;
+
+    Slic3r::FillParams params;
+    params.density = density;
+    params.dont_adjust = true;
+
+    for (auto _ : state) {
+        Slic3r::Polylines paths;
+        for (const Slic3r::ExPolygon& island : layer) {
+            Slic3r::Surface surface(Slic3r::stInternal, island);
+            Slic3r::append(paths, fill->fill_surface(&surface, params));
+        }
+        orc::micro::do_not_optimize(paths);
+    }
+    state.set_items_processed(state.iterations() * layer.size());
+}
+
+} // namespace
+
+static void BM_fill_rectilinear(State& state) { fill_layer(state, Slic3r::ipRectilinear, 0.15f); }
+ORC_MICRO_BENCHMARK(BM_fill_rectilinear);
+
+static void BM_fill_grid(State& state) { fill_layer(state, Slic3r::ipGrid, 0.15f); }
+ORC_MICRO_BENCHMARK(BM_fill_grid);
+
+static void BM_fill_gyroid(State& state) { fill_layer(state, Slic3r::ipGyroid, 0.15f); }
+ORC_MICRO_BENCHMARK(BM_fill_gyroid);
+
+static void BM_fill_honeycomb(State& state) { fill_layer(state, Slic3r::ipHoneycomb, 0.15f); }
+ORC_MICRO_BENCHMARK(BM_fill_honeycomb);
+
+// Solid top/bottom skin: the densest path set per layer.
+static void BM_fill_monotonic_solid(State& state) { fill_layer(state, Slic3r::ipMonotonic, 1.f); }
+ORC_MICRO_BENCHMARK(BM_fill_monotonic_solid);
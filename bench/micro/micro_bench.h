@@ -0,0 +1,147 @@
+#ifndef ORCA_WASM_MICRO_BENCH_H
+#define ORCA_WASM_MICRO_BENCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal Google-Benchmark-style harness. It is small enough to build with
+// Emscripten without another third-party dependency and keeps the familiar
+// shape:
+//
+//     static void BM_thing(orc::micro::State& state) {
+//         Input in = make_input(state.rng());
+//         for (auto _ : state)
+//             orc::micro::do_not_optimize(thing(in));
+//         state.set_items_processed(state.iterations() * in.size());
+//     }
+//     ORC_MICRO_BENCHMARK(BM_thing);
+//
+// The runner grows the iteration count until one batch takes at least
+// --min-time, then reports time per iteration from that batch.
+namespace orc::micro {
+
+// splitmix64; every benchmark starts from the same seed so inputs are
+// identical across runs, builds and targets.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 0x5eed5eed5eedULL) : m_state(seed) {}
+
+    uint64_t next()
+    {
+        uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [lo, hi).
+    double uniform(double lo = 0., double hi = 1.)
+    {
+        return lo + (hi - lo) * static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Uniform integer in [0, n).
+    size_t below(size_t n) { return n == 0 ? 0 : static_cast<size_t>(next() % n); }
+
+private:
+    uint64_t m_state;
+};
+
+class State {
+public:
+    explicit State(uint64_t iterations) : m_iterations(iterations) {}
+
+    // `for (auto _ : state)` must not trip -Wunused-variable.
+    struct __attribute__((unused)) Value {};
+
+    struct Iterator {
+        State*   state;
+        uint64_t remaining;
+        bool operator!=(const Iterator&)
+        {
+            if (remaining != 0)
+                return true;
+            state->stop();
+            return false;
+        }
+        void operator++() { --remaining; }
+        Value operator*() const { return {}; }
+    };
+
+    // The clock runs only while the loop does, so setup before it and
+    // reporting after it are free.
+    Iterator begin();
+    Iterator end() { return Iterator{this, 0}; }
+
+    uint64_t iterations() const { return m_iterations; }
+    Rng&     rng() { return m_rng; }
+
+    // Excludes the enclosed work from the measured time.
+    void pause_timing();
+    void resume_timing();
+
+    void set_items_processed(uint64_t items) { m_items = items; }
+    void set_bytes_processed(uint64_t bytes) { m_bytes = bytes; }
+    void set_label(std::string label) { m_label = std::move(label); }
+    void skip_with_error(std::string message) { m_error = std::move(message); }
+
+    // Runner bookkeeping.
+    bool   finished() const { return m_stopped; }
+    double elapsed_ms() const;
+    uint64_t items() const { return m_items; }
+    uint64_t bytes() const { return m_bytes; }
+    const std::string& label() const { return m_label; }
+    const std::string& error() const { return m_error; }
+
+private:
+    uint64_t    m_iterations;
+    Rng         m_rng;
+    double      m_start_ms    = 0.;
+    double      m_paused_ms   = 0.;
+    double      m_pause_start = 0.;
+    double      m_stop_ms     = 0.;
+    bool        m_stopped     = false;
+    uint64_t    m_items       = 0;
+    uint64_t    m_bytes       = 0;
+    std::string m_label;
+    std::string m_error;
+
+    void stop();
+};
+
+using Function = void (*)(State&);
+
+struct Benchmark {
+    const char* name;
+    Function    fn;
+};
+
+std::vector<Benchmark>& registry();
+
+struct Registration {
+    Registration(const char* name, Function fn) { registry().push_back({name, fn}); }
+};
+
+// Keeps `value` observable so the compiler cannot drop the computation.
+template<class T>
+inline void do_not_optimize(T const& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber_memory()
+{
+    asm volatile("" : : : "memory");
+}
+
+} // namespace orc::micro
+
+#define ORC_MICRO_CONCAT_(a, b) a##b
+#define ORC_MICRO_CONCAT(a, b) ORC_MICRO_CONCAT_(a, b)
+#define ORC_MICRO_BENCHMARK(fn) \
+    static ::orc::micro::Registration ORC_MICRO_CONCAT(orc_micro_reg_, __LINE__)(#fn, fn)
+
+#endif
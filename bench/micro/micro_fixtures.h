@@ -0,0 +1,66 @@
+#ifndef ORCA_WASM_MICRO_FIXTURES_H
+#define ORCA_WASM_MICRO_FIXTURES_H
+
+#include "micro_bench.h"
+
+#include <libslic3r/ExPolygon.hpp>
+#include <libslic3r/Polygon.hpp>
+#include <libslic3r/Polyline.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Seeded, layer-sized inputs shared by the libslic3r micro-benchmarks. Sizes
+// follow what one layer of the bench/corpus models produces: a few dozen
+// islands of a few hundred vertices each, in scaled coordinates.
+namespace orc::micro {
+
+// Star-shaped, non-self-intersecting closed contour with radial jitter (CCW).
+inline Slic3r::Polygon jittered_circle(Rng& rng, const Slic3r::Vec2d& center_mm, double radius_mm, size_t vertices,
+                                       double jitter = 0.15)
+{
+    Slic3r::Polygon polygon;
+    polygon.points.reserve(vertices);
+    for (size_t i = 0; i < vertices; ++i) {
+        const double angle = 2. * M_PI * double(i) / double(vertices);
+        const double r = radius_mm * (1. + jitter * (rng.uniform() - 0.5));
+        polygon.points.emplace_back(Slic3r::scaled<Slic3r::coord_t>(center_mm.x() + r * std::cos(angle)),
+                                    Slic3r::scaled<Slic3r::coord_t>(center_mm.y() + r * std::sin(angle)));
+    }
+    return polygon;
+}
+
+// `count` islands on a grid inside a 200 x 200 mm bed, each with a hole.
+inline Slic3r::ExPolygons island_layer(Rng& rng, size_t count, size_t vertices)
+{
+    Slic3r::ExPolygons islands;
+    const size_t columns = std::max<size_t>(1, size_t(std::ceil(std::sqrt(double(count)))));
+    const double pitch = 200. / double(columns);
+    for (size_t i = 0; i < count; ++i) {
+        const Slic3r::Vec2d center((double(i % columns) + 0.5) * pitch, (double(i / columns) + 0.5) * pitch);
+        Slic3r::ExPolygon island(jittered_circle(rng, center, pitch * 0.4, vertices));
+        Slic3r::Polygon hole = jittered_circle(rng, center, pitch * 0.15, vertices / 2 + 3, 0.05);
+        hole.reverse();
+        island.holes.emplace_back(std::move(hole));
+        islands.emplace_back(std::move(island));
+    }
+    return islands;
+}
+
+// Densely sampled open path along a noisy sine; typical input for
+// Douglas-Peucker after arc fitting is disabled.
+inline Slic3r::Polyline noisy_path(Rng& rng, size_t vertices, double length_mm = 180.)
+{
+    Slic3r::Polyline polyline;
+    polyline.points.reserve(vertices);
+    for (size_t i = 0; i < vertices; ++i) {
+        const double x = length_mm * double(i) / double(vertices);
+        const double y = 20. * std::sin(x * 0.15) + 0.01 * (rng.uniform() - 0.5);
+        polyline.points.emplace_back(Slic3r::scaled<Slic3r::coord_t>(x), Slic3r::scaled<Slic3r::coord_t>(y));
+    }
+    return polyline;
+}
+
+} // namespace orc::micro
+
+#endif
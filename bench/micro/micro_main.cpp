@@ -0,0 +1,251 @@
+// Runner for the micro-benchmarks registered with ORC_MICRO_BENCHMARK.
+//
+// Usage: orca_micro_bench [--filter=REGEX] [--min-time=SECONDS] [--repetitions=N]
+//                         [--json=FILE] [--list]
+//
+// --json writes the Google Benchmark JSON layout (context + benchmarks[] with
+// real_time/cpu_time in ns) so its compare.py and existing dashboards can read
+// the results unchanged.
+
+#include "micro_bench.h"
+#include "orc_clock.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <regex>
+#include <string>
+
+namespace orc::micro {
+
+std::vector<Benchmark>& registry()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+State::Iterator State::begin()
+{
+    m_start_ms = orc::now_ms();
+    return Iterator{this, m_iterations};
+}
+
+void State::stop()
+{
+    if (!m_stopped) {
+        m_stop_ms = orc::now_ms();
+        m_stopped = true;
+    }
+}
+
+void State::pause_timing()
+{
+    m_pause_start = orc::now_ms();
+}
+
+void State::resume_timing()
+{
+    m_paused_ms += orc::now_ms() - m_pause_start;
+}
+
+double State::elapsed_ms() const
+{
+    return std::max(0., m_stop_ms - m_start_ms - m_paused_ms);
+}
+
+} // namespace orc::micro
+
+namespace {
+
+using json = nlohmann::json;
+using orc::micro::Benchmark;
+using orc::micro::State;
+
+struct Options
+{
+    std::string filter = ".*";
+    double      min_time_ms = 500.;
+    int         repetitions = 1;
+    std::string json_path;
+    bool        list = false;
+};
+
+constexpr uint64_t kMaxIterations = 1000000000ULL;
+
+struct Measurement
+{
+    uint64_t    iterations = 0;
+    double      elapsed_ms = 0.;
+    uint64_t    items = 0;
+    uint64_t    bytes = 0;
+    std::string label;
+    std::string error;
+};
+
+// Grows the iteration count the way Google Benchmark does: aim 40% past the
+// target based on the last batch, never more than 10x per step.
+Measurement measure(const Benchmark& benchmark, double min_time_ms)
+{
+    uint64_t iterations = 1;
+    for (;;) {
+        State state(iterations);
+        benchmark.fn(state);
+        Measurement m{iterations, state.elapsed_ms(), state.items(), state.bytes(), state.label(), state.error()};
+        if (!m.error.empty() || !state.finished() || m.elapsed_ms >= min_time_ms || iterations >= kMaxIterations) {
+            if (m.error.empty() && !state.finished()) {
+                m.error = "benchmark did not run its state loop";
+            }
+            return m;
+        }
+        const double ratio = m.elapsed_ms > 0. ? (min_time_ms * 1.4) / m.elapsed_ms : 10.;
+        const double grow = std::clamp(ratio, 2., 10.);
+        iterations = std::min<uint64_t>(kMaxIterations, static_cast<uint64_t>(static_cast<double>(iterations) * grow) + 1);
+    }
+}
+
+bool parse_args(int argc, char** argv, Options& opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value_of = [&](const char* prefix) -> const char* {
+            const size_t n = std::strlen(prefix);
+            return arg.compare(0, n, prefix) == 0 ? arg.c_str() + n : nullptr;
+        };
+        if (const char* v = value_of("--filter=")) opts.filter = v;
+        else if (const char* v = value_of("--min-time=")) opts.min_time_ms = std::max(0.001, std::atof(v)) * 1000.;
+        else if (const char* v = value_of("--repetitions=")) opts.repetitions = std::max(1, std::atoi(v));
+        else if (const char* v = value_of("--json=")) opts.json_path = v;
+        else if (arg == "--list") opts.list = true;
+        else {
+            std::fprintf(stderr,
+                         "usage: %s [--filter=REGEX] [--min-time=SECONDS] [--repetitions=N] [--json=FILE] [--list]\n",
+                         argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string human_time(double ns)
+{
+    char buffer[32];
+    if (ns < 1e3)
+        std::snprintf(buffer, sizeof(buffer), "%.1f ns", ns);
+    else if (ns < 1e6)
+        std::snprintf(buffer, sizeof(buffer), "%.2f us", ns / 1e3);
+    else if (ns < 1e9)
+        std::snprintf(buffer, sizeof(buffer), "%.2f ms", ns / 1e6);
+    else
+        std::snprintf(buffer, sizeof(buffer), "%.2f s", ns / 1e9);
+    return buffer;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse_args(argc, argv, opts)) {
+        return 2;
+    }
+
+    std::regex filter;
+    try {
+        filter = std::regex(opts.filter);
+    } catch (const std::regex_error& ex) {
+        std::fprintf(stderr, "[micro] invalid --filter: %s\n", ex.what());
+        return 2;
+    }
+
+    auto& benchmarks = orc::micro::registry();
+    std::sort(benchmarks.begin(), benchmarks.end(),
+              [](const Benchmark& a, const Benchmark& b) { return std::strcmp(a.name, b.name) < 0; });
+
+    json results = json::array();
+    int failures = 0;
+    std::printf("%-48s %14s %12s %14s\n", "Benchmark", "Time", "Iterations", "Throughput");
+    for (const Benchmark& benchmark : benchmarks) {
+        if (!std::regex_search(benchmark.name, filter)) {
+            continue;
+        }
+        if (opts.list) {
+            std::printf("%s\n", benchmark.name);
+            continue;
+        }
+        for (int repetition = 0; repetition < opts.repetitions; ++repetition) {
+            const Measurement m = measure(benchmark, opts.min_time_ms);
+            json entry{{"name", benchmark.name},
+                       {"run_name", benchmark.name},
+                       {"run_type", "iteration"},
+                       {"repetition_index", repetition},
+                       {"iterations", m.iterations},
+                       {"time_unit", "ns"}};
+            if (!m.error.empty()) {
+                ++failures;
+                entry["error_occurred"] = true;
+                entry["error_message"] = m.error;
+                std::printf("%-48s ERROR: %s\n", benchmark.name, m.error.c_str());
+                results.push_back(std::move(entry));
+                continue;
+            }
+
+            const double ns_per_iter = m.elapsed_ms * 1e6 / static_cast<double>(m.iterations);
+            const double seconds = m.elapsed_ms / 1e3;
+            entry["real_time"] = ns_per_iter;
+            entry["cpu_time"] = ns_per_iter;
+            std::string throughput;
+            if (m.items != 0 && seconds > 0.) {
+                entry["items_per_second"] = static_cast<double>(m.items) / seconds;
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "%.3g items/s", static_cast<double>(m.items) / seconds);
+                throughput = buffer;
+            }
+            if (m.bytes != 0 && seconds > 0.) {
+                entry["bytes_per_second"] = static_cast<double>(m.bytes) / seconds;
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "%.1f MiB/s", static_cast<double>(m.bytes) / seconds / 1048576.);
+                throughput = buffer;
+            }
+            if (!m.label.empty()) {
+                entry["label"] = m.label;
+            }
+            std::printf("%-48s %14s %12llu %14s %s\n", benchmark.name, human_time(ns_per_iter).c_str(),
+                        static_cast<unsigned long long>(m.iterations), throughput.c_str(), m.label.c_str());
+            std::fflush(stdout);
+            results.push_back(std::move(entry));
+        }
+    }
+
+    if (!opts.json_path.empty() && !opts.list) {
+        char date[32] = {0};
+        const std::time_t tt = std::time(nullptr);
+        std::tm tm{};
+        gmtime_r(&tt, &tm);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        const json document{
+            {"context",
+             {{"date", date},
+              {"executable", argv[0]},
+#ifdef __EMSCRIPTEN__
+              {"target", "wasm"},
+#else
+              {"target", "native"},
+#endif
+              {"library_build_type", "release"},
+              {"min_time_ms", opts.min_time_ms}}},
+            {"benchmarks", std::move(results)},
+        };
+        std::ofstream out(opts.json_path, std::ios::binary);
+        if (!out) {
+            std::fprintf(stderr, "[micro] cannot write %s\n", opts.json_path.c_str());
+            return 1;
+        }
+        out << document.dump(2) << '\n';
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,296 @@
+// Native end-to-end slicing benchmark.
+//
+// Runs every case x preset pair from bench/corpus/corpus.json through the
+// bridge C API (orc_init + orc_slice) and writes machine-readable results in
+// the same schema as scripts/bench-slicer.js, so bench/compare.js can diff a
+// native run against a WASM one or against a stored baseline.
+//
+// Each run happens in a forked child: the bridge keeps global state and
+// fixed temp paths, and wait4() hands back the child's peak RSS without
+// polling /proc. The child reads the model itself; a forked process starts
+// with its parent's RSS high-water mark, so the parent keeps its footprint
+// small.
+
+#include "wasm_wrap.h"
+
+#include <nlohmann/json.hpp>
+
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct Options
+{
+    std::string corpus   = "bench/corpus/corpus.json";
+    std::string models   = "build-bench/corpus";
+    std::string out      = "build-bench/results-native.json";
+    std::string only_case;
+    std::string only_preset;
+    int         repeat   = 1;
+};
+
+void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--corpus=FILE] [--models=DIR] [--out=FILE]\n"
+                 "          [--case=ID] [--preset=NAME] [--repeat=N]\n",
+                 argv0);
+}
+
+bool parse_args(int argc, char **argv, Options &opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value_of = [&](const char *prefix) -> const char * {
+            const size_t n = std::strlen(prefix);
+            return arg.compare(0, n, prefix) == 0 ? arg.c_str() + n : nullptr;
+        };
+        if (const char *v = value_of("--corpus=")) opts.corpus = v;
+        else if (const char *v = value_of("--models=")) opts.models = v;
+        else if (const char *v = value_of("--out=")) opts.out = v;
+        else if (const char *v = value_of("--case=")) opts.only_case = v;
+        else if (const char *v = value_of("--preset=")) opts.only_preset = v;
+        else if (const char *v = value_of("--repeat=")) opts.repeat = std::max(1, std::atoi(v));
+        else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool read_file(const std::string &path, std::string &out)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string iso8601_now_utc()
+{
+    const std::time_t tt = std::time(nullptr);
+    std::tm tm{};
+    gmtime_r(&tt, &tm);
+    char buffer[32] = {0};
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return buffer;
+}
+
+json host_info()
+{
+    utsname uts{};
+    uname(&uts);
+    return json{
+        {"os", uts.sysname},
+        {"release", uts.release},
+        {"arch", uts.machine},
+        {"cpus", static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN))},
+    };
+}
+
+// Child side of one run: slice and report {rc, outputBytes, profile} as JSON
+// on `fd`. Never returns.
+[[noreturn]] void run_child(int fd, const std::string &model_path, const json &preset)
+{
+    json report;
+    std::string model;
+    if (!read_file(model_path, model)) {
+        std::_Exit(3);
+    }
+    const std::string payload = json{{"config", preset}}.dump();
+    orc_init(reinterpret_cast<const uint8_t *>(payload.data()), payload.size());
+
+    uint8_t *gcode     = nullptr;
+    size_t   gcode_len = 0;
+    const int rc = orc_slice(reinterpret_cast<const uint8_t *>(model.data()), model.size(), &gcode, &gcode_len);
+    report["rc"]          = rc;
+    report["outputBytes"] = rc == 0 ? gcode_len : 0;
+    orc_free(gcode);
+
+    uint8_t *profile     = nullptr;
+    size_t   profile_len = 0;
+    if (orc_get_profile(&profile, &profile_len) == 0) {
+        report["profile"] = json::parse(profile, profile + profile_len, nullptr, false);
+        orc_free(profile);
+    }
+
+    const std::string encoded = report.dump();
+    size_t written = 0;
+    while (written < encoded.size()) {
+        const ssize_t n = write(fd, encoded.data() + written, encoded.size() - written);
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    close(fd);
+    std::_Exit(0);
+}
+
+json run_once(const std::string &case_id, const std::string &preset_name, const std::string &model_path,
+              const json &preset)
+{
+    json result{{"case", case_id}, {"preset", preset_name}, {"ok", false}};
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        result["error"] = "pipe failed";
+        return result;
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        result["error"] = "fork failed";
+        return result;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        run_child(fds[1], model_path, preset);
+    }
+    close(fds[1]);
+
+    std::string reply;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = read(fds[0], chunk, sizeof(chunk))) > 0) {
+        reply.append(chunk, static_cast<size_t>(n));
+    }
+    close(fds[0]);
+
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    result["wallMs"]       = wall_ms;
+    result["peakRssBytes"] = static_cast<uint64_t>(usage.ru_maxrss) * 1024u; // Linux reports KiB
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        result["error"] = WIFSIGNALED(status) ? "child killed by signal " + std::to_string(WTERMSIG(status))
+                                              : "child exited abnormally";
+        return result;
+    }
+
+    const json report = json::parse(reply, nullptr, false);
+    if (report.is_discarded()) {
+        result["error"] = "malformed child report";
+        return result;
+    }
+
+    const int rc        = report.value("rc", -100);
+    result["rc"]          = rc;
+    result["ok"]          = rc == 0;
+    result["outputBytes"] = report.value("outputBytes", 0);
+    if (auto it = report.find("profile"); it != report.end() && it->is_object()) {
+        json phases = json::object();
+        uint64_t peak_heap = 0;
+        const json groups = it->value("phases", json::object());
+        for (const auto &group : groups.items()) {
+            for (const json &phase : group.value()) {
+                phases[group.key() + "/" + phase.value("name", "?")] = phase.value("durationMs", 0.0);
+                peak_heap = std::max<uint64_t>(peak_heap, phase.value("peakHeapBytes", uint64_t{0}));
+            }
+        }
+        result["phases"]        = std::move(phases);
+        result["peakHeapBytes"] = peak_heap;
+        result["counters"]      = it->value("counters", json::object());
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!parse_args(argc, argv, opts)) {
+        return 2;
+    }
+
+    if (std::getenv("ORC_RESOURCES_DIR") == nullptr) {
+        setenv("ORC_RESOURCES_DIR", ORC_BENCH_RESOURCES_DIR, 0);
+    }
+
+    std::string manifest_text;
+    if (!read_file(opts.corpus, manifest_text)) {
+        std::fprintf(stderr, "[slice_bench] cannot read corpus manifest %s\n", opts.corpus.c_str());
+        return 1;
+    }
+    const json manifest = json::parse(manifest_text, nullptr, true, true);
+    const json &presets = manifest.at("presets");
+    const json  default_presets = manifest.value("defaultPresets", json::array());
+
+    json results = json::array();
+    int failures = 0;
+    for (const json &entry : manifest.at("cases")) {
+        const std::string case_id = entry.at("id").get<std::string>();
+        if (!opts.only_case.empty() && opts.only_case != case_id) {
+            continue;
+        }
+        const std::string model_path = opts.models + "/" + entry.value("file", case_id + ".stl");
+        if (access(model_path.c_str(), R_OK) != 0) {
+            std::fprintf(stderr, "[slice_bench] %s: missing %s (run bench/corpus/generate.js)\n", case_id.c_str(),
+                         model_path.c_str());
+            ++failures;
+            continue;
+        }
+
+        for (const json &preset_name_json : entry.value("presets", default_presets)) {
+            const std::string preset_name = preset_name_json.get<std::string>();
+            if (!opts.only_preset.empty() && opts.only_preset != preset_name) {
+                continue;
+            }
+            const json &preset = presets.at(preset_name);
+            for (int iteration = 0; iteration < opts.repeat; ++iteration) {
+                json result = run_once(case_id, preset_name, model_path, preset);
+                result["iteration"] = iteration;
+                std::fprintf(stderr, "[slice_bench] %-20s %-12s rc=%-3d %9.1f ms  rss=%6.1f MiB  out=%zu\n",
+                             case_id.c_str(), preset_name.c_str(), result.value("rc", -100),
+                             result.value("wallMs", 0.0), result.value("peakRssBytes", 0.0) / (1024.0 * 1024.0),
+                             result.value("outputBytes", size_t{0}));
+                if (!result.value("ok", false)) {
+                    ++failures;
+                }
+                results.push_back(std::move(result));
+            }
+        }
+    }
+
+    const json document{
+        {"schema", 1},
+        {"runner", "native"},
+        {"timestamp", iso8601_now_utc()},
+        {"host", host_info()},
+        {"results", std::move(results)},
+    };
+    std::ofstream out(opts.out, std::ios::binary);
+    if (!out) {
+        std::fprintf(stderr, "[slice_bench] cannot write %s\n", opts.out.c_str());
+        return 1;
+    }
+    out << document.dump(2) << '\n';
+    std::fprintf(stderr, "[slice_bench] wrote %s (%d failing runs)\n", opts.out.c_str(), failures);
+    return failures == 0 ? 0 : 1;
+}
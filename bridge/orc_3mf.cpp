@@ -0,0 +1,599 @@
+#include "orc_3mf.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <expat.h>
+#include <miniz.h>
+
+#include <libslic3r/Geometry.hpp>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/PrintConfig.hpp>
+#include <libslic3r/TriangleMesh.hpp>
+
+namespace orc::threemf {
+
+namespace {
+
+static constexpr const char* kDefaultModelPart = "3D/3dmodel.model";
+static constexpr const char* kRelationships = "_rels/.rels";
+static constexpr const char* kModelRelationship = "http://schemas.microsoft.com/3dmanufacturing/2013/01/3dmodel";
+static constexpr const char* kSettingsParts[] = {
+    "Metadata/model_settings.config",
+    "Metadata/Slic3r_PE_model.config",
+};
+// Components nest and may share children; a chain this deep is a cycle and a
+// tree this wide is not a model anyone meant to print.
+static constexpr int kMaxComponentDepth = 32;
+static constexpr size_t kMaxVolumesPerObject = 4096;
+
+// An object is identified by its part and its id within that part.
+using ObjectKey = std::pair<std::string, int>;
+
+struct Component {
+    ObjectKey object;
+    Slic3r::Transform3d transform = Slic3r::Transform3d::Identity();
+};
+
+struct ObjectDef {
+    std::string name;
+    indexed_triangle_set mesh;
+    std::vector<Component> components;
+};
+
+struct Item {
+    ObjectKey object;
+    Slic3r::Transform3d transform = Slic3r::Transform3d::Identity();
+    bool printable = true;
+};
+
+struct Package {
+    std::map<ObjectKey, ObjectDef> objects;
+    std::vector<Item> items;
+    std::set<std::string> parsed_parts;
+};
+
+// "/3D/Objects/a.model" and "3D/Objects/a.model" name the same zip entry.
+static std::string part_name(const char* path)
+{
+    while (*path == '/') {
+        ++path;
+    }
+    return path;
+}
+
+static const char* local_name(const char* name)
+{
+    const char* colon = std::strrchr(name, ':');
+    return colon != nullptr ? colon + 1 : name;
+}
+
+static const char* attribute(const XML_Char** atts, const char* name)
+{
+    for (size_t i = 0; atts[i] != nullptr; i += 2) {
+        if (std::strcmp(local_name(atts[i]), name) == 0) {
+            return atts[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+static bool parse_int(const char* text, int& out)
+{
+    if (text == nullptr) {
+        return false;
+    }
+    char* end = nullptr;
+    const long value = std::strtol(text, &end, 10);
+    if (end == text || value < 0 || value > 0x7fffffff) {
+        return false;
+    }
+    out = static_cast<int>(value);
+    return true;
+}
+
+// Twelve numbers "m00 m01 m02 m10 ... m32", row-vector convention: a point
+// maps to [x y z 1] * M.
+static bool parse_transform(const char* text, double unit, Slic3r::Transform3d& out)
+{
+    std::array<double, 12> m;
+    const char* p = text;
+    for (double& value : m) {
+        char* end = nullptr;
+        value = std::strtod(p, &end);
+        if (end == p) {
+            return false;
+        }
+        p = end;
+    }
+    out = Slic3r::Transform3d::Identity();
+    out.linear() << m[0], m[3], m[6],
+                    m[1], m[4], m[7],
+                    m[2], m[5], m[8];
+    out.translation() << m[9] * unit, m[10] * unit, m[11] * unit;
+    return true;
+}
+
+static double unit_scale(const char* unit)
+{
+    static constexpr std::pair<const char*, double> kUnits[] = {
+        {"micron", 0.001}, {"millimeter", 1.0}, {"centimeter", 10.0},
+        {"inch", 25.4},    {"foot", 304.8},     {"meter", 1000.0},
+    };
+    for (const auto& [name, scale] : kUnits) {
+        if (unit != nullptr && std::strcmp(unit, name) == 0) {
+            return scale;
+        }
+    }
+    return 1.0;
+}
+
+// Feeds a zip entry to an expat parser as miniz inflates it.
+class XmlPart {
+public:
+    explicit XmlPart(std::string& error) : m_error(error), m_parser(XML_ParserCreate(nullptr))
+    {
+        XML_SetUserData(m_parser, this);
+        XML_SetElementHandler(m_parser, &XmlPart::on_start, &XmlPart::on_end);
+    }
+    virtual ~XmlPart() { XML_ParserFree(m_parser); }
+
+    XmlPart(const XmlPart&) = delete;
+    XmlPart& operator=(const XmlPart&) = delete;
+
+    // False if the entry is missing and `required`, or on any error.
+    bool parse(mz_zip_archive& zip, const std::string& name, bool required)
+    {
+        if (m_parser == nullptr) {
+            m_error = "out of memory";
+            return false;
+        }
+        const int index = mz_zip_reader_locate_file(&zip, name.c_str(), nullptr, 0);
+        if (index < 0) {
+            if (required) {
+                m_error = "missing part " + name;
+            }
+            return !required;
+        }
+        m_name = name;
+        const bool extracted = mz_zip_reader_extract_to_callback(&zip, static_cast<mz_uint>(index), &XmlPart::on_data, this, 0);
+        if (!m_error.empty()) {
+            return false;
+        }
+        if (!extracted) {
+            m_error = name + ": " + mz_zip_get_error_string(mz_zip_get_last_error(&zip));
+            return false;
+        }
+        return feed(nullptr, 0, true);
+    }
+
+protected:
+    virtual void start(const char* name, const XML_Char** atts) = 0;
+    virtual void end(const char* /*name*/) {}
+
+    void stop(const std::string& message)
+    {
+        if (m_error.empty()) {
+            m_error = m_name + ":" + std::to_string(XML_GetCurrentLineNumber(m_parser)) + ": " + message;
+        }
+        XML_StopParser(m_parser, false);
+    }
+
+    const std::string& name() const { return m_name; }
+
+private:
+    bool feed(const void* data, size_t len, bool final)
+    {
+        if (XML_Parse(m_parser, static_cast<const char*>(data), static_cast<int>(len), final) == XML_STATUS_OK) {
+            return true;
+        }
+        if (m_error.empty()) {
+            m_error = m_name + ":" + std::to_string(XML_GetCurrentLineNumber(m_parser)) + ": " +
+                      XML_ErrorString(XML_GetErrorCode(m_parser));
+        }
+        return false;
+    }
+
+    // miniz hands out at most its dictionary size (32 KiB) per call.
+    static size_t on_data(void* opaque, mz_uint64 /*offset*/, const void* data, size_t len)
+    {
+        XmlPart* self = static_cast<XmlPart*>(opaque);
+        return self->feed(data, len, false) ? len : 0;
+    }
+
+    static void XMLCALL on_start(void* user, const XML_Char* name, const XML_Char** atts)
+    {
+        static_cast<XmlPart*>(user)->start(local_name(name), atts);
+    }
+
+    static void XMLCALL on_end(void* user, const XML_Char* name)
+    {
+        static_cast<XmlPart*>(user)->end(local_name(name));
+    }
+
+    std::string& m_error;
+    XML_Parser m_parser;
+    std::string m_name;
+};
+
+class RelationshipsPart : public XmlPart {
+public:
+    using XmlPart::XmlPart;
+
+    std::string model_part;
+
+protected:
+    void start(const char* name, const XML_Char** atts) override
+    {
+        const char* type = attribute(atts, "Type");
+        const char* target = attribute(atts, "Target");
+        if (model_part.empty() && std::strcmp(name, "Relationship") == 0 && type != nullptr && target != nullptr &&
+            std::strcmp(type, kModelRelationship) == 0) {
+            model_part = part_name(target);
+        }
+    }
+};
+
+class ModelPart : public XmlPart {
+public:
+    ModelPart(std::string& error, Package& package, LoadStats& stats, bool root)
+        : XmlPart(error), m_package(package), m_stats(stats), m_root(root)
+    {}
+
+protected:
+    void start(const char* name, const XML_Char** atts) override
+    {
+        if (m_object != nullptr && std::strcmp(name, "vertex") == 0) {
+            add_vertex(atts);
+        } else if (m_object != nullptr && std::strcmp(name, "triangle") == 0) {
+            add_triangle(atts);
+        } else if (std::strcmp(name, "object") == 0) {
+            int id = 0;
+            if (!parse_int(attribute(atts, "id"), id)) {
+                return stop("object without id");
+            }
+            m_object = &m_package.objects[{this->name(), id}];
+            if (const char* object_name = attribute(atts, "name")) {
+                m_object->name = object_name;
+            }
+        } else if (m_object != nullptr && std::strcmp(name, "component") == 0) {
+            Component component;
+            if (!reference(atts, component.object, component.transform)) {
+                return stop("bad component");
+            }
+            m_object->components.push_back(std::move(component));
+        } else if (m_root && std::strcmp(name, "item") == 0) {
+            Item item;
+            if (!reference(atts, item.object, item.transform)) {
+                return stop("bad build item");
+            }
+            const char* printable = attribute(atts, "printable");
+            item.printable = printable == nullptr || std::strcmp(printable, "0") != 0;
+            m_package.items.push_back(std::move(item));
+        } else if (std::strcmp(name, "model") == 0) {
+            m_unit = unit_scale(attribute(atts, "unit"));
+        }
+    }
+
+    void end(const char* name) override
+    {
+        if (m_object == nullptr || std::strcmp(name, "object") != 0) {
+            return;
+        }
+        const indexed_triangle_set& mesh = m_object->mesh;
+        const int vertices = static_cast<int>(mesh.vertices.size());
+        for (const stl_triangle_vertex_indices& facet : mesh.indices) {
+            if (facet.maxCoeff() >= vertices) {
+                return stop("triangle index out of range");
+            }
+        }
+        m_object = nullptr;
+    }
+
+private:
+    void add_vertex(const XML_Char** atts)
+    {
+        static constexpr const char* kAxes[] = {"x", "y", "z"};
+        stl_vertex vertex;
+        for (int axis = 0; axis < 3; ++axis) {
+            const char* text = attribute(atts, kAxes[axis]);
+            char* end = nullptr;
+            vertex[axis] = text != nullptr ? std::strtof(text, &end) : 0.f;
+            if (text == nullptr || end == text) {
+                return stop("bad vertex");
+            }
+        }
+        m_object->mesh.vertices.push_back(vertex * static_cast<float>(m_unit));
+        ++m_stats.vertices;
+    }
+
+    void add_triangle(const XML_Char** atts)
+    {
+        static constexpr const char* kCorners[] = {"v1", "v2", "v3"};
+        stl_triangle_vertex_indices facet;
+        for (int corner = 0; corner < 3; ++corner) {
+            if (!parse_int(attribute(atts, kCorners[corner]), facet[corner])) {
+                return stop("bad triangle");
+            }
+        }
+        m_object->mesh.indices.push_back(facet);
+        ++m_stats.triangles;
+    }
+
+    // objectid, optional p:path and transform of a component or build item.
+    bool reference(const XML_Char** atts, ObjectKey& object, Slic3r::Transform3d& transform) const
+    {
+        const char* path = attribute(atts, "path");
+        object.first = path != nullptr ? part_name(path) : this->name();
+        if (!parse_int(attribute(atts, "objectid"), object.second)) {
+            return false;
+        }
+        const char* text = attribute(atts, "transform");
+        return text == nullptr || parse_transform(text, m_unit, transform);
+    }
+
+    Package& m_package;
+    LoadStats& m_stats;
+    bool m_root;
+    double m_unit = 1.0;
+    ObjectDef* m_object = nullptr;
+};
+
+// <object id="N"> with <metadata [type="object"] key=".." value=".."/>
+// children; anything under <part> or <volume> belongs to a volume.
+class SettingsPart : public XmlPart {
+public:
+    using XmlPart::XmlPart;
+
+    std::map<int, std::vector<std::pair<std::string, std::string>>> settings;
+
+protected:
+    void start(const char* name, const XML_Char** atts) override
+    {
+        if (std::strcmp(name, "object") == 0) {
+            m_object = parse_int(attribute(atts, "id"), m_id);
+            m_volume_depth = 0;
+        } else if (std::strcmp(name, "part") == 0 || std::strcmp(name, "volume") == 0) {
+            ++m_volume_depth;
+        } else if (m_object && m_volume_depth == 0 && std::strcmp(name, "metadata") == 0) {
+            const char* type = attribute(atts, "type");
+            const char* key = attribute(atts, "key");
+            const char* value = attribute(atts, "value");
+            if (key != nullptr && value != nullptr && (type == nullptr || std::strcmp(type, "object") == 0)) {
+                settings[m_id].emplace_back(key, value);
+            }
+        }
+    }
+
+    void end(const char* name) override
+    {
+        if (std::strcmp(name, "object") == 0) {
+            m_object = false;
+        } else if ((std::strcmp(name, "part") == 0 || std::strcmp(name, "volume") == 0) && m_volume_depth > 0) {
+            --m_volume_depth;
+        }
+    }
+
+private:
+    bool m_object = false;
+    int m_id = 0;
+    int m_volume_depth = 0;
+};
+
+struct Leaf {
+    const ObjectDef* object = nullptr;
+    Slic3r::Transform3d transform;
+};
+
+static bool collect(const Package& package, const ObjectKey& key, const Slic3r::Transform3d& transform, int depth,
+                    std::vector<Leaf>& leaves, std::string& error)
+{
+    const auto it = package.objects.find(key);
+    if (it == package.objects.end()) {
+        error = "object " + std::to_string(key.second) + " not found in " + key.first;
+        return false;
+    }
+    if (depth > kMaxComponentDepth) {
+        error = "components nested too deep (cycle?) at object " + std::to_string(key.second);
+        return false;
+    }
+    if (!it->second.mesh.indices.empty()) {
+        if (leaves.size() == kMaxVolumesPerObject) {
+            error = "too many components under object " + std::to_string(key.second);
+            return false;
+        }
+        leaves.push_back({&it->second, transform});
+    }
+    for (const Component& component : it->second.components) {
+        if (!collect(package, component.object, transform * component.transform, depth + 1, leaves, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Parts referenced by components and not parsed yet.
+static std::vector<std::string> unparsed_parts(const Package& package)
+{
+    std::set<std::string> parts;
+    for (const auto& entry : package.objects) {
+        for (const Component& component : entry.second.components) {
+            if (package.parsed_parts.count(component.object.first) == 0) {
+                parts.insert(component.object.first);
+            }
+        }
+    }
+    for (const Item& item : package.items) {
+        if (package.parsed_parts.count(item.object.first) == 0) {
+            parts.insert(item.object.first);
+        }
+    }
+    return {parts.begin(), parts.end()};
+}
+
+// Object and region options; printer and filament keys stay with the payload.
+static bool is_object_option(const std::string& key)
+{
+    static const std::set<std::string> keys = [] {
+        std::set<std::string> out;
+        for (const std::string& name : Slic3r::PrintObjectConfig().keys()) {
+            out.insert(name);
+        }
+        for (const std::string& name : Slic3r::PrintRegionConfig().keys()) {
+            out.insert(name);
+        }
+        return out;
+    }();
+    return keys.count(key) != 0;
+}
+
+static void apply_settings(Slic3r::ModelObject& object, const std::vector<std::pair<std::string, std::string>>& settings,
+                           LoadStats& stats)
+{
+    Slic3r::ConfigSubstitutionContext substitutions(Slic3r::ForwardCompatibilitySubstitutionRule::Enable);
+    for (const auto& [key, value] : settings) {
+        if (key == "name") {
+            object.name = value;
+            continue;
+        }
+        if (!is_object_option(key)) {
+            continue;
+        }
+        try {
+            object.config.set_deserialize(key, value, substitutions);
+            ++stats.settings;
+        } catch (const std::exception&) {
+            // A value this build cannot parse keeps the payload's setting.
+        }
+    }
+}
+
+static bool build_model(mz_zip_archive& zip, Package& package, const std::string& root, Slic3r::Model& model,
+                        LoadStats& stats, std::string& error)
+{
+    // One parser per part: a finished expat parser cannot take a second document.
+    std::map<int, std::vector<std::pair<std::string, std::string>>> object_settings;
+    for (const char* part : kSettingsParts) {
+        SettingsPart settings(error);
+        if (!settings.parse(zip, part, false)) {
+            return false;
+        }
+        if (!settings.settings.empty()) {
+            object_settings = std::move(settings.settings);
+            break;
+        }
+    }
+
+    std::map<ObjectKey, Slic3r::ModelObject*> created;
+    for (const Item& item : package.items) {
+        Slic3r::ModelObject*& object = created[item.object];
+        if (object == nullptr) {
+            std::vector<Leaf> leaves;
+            if (!collect(package, item.object, Slic3r::Transform3d::Identity(), 0, leaves, error)) {
+                return false;
+            }
+            if (leaves.empty()) {
+                error = "object " + std::to_string(item.object.second) + " has no mesh";
+                return false;
+            }
+            object = model.add_object();
+            object->name = package.objects[item.object].name;
+            if (object->name.empty()) {
+                object->name = "object_" + std::to_string(item.object.second);
+            }
+            for (const Leaf& leaf : leaves) {
+                Slic3r::ModelVolume* volume = object->add_volume(Slic3r::TriangleMesh(leaf.object->mesh));
+                volume->name = leaf.object->name.empty() ? object->name : leaf.object->name;
+                volume->set_transformation(Slic3r::Geometry::Transformation(leaf.transform));
+                ++stats.volumes;
+            }
+            if (item.object.first == root) {
+                const auto it = object_settings.find(item.object.second);
+                if (it != object_settings.end()) {
+                    apply_settings(*object, it->second, stats);
+                }
+            }
+            ++stats.objects;
+        }
+        Slic3r::ModelInstance* instance = object->add_instance();
+        instance->set_transformation(Slic3r::Geometry::Transformation(item.transform));
+        instance->printable = item.printable;
+        ++stats.instances;
+    }
+    return true;
+}
+
+} // namespace
+
+nlohmann::json LoadStats::to_json() const
+{
+    return {
+        {"parts", parts},
+        {"objects", objects},
+        {"volumes", volumes},
+        {"instances", instances},
+        {"vertices", vertices},
+        {"triangles", triangles},
+        {"settings", settings},
+    };
+}
+
+bool is_3mf(const uint8_t* data, size_t len)
+{
+    if (len < 4 || data[0] != 'P' || data[1] != 'K' || data[2] != 3 || data[3] != 4) {
+        return false;
+    }
+    mz_zip_archive zip;
+    mz_zip_zero_struct(&zip);
+    if (!mz_zip_reader_init_mem(&zip, data, len, 0)) {
+        return false;
+    }
+    const bool package = mz_zip_reader_locate_file(&zip, kRelationships, nullptr, 0) >= 0
+                      || mz_zip_reader_locate_file(&zip, kDefaultModelPart, nullptr, 0) >= 0;
+    mz_zip_reader_end(&zip);
+    return package;
+}
+
+bool load_3mf(const uint8_t* data, size_t len, Slic3r::Model& model, LoadStats& stats, std::string& error)
+{
+    mz_zip_archive zip;
+    mz_zip_zero_struct(&zip);
+    if (!mz_zip_reader_init_mem(&zip, data, len, 0)) {
+        error = std::string("not a zip archive: ") + mz_zip_get_error_string(mz_zip_get_last_error(&zip));
+        return false;
+    }
+    const std::unique_ptr<mz_zip_archive, mz_bool (*)(mz_zip_archive*)> close(&zip, &mz_zip_reader_end);
+
+    RelationshipsPart relationships(error);
+    if (!relationships.parse(zip, kRelationships, false)) {
+        return false;
+    }
+    const std::string root = relationships.model_part.empty() ? kDefaultModelPart : relationships.model_part;
+
+    Package package;
+    for (std::vector<std::string> parts = {root}; !parts.empty(); parts = unparsed_parts(package)) {
+        for (const std::string& part : parts) {
+            ModelPart parser(error, package, stats, part == root);
+            package.parsed_parts.insert(part);
+            if (!parser.parse(zip, part, true)) {
+                return false;
+            }
+            ++stats.parts;
+        }
+    }
+    if (package.items.empty()) {
+        error = "no build items in " + root;
+        return false;
+    }
+    return build_model(zip, package, root, model, stats, error);
+}
+
+} // namespace orc::threemf
@@ -0,0 +1,55 @@
+#ifndef ORCA_WASM_ORC_3MF_H
+#define ORCA_WASM_ORC_3MF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+namespace Slic3r {
+class Model;
+}
+
+// 3MF packages straight from the input buffer: miniz reads the zip in place
+// and inflates each model part into the expat-API parser (wasm_shims/expat.h)
+// chunk by chunk, so vertices and triangles are parsed while the part is
+// being decompressed and no temp file or whole-part copy is made.
+//
+//   - The root model part comes from _rels/.rels (3D/3dmodel.model if absent).
+//     Components that point into other parts (the production extension's
+//     p:path, as Bambu Studio and Orca write) load those parts on demand.
+//   - Every build item becomes an instance with the item's transform; items
+//     of the same object share one ModelObject. Component transforms end up
+//     as volume transforms, the model unit is applied to the coordinates.
+//   - Object settings from Metadata/model_settings.config (Orca, Bambu
+//     Studio) or Metadata/Slic3r_PE_model.config (PrusaSlicer) are applied to
+//     the object's config when the key is an object or region option.
+//     Volume settings, plates, colors and project-wide settings are ignored;
+//     the payload carries the print settings.
+namespace orc::threemf {
+
+struct LoadStats {
+    uint64_t parts = 0;
+    uint64_t objects = 0;
+    uint64_t volumes = 0;
+    uint64_t instances = 0;
+    uint64_t vertices = 0;
+    uint64_t triangles = 0;
+    // Object settings applied from the package's metadata.
+    uint64_t settings = 0;
+
+    nlohmann::json to_json() const;
+};
+
+// A zip archive with an OPC package's relationships or a 3D model part;
+// other zips are left to orc::inflate.
+bool is_3mf(const uint8_t* data, size_t len);
+
+// Adds the package's build items to `model`. On failure `error` says why and
+// `model` may hold part of the objects.
+bool load_3mf(const uint8_t* data, size_t len, Slic3r::Model& model, LoadStats& stats, std::string& error);
+
+} // namespace orc::threemf
+
+#endif
@@ -0,0 +1,951 @@
+#include "orc_alloc.h"
+
+#include "orc_arena.h"
+#include "orc_profile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <string_view>
+#include <vector>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#include <emscripten/emmalloc.h>
+#include <emscripten/heap.h>
+extern "C" char __heap_base;
+#elif defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+
+namespace orc::alloc {
+
+#if ORC_BRIDGE_ALLOC_PROFILE != ORC_ALLOC_PROFILE_OFF
+
+// Pointers charged to one budget and not freed yet. It is consulted inside
+// operator new and delete, so it keeps its slots in raw malloc memory and
+// guards each shard with a spinlock. Open addressing with linear probing:
+// slot value 0 is empty and 1 a deleted entry, neither a valid pointer.
+class ChargedSet {
+public:
+    ChargedSet() = default;
+    ~ChargedSet()
+    {
+        for (Shard& shard : m_shards) {
+            std::free(shard.slots);
+        }
+    }
+    ChargedSet(const ChargedSet&) = delete;
+    ChargedSet& operator=(const ChargedSet&) = delete;
+
+    // False when the table cannot grow; the pointer then stays charged.
+    bool insert(const void* ptr)
+    {
+        const uintptr_t key = reinterpret_cast<uintptr_t>(ptr);
+        const uint64_t hash = hash_of(key);
+        Shard& shard = m_shards[hash >> (64 - kShardBits)];
+        Lock lock(shard);
+        if ((shard.used + 1) * 4 > shard.capacity * 3 && !rehash(shard)) {
+            return false;
+        }
+        const size_t mask = shard.capacity - 1;
+        size_t reuse = shard.capacity;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const uintptr_t slot = shard.slots[i];
+            if (slot == key) {
+                return true;
+            }
+            if (slot == kDeleted && reuse == shard.capacity) {
+                reuse = i;
+            } else if (slot == kEmpty) {
+                if (reuse == shard.capacity) {
+                    reuse = i;
+                    ++shard.used;
+                }
+                shard.slots[reuse] = key;
+                ++shard.live;
+                return true;
+            }
+        }
+    }
+
+    // True when `ptr` was charged; it is forgotten either way.
+    bool erase(const void* ptr)
+    {
+        const uintptr_t key = reinterpret_cast<uintptr_t>(ptr);
+        const uint64_t hash = hash_of(key);
+        Shard& shard = m_shards[hash >> (64 - kShardBits)];
+        Lock lock(shard);
+        if (shard.live == 0) {
+            return false;
+        }
+        const size_t mask = shard.capacity - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const uintptr_t slot = shard.slots[i];
+            if (slot == key) {
+                shard.slots[i] = kDeleted;
+                --shard.live;
+                return true;
+            }
+            if (slot == kEmpty) {
+                return false;
+            }
+        }
+    }
+
+private:
+    static constexpr uintptr_t kEmpty = 0;
+    static constexpr uintptr_t kDeleted = 1;
+    static constexpr unsigned kShardBits = 6;
+
+    struct Shard {
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        uintptr_t* slots = nullptr;
+        size_t capacity = 0;
+        // Slots that are not empty, deleted ones included.
+        size_t used = 0;
+        size_t live = 0;
+    };
+
+    class Lock {
+    public:
+        explicit Lock(Shard& shard) : m_shard(shard)
+        {
+            while (m_shard.lock.test_and_set(std::memory_order_acquire)) {
+            }
+        }
+        ~Lock() { m_shard.lock.clear(std::memory_order_release); }
+        Lock(const Lock&) = delete;
+        Lock& operator=(const Lock&) = delete;
+
+    private:
+        Shard& m_shard;
+    };
+
+    static uint64_t hash_of(uintptr_t key) { return (uint64_t(key) >> 3) * 0x9E3779B97F4A7C15ull; }
+
+    // Rebuilds the shard at most half full, dropping deleted slots.
+    static bool rehash(Shard& shard)
+    {
+        size_t capacity = 64;
+        while (capacity < 2 * (shard.live + 1)) {
+            capacity *= 2;
+        }
+        uintptr_t* slots = static_cast<uintptr_t*>(std::calloc(capacity, sizeof(uintptr_t)));
+        if (slots == nullptr) {
+            return false;
+        }
+        for (size_t i = 0; i < shard.capacity; ++i) {
+            const uintptr_t key = shard.slots[i];
+            if (key == kEmpty || key == kDeleted) {
+                continue;
+            }
+            size_t j = hash_of(key) & (capacity - 1);
+            while (slots[j] != kEmpty) {
+                j = (j + 1) & (capacity - 1);
+            }
+            slots[j] = key;
+        }
+        std::free(shard.slots);
+        shard.slots = slots;
+        shard.capacity = capacity;
+        shard.used = shard.live;
+        return true;
+    }
+
+    Shard m_shards[size_t(1) << kShardBits];
+};
+
+#endif // != ORC_ALLOC_PROFILE_OFF
+
+namespace {
+
+static std::atomic<uint64_t> g_allocations{0};
+static std::atomic<uint64_t> g_frees{0};
+static std::atomic<uint64_t> g_bytes_allocated{0};
+static std::atomic<uint64_t> g_failures{0};
+static std::atomic<uint64_t> g_last_failure_bytes{0};
+static std::atomic<uint64_t> g_budget_refusals{0};
+
+// Budget charged for this thread's allocations; nullptr when uncapped.
+static thread_local Budget* t_budget = nullptr;
+
+#if ORC_BRIDGE_ALLOC_PROFILE == ORC_ALLOC_PROFILE_SAMPLING
+
+static constexpr size_t kMaxFrames = 12;
+static constexpr size_t kSiteCapacity = 512;
+static constexpr size_t kLiveCapacity = 4096; // power of two
+static constexpr size_t kLiveMask = kLiveCapacity - 1;
+static constexpr size_t kReportedSites = 64;
+static constexpr uint64_t kSampleInterval = ORC_ALLOC_SAMPLE_INTERVAL;
+
+// Call stack of one sampled allocation. Emscripten only hands out the stack as
+// text, so web builds keep the (filtered) frame lines; native builds keep
+// return addresses and symbolize them when the profile is read.
+struct Stack {
+#ifdef __EMSCRIPTEN__
+    char text[768];
+#else
+    void* frames[kMaxFrames + 4];
+    int depth;
+#endif
+    uint64_t hash;
+};
+
+struct Site {
+    Stack stack;
+    uint64_t samples;
+    uint64_t sampled_bytes;
+    uint64_t estimated_bytes;
+    uint64_t live_samples;
+    uint64_t live_estimated_bytes;
+};
+
+struct LiveSample {
+    void* ptr;
+    uint32_t site;
+    uint64_t weight;
+};
+
+static Site g_sites[kSiteCapacity];
+static size_t g_site_count = 0;
+static uint64_t g_dropped_samples = 0;
+static LiveSample g_live[kLiveCapacity];
+static std::atomic<size_t> g_live_count{0};
+static std::atomic_flag g_lock = ATOMIC_FLAG_INIT;
+
+// Counting filter over the live table: how many tracked pointers hash to each
+// counter. Updated under the lock, read without it, so a free whose counter is
+// zero knows its pointer was never sampled and skips the lock. The sample was
+// published before the pointer left operator new, so its count is visible to
+// whichever thread frees it.
+static constexpr size_t kFilterSize = 1u << 15; // power of two
+static std::atomic<uint16_t> g_live_filter[kFilterSize];
+
+// Bytes left before this thread takes its next sample.
+static thread_local int64_t t_until_sample = static_cast<int64_t>(kSampleInterval);
+// Set while this thread records a sample, so allocations made by the stack
+// walker are not sampled themselves.
+static thread_local bool t_in_sampler = false;
+
+// Sampling runs inside operator new, so it must never allocate while holding
+// the lock; a spinlock keeps it independent of anything that might.
+class SpinLock {
+public:
+    SpinLock()
+    {
+        while (g_lock.test_and_set(std::memory_order_acquire)) {
+        }
+    }
+    ~SpinLock() { g_lock.clear(std::memory_order_release); }
+    SpinLock(const SpinLock&) = delete;
+    SpinLock& operator=(const SpinLock&) = delete;
+};
+
+static uint64_t fnv1a(const void* data, size_t len, uint64_t hash = 14695981039346656037ull)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Frames that belong to the allocator rather than to the code being profiled.
+static bool is_allocator_frame(std::string_view frame)
+{
+    static constexpr std::string_view kMarkers[] = {
+        "orc::alloc", "orc5alloc", "operator new", "_Znwj", "_Znaj", "_Znwm", "_Znam", "emscripten_get_callstack",
+    };
+    for (std::string_view marker : kMarkers) {
+        if (frame.find(marker) != std::string_view::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef __EMSCRIPTEN__
+static void capture_stack(Stack& stack)
+{
+    char raw[4096];
+    const int written = emscripten_get_callstack(EM_LOG_C_STACK | EM_LOG_NO_PATHS, raw, static_cast<int>(sizeof(raw)));
+    raw[written > 0 ? std::min<size_t>(static_cast<size_t>(written), sizeof(raw) - 1) : 0] = '\0';
+
+    // Everything up to the last allocator frame is the sampler itself (and,
+    // depending on the runtime, JS glue); keep the next kMaxFrames lines.
+    const std::string_view all(raw);
+    size_t begin = 0;
+    for (size_t pos = 0; pos < all.size();) {
+        const size_t eol = std::min(all.find('\n', pos), all.size());
+        if (is_allocator_frame(all.substr(pos, eol - pos))) {
+            begin = eol + 1;
+        }
+        pos = eol + 1;
+    }
+
+    size_t out = 0;
+    size_t frames = 0;
+    for (size_t pos = begin; pos < all.size() && frames < kMaxFrames;) {
+        const size_t eol = std::min(all.find('\n', pos), all.size());
+        std::string_view line = all.substr(pos, eol - pos);
+        pos = eol + 1;
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string_view::npos) {
+            continue;
+        }
+        line.remove_prefix(first);
+        if (out + line.size() + 1 >= sizeof(stack.text)) {
+            break;
+        }
+        std::memcpy(stack.text + out, line.data(), line.size());
+        out += line.size();
+        stack.text[out++] = '\n';
+        ++frames;
+    }
+    stack.text[out] = '\0';
+    stack.hash = fnv1a(stack.text, out);
+}
+#else
+__attribute__((noinline)) static void capture_stack(Stack& stack)
+{
+#if defined(__GLIBC__)
+    // Leading sampler frames are dropped when symbolizing; capture a few
+    // extra so kMaxFrames caller frames survive.
+    stack.depth = backtrace(stack.frames, static_cast<int>(std::size(stack.frames)));
+#else
+    stack.depth = 0;
+#endif
+    stack.hash = fnv1a(stack.frames, sizeof(void*) * static_cast<size_t>(std::max(stack.depth, 0)));
+}
+#endif
+
+static size_t live_slot(const void* ptr)
+{
+    return static_cast<size_t>((reinterpret_cast<uintptr_t>(ptr) >> 4) * 0x9E3779B97F4A7C15ull) & kLiveMask;
+}
+
+// Uses the high bits of the product, so it is independent of live_slot.
+static std::atomic<uint16_t>& live_filter(const void* ptr)
+{
+    const uint64_t mixed = (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)) >> 4) * 0x9E3779B97F4A7C15ull;
+    return g_live_filter[static_cast<size_t>(mixed >> 49) & (kFilterSize - 1)];
+}
+
+// Caller holds the lock. Returns false when the table is too full to track
+// another pointer; the sample still counts towards its site's totals.
+static bool insert_live(void* ptr, uint32_t site, uint64_t weight)
+{
+    if (g_live_count.load(std::memory_order_relaxed) >= kLiveCapacity - kLiveCapacity / 4) {
+        return false;
+    }
+    for (size_t idx = live_slot(ptr);; idx = (idx + 1) & kLiveMask) {
+        if (g_live[idx].ptr == nullptr) {
+            g_live[idx] = LiveSample{ptr, site, weight};
+            g_live_count.fetch_add(1, std::memory_order_relaxed);
+            live_filter(ptr).fetch_add(1, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+// Caller holds the lock. Linear probing with backward-shift deletion, so no
+// tombstones accumulate over long-running workers.
+static void erase_live(void* ptr)
+{
+    size_t idx = live_slot(ptr);
+    while (g_live[idx].ptr != ptr) {
+        if (g_live[idx].ptr == nullptr) {
+            return;
+        }
+        idx = (idx + 1) & kLiveMask;
+    }
+    Site& site = g_sites[g_live[idx].site];
+    site.live_samples -= 1;
+    site.live_estimated_bytes -= g_live[idx].weight;
+    live_filter(ptr).fetch_sub(1, std::memory_order_relaxed);
+
+    size_t hole = idx;
+    for (size_t next = (hole + 1) & kLiveMask; g_live[next].ptr != nullptr; next = (next + 1) & kLiveMask) {
+        const size_t home = live_slot(g_live[next].ptr);
+        const bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!stays) {
+            g_live[hole] = g_live[next];
+            hole = next;
+        }
+    }
+    g_live[hole] = LiveSample{};
+    g_live_count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+static void maybe_sample(void* ptr, size_t size)
+{
+    t_until_sample -= static_cast<int64_t>(size);
+    if (t_until_sample > 0 || t_in_sampler) {
+        return;
+    }
+    // Every sample stands for the whole interval(s) it closes, which keeps the
+    // estimate unbiased for both small and huge allocations.
+    const uint64_t intervals = 1 + static_cast<uint64_t>(-t_until_sample) / kSampleInterval;
+    const uint64_t weight = intervals * kSampleInterval;
+    t_until_sample += static_cast<int64_t>(weight);
+
+    t_in_sampler = true;
+    Stack stack;
+    capture_stack(stack);
+    {
+        SpinLock lock;
+        size_t index = 0;
+        while (index < g_site_count && g_sites[index].stack.hash != stack.hash) {
+            ++index;
+        }
+        if (index == g_site_count) {
+            if (g_site_count == kSiteCapacity) {
+                ++g_dropped_samples;
+                t_in_sampler = false;
+                return;
+            }
+            g_sites[index] = Site{};
+            g_sites[index].stack = stack;
+            ++g_site_count;
+        }
+        Site& site = g_sites[index];
+        site.samples += 1;
+        site.sampled_bytes += size;
+        site.estimated_bytes += weight;
+        if (insert_live(ptr, static_cast<uint32_t>(index), weight)) {
+            site.live_samples += 1;
+            site.live_estimated_bytes += weight;
+        } else {
+            ++g_dropped_samples;
+        }
+    }
+    t_in_sampler = false;
+}
+
+static void forget_sample(void* ptr)
+{
+    if (live_filter(ptr).load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    SpinLock lock;
+    erase_live(ptr);
+}
+
+static nlohmann::json site_frames(const Stack& stack)
+{
+    nlohmann::json frames = nlohmann::json::array();
+#ifdef __EMSCRIPTEN__
+    std::string_view text(stack.text);
+    while (!text.empty()) {
+        const size_t eol = text.find('\n');
+        frames.push_back(std::string(text.substr(0, eol)));
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+    }
+#elif defined(__GLIBC__)
+    char** symbols = backtrace_symbols(stack.frames, stack.depth);
+    // Frames up to operator new belong to the sampler; anonymous helpers have
+    // no symbol, so skip to just past the last allocator frame.
+    int begin = 0;
+    for (int i = 0; symbols != nullptr && i < stack.depth; ++i) {
+        if (is_allocator_frame(symbols[i])) {
+            begin = i + 1;
+        }
+    }
+    for (int i = begin; i < stack.depth && frames.size() < kMaxFrames; ++i) {
+        if (symbols != nullptr) {
+            frames.push_back(symbols[i]);
+        } else {
+            char address[32];
+            std::snprintf(address, sizeof(address), "%p", stack.frames[i]);
+            frames.push_back(address);
+        }
+    }
+    std::free(symbols);
+#else
+    (void)stack;
+#endif
+    return frames;
+}
+
+#endif // ORC_ALLOC_PROFILE_SAMPLING
+
+#if ORC_BRIDGE_ALLOC_PROFILE != ORC_ALLOC_PROFILE_OFF
+
+// Printed when an allocation fails, which on emmalloc usually means the heap
+// hit MAXIMUM_MEMORY or is too fragmented for one contiguous block.
+static void report_failure(std::size_t size, std::size_t alignment, const char* kind)
+{
+    g_failures.fetch_add(1, std::memory_order_relaxed);
+    g_last_failure_bytes.store(size, std::memory_order_relaxed);
+    std::fprintf(stderr,
+        "[orc_alloc] %s failed size=%zu align=%zu live=%zu allocations=%" PRIu64 " frees=%" PRIu64 "\n",
+        kind,
+        size,
+        alignment,
+        profile::heap_in_use(),
+        g_allocations.load(std::memory_order_relaxed),
+        g_frees.load(std::memory_order_relaxed));
+#ifdef __EMSCRIPTEN__
+    const intptr_t heap_base = reinterpret_cast<intptr_t>(&__heap_base);
+    const intptr_t heap_break = reinterpret_cast<intptr_t>(sbrk(0));
+    std::fprintf(stderr,
+        "[orc_alloc] heap=%zu span=%zu\n",
+        static_cast<size_t>(emscripten_get_heap_size()),
+        heap_break > heap_base ? static_cast<size_t>(heap_break - heap_base) : size_t{0});
+    char stack_buffer[4096] = {0};
+    const int written = emscripten_get_callstack(EM_LOG_C_STACK | EM_LOG_JS_STACK, stack_buffer, static_cast<int>(sizeof(stack_buffer)));
+    if (written > 0) {
+        stack_buffer[sizeof(stack_buffer) - 1] = '\0';
+        std::fprintf(stderr, "[orc_alloc] callstack (failure):\n%s\n", stack_buffer);
+    }
+#elif defined(__GLIBC__)
+    void* frames[32];
+    backtrace_symbols_fd(frames, backtrace(frames, 32), fileno(stderr));
+#endif
+#if ORC_BRIDGE_ALLOC_PROFILE == ORC_ALLOC_PROFILE_SAMPLING
+    {
+        // Heaviest live sites, without allocating: the heap is exhausted.
+        SpinLock lock;
+        size_t order[8];
+        size_t shown = 0;
+        const auto live = [](size_t index) { return g_sites[index].live_estimated_bytes; };
+        for (size_t i = 0; i < g_site_count; ++i) {
+            if (shown < std::size(order)) {
+                order[shown++] = i;
+            } else if (live(i) > live(order[shown - 1])) {
+                order[shown - 1] = i;
+            } else {
+                continue;
+            }
+            for (size_t pos = shown - 1; pos > 0 && live(order[pos - 1]) < live(order[pos]); --pos) {
+                std::swap(order[pos - 1], order[pos]);
+            }
+        }
+        for (size_t i = 0; i < shown; ++i) {
+            const Site& site = g_sites[order[i]];
+            std::fprintf(stderr,
+                "[orc_alloc] live site #%zu ~%" PRIu64 " bytes in %" PRIu64 " samples\n",
+                i,
+                site.live_estimated_bytes,
+                site.live_samples);
+#ifdef __EMSCRIPTEN__
+            std::fprintf(stderr, "%s", site.stack.text);
+#elif defined(__GLIBC__)
+            std::fflush(stderr);
+            backtrace_symbols_fd(site.stack.frames, site.stack.depth, fileno(stderr));
+#endif
+        }
+    }
+#endif
+    std::fflush(stderr);
+}
+
+static size_t usable_size(void* ptr)
+{
+    return arena::owns(ptr) ? arena::usable_size(ptr) : malloc_usable_size(ptr);
+}
+
+// Charges `size` to `budget`, or refuses it and returns false. Only the first
+// refusal of a scope is printed; ~BudgetScope reports the total.
+static bool charge(Budget& budget, std::size_t size, const char* kind)
+{
+    const int64_t live = budget.live.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) +
+                         static_cast<int64_t>(size);
+    if (live > static_cast<int64_t>(budget.limit)) {
+        budget.live.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+        g_budget_refusals.fetch_add(1, std::memory_order_relaxed);
+        if (budget.refusals.fetch_add(1, std::memory_order_relaxed) == 0) {
+            std::fprintf(stderr, "[orc_alloc] %s of %zu bytes refused: memory budget %zu bytes, live %" PRId64 "\n",
+                kind, size, budget.limit, live - static_cast<int64_t>(size));
+        }
+        return false;
+    }
+    int64_t peak = budget.peak.load(std::memory_order_relaxed);
+    while (live > peak && !budget.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+static void release(void* ptr)
+{
+    if (arena::owns(ptr)) {
+        arena::deallocate(ptr);
+        return;
+    }
+    std::free(ptr);
+}
+
+static void* allocate(std::size_t size, std::size_t alignment, bool nothrow, const char* kind)
+{
+    Budget* budget = t_budget;
+    if (budget != nullptr && !charge(*budget, size, kind)) {
+        errno = ENOMEM;
+        if (!nothrow) {
+            throw std::bad_alloc();
+        }
+        return nullptr;
+    }
+    // Arena slots are 16-byte aligned, which covers every fundamental type.
+    void* ptr = alignment <= 16 ? arena::allocate(size) : nullptr;
+    if (ptr == nullptr) {
+        ptr = alignment > 0 ? memalign(alignment, size) : std::malloc(size);
+    }
+    if (ptr == nullptr) {
+        if (budget != nullptr) {
+            budget->live.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+        }
+        report_failure(size, alignment, kind);
+        errno = ENOMEM;
+        if (!nothrow) {
+            throw std::bad_alloc();
+        }
+        return nullptr;
+    }
+    const size_t usable = usable_size(ptr);
+    if (budget != nullptr) {
+        // Frees credit the usable size, so the slack counts against the limit
+        // too.
+        if (usable > size && !charge(*budget, usable - size, kind)) {
+            budget->live.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+            release(ptr);
+            errno = ENOMEM;
+            if (!nothrow) {
+                throw std::bad_alloc();
+            }
+            return nullptr;
+        }
+        // Untracked, the bytes stay charged until the scope closes: the
+        // budget overstates, never understates, what the slice holds.
+        if (budget->charged != nullptr) {
+            budget->charged->insert(ptr);
+        }
+    }
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes_allocated.fetch_add(usable, std::memory_order_relaxed);
+    profile::note_alloc(usable);
+#if ORC_BRIDGE_ALLOC_PROFILE == ORC_ALLOC_PROFILE_SAMPLING
+    maybe_sample(ptr, usable);
+#endif
+    return ptr;
+}
+
+static void deallocate(void* ptr) noexcept
+{
+    if (ptr == nullptr) {
+        return;
+    }
+#if ORC_BRIDGE_ALLOC_PROFILE == ORC_ALLOC_PROFILE_SAMPLING
+    forget_sample(ptr);
+#endif
+    g_frees.fetch_add(1, std::memory_order_relaxed);
+    const size_t usable = usable_size(ptr);
+    Budget* budget = t_budget;
+    if (budget != nullptr && budget->charged != nullptr && budget->charged->erase(ptr)) {
+        budget->live.fetch_sub(static_cast<int64_t>(usable), std::memory_order_relaxed);
+    }
+    profile::note_free(usable);
+    release(ptr);
+}
+
+#endif // != ORC_ALLOC_PROFILE_OFF
+
+} // namespace
+
+const char* mode_name()
+{
+#if ORC_BRIDGE_ALLOC_PROFILE == ORC_ALLOC_PROFILE_SAMPLING
+    return "sampling";
+#elif ORC_BRIDGE_ALLOC_PROFILE == ORC_ALLOC_PROFILE_WATERMARK
+    return "watermark";
+#else
+    return "off";
+#endif
+}
+
+nlohmann::json to_json()
+{
+    using json = nlohmann::json;
+    json result = {
+        {"version", 1},
+        {"mode", mode_name()},
+    };
+#if ORC_BRIDGE_ALLOC_PROFILE != ORC_ALLOC_PROFILE_OFF
+    result["allocations"] = g_allocations.load(std::memory_order_relaxed);
+    result["frees"] = g_frees.load(std::memory_order_relaxed);
+    result["bytesAllocated"] = g_bytes_allocated.load(std::memory_order_relaxed);
+    result["liveBytes"] = profile::heap_in_use();
+    result["peakBytes"] = profile::peek_watermark(profile::Watermark::Process);
+    result["failures"] = g_failures.load(std::memory_order_relaxed);
+    result["lastFailureBytes"] = g_last_failure_bytes.load(std::memory_order_relaxed);
+    result["budgetRefusals"] = g_budget_refusals.load(std::memory_order_relaxed);
+#endif
+#if ORC_BRIDGE_ALLOC_PROFILE == ORC_ALLOC_PROFILE_SAMPLING
+    // Copy the table out first: allocating while holding the lock would
+    // deadlock against the sampler.
+    std::vector<Site> sites(kSiteCapacity);
+    size_t site_count = 0;
+    uint64_t dropped = 0;
+    {
+        SpinLock lock;
+        site_count = g_site_count;
+        dropped = g_dropped_samples;
+        std::copy(g_sites, g_sites + site_count, sites.begin());
+    }
+    sites.resize(site_count);
+    std::sort(sites.begin(), sites.end(), [](const Site& lhs, const Site& rhs) {
+        return lhs.estimated_bytes > rhs.estimated_bytes;
+    });
+
+    json reported = json::array();
+    for (size_t i = 0; i < sites.size() && i < kReportedSites; ++i) {
+        const Site& site = sites[i];
+        reported.push_back({
+            {"frames", site_frames(site.stack)},
+            {"samples", site.samples},
+            {"sampledBytes", site.sampled_bytes},
+            {"estimatedBytes", site.estimated_bytes},
+            {"liveSamples", site.live_samples},
+            {"liveEstimatedBytes", site.live_estimated_bytes},
+        });
+    }
+    result["sampleIntervalBytes"] = kSampleInterval;
+    result["samples"] = {
+        {"sites", site_count},
+        {"live", g_live_count.load(std::memory_order_relaxed)},
+        {"dropped", dropped},
+    };
+    result["sites"] = std::move(reported);
+#endif
+    return result;
+}
+
+void reset()
+{
+#if ORC_BRIDGE_ALLOC_PROFILE != ORC_ALLOC_PROFILE_OFF
+    g_allocations.store(0, std::memory_order_relaxed);
+    g_frees.store(0, std::memory_order_relaxed);
+    g_bytes_allocated.store(0, std::memory_order_relaxed);
+    g_failures.store(0, std::memory_order_relaxed);
+    g_last_failure_bytes.store(0, std::memory_order_relaxed);
+    g_budget_refusals.store(0, std::memory_order_relaxed);
+    profile::reset_watermark(profile::Watermark::Process);
+#endif
+#if ORC_BRIDGE_ALLOC_PROFILE == ORC_ALLOC_PROFILE_SAMPLING
+    SpinLock lock;
+    g_site_count = 0;
+    g_dropped_samples = 0;
+    std::fill(std::begin(g_live), std::end(g_live), LiveSample{});
+    g_live_count.store(0, std::memory_order_relaxed);
+    for (std::atomic<uint16_t>& count : g_live_filter) {
+        count.store(0, std::memory_order_relaxed);
+    }
+#endif
+}
+
+BudgetScope::BudgetScope(size_t bytes) : m_previous(t_budget)
+{
+    m_budget.limit = bytes;
+#if ORC_BRIDGE_ALLOC_PROFILE != ORC_ALLOC_PROFILE_OFF
+    if (bytes != 0) {
+        // Raw malloc: the set must not be charged to the budget it tracks.
+        if (void* storage = std::malloc(sizeof(ChargedSet))) {
+            m_budget.charged = new (storage) ChargedSet();
+        }
+    }
+#endif
+    t_budget = bytes != 0 ? &m_budget : nullptr;
+}
+
+BudgetScope::~BudgetScope()
+{
+    t_budget = m_previous;
+#if ORC_BRIDGE_ALLOC_PROFILE != ORC_ALLOC_PROFILE_OFF
+    if (m_budget.charged != nullptr) {
+        m_budget.charged->~ChargedSet();
+        std::free(m_budget.charged);
+    }
+#endif
+    const uint64_t refused = refusals();
+    if (refused > 1) {
+        std::fprintf(stderr, "[orc_alloc] memory budget %zu bytes: %" PRIu64 " allocations refused\n", m_budget.limit,
+            refused);
+    }
+}
+
+size_t BudgetScope::peak_bytes() const
+{
+    return static_cast<size_t>(std::max<int64_t>(m_budget.peak.load(std::memory_order_relaxed), 0));
+}
+
+Budget* current_budget()
+{
+    return t_budget;
+}
+
+Budget* exchange_budget(Budget* budget)
+{
+    Budget* previous = t_budget;
+    t_budget = budget;
+    return previous;
+}
+
+uint64_t budget_refusals()
+{
+    return g_budget_refusals.load(std::memory_order_relaxed);
+}
+
+nlohmann::json trim_heap()
+{
+    using json = nlohmann::json;
+#ifdef __EMSCRIPTEN__
+    // WebAssembly memory never shrinks; trimming lowers the sbrk break so the
+    // top of the heap becomes unclaimed space that any size can reuse.
+    const bool trimmed = emmalloc_trim(0) != 0;
+    size_t buckets[32] = {};
+    emmalloc_compute_free_dynamic_memory_fragmentation_map(buckets);
+    // Bucket i counts free blocks of [2^i, 2^(i+1)) bytes, so the largest free
+    // block is known to within a factor of two.
+    size_t largest_free = 0;
+    for (size_t i = 32; i-- > 0;) {
+        if (buckets[i] != 0) {
+            largest_free = size_t{1} << i;
+            break;
+        }
+    }
+    const size_t free_bytes = emmalloc_free_dynamic_memory();
+    const size_t unclaimed = emmalloc_unclaimed_heap_memory();
+    json result = {
+        {"allocator", "emmalloc"},
+        {"trimmed", trimmed},
+        {"heapBytes", static_cast<size_t>(emscripten_get_heap_size())},
+        {"dynamicHeapBytes", emmalloc_dynamic_heap_size()},
+        {"freeBytes", free_bytes},
+        {"unclaimedBytes", unclaimed},
+        {"largestFreeBlockBytes", std::max(largest_free, unclaimed)},
+    };
+    const size_t reusable = free_bytes + unclaimed;
+    result["fragmentation"] = reusable > 0 ? 1.0 - static_cast<double>(std::max(largest_free, unclaimed)) / static_cast<double>(reusable) : 0.0;
+    return result;
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const bool trimmed = malloc_trim(0) != 0;
+    const struct mallinfo2 info = mallinfo2();
+    // glibc does not expose its largest free chunk; the top chunk is the one
+    // contiguous block it can report.
+    json result = {
+        {"allocator", "glibc"},
+        {"trimmed", trimmed},
+        {"heapBytes", info.arena + info.hblkhd},
+        {"freeBytes", info.fordblks},
+        {"largestFreeBlockBytes", info.keepcost},
+    };
+    result["fragmentation"] = info.fordblks > 0 ? 1.0 - static_cast<double>(info.keepcost) / static_cast<double>(info.fordblks) : 0.0;
+    return result;
+#else
+    return json{{"allocator", "unknown"}, {"trimmed", false}};
+#endif
+}
+
+} // namespace orc::alloc
+
+#if ORC_BRIDGE_ALLOC_PROFILE != ORC_ALLOC_PROFILE_OFF
+
+void* operator new(std::size_t size)
+{
+    return orc::alloc::allocate(size, 0, false, "operator new");
+}
+
+void* operator new[](std::size_t size)
+{
+    return orc::alloc::allocate(size, 0, false, "operator new[]");
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return orc::alloc::allocate(size, 0, true, "operator new (nothrow)");
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return orc::alloc::allocate(size, 0, true, "operator new[] (nothrow)");
+}
+
+#if defined(__cpp_aligned_new)
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return orc::alloc::allocate(size, static_cast<std::size_t>(alignment), false, "operator new aligned");
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return orc::alloc::allocate(size, static_cast<std::size_t>(alignment), false, "operator new[] aligned");
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return orc::alloc::allocate(size, static_cast<std::size_t>(alignment), true, "operator new aligned (nothrow)");
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return orc::alloc::allocate(size, static_cast<std::size_t>(alignment), true, "operator new[] aligned (nothrow)");
+}
+#endif
+
+void operator delete(void* ptr) noexcept
+{
+    orc::alloc::deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    orc::alloc::deallocate(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    orc::alloc::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    orc::alloc::deallocate(ptr);
+}
+#endif
+
+#if defined(__cpp_aligned_new)
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    orc::alloc::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    orc::alloc::deallocate(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    orc::alloc::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    orc::alloc::deallocate(ptr);
+}
+#endif
+#endif // __cpp_aligned_new
+
+#endif // != ORC_ALLOC_PROFILE_OFF
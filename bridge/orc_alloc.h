@@ -0,0 +1,104 @@
+#ifndef ORCA_WASM_ORC_ALLOC_H
+#define ORCA_WASM_ORC_ALLOC_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <nlohmann/json.hpp>
+
+// Allocation profiler behind the global operator new/delete overrides. The
+// mode is fixed at compile time (ORC_BRIDGE_ALLOC_PROFILE in CMake):
+//
+//   off       - no overrides at all; operator new is the C++ runtime's.
+//   watermark - every allocation feeds the orc_profile heap counters, so each
+//               phase, step and stage gets a high-water mark. No per-pointer
+//               state.
+//   sampling  - watermark, plus one sampled allocation every
+//               ORC_ALLOC_SAMPLE_INTERVAL bytes with its call stack. Sampled
+//               pointers are tracked until freed, so the profile shows both
+//               where memory was allocated and what is still live.
+#define ORC_ALLOC_PROFILE_OFF 0
+#define ORC_ALLOC_PROFILE_WATERMARK 1
+#define ORC_ALLOC_PROFILE_SAMPLING 2
+
+#ifndef ORC_BRIDGE_ALLOC_PROFILE
+#define ORC_BRIDGE_ALLOC_PROFILE ORC_ALLOC_PROFILE_WATERMARK
+#endif
+
+#ifndef ORC_ALLOC_SAMPLE_INTERVAL
+#define ORC_ALLOC_SAMPLE_INTERVAL (512u * 1024u)
+#endif
+
+namespace orc::alloc {
+
+const char* mode_name();
+
+// Process-wide allocation counters and, in sampling mode, the heaviest call
+// sites by estimated bytes. Safe to call while other threads allocate.
+nlohmann::json to_json();
+
+// Restarts counters, the peak and the site table. Samples of allocations that
+// are still live are forgotten as well.
+void reset();
+
+class ChargedSet;
+
+// What one BudgetScope has been charged: the usable size of every allocation
+// made under it, less those of them freed again. `charged` holds the pointers
+// still live, so freeing memory the scope never paid for (allocated before it
+// opened, or under another scope) credits nothing.
+struct Budget {
+    size_t limit = 0;
+    std::atomic<int64_t> live{0};
+    std::atomic<int64_t> peak{0};
+    std::atomic<uint64_t> refusals{0};
+    ChargedSet* charged = nullptr;
+};
+
+// False when the operator new hooks are compiled out (ORC_BRIDGE_ALLOC_PROFILE
+// off): a BudgetScope then caps nothing, so callers must refuse budgets.
+constexpr bool kBudgetsEnforced = ORC_BRIDGE_ALLOC_PROFILE != ORC_ALLOC_PROFILE_OFF;
+
+// Caps what a slice allocates while in scope: an allocation that would take the
+// scope's live bytes past `bytes` fails as if the heap were exhausted, so a
+// slice stops with bad_alloc at a known size instead of at MAXIMUM_MEMORY.
+// Allocations are charged to the scope installed on the allocating thread and
+// credited back when a thread under the same scope frees them; the opening
+// thread has it and TBB workers take it over inside an orc::workers::TaskArena. Sessions
+// slicing at once therefore do not charge each other. 0 leaves the thread
+// uncapped; scopes nest and the innermost one is charged.
+class BudgetScope {
+public:
+    explicit BudgetScope(size_t bytes);
+    ~BudgetScope();
+    BudgetScope(const BudgetScope&) = delete;
+    BudgetScope& operator=(const BudgetScope&) = delete;
+
+    uint64_t refusals() const { return m_budget.refusals.load(std::memory_order_relaxed); }
+    // Highest live byte count charged to this scope.
+    size_t peak_bytes() const;
+
+private:
+    Budget m_budget;
+    Budget* m_previous;
+};
+
+// The calling thread's innermost budget, nullptr when uncapped.
+Budget* current_budget();
+
+// Installs `budget` on the calling thread and returns the one it replaces;
+// how a worker thread joins a slice's budget and leaves it again.
+Budget* exchange_budget(Budget* budget);
+
+// Allocations refused by any BudgetScope since the last reset().
+uint64_t budget_refusals();
+
+// Returns free memory at the top of the heap to the allocator's unclaimed
+// pool (emmalloc_trim) or the OS (malloc_trim), then reports heap size, free
+// bytes and the largest free block. Works in every profiler mode.
+nlohmann::json trim_heap();
+
+} // namespace orc::alloc
+
+#endif
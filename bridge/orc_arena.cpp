@@ -0,0 +1,340 @@
+#include "orc_arena.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include <malloc.h>
+
+namespace orc::arena {
+
+namespace {
+
+// Size classes grow by roughly 25% per step, which bounds internal waste.
+static constexpr std::array<uint32_t, 32> kClassSizes = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096, 5120, 6144, 7168, 8192,
+};
+static constexpr size_t kClassCount = kClassSizes.size();
+static_assert(kClassSizes.back() == kMaxSmallSize);
+
+// Class index for every size in 16-byte steps, built at compile time so the
+// lookup is usable from operator new before any static constructor ran.
+static constexpr auto kClassBySixteenth = [] {
+    std::array<uint8_t, kMaxSmallSize / 16 + 1> table{};
+    size_t cls = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+        while (kClassSizes[cls] < i * 16) {
+            ++cls;
+        }
+        table[i] = static_cast<uint8_t>(cls);
+    }
+    return table;
+}();
+
+struct Page {
+    Page* prev;
+    Page* next;
+    void* free_list;
+    uint32_t size_class;
+    uint32_t slot_size;
+    uint32_t capacity;
+    uint32_t bump;
+    uint32_t live;
+};
+
+static constexpr size_t kHeaderSize = (sizeof(Page) + 15) & ~size_t{15};
+static constexpr uintptr_t kPageMask = ~static_cast<uintptr_t>(kPageSize - 1);
+
+// Page ownership bitmap, one bit per 64 KiB of address space. wasm32 needs a
+// single 8 KiB leaf; wasm64 (at most 16 GiB of linear memory) four of them;
+// other 64-bit hosts get a lazily filled top level covering 48 bits.
+static constexpr unsigned kPageShift = 16;
+static constexpr unsigned kLeafBits = 16;
+#if UINTPTR_MAX == 0xFFFFFFFFu
+static constexpr unsigned kAddressBits = 32;
+#elif defined(__wasm64__)
+static constexpr unsigned kAddressBits = 34;
+#else
+static constexpr unsigned kAddressBits = 48;
+#endif
+static constexpr size_t kLeafWords = (size_t{1} << kLeafBits) / 64;
+static constexpr size_t kTopEntries = size_t{1} << (kAddressBits - kPageShift - kLeafBits);
+static std::atomic<std::atomic<uint64_t>*> g_page_bits[kTopEntries];
+
+// One lock and partial-page list per size class, each on its own cache line,
+// so threads allocating different sizes never wait on each other.
+struct alignas(64) SizeClass {
+    std::atomic<bool> locked{false};
+    // Pages of this class with a free slot.
+    Page* partial = nullptr;
+};
+
+static SizeClass g_classes[kClassCount];
+static std::atomic<size_t> g_pages{0};
+static std::atomic<size_t> g_live_bytes{0};
+static std::atomic<size_t> g_released_pages{0};
+static std::atomic<size_t> g_retained_pages{0};
+static std::atomic<uint64_t> g_scopes{0};
+// Scopes open on any thread; pages are released when the last one closes.
+static std::atomic<int> g_open{0};
+// Scopes routing this thread's allocations, its own or, on a TBB worker, the
+// ones of the slice whose tasks it runs.
+static thread_local int t_depth = 0;
+
+class SpinLock {
+public:
+    explicit SpinLock(SizeClass& cls) : m_cls(cls)
+    {
+        while (m_cls.locked.exchange(true, std::memory_order_acquire)) {
+        }
+    }
+    ~SpinLock() { m_cls.locked.store(false, std::memory_order_release); }
+    SpinLock(const SpinLock&) = delete;
+    SpinLock& operator=(const SpinLock&) = delete;
+
+private:
+    SizeClass& m_cls;
+};
+
+static std::atomic<uint64_t>* leaf_for(uintptr_t page_number, bool create)
+{
+    const size_t top = static_cast<size_t>(page_number >> kLeafBits);
+    if (top >= kTopEntries) {
+        return nullptr;
+    }
+    std::atomic<uint64_t>* leaf = g_page_bits[top].load(std::memory_order_acquire);
+    if (leaf == nullptr && create) {
+        // calloc, not new: this runs inside operator new.
+        auto* fresh = static_cast<std::atomic<uint64_t>*>(std::calloc(kLeafWords, sizeof(uint64_t)));
+        if (fresh == nullptr) {
+            return nullptr;
+        }
+        // Two size classes may need the same leaf at once; the loser frees its
+        // copy and uses the winner's.
+        if (g_page_bits[top].compare_exchange_strong(leaf, fresh, std::memory_order_acq_rel)) {
+            leaf = fresh;
+        } else {
+            std::free(fresh);
+        }
+    }
+    return leaf;
+}
+
+static bool mark_page(const Page* page, bool owned)
+{
+    const uintptr_t number = reinterpret_cast<uintptr_t>(page) >> kPageShift;
+    std::atomic<uint64_t>* leaf = leaf_for(number, owned);
+    if (leaf == nullptr) {
+        return false;
+    }
+    const size_t bit = static_cast<size_t>(number & ((uintptr_t{1} << kLeafBits) - 1));
+    const uint64_t mask = uint64_t{1} << (bit % 64);
+    if (owned) {
+        leaf[bit / 64].fetch_or(mask, std::memory_order_relaxed);
+    } else {
+        leaf[bit / 64].fetch_and(~mask, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// Caller holds the page's class lock, as for unlink().
+static void link_front(Page* page)
+{
+    Page*& head = g_classes[page->size_class].partial;
+    page->prev = nullptr;
+    page->next = head;
+    if (head != nullptr) {
+        head->prev = page;
+    }
+    head = page;
+}
+
+static void unlink(Page* page)
+{
+    if (page->prev != nullptr) {
+        page->prev->next = page->next;
+    } else {
+        g_classes[page->size_class].partial = page->next;
+    }
+    if (page->next != nullptr) {
+        page->next->prev = page->prev;
+    }
+    page->prev = page->next = nullptr;
+}
+
+// Caller holds the class lock.
+static Page* new_page(size_t cls)
+{
+    void* memory = memalign(kPageSize, kPageSize);
+    if (memory == nullptr) {
+        return nullptr;
+    }
+    Page* page = static_cast<Page*>(memory);
+    if (!mark_page(page, true)) {
+        std::free(memory);
+        return nullptr;
+    }
+    *page = Page{};
+    page->size_class = static_cast<uint32_t>(cls);
+    page->slot_size = kClassSizes[cls];
+    page->capacity = static_cast<uint32_t>((kPageSize - kHeaderSize) / page->slot_size);
+    g_pages.fetch_add(1, std::memory_order_relaxed);
+    link_front(page);
+    return page;
+}
+
+// Caller holds the class lock; `page` is empty and already unlinked.
+static void release_page(Page* page)
+{
+    mark_page(page, false);
+    g_pages.fetch_sub(1, std::memory_order_relaxed);
+    std::free(page);
+}
+
+static Page* page_of(const void* ptr)
+{
+    return reinterpret_cast<Page*>(reinterpret_cast<uintptr_t>(ptr) & kPageMask);
+}
+
+} // namespace
+
+Scope::Scope(bool enabled) : m_enabled(enabled)
+{
+    if (m_enabled) {
+        ++t_depth;
+        g_open.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+Scope::~Scope()
+{
+    if (!m_enabled) {
+        return;
+    }
+    --t_depth;
+    if (g_open.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    size_t released = 0;
+    for (SizeClass& cls : g_classes) {
+        SpinLock lock(cls);
+        if (g_open.load(std::memory_order_relaxed) != 0) {
+            return; // another slice opened a scope meanwhile; it will release
+        }
+        for (Page* page = cls.partial; page != nullptr;) {
+            Page* next = page->next;
+            if (page->live == 0) {
+                unlink(page);
+                release_page(page);
+                ++released;
+            }
+            page = next;
+        }
+    }
+    g_scopes.fetch_add(1, std::memory_order_relaxed);
+    g_released_pages.store(released, std::memory_order_relaxed);
+    g_retained_pages.store(g_pages.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+int thread_depth()
+{
+    return t_depth;
+}
+
+int exchange_thread_depth(int depth)
+{
+    const int previous = t_depth;
+    t_depth = depth;
+    return previous;
+}
+
+void* allocate(size_t size)
+{
+    if (size > kMaxSmallSize || t_depth == 0) {
+        return nullptr;
+    }
+    const size_t index = kClassBySixteenth[(size + 15) / 16];
+    SizeClass& cls = g_classes[index];
+    SpinLock lock(cls);
+    Page* page = cls.partial;
+    if (page == nullptr && (page = new_page(index)) == nullptr) {
+        return nullptr;
+    }
+    void* slot;
+    if (page->free_list != nullptr) {
+        slot = page->free_list;
+        page->free_list = *static_cast<void**>(slot);
+    } else {
+        slot = reinterpret_cast<char*>(page) + kHeaderSize + size_t{page->bump} * page->slot_size;
+        ++page->bump;
+    }
+    ++page->live;
+    g_live_bytes.fetch_add(page->slot_size, std::memory_order_relaxed);
+    if (page->live == page->capacity) {
+        unlink(page);
+    }
+    return slot;
+}
+
+bool owns(const void* ptr)
+{
+    const uintptr_t number = reinterpret_cast<uintptr_t>(ptr) >> kPageShift;
+    const std::atomic<uint64_t>* leaf = leaf_for(number, false);
+    if (leaf == nullptr) {
+        return false;
+    }
+    const size_t bit = static_cast<size_t>(number & ((uintptr_t{1} << kLeafBits) - 1));
+    return (leaf[bit / 64].load(std::memory_order_relaxed) >> (bit % 64)) & 1u;
+}
+
+void deallocate(void* ptr)
+{
+    Page* page = page_of(ptr);
+    // A page's class never changes while it has live slots.
+    SpinLock lock(g_classes[page->size_class]);
+    const bool was_full = page->live == page->capacity;
+    *static_cast<void**>(ptr) = page->free_list;
+    page->free_list = ptr;
+    --page->live;
+    g_live_bytes.fetch_sub(page->slot_size, std::memory_order_relaxed);
+    if (page->live == 0 && g_open.load(std::memory_order_relaxed) == 0) {
+        // Retained page whose last escaped object just died.
+        if (!was_full) {
+            unlink(page);
+        }
+        release_page(page);
+        size_t retained = g_retained_pages.load(std::memory_order_relaxed);
+        while (retained > 0 &&
+               !g_retained_pages.compare_exchange_weak(retained, retained - 1, std::memory_order_relaxed)) {
+        }
+        return;
+    }
+    if (was_full) {
+        link_front(page);
+    }
+}
+
+size_t usable_size(const void* ptr)
+{
+    return page_of(ptr)->slot_size;
+}
+
+nlohmann::json to_json()
+{
+    const size_t pages = g_pages.load(std::memory_order_relaxed);
+    return nlohmann::json{
+        {"active", g_open.load(std::memory_order_relaxed) > 0},
+        {"pages", pages},
+        {"pageBytes", pages * kPageSize},
+        {"liveBytes", g_live_bytes.load(std::memory_order_relaxed)},
+        {"scopes", g_scopes.load(std::memory_order_relaxed)},
+        {"lastReleasedPages", g_released_pages.load(std::memory_order_relaxed)},
+        {"retainedPages", g_retained_pages.load(std::memory_order_relaxed)},
+    };
+}
+
+} // namespace orc::arena
@@ -0,0 +1,64 @@
+#ifndef ORCA_WASM_ORC_ARENA_H
+#define ORCA_WASM_ORC_ARENA_H
+
+#include <cstddef>
+
+#include <nlohmann/json.hpp>
+
+// Slab arena for the small objects of one slice. While a Scope is open, the
+// operator new hooks in orc_alloc.cpp serve allocations of up to kMaxSmallSize
+// bytes from 64 KiB pages segregated by size class instead of from the main
+// heap. When the last Scope closes, every page whose objects are all gone is
+// handed back to malloc at once, so a slice's thousands of small nodes never
+// end up interleaved with long-lived data in the main heap.
+//
+// Objects that outlive the slice (lazily built statics, caches) keep their
+// page alive; it is "retained", still fully usable, and freed once its last
+// object is deleted. Requires ORC_BRIDGE_ALLOC_PROFILE != off.
+namespace orc::arena {
+
+constexpr size_t kPageSize = 64 * 1024;
+constexpr size_t kMaxSmallSize = 8192;
+
+// Routes the calling thread's small allocations into the arena for its
+// lifetime when `enabled`; TBB workers running the slice's tasks in an
+// orc::workers::TaskArena are routed with it. Other threads, including
+// sessions slicing without an arena, keep using malloc. Scopes nest and may be
+// open on several threads; pages are shared, each size class under its own
+// lock, and released when the last scope anywhere closes.
+class Scope {
+public:
+    explicit Scope(bool enabled);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    bool m_enabled;
+};
+
+// Scopes routing the calling thread, and a way to install another thread's
+// count: how a worker joins a slice's routing and leaves it again.
+int thread_depth();
+int exchange_thread_depth(int depth);
+
+// nullptr when no Scope routes the calling thread, `size` is above
+// kMaxSmallSize, or a page cannot be obtained; the caller then falls back to
+// malloc.
+void* allocate(size_t size);
+
+// True if `ptr` was returned by allocate(). Cheap enough for every delete.
+bool owns(const void* ptr);
+
+void deallocate(void* ptr);
+
+// Size of the slot backing `ptr`; only valid when owns(ptr).
+size_t usable_size(const void* ptr);
+
+// Pages in use, live bytes, and what the last closing Scope released and
+// retained.
+nlohmann::json to_json();
+
+} // namespace orc::arena
+
+#endif
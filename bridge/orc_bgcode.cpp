@@ -0,0 +1,786 @@
+#include "orc_bgcode.h"
+
+#include "orc_clock.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <miniz.h>
+
+namespace orc::bgcode {
+
+namespace {
+
+// Text per G-code block, as libbgcode cuts it.
+static constexpr size_t kBlockText = 65535;
+// Header, compressed size, encoding parameter and CRC-32 of a G-code block.
+static constexpr size_t kBlockOverhead = 18;
+
+static constexpr uint32_t kVersion = 1;
+static constexpr uint16_t kChecksumCrc32 = 1;
+static constexpr uint16_t kMetadataIni = 0;
+
+enum class BlockType : uint16_t {
+    FileMetadata = 0,
+    GCode = 1,
+    SlicerMetadata = 2,
+    PrinterMetadata = 3,
+    PrintMetadata = 4,
+    Thumbnail = 5,
+};
+
+// Copied into the printer metadata under the first name, from the first key
+// found. Orca names the temperatures and the infill density differently.
+struct PrinterKey {
+    const char* name;
+    const char* keys[2];
+};
+
+static constexpr PrinterKey kPrinterKeys[] = {
+    {"printer_model", {"printer_model", nullptr}},
+    {"filament_type", {"filament_type", nullptr}},
+    {"nozzle_diameter", {"nozzle_diameter", nullptr}},
+    {"bed_temperature", {"bed_temperature", "hot_plate_temp"}},
+    {"temperature", {"temperature", "nozzle_temperature"}},
+    {"brim_width", {"brim_width", nullptr}},
+    {"fill_density", {"fill_density", "sparse_infill_density"}},
+    {"layer_height", {"layer_height", nullptr}},
+    {"support_material", {"support_material", "enable_support"}},
+    {"extruder_colour", {"extruder_colour", nullptr}},
+    {"filament used [mm]", {"filament used [mm]", nullptr}},
+    {"filament used [g]", {"filament used [g]", nullptr}},
+    {"estimated printing time (normal mode)", {"estimated printing time (normal mode)", nullptr}},
+};
+
+static void put_u16(std::string& out, uint16_t value)
+{
+    out.push_back(char(value & 0xff));
+    out.push_back(char(value >> 8));
+}
+
+static void put_u32(std::string& out, uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(char((value >> shift) & 0xff));
+    }
+}
+
+static bool starts_with(std::string_view text, std::string_view prefix)
+{
+    return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+static std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// "; key = value"; false for any other line.
+static bool split_setting(std::string_view text, std::string_view& key, std::string_view& value)
+{
+    if (!starts_with(text, "; ")) {
+        return false;
+    }
+    text.remove_prefix(2);
+    const size_t eq = text.find(" = ");
+    if (eq == std::string_view::npos || eq == 0) {
+        return false;
+    }
+    key = trim(text.substr(0, eq));
+    value = trim(text.substr(eq + 3));
+    return !key.empty();
+}
+
+static bool decode_base64(std::string_view text, std::string& out)
+{
+    uint32_t accumulator = 0;
+    int bits = 0;
+    for (const char c : text) {
+        int value = 0;
+        if (c >= 'A' && c <= 'Z') {
+            value = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            value = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            value = c - '0' + 52;
+        } else if (c == '+') {
+            value = 62;
+        } else if (c == '/') {
+            value = 63;
+        } else if (c == '=' || c == '\n' || c == '\r' || c == ' ') {
+            continue;
+        } else {
+            return false;
+        }
+        accumulator = (accumulator << 6) | uint32_t(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(char((accumulator >> bits) & 0xff));
+        }
+    }
+    return true;
+}
+
+// MeatPack, as libbgcode packs a block: two characters from "0-9. \nGX" per
+// byte, low nibble first, 0xF for a character that follows in full. G-code
+// lines lose their spaces (the firmware's parser does not need them),
+// comment lines are dropped or, with `keep_comments`, sent with packing
+// switched off.
+class MeatPacker {
+public:
+    MeatPacker(bool keep_comments, std::string& out) : m_keep_comments(keep_comments), m_out(out)
+    {
+        command(kEnablePacking);
+        m_packing = true;
+    }
+
+    void line(std::string_view text)
+    {
+        if (text.empty()) {
+            return;
+        }
+        if (m_keep_comments && text.front() == ';') {
+            if (m_packing) {
+                command(kDisablePacking);
+                m_packing = false;
+            }
+            m_out.append(text.data(), text.size());
+            m_out.push_back('\n');
+            return;
+        }
+        if (text.front() == ';' || text.front() == '\r') {
+            return;
+        }
+        text = trim(text.substr(0, text.find(';')));
+        if (text.empty()) {
+            return;
+        }
+        m_line.assign(text.data(), text.size());
+        if (is_gcode_move(m_line)) {
+            compact(m_line);
+        }
+        m_line.push_back('\n');
+
+        if (!m_packing) {
+            command(kEnablePacking);
+            m_packing = true;
+        }
+        for (size_t i = 0; i < m_line.size(); i += 2) {
+            const char first = m_line[i];
+            const char second = i + 1 < m_line.size() ? m_line[i + 1] : '\n';
+            const uint8_t low = nibble(first);
+            const uint8_t high = nibble(second);
+            m_out.push_back(char(uint8_t(high << 4) | low));
+            if (low == kFull) {
+                m_out.push_back(first);
+            }
+            if (high == kFull) {
+                m_out.push_back(second);
+            }
+        }
+    }
+
+    void finish()
+    {
+        if (!m_keep_comments) {
+            command(kResetAll);
+        }
+    }
+
+private:
+    static constexpr uint8_t kSignal = 0xff;
+    static constexpr uint8_t kEnablePacking = 251;
+    static constexpr uint8_t kDisablePacking = 250;
+    static constexpr uint8_t kResetAll = 249;
+    static constexpr uint8_t kFull = 0x0f;
+
+    static uint8_t nibble(char c)
+    {
+        if (c >= '0' && c <= '9') {
+            return uint8_t(c - '0');
+        }
+        switch (c) {
+        case '.': return 10;
+        case ' ': return 11;
+        case '\n': return 12;
+        case 'G': return 13;
+        case 'X': return 14;
+        default: return kFull;
+        }
+    }
+
+    // A 'G' followed by a digit anywhere in the line, as libbgcode decides.
+    static bool is_gcode_move(const std::string& text)
+    {
+        const size_t g = text.find('G');
+        return g != std::string::npos && g + 1 < text.size() && text[g + 1] >= '0' && text[g + 1] <= '9';
+    }
+
+    // Upper-cases e, x and g and drops the spaces; a line checksum is
+    // recomputed over what remains.
+    static void compact(std::string& text)
+    {
+        for (char& c : text) {
+            if (c == 'e' || c == 'x' || c == 'g') {
+                c = char(c - 'a' + 'A');
+            }
+        }
+        text.erase(std::remove(text.begin(), text.end(), ' '), text.end());
+        const size_t star = text.find('*');
+        if (star != std::string::npos) {
+            text.erase(std::remove(text.begin(), text.end(), '*'), text.end());
+            uint8_t checksum = 0;
+            for (const char c : text) {
+                checksum ^= uint8_t(c);
+            }
+            text += "*" + std::to_string(checksum);
+        }
+    }
+
+    void command(uint8_t code)
+    {
+        m_out.push_back(char(kSignal));
+        m_out.push_back(char(kSignal));
+        m_out.push_back(char(code));
+    }
+
+    bool m_keep_comments;
+    bool m_packing = false;
+    std::string& m_out;
+    std::string m_line;
+};
+
+static void meatpack(const std::string& text, bool keep_comments, std::string& out)
+{
+    MeatPacker packer(keep_comments, out);
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        packer.line(std::string_view(text).substr(start, end - start));
+        start = end + 1;
+    }
+    packer.finish();
+}
+
+// MSB-first bits, as heatshrink reads them.
+class BitWriter {
+public:
+    explicit BitWriter(std::string& out) : m_out(out) {}
+
+    void put(uint32_t value, int count)
+    {
+        for (int bit = count - 1; bit >= 0; --bit) {
+            m_byte = uint8_t((m_byte << 1) | ((value >> bit) & 1));
+            if (++m_bits == 8) {
+                m_out.push_back(char(m_byte));
+                m_byte = 0;
+                m_bits = 0;
+            }
+        }
+    }
+
+    // Pads with zero bits, which the decoder drops as an incomplete backref.
+    void flush()
+    {
+        if (m_bits > 0) {
+            m_out.push_back(char(m_byte << (8 - m_bits)));
+            m_byte = 0;
+            m_bits = 0;
+        }
+    }
+
+private:
+    std::string& m_out;
+    uint8_t m_byte = 0;
+    int m_bits = 0;
+};
+
+// heatshrink's LZSS stream: a 1 bit and the byte for a literal, a 0 bit, the
+// distance - 1 in `window_bits` and the length - 1 in 4 bits for a backref.
+// Matches come from hash chains over the block; a backref is only used where
+// it is shorter than the literals, as heatshrink's own encoder does.
+static void heatshrink(const std::string& in, int window_bits, std::string& out)
+{
+    static constexpr int kLookaheadBits = 4;
+    static constexpr int kHashBits = 13;
+    static constexpr int kChainLimit = 64;
+    const size_t max_distance = (size_t(1) << window_bits) - 1;
+    const size_t max_length = size_t(1) << kLookaheadBits;
+    const size_t min_length = size_t(1 + window_bits + kLookaheadBits) / 8 + 1;
+
+    const size_t n = in.size();
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(in.data());
+    std::vector<int32_t> head(size_t(1) << kHashBits, -1);
+    std::vector<int32_t> prev(n, -1);
+    const auto hash_at = [&](size_t pos) {
+        const uint32_t key = uint32_t(data[pos]) | uint32_t(data[pos + 1]) << 8 | uint32_t(data[pos + 2]) << 16;
+        return (key * 2654435761u) >> (32 - kHashBits);
+    };
+    const auto insert = [&](size_t pos) {
+        if (pos + 2 < n) {
+            const uint32_t h = hash_at(pos);
+            prev[pos] = head[h];
+            head[h] = int32_t(pos);
+        }
+    };
+
+    BitWriter bits(out);
+    size_t pos = 0;
+    while (pos < n) {
+        size_t best_length = 0;
+        size_t best_distance = 0;
+        if (pos + 2 < n) {
+            const size_t limit = std::min(max_length, n - pos);
+            int32_t candidate = head[hash_at(pos)];
+            for (int chain = 0; candidate >= 0 && chain < kChainLimit; ++chain) {
+                const size_t distance = pos - size_t(candidate);
+                if (distance > max_distance) {
+                    break;
+                }
+                size_t length = 0;
+                while (length < limit && data[size_t(candidate) + length] == data[pos + length]) {
+                    ++length;
+                }
+                if (length > best_length) {
+                    best_length = length;
+                    best_distance = distance;
+                    if (length == limit) {
+                        break;
+                    }
+                }
+                candidate = prev[size_t(candidate)];
+            }
+        }
+        if (best_length >= min_length) {
+            bits.put(0, 1);
+            bits.put(uint32_t(best_distance - 1), window_bits);
+            bits.put(uint32_t(best_length - 1), kLookaheadBits);
+            for (size_t i = 0; i < best_length; ++i) {
+                insert(pos + i);
+            }
+            pos += best_length;
+        } else {
+            bits.put(1, 1);
+            bits.put(data[pos], 8);
+            insert(pos);
+            ++pos;
+        }
+    }
+    bits.flush();
+}
+
+// Compressed payload of a block; deflate uses the zlib wrapper, as libbgcode.
+static std::string compress(const std::string& raw, Compression compression, int level)
+{
+    std::string out;
+    switch (compression) {
+    case Compression::None:
+        return raw;
+    case Compression::Deflate: {
+        mz_ulong length = mz_compressBound(mz_ulong(raw.size()));
+        out.resize(length);
+        if (mz_compress2(reinterpret_cast<unsigned char*>(&out[0]), &length,
+                         reinterpret_cast<const unsigned char*>(raw.data()), mz_ulong(raw.size()),
+                         std::clamp(level, 0, 9)) != MZ_OK) {
+            throw std::runtime_error("bgcode: deflate failed");
+        }
+        out.resize(length);
+        return out;
+    }
+    case Compression::Heatshrink11:
+        heatshrink(raw, 11, out);
+        return out;
+    case Compression::Heatshrink12:
+        heatshrink(raw, 12, out);
+        return out;
+    }
+    return raw;
+}
+
+// Header, parameters, payload and the CRC-32 over all three.
+static void append_block(std::string& out, BlockType type, Compression compression, const std::string& params,
+                         const std::string& raw, int level)
+{
+    const std::string stored = compress(raw, compression, level);
+    const size_t start = out.size();
+    put_u16(out, uint16_t(type));
+    put_u16(out, uint16_t(compression));
+    put_u32(out, uint32_t(raw.size()));
+    if (compression != Compression::None) {
+        put_u32(out, uint32_t(stored.size()));
+    }
+    out += params;
+    out += stored;
+    const mz_ulong crc = mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(out.data() + start),
+                                  out.size() - start);
+    put_u32(out, uint32_t(crc));
+}
+
+static std::string ini(const std::vector<std::pair<std::string, std::string>>& entries)
+{
+    std::string out;
+    for (const auto& [key, value] : entries) {
+        out += key;
+        out += '=';
+        out += value;
+        out += '\n';
+    }
+    return out;
+}
+
+static const char* compression_name(Compression compression)
+{
+    switch (compression) {
+    case Compression::None: return "none";
+    case Compression::Deflate: return "deflate";
+    case Compression::Heatshrink11: return "heatshrink11";
+    case Compression::Heatshrink12: return "heatshrink12";
+    }
+    return "unknown";
+}
+
+static const char* encoding_name(Encoding encoding)
+{
+    switch (encoding) {
+    case Encoding::None: return "none";
+    case Encoding::MeatPack: return "meatpack";
+    case Encoding::MeatPackComments: return "meatpackComments";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+nlohmann::json Stats::to_json(const Options& options) const
+{
+    return {
+        {"format", "bgcode"},
+        {"compression", compression_name(options.gcode_compression)},
+        {"encoding", encoding_name(options.encoding)},
+        {"textBytes", text_bytes},
+        {"encodedBytes", encoded_bytes},
+        {"bytes", bytes},
+        {"ratio", bytes > 0 ? double(text_bytes) / double(bytes) : 0.0},
+        {"gcodeBlocks", gcode_blocks},
+        {"metadataKeys", metadata_keys},
+        {"thumbnails", thumbnails},
+        {"encodeMs", encode_ms},
+        {"encodeMBps", encode_ms > 0.0 ? double(text_bytes) / 1000.0 / encode_ms : 0.0},
+    };
+}
+
+Writer::Writer(Options options) : m_options(std::move(options))
+{
+    m_thumbnails = std::move(m_options.thumbnails);
+    m_options.thumbnails.clear();
+}
+
+Writer::~Writer()
+{
+    std::free(m_out);
+}
+
+void Writer::scan(const char* data, size_t len)
+{
+    const double start = now_ms();
+    split(data, len);
+    m_stats.encode_ms += now_ms() - start;
+}
+
+void Writer::feed(const char* data, size_t len)
+{
+    const double start = now_ms();
+    if (m_scanning) {
+        lay_out_metadata();
+    }
+    m_stats.text_bytes += len;
+    split(data, len);
+    m_stats.encode_ms += now_ms() - start;
+}
+
+void Writer::split(const char* data, size_t len)
+{
+    std::string_view rest(data, len);
+    if (!m_partial.empty()) {
+        const size_t newline = rest.find('\n');
+        if (newline == std::string_view::npos) {
+            m_partial.append(rest.data(), rest.size());
+            return;
+        }
+        m_partial.append(rest.data(), newline);
+        line(m_partial);
+        m_partial.clear();
+        rest.remove_prefix(newline + 1);
+    }
+    size_t newline;
+    while ((newline = rest.find('\n')) != std::string_view::npos) {
+        line(rest.substr(0, newline));
+        rest.remove_prefix(newline + 1);
+    }
+    m_partial.assign(rest.data(), rest.size());
+}
+
+// Both passes sort the lines the same way; the first keeps the metadata and
+// thumbnails and only measures the G-code, the second keeps only the G-code.
+void Writer::line(std::string_view text)
+{
+    if (!text.empty() && text.back() == '\r') {
+        text.remove_suffix(1);
+    }
+    if (text == "; CONFIG_BLOCK_START") {
+        m_in_config = true;
+        return;
+    }
+    if (text == "; CONFIG_BLOCK_END") {
+        m_in_config = false;
+        return;
+    }
+    std::string_view key;
+    std::string_view value;
+    if (m_in_config) {
+        if (m_scanning && split_setting(text, key, value)) {
+            m_slicer.emplace_back(std::string(key), std::string(value));
+        }
+        return;
+    }
+
+    // "; thumbnail begin 300x300 12345", then "; <base64>" lines; _JPG and
+    // _QOI tags for the other formats.
+    if (m_in_thumbnail) {
+        if (starts_with(text, "; thumbnail") && text.find(" end") != std::string_view::npos) {
+            m_in_thumbnail = false;
+            if (m_scanning && decode_base64(m_thumbnail_base64, m_thumbnail.data) && !m_thumbnail.data.empty()) {
+                m_thumbnails.push_back(std::move(m_thumbnail));
+            }
+            m_thumbnail = Thumbnail{};
+            m_thumbnail_base64.clear();
+        } else if (m_scanning && starts_with(text, "; ")) {
+            m_thumbnail_base64.append(text.data() + 2, text.size() - 2);
+        }
+        return;
+    }
+    if (text == "; THUMBNAIL_BLOCK_START" || text == "; THUMBNAIL_BLOCK_END") {
+        return;
+    }
+    if (starts_with(text, "; thumbnail")) {
+        const size_t begin = text.find(" begin ");
+        if (begin != std::string_view::npos) {
+            const std::string_view tag = text.substr(2, begin - 2);
+            m_thumbnail = Thumbnail{};
+            m_thumbnail.format = tag == "thumbnail_JPG" ? ThumbnailFormat::Jpg :
+                                 tag == "thumbnail_QOI" ? ThumbnailFormat::Qoi : ThumbnailFormat::Png;
+            unsigned width = 0;
+            unsigned height = 0;
+            const std::string size(text.substr(begin + 7));
+            if (std::sscanf(size.c_str(), "%ux%u", &width, &height) == 2) {
+                m_thumbnail.width = uint16_t(width);
+                m_thumbnail.height = uint16_t(height);
+            }
+            m_in_thumbnail = true;
+            return;
+        }
+    }
+
+    if (split_setting(text, key, value)) {
+        if (m_scanning) {
+            m_print.emplace_back(std::string(key), std::string(value));
+        }
+        return;
+    }
+    if (m_scanning) {
+        m_gcode_bytes += text.size() + 1;
+        return;
+    }
+    m_text.append(text.data(), text.size());
+    m_text.push_back('\n');
+    if (m_text.size() >= kBlockText) {
+        flush_gcode();
+    }
+}
+
+void Writer::lay_out_metadata()
+{
+    if (!m_partial.empty()) {
+        const std::string last = std::move(m_partial);
+        m_partial.clear();
+        line(last);
+    }
+    m_scanning = false;
+    m_in_config = false;
+    m_in_thumbnail = false;
+    m_thumbnail = Thumbnail{};
+    m_thumbnail_base64.clear();
+
+    Metadata printer;
+    for (const PrinterKey& entry : kPrinterKeys) {
+        bool found = false;
+        for (const char* wanted : entry.keys) {
+            for (const Metadata* source : {&m_print, &m_slicer}) {
+                for (const auto& [key, value] : *source) {
+                    if (!found && wanted != nullptr && key == wanted) {
+                        printer.emplace_back(entry.name, value);
+                        found = true;
+                    }
+                }
+            }
+        }
+    }
+
+    std::string params;
+    put_u16(params, kMetadataIni);
+    std::string& head = m_block;
+    head.clear();
+    head += "GCDE";
+    put_u32(head, kVersion);
+    put_u16(head, kChecksumCrc32);
+    if (!m_options.producer.empty()) {
+        append_block(head, BlockType::FileMetadata, Compression::None, params, ini({{"Producer", m_options.producer}}),
+                     m_options.level);
+    }
+    append_block(head, BlockType::PrinterMetadata, Compression::None, params, ini(printer), m_options.level);
+    for (const Thumbnail& thumbnail : m_thumbnails) {
+        std::string thumbnail_params;
+        put_u16(thumbnail_params, uint16_t(thumbnail.format));
+        put_u16(thumbnail_params, thumbnail.width);
+        put_u16(thumbnail_params, thumbnail.height);
+        append_block(head, BlockType::Thumbnail, Compression::None, thumbnail_params, thumbnail.data, m_options.level);
+    }
+    append_block(head, BlockType::PrintMetadata, Compression::None, params, ini(m_print), m_options.level);
+    append_block(head, BlockType::SlicerMetadata, m_options.metadata_compression, params, ini(m_slicer),
+                 m_options.level);
+
+    // Sized from the first pass: uncompressed G-code takes its text size,
+    // encoded or compressed G-code about half of it.
+    const bool raw = m_options.encoding == Encoding::None && m_options.gcode_compression == Compression::None;
+    const uint64_t blocks = m_gcode_bytes / kBlockText + 1;
+    reserve(head.size() + (raw ? m_gcode_bytes : m_gcode_bytes / 2) + blocks * kBlockOverhead);
+    emit(head);
+
+    m_stats.metadata_keys = printer.size() + m_print.size() + m_slicer.size();
+    m_stats.thumbnails = m_thumbnails.size();
+    m_print.clear();
+    m_slicer.clear();
+    m_thumbnails.clear();
+    m_text.reserve(kBlockText + 4096);
+}
+
+void Writer::flush_gcode()
+{
+    if (m_text.empty()) {
+        return;
+    }
+    std::string params;
+    put_u16(params, uint16_t(m_options.encoding));
+    m_block.clear();
+    if (m_options.encoding == Encoding::None) {
+        m_stats.encoded_bytes += m_text.size();
+        append_block(m_block, BlockType::GCode, m_options.gcode_compression, params, m_text, m_options.level);
+    } else {
+        std::string packed;
+        packed.reserve(m_text.size() * 2 / 3);
+        meatpack(m_text, m_options.encoding == Encoding::MeatPackComments, packed);
+        m_stats.encoded_bytes += packed.size();
+        append_block(m_block, BlockType::GCode, m_options.gcode_compression, params, packed, m_options.level);
+    }
+    emit(m_block);
+    ++m_stats.gcode_blocks;
+    m_text.clear();
+}
+
+void Writer::reserve(size_t capacity)
+{
+    if (capacity <= m_capacity) {
+        return;
+    }
+    void* grown = std::realloc(m_out, capacity);
+    if (grown == nullptr) {
+        throw std::bad_alloc();
+    }
+    m_out = static_cast<uint8_t*>(grown);
+    m_capacity = capacity;
+}
+
+void Writer::emit(const std::string& bytes)
+{
+    if (m_size + bytes.size() > m_capacity) {
+        reserve(std::max(m_size + bytes.size(), m_capacity + m_capacity / 2));
+    }
+    std::memcpy(m_out + m_size, bytes.data(), bytes.size());
+    m_size += bytes.size();
+}
+
+void Writer::finish()
+{
+    const double start = now_ms();
+    if (m_scanning) {
+        lay_out_metadata();
+    }
+    if (!m_partial.empty()) {
+        const std::string last = std::move(m_partial);
+        m_partial.clear();
+        line(last);
+    }
+    flush_gcode();
+    std::string().swap(m_text);
+    std::string().swap(m_block);
+
+    // Hand back what the estimate over-reserved; shrinking stays in place.
+    if (m_size != 0 && m_size < m_capacity) {
+        if (void* shrunk = std::realloc(m_out, m_size)) {
+            m_out = static_cast<uint8_t*>(shrunk);
+            m_capacity = m_size;
+        }
+    }
+    m_stats.bytes = m_size;
+    m_stats.encode_ms += now_ms() - start;
+}
+
+uint8_t* Writer::release(size_t& size)
+{
+    uint8_t* out = m_out;
+    size = m_size;
+    m_out = nullptr;
+    m_size = 0;
+    m_capacity = 0;
+    return out;
+}
+
+bool png_thumbnail(std::string_view base64, Thumbnail& out)
+{
+    static constexpr unsigned char kSignature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::string png;
+    if (!decode_base64(base64, png) || png.size() < 24 || std::memcmp(png.data(), kSignature, 8) != 0
+        || png.compare(12, 4, "IHDR") != 0) {
+        return false;
+    }
+    const auto be32 = [&](size_t at) {
+        const auto* p = reinterpret_cast<const uint8_t*>(png.data() + at);
+        return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+    };
+    const uint32_t width = be32(16);
+    const uint32_t height = be32(20);
+    if (width == 0 || height == 0 || width > 0xffff || height > 0xffff) {
+        return false;
+    }
+    out.format = ThumbnailFormat::Png;
+    out.width = uint16_t(width);
+    out.height = uint16_t(height);
+    out.data = std::move(png);
+    return true;
+}
+
+} // namespace orc::bgcode
@@ -0,0 +1,147 @@
+#ifndef ORCA_WASM_ORC_BGCODE_H
+#define ORCA_WASM_ORC_BGCODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// Binary G-code: the block container libbgcode defines and Prusa printers
+// read (.bgcode). The file puts the metadata and thumbnails ahead of the
+// G-code, while Orca writes them at the end of the text, so the Writer reads
+// the text twice. The first pass only collects the metadata and measures the
+// G-code. The second lays the metadata blocks out in the output buffer and
+// turns every 64 KiB of G-code into one block right behind them: the lines
+// are MeatPack-encoded, then deflated or heatshrunk. Neither the text nor the
+// finished blocks are ever held anywhere but in that one buffer, which goes to
+// the caller as is.
+//
+//   - Comment lines of the form "; key = value" are pulled out of the text:
+//     the config block becomes the slicer metadata, the others (filament
+//     used, estimated time) the print metadata. A handful of keys the
+//     printers show before printing is copied into the printer metadata.
+//   - Thumbnails embedded as base64 comments become thumbnail blocks, as do
+//     the ones passed in Options.
+//   - Blocks carry a CRC-32. The printer and print metadata stay
+//     uncompressed, the slicer metadata uses Options::metadata_compression.
+namespace orc::bgcode {
+
+enum class Compression : uint16_t {
+    None = 0,
+    Deflate = 1,
+    Heatshrink11 = 2, // window 2^11, lookahead 2^4
+    Heatshrink12 = 3, // window 2^12, lookahead 2^4
+};
+
+enum class Encoding : uint16_t {
+    None = 0,
+    MeatPack = 1,         // comments dropped
+    MeatPackComments = 2, // comments kept, unpacked
+};
+
+enum class ThumbnailFormat : uint16_t {
+    Png = 0,
+    Jpg = 1,
+    Qoi = 2,
+};
+
+struct Thumbnail {
+    ThumbnailFormat format = ThumbnailFormat::Png;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    std::string data;
+};
+
+// Defaults match PrusaSlicer's binary output.
+struct Options {
+    Compression gcode_compression = Compression::Heatshrink12;
+    Compression metadata_compression = Compression::Deflate;
+    Encoding encoding = Encoding::MeatPackComments;
+    // Deflate level, 0-9; heatshrink has none.
+    int level = 6;
+    // "Producer" of the file metadata block.
+    std::string producer;
+    std::vector<Thumbnail> thumbnails;
+};
+
+struct Stats {
+    // Text G-code fed in.
+    uint64_t text_bytes = 0;
+    // After MeatPack, before compression.
+    uint64_t encoded_bytes = 0;
+    // The whole .bgcode file.
+    uint64_t bytes = 0;
+    uint64_t gcode_blocks = 0;
+    uint64_t metadata_keys = 0;
+    uint64_t thumbnails = 0;
+    // Time spent sorting, encoding and compressing.
+    double encode_ms = 0.0;
+
+    nlohmann::json to_json(const Options& options) const;
+};
+
+class Writer {
+public:
+    explicit Writer(Options options);
+    ~Writer();
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    // First pass: the whole text, in chunks of any size.
+    void scan(const char* data, size_t len);
+
+    // Second pass: the same text again from the start. The first call lays out
+    // the file header, file, printer metadata, thumbnails, print and slicer
+    // metadata; after that a G-code block is emitted whenever 64 KiB of G-code
+    // text has gathered.
+    void feed(const char* data, size_t len);
+
+    // Emits the last G-code block and trims the buffer to the file size.
+    void finish();
+
+    // The finished file in a malloc'd buffer the caller frees.
+    uint8_t* release(size_t& size);
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    using Metadata = std::vector<std::pair<std::string, std::string>>;
+
+    void split(const char* data, size_t len);
+    void line(std::string_view text);
+    void lay_out_metadata();
+    void flush_gcode();
+    void reserve(size_t capacity);
+    void emit(const std::string& bytes);
+
+    Options m_options;
+    Stats m_stats;
+    bool m_scanning = true;
+    uint64_t m_gcode_bytes = 0;
+    std::string m_partial;
+    std::string m_text;
+    // One block (or the metadata blocks) on its way into m_out.
+    std::string m_block;
+    uint8_t* m_out = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+    Metadata m_print;
+    Metadata m_slicer;
+    std::vector<Thumbnail> m_thumbnails;
+    bool m_in_config = false;
+    bool m_in_thumbnail = false;
+    Thumbnail m_thumbnail;
+    std::string m_thumbnail_base64;
+};
+
+// A base64 PNG (as passed in the payload) as a thumbnail; false if it does not
+// decode to a PNG.
+bool png_thumbnail(std::string_view base64, Thumbnail& out);
+
+} // namespace orc::bgcode
+
+#endif
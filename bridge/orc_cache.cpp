@@ -0,0 +1,455 @@
+#include "orc_cache.h"
+
+#include "orc_log.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <libslic3r/PrintConfig.hpp>
+#include <libslic3r/libslic3r_version.h>
+
+namespace orc::cache {
+
+namespace {
+
+// Bump when the bridge changes what a given key produces.
+static constexpr const char* kKeyVersion = "orc-cache-1";
+
+// Names, notes and host settings: they reach the G-code only as comments (if
+// at all), so a hit may carry the first requester's values for them.
+static constexpr const char* kCosmeticKeys[] = {
+    "compatible_printers",
+    "compatible_printers_condition",
+    "compatible_prints",
+    "compatible_prints_condition",
+    "filament_notes",
+    "filament_settings_id",
+    "inherits",
+    "notes",
+    "print_host",
+    "print_settings_id",
+    "printer_notes",
+    "printer_settings_id",
+    "printhost_apikey",
+    "printhost_cafile",
+};
+
+struct Node {
+    hash::Digest key;
+    Kind kind = Kind::Slice;
+    size_t bytes = 0;
+    // Memory mode only; persisted entries are read back on a hit.
+    std::shared_ptr<const std::string> data;
+    nlohmann::json stats;
+};
+
+struct Counters {
+    uint64_t hits = 0;
+    uint64_t alias_hits = 0;
+    uint64_t misses = 0;
+    uint64_t stores = 0;
+    uint64_t rejected = 0;
+    uint64_t evictions = 0;
+    uint64_t evicted_bytes = 0;
+    uint64_t io_errors = 0;
+};
+
+struct State {
+    std::mutex mutex;
+    Limits limits;
+    // Front is most recently used.
+    std::list<Node> lru;
+    std::unordered_map<hash::Digest, std::list<Node>::iterator, hash::DigestHasher> index;
+    std::unordered_map<hash::Digest, hash::Digest, hash::DigestHasher> aliases;
+    size_t bytes = 0;
+    Counters counters;
+};
+
+static State& state()
+{
+    static State s;
+    return s;
+}
+
+static constexpr const char* kDataExtensions[] = {".gcode", ".layers"};
+
+static const char* data_extension(Kind kind)
+{
+    return kDataExtensions[static_cast<int>(kind)];
+}
+
+static std::string entry_path(const State& s, const hash::Digest& key, const char* extension)
+{
+    return s.limits.dir + "/" + key.hex() + extension;
+}
+
+static bool parse_hex(const std::string& text, hash::Digest& digest)
+{
+    if (text.size() != 32 || text.find_first_not_of("0123456789abcdef") != std::string::npos) {
+        return false;
+    }
+    digest.hi = std::strtoull(text.substr(0, 16).c_str(), nullptr, 16);
+    digest.lo = std::strtoull(text.substr(16).c_str(), nullptr, 16);
+    return true;
+}
+
+static bool read_file(const std::string& path, std::string& out)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = fseeko(f, 0, SEEK_END) == 0;
+    const off_t size = ok ? ftello(f) : -1;
+    ok = ok && size >= 0 && fseeko(f, 0, SEEK_SET) == 0;
+    if (ok) {
+        out.resize(static_cast<size_t>(size));
+        ok = out.empty() || std::fread(&out[0], 1, out.size(), f) == out.size();
+    }
+    std::fclose(f);
+    return ok;
+}
+
+// Written under a temporary name and renamed, so a crash never leaves a
+// truncated entry behind.
+static bool write_file(const std::string& path, const void* data, size_t len)
+{
+    const std::string temp = path + ".tmp";
+    FILE* f = std::fopen(temp.c_str(), "wb");
+    if (f == nullptr) {
+        return false;
+    }
+    const bool written = len == 0 || std::fwrite(data, 1, len, f) == len;
+    if (std::fclose(f) != 0 || !written || std::rename(temp.c_str(), path.c_str()) != 0) {
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void remove_files(const State& s, const hash::Digest& key, Kind kind)
+{
+    unlink(entry_path(s, key, data_extension(kind)).c_str());
+    unlink(entry_path(s, key, ".json").c_str());
+}
+
+static void erase(State& s, std::list<Node>::iterator it, bool evicted)
+{
+    if (evicted) {
+        ++s.counters.evictions;
+        s.counters.evicted_bytes += it->bytes;
+    }
+    if (!s.limits.dir.empty()) {
+        remove_files(s, it->key, it->kind);
+    }
+    s.bytes -= it->bytes;
+    s.index.erase(it->key);
+    s.lru.erase(it);
+}
+
+// Evicts from the cold end until `bytes` and `entries` more fit.
+static void make_room(State& s, size_t bytes, size_t entries)
+{
+    while (!s.lru.empty() && (s.bytes + bytes > s.limits.max_bytes ||
+                              (s.limits.max_entries > 0 && s.lru.size() + entries > s.limits.max_entries))) {
+        erase(s, std::prev(s.lru.end()), true);
+    }
+}
+
+// Aliases are cheap but unbounded otherwise; drop the ones whose entry is
+// gone once they outnumber the entries by a wide margin.
+static void prune_aliases(State& s)
+{
+    if (s.aliases.size() <= 4 * s.index.size() + 64) {
+        return;
+    }
+    for (auto it = s.aliases.begin(); it != s.aliases.end();) {
+        it = s.index.count(it->second) == 0 ? s.aliases.erase(it) : std::next(it);
+    }
+}
+
+static void scan_dir(State& s)
+{
+    DIR* dir = opendir(s.limits.dir.c_str());
+    if (dir == nullptr) {
+        if (mkdir(s.limits.dir.c_str(), 0700) != 0) {
+            ORC_WARN("[orc_cache] cannot create %s\n", s.limits.dir.c_str());
+            ++s.counters.io_errors;
+        }
+        return;
+    }
+    struct Found {
+        hash::Digest key;
+        Kind kind;
+        size_t bytes;
+        time_t mtime;
+    };
+    std::vector<Found> found;
+    while (const dirent* item = readdir(dir)) {
+        const std::string name = item->d_name;
+        const size_t dot = name.find('.');
+        hash::Digest key;
+        if (dot == std::string::npos || !parse_hex(name.substr(0, dot), key)) {
+            continue;
+        }
+        const auto extension = std::find_if(std::begin(kDataExtensions), std::end(kDataExtensions),
+                                            [&](const char* candidate) { return name.compare(dot, std::string::npos, candidate) == 0; });
+        if (extension == std::end(kDataExtensions)) {
+            continue;
+        }
+        const Kind kind = static_cast<Kind>(extension - std::begin(kDataExtensions));
+        struct stat info;
+        if (stat((s.limits.dir + "/" + name).c_str(), &info) == 0) {
+            found.push_back({key, kind, static_cast<size_t>(info.st_size), info.st_mtime});
+        }
+    }
+    closedir(dir);
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.mtime < b.mtime; });
+    for (const Found& entry : found) {
+        Node node;
+        node.key = entry.key;
+        node.kind = entry.kind;
+        node.bytes = entry.bytes;
+        s.lru.push_front(std::move(node));
+        s.index[entry.key] = s.lru.begin();
+        s.bytes += entry.bytes;
+    }
+    make_room(s, 0, 0);
+}
+
+} // namespace
+
+void configure(const Limits& limits)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const bool dir_changed = limits.dir != s.limits.dir;
+    const bool was_enabled = s.limits.max_bytes > 0;
+    if (dir_changed || limits.max_bytes == 0) {
+        s.lru.clear();
+        s.index.clear();
+        s.aliases.clear();
+        s.bytes = 0;
+    }
+    s.limits = limits;
+    if (s.limits.max_bytes == 0) {
+        return;
+    }
+    if ((dir_changed || !was_enabled) && !s.limits.dir.empty()) {
+        scan_dir(s);
+    }
+    make_room(s, 0, 0);
+}
+
+bool enabled()
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.limits.max_bytes > 0;
+}
+
+hash::Digest input_key(const hash::Digest& mesh, const std::string& payload)
+{
+    hash::Hasher hasher;
+    hasher.field(std::string(kKeyVersion) + "/input/" SLIC3R_VERSION);
+    hasher.field(mesh);
+    hasher.field(payload);
+    return hasher.finish();
+}
+
+hash::Digest content_key(const hash::Digest& mesh, const Slic3r::DynamicPrintConfig& config,
+                         const nlohmann::json& extra)
+{
+    hash::Hasher hasher;
+    hasher.field(std::string(kKeyVersion) + "/content/" SLIC3R_VERSION);
+    hasher.field(mesh);
+    std::vector<std::string> keys = config.keys();
+    std::sort(keys.begin(), keys.end());
+    for (const std::string& key : keys) {
+        if (std::find_if(std::begin(kCosmeticKeys), std::end(kCosmeticKeys),
+                         [&key](const char* cosmetic) { return key == cosmetic; }) != std::end(kCosmeticKeys)) {
+            continue;
+        }
+        if (const Slic3r::ConfigOption* option = config.option(key)) {
+            hasher.field(key);
+            hasher.field(option->serialize());
+        }
+    }
+    hasher.field(extra.dump());
+    return hasher.finish();
+}
+
+std::optional<hash::Digest> resolve(const hash::Digest& input)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const auto it = s.aliases.find(input);
+    if (it == s.aliases.end() || s.index.count(it->second) == 0) {
+        return std::nullopt;
+    }
+    ++s.counters.alias_hits;
+    return it->second;
+}
+
+std::optional<Entry> find(const hash::Digest& key)
+{
+    State& s = state();
+    std::string data_path;
+    std::string stats_path;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        const auto it = s.index.find(key);
+        if (it == s.index.end()) {
+            return std::nullopt;
+        }
+        if (s.limits.dir.empty()) {
+            Entry entry;
+            entry.data = it->second->data;
+            entry.stats = it->second->stats;
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+            ++s.counters.hits;
+            return entry;
+        }
+        data_path = entry_path(s, key, data_extension(it->second->kind));
+        stats_path = entry_path(s, key, ".json");
+    }
+
+    // Persisted entries are read without the lock, so other sessions' lookups
+    // and stores do not wait on the disk. Files are replaced by rename and an
+    // entry's content only depends on its key, so a concurrent store of the
+    // same key reads back the same bytes; a concurrent eviction makes this a
+    // miss.
+    auto data = std::make_shared<std::string>();
+    std::string stats;
+    const bool read = read_file(data_path, *data);
+    const bool has_stats = read && read_file(stats_path, stats);
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const auto it = s.index.find(key);
+    if (it == s.index.end() || data_path != entry_path(s, key, data_extension(it->second->kind))) {
+        return std::nullopt;
+    }
+    if (!read) {
+        ORC_WARN("[orc_cache] entry %s unreadable, dropped\n", key.hex().c_str());
+        ++s.counters.io_errors;
+        erase(s, it->second, false);
+        return std::nullopt;
+    }
+    Entry entry;
+    if (has_stats) {
+        entry.stats = nlohmann::json::parse(stats, nullptr, false);
+    }
+    entry.data = std::move(data);
+    // Keeps the on-disk order in step for the next scan.
+    utimensat(AT_FDCWD, data_path.c_str(), nullptr, 0);
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    ++s.counters.hits;
+    return entry;
+}
+
+void store(const hash::Digest& input, const hash::Digest& key, const uint8_t* data, size_t len,
+           nlohmann::json stats, Kind kind)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.limits.max_bytes == 0) {
+        return;
+    }
+    if (len > s.limits.max_bytes) {
+        ++s.counters.rejected;
+        return;
+    }
+    if (const auto existing = s.index.find(key); existing != s.index.end()) {
+        erase(s, existing->second, false);
+    }
+    make_room(s, len, 1);
+
+    Node node;
+    node.key = key;
+    node.kind = kind;
+    node.bytes = len;
+    if (s.limits.dir.empty()) {
+        node.data = std::make_shared<const std::string>(reinterpret_cast<const char*>(data), len);
+        node.stats = std::move(stats);
+    } else {
+        const std::string dump = stats.dump();
+        if (!write_file(entry_path(s, key, ".json"), dump.data(), dump.size()) ||
+            !write_file(entry_path(s, key, data_extension(kind)), data, len)) {
+            ORC_WARN("[orc_cache] cannot persist %s in %s\n", key.hex().c_str(), s.limits.dir.c_str());
+            ++s.counters.io_errors;
+            remove_files(s, key, kind);
+            return;
+        }
+    }
+    s.lru.push_front(std::move(node));
+    s.index[key] = s.lru.begin();
+    s.bytes += len;
+    if (input != key) {
+        s.aliases[input] = key;
+        prune_aliases(s);
+    }
+    ++s.counters.stores;
+}
+
+void alias(const hash::Digest& input, const hash::Digest& key)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.index.count(key) != 0) {
+        s.aliases[input] = key;
+        prune_aliases(s);
+    }
+}
+
+void clear()
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    while (!s.lru.empty()) {
+        erase(s, s.lru.begin(), false);
+    }
+    s.aliases.clear();
+}
+
+nlohmann::json to_json()
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return {
+        {"enabled", s.limits.max_bytes > 0},
+        {"maxBytes", s.limits.max_bytes},
+        {"maxEntries", s.limits.max_entries},
+        {"dir", s.limits.dir},
+        {"entries", s.lru.size()},
+        {"bytes", s.bytes},
+        {"hits", s.counters.hits},
+        {"aliasHits", s.counters.alias_hits},
+        {"misses", s.counters.misses},
+        {"stores", s.counters.stores},
+        {"rejected", s.counters.rejected},
+        {"evictions", s.counters.evictions},
+        {"evictedBytes", s.counters.evicted_bytes},
+        {"ioErrors", s.counters.io_errors},
+    };
+}
+
+void note_miss()
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    ++s.counters.misses;
+}
+
+} // namespace orc::cache
@@ -0,0 +1,88 @@
+#ifndef ORCA_WASM_ORC_CACHE_H
+#define ORCA_WASM_ORC_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "orc_hash.h"
+
+namespace Slic3r {
+class DynamicPrintConfig;
+}
+
+// Process-wide LRU cache of finished slices, keyed by content:
+//
+//   - The content key hashes the mesh bytes, the fully resolved print config
+//     (sorted keys, serialized values, cosmetic keys left out) and the few
+//     payload settings that change the output outside the config (model
+//     rotation, decimation). Different payloads that resolve to the same
+//     config share an entry.
+//   - The input key hashes the mesh bytes and the raw payload. It is an alias
+//     to a content key, so a repeated request is answered before the model is
+//     even loaded.
+//
+// Entries are bounded by total bytes and by count. With a directory
+// configured, entries live in it as <key>.gcode / <key>.json instead of in
+// memory and survive restarts (on the web the directory is an IDBFS mount).
+// The intermediate layer records of orc::layer_cache share the store, limits
+// and directory as <key>.layers. All functions are thread-safe.
+namespace orc::cache {
+
+struct Limits {
+    // 0 disables the cache and drops the in-memory index.
+    size_t max_bytes = 0;
+    size_t max_entries = 0;
+    // Empty: memory only.
+    std::string dir;
+};
+
+enum class Kind {
+    Slice,
+    Layers,
+};
+
+struct Entry {
+    // G-code for Kind::Slice, a packed layer record for Kind::Layers.
+    std::shared_ptr<const std::string> data;
+    // What the original slice reported (profile counters and timing).
+    nlohmann::json stats;
+};
+
+// Applies new limits, evicting as needed. A directory is scanned and its
+// entries indexed, oldest first.
+void configure(const Limits& limits);
+bool enabled();
+
+hash::Digest input_key(const hash::Digest& mesh, const std::string& payload);
+hash::Digest content_key(const hash::Digest& mesh, const Slic3r::DynamicPrintConfig& config,
+                         const nlohmann::json& extra);
+
+std::optional<hash::Digest> resolve(const hash::Digest& input);
+// Marks the entry most recently used. Empty if absent or unreadable.
+std::optional<Entry> find(const hash::Digest& key);
+// Copies `data` into the cache and points `input` at it (unless it is `key`
+// itself). Entries larger than max_bytes are refused.
+void store(const hash::Digest& input, const hash::Digest& key, const uint8_t* data, size_t len,
+           nlohmann::json stats, Kind kind = Kind::Slice);
+
+// Points `input` at an existing entry (a new payload that resolved to a
+// cached config).
+void alias(const hash::Digest& input, const hash::Digest& key);
+
+// Drops every entry, persisted ones included.
+void clear();
+
+// Limits, occupancy and hit/miss/eviction counters.
+nlohmann::json to_json();
+
+// Called by the bridge on a lookup that found nothing usable.
+void note_miss();
+
+} // namespace orc::cache
+
+#endif
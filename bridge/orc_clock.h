@@ -0,0 +1,26 @@
+#ifndef ORCA_WASM_ORC_CLOCK_H
+#define ORCA_WASM_ORC_CLOCK_H
+
+#include <chrono>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+namespace orc {
+
+// Monotonic milliseconds. Emscripten maps this onto performance.now(), native
+// builds use the steady clock so timings survive wall-clock adjustments.
+inline double now_ms()
+{
+#ifdef __EMSCRIPTEN__
+    return emscripten_get_now();
+#else
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
+#endif
+}
+
+} // namespace orc
+
+#endif
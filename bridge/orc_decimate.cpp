@@ -0,0 +1,221 @@
+#include "orc_decimate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+#include <libslic3r/AABBTreeIndirect.hpp>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/PrintConfig.hpp>
+#include <libslic3r/QuadricEdgeCollapse.hpp>
+#include <libslic3r/TriangleMesh.hpp>
+
+namespace orc::decimate {
+
+namespace {
+
+// Parts this small are left as they are; collapsing them gains nothing.
+static constexpr size_t kMinPartTriangles = 64;
+
+struct Volume {
+    Slic3r::ModelVolume* volume = nullptr;
+    indexed_triangle_set original;
+    std::vector<indexed_triangle_set> parts;
+    // Print-space length of one mesh unit.
+    double scale = 1.0;
+};
+
+// One part of one volume, collapsed independently of the others.
+struct Job {
+    indexed_triangle_set* its = nullptr;
+    float max_error = 0.f;
+};
+
+struct Sampled {
+    double max = 0.0;
+    double sum = 0.0;
+    size_t count = 0;
+};
+
+// Distances from every stride-th vertex of `from` to the surface of `to`.
+static Sampled sample_distances(const indexed_triangle_set& from, const indexed_triangle_set& to, size_t max_samples)
+{
+    if (from.vertices.empty() || to.indices.empty()) {
+        return {};
+    }
+    const auto tree = Slic3r::AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(to.vertices, to.indices);
+    const size_t stride = std::max<size_t>(1, (from.vertices.size() + max_samples - 1) / std::max<size_t>(max_samples, 1));
+    const size_t samples = (from.vertices.size() + stride - 1) / stride;
+    return tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(0, samples), Sampled{},
+        [&](const tbb::blocked_range<size_t>& range, Sampled acc) {
+            for (size_t i = range.begin(); i < range.end(); ++i) {
+                size_t hit_idx = 0;
+                Slic3r::Vec3f hit_point;
+                const float d2 = Slic3r::AABBTreeIndirect::squared_distance_to_indexed_triangle_set(
+                    to.vertices, to.indices, tree, from.vertices[i * stride], hit_idx, hit_point);
+                if (d2 < 0.f) {
+                    continue;
+                }
+                const double d = std::sqrt(double(d2));
+                acc.max = std::max(acc.max, d);
+                acc.sum += d;
+                ++acc.count;
+            }
+            return acc;
+        },
+        [](Sampled a, const Sampled& b) {
+            a.max = std::max(a.max, b.max);
+            a.sum += b.sum;
+            a.count += b.count;
+            return a;
+        });
+}
+
+// Largest axis scale of the first instance and volume transforms combined.
+static double print_scale(const Slic3r::ModelVolume& volume)
+{
+    Slic3r::Transform3d matrix = volume.get_matrix();
+    const Slic3r::ModelObject* object = volume.get_object();
+    if (object != nullptr && !object->instances.empty()) {
+        matrix = object->instances.front()->get_matrix() * matrix;
+    }
+    const double scale = matrix.linear().colwise().norm().maxCoeff();
+    return scale > 0.0 ? scale : 1.0;
+}
+
+} // namespace
+
+nlohmann::json Report::to_json() const
+{
+    return {
+        {"toleranceMm", tolerance_mm},
+        {"volumes", volumes},
+        {"parts", parts},
+        {"trianglesBefore", triangles_before},
+        {"trianglesAfter", triangles_after},
+        {"hausdorffMm", hausdorff_mm},
+        {"meanDeviationMm", mean_deviation_mm},
+    };
+}
+
+double tolerance_from_config(const Slic3r::DynamicPrintConfig& config)
+{
+    double tolerance = std::numeric_limits<double>::max();
+    if (const auto* layer_height = config.option<Slic3r::ConfigOptionFloat>("layer_height")) {
+        if (layer_height->value > 0.0) {
+            tolerance = std::min(tolerance, layer_height->value / 4.0);
+        }
+    }
+    if (const auto* nozzles = config.option<Slic3r::ConfigOptionFloats>("nozzle_diameter")) {
+        for (const double nozzle : nozzles->values) {
+            if (nozzle > 0.0) {
+                tolerance = std::min(tolerance, nozzle / 8.0);
+            }
+        }
+    }
+    if (tolerance == std::numeric_limits<double>::max()) {
+        tolerance = 0.05;
+    }
+    if (const auto* resolution = config.option<Slic3r::ConfigOptionFloat>("resolution")) {
+        tolerance = std::max(tolerance, resolution->value);
+    }
+    return tolerance;
+}
+
+Deviation hausdorff(const indexed_triangle_set& a, const indexed_triangle_set& b, size_t max_samples)
+{
+    const Sampled ab = sample_distances(a, b, max_samples);
+    const Sampled ba = sample_distances(b, a, max_samples);
+    Deviation deviation;
+    deviation.max = std::max(ab.max, ba.max);
+    const size_t count = ab.count + ba.count;
+    deviation.mean = count > 0 ? (ab.sum + ba.sum) / double(count) : 0.0;
+    return deviation;
+}
+
+Report decimate_model(Slic3r::Model& model, double tolerance_mm, size_t min_triangles)
+{
+    Report report;
+    report.tolerance_mm = tolerance_mm;
+    if (!(tolerance_mm > 0.0)) {
+        return report;
+    }
+
+    std::vector<Volume> volumes;
+    for (Slic3r::ModelObject* object : model.objects) {
+        for (Slic3r::ModelVolume* volume : object->volumes) {
+            if (!volume->is_model_part() || volume->mesh().facets_count() < min_triangles) {
+                continue;
+            }
+            Volume entry;
+            entry.volume = volume;
+            entry.original = volume->mesh().its;
+            entry.scale = print_scale(*volume);
+            volumes.push_back(std::move(entry));
+        }
+    }
+
+    // Splitting is per volume, collapsing per part across all volumes.
+    tbb::parallel_for(size_t(0), volumes.size(),
+                      [&](size_t i) { volumes[i].parts = Slic3r::its_split(volumes[i].original); });
+    std::vector<Job> jobs;
+    for (Volume& volume : volumes) {
+        // its_quadric_edge_collapse bounds the quadric error, a sum of squared
+        // distances to the planes around each vertex, in mesh units.
+        const double tolerance = tolerance_mm / volume.scale;
+        const float max_error = float(tolerance * tolerance);
+        for (indexed_triangle_set& part : volume.parts) {
+            if (part.indices.size() >= kMinPartTriangles) {
+                jobs.push_back({&part, max_error});
+            }
+        }
+    }
+    std::sort(jobs.begin(), jobs.end(),
+              [](const Job& a, const Job& b) { return a.its->indices.size() > b.its->indices.size(); });
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, jobs.size(), 1), [&](const tbb::blocked_range<size_t>& range) {
+        for (size_t i = range.begin(); i < range.end(); ++i) {
+            float max_error = jobs[i].max_error;
+            Slic3r::its_quadric_edge_collapse(*jobs[i].its, 0, &max_error);
+        }
+    });
+    report.parts = jobs.size();
+
+    double weighted_mean = 0.0;
+    for (Volume& volume : volumes) {
+        indexed_triangle_set decimated;
+        for (const indexed_triangle_set& part : volume.parts) {
+            Slic3r::its_merge(decimated, part);
+        }
+        const size_t before = volume.original.indices.size();
+        const size_t after = decimated.indices.size();
+        report.triangles_before += before;
+        if (after == 0 || after >= before) {
+            report.triangles_after += before;
+            continue;
+        }
+        const Deviation deviation = hausdorff(volume.original, decimated);
+        report.hausdorff_mm = std::max(report.hausdorff_mm, deviation.max * volume.scale);
+        weighted_mean += deviation.mean * volume.scale * double(before);
+        report.triangles_after += after;
+        ++report.volumes;
+
+        Slic3r::ModelObject* object = volume.volume->get_object();
+        volume.volume->set_mesh(Slic3r::TriangleMesh(std::move(decimated)));
+        volume.volume->calculate_convex_hull();
+        volume.volume->set_new_unique_id();
+        object->invalidate_bounding_box();
+    }
+    if (report.triangles_before > 0) {
+        report.mean_deviation_mm = weighted_mean / double(report.triangles_before);
+    }
+    return report;
+}
+
+} // namespace orc::decimate
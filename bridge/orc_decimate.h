@@ -0,0 +1,61 @@
+#ifndef ORCA_WASM_ORC_DECIMATE_H
+#define ORCA_WASM_ORC_DECIMATE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <admesh/stl.h>
+#include <nlohmann/json.hpp>
+
+namespace Slic3r {
+class DynamicPrintConfig;
+class Model;
+}
+
+// Pre-slice decimation of dense meshes (3D scans, fine CAD exports) down to
+// the detail the printer can reproduce. Each model part volume is split into
+// its connected parts, every part is collapsed with libslic3r's
+// its_quadric_edge_collapse under an error bound derived from the print
+// resolution, and the parts are collapsed in parallel, largest first. A part
+// is never cut into spatial chunks: the collapse has no way to pin seam
+// vertices, so chunk borders would drift apart and open the mesh.
+//
+// The deviation introduced is measured afterwards as a vertex-sampled
+// symmetric Hausdorff distance between the original and decimated surfaces.
+namespace orc::decimate {
+
+struct Report {
+    double tolerance_mm = 0.0;
+    uint64_t volumes = 0;
+    uint64_t parts = 0;
+    uint64_t triangles_before = 0;
+    uint64_t triangles_after = 0;
+    // Largest and mean surface deviation over all decimated volumes, in mm.
+    double hausdorff_mm = 0.0;
+    double mean_deviation_mm = 0.0;
+
+    nlohmann::json to_json() const;
+};
+
+struct Deviation {
+    double max = 0.0;
+    double mean = 0.0;
+};
+
+// Target surface deviation in mm: a quarter layer or an eighth of the
+// smallest nozzle, whichever is finer, but never below `resolution`.
+double tolerance_from_config(const Slic3r::DynamicPrintConfig& config);
+
+// Decimates every model part volume of at least `min_triangles` facets so that
+// its surface stays within `tolerance_mm` (in print space, i.e. after the
+// first instance's scaling) of the original. Volumes that do not shrink are
+// left untouched.
+Report decimate_model(Slic3r::Model& model, double tolerance_mm, size_t min_triangles = 20000);
+
+// Symmetric Hausdorff distance between two meshes, measured from up to
+// `max_samples` vertices of each mesh to the other's surface.
+Deviation hausdorff(const indexed_triangle_set& a, const indexed_triangle_set& b, size_t max_samples = 1 << 20);
+
+} // namespace orc::decimate
+
+#endif
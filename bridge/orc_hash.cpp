@@ -0,0 +1,286 @@
+#include "orc_hash.h"
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace orc::hash {
+
+namespace {
+
+static constexpr uint64_t kPrime32_1 = 0x9E3779B1u;
+static constexpr uint64_t kPrime32_2 = 0x85EBCA77u;
+static constexpr uint64_t kPrime32_3 = 0xC2B2AE3Du;
+static constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ull;
+static constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5ull;
+
+static constexpr size_t kStripesPerBlock = 16;
+// One 64-bit secret word per lane for each stripe offset of a block, plus the
+// scramble and finalization keys at the end.
+static constexpr size_t kSecretWords = 8 + kStripesPerBlock + 8;
+
+// splitmix64 expansion of a fixed seed, computed at compile time.
+static constexpr std::array<uint64_t, kSecretWords> make_secret()
+{
+    std::array<uint64_t, kSecretWords> secret{};
+    uint64_t state = 0x6f72632d68617368ull; // "orc-hash"
+    for (uint64_t& word : secret) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        word = z ^ (z >> 31);
+    }
+    return secret;
+}
+
+static constexpr std::array<uint64_t, kSecretWords> kSecret = make_secret();
+static constexpr size_t kScrambleKey = kStripesPerBlock;
+static constexpr size_t kFinalKey = kStripesPerBlock + 8;
+
+static inline uint64_t read64(const uint8_t* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t mul128_fold64(uint64_t a, uint64_t b)
+{
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+static inline uint64_t avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ull;
+    return h ^ (h >> 32);
+}
+
+static uint64_t merge(const uint64_t* acc, size_t key, uint64_t start)
+{
+    uint64_t result = start;
+    for (size_t i = 0; i < 8; i += 2) {
+        result += mul128_fold64(acc[i] ^ kSecret[key + i], acc[i + 1] ^ kSecret[key + i + 1]);
+    }
+    return avalanche(result);
+}
+
+// One stripe per call of the inner loop, each 64-bit lane i taking
+//     acc[i ^ 1] += data[i];  acc[i] += lo32(data[i] ^ key[i]) * hi32(data[i] ^ key[i])
+// with the key sliding one word per stripe.
+#if defined(__wasm_simd128__)
+
+static void accumulate(uint64_t* acc, const uint8_t* p, size_t stripes, const uint64_t* secret)
+{
+    v128_t a[4];
+    for (size_t i = 0; i < 4; ++i) {
+        a[i] = wasm_v128_load(acc + 2 * i);
+    }
+    for (size_t s = 0; s < stripes; ++s, p += 64, ++secret) {
+        for (size_t i = 0; i < 4; ++i) {
+            const v128_t data = wasm_v128_load(p + 16 * i);
+            const v128_t keyed = wasm_v128_xor(data, wasm_v128_load(secret + 2 * i));
+            const v128_t lo = wasm_i32x4_shuffle(keyed, keyed, 0, 2, 0, 2);
+            const v128_t hi = wasm_i32x4_shuffle(keyed, keyed, 1, 3, 1, 3);
+            const v128_t product = wasm_u64x2_extmul_low_u32x4(lo, hi);
+            const v128_t swapped = wasm_i64x2_shuffle(data, data, 1, 0);
+            a[i] = wasm_i64x2_add(a[i], wasm_i64x2_add(product, swapped));
+        }
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        wasm_v128_store(acc + 2 * i, a[i]);
+    }
+}
+
+static void scramble(uint64_t* acc, const uint64_t* key)
+{
+    const v128_t prime = wasm_i64x2_splat(static_cast<int64_t>(kPrime32_1));
+    for (size_t i = 0; i < 4; ++i) {
+        v128_t a = wasm_v128_load(acc + 2 * i);
+        a = wasm_v128_xor(a, wasm_u64x2_shr(a, 47));
+        a = wasm_v128_xor(a, wasm_v128_load(key + 2 * i));
+        wasm_v128_store(acc + 2 * i, wasm_i64x2_mul(a, prime));
+    }
+}
+
+#elif defined(__SSE2__)
+
+static void accumulate(uint64_t* acc, const uint8_t* p, size_t stripes, const uint64_t* secret)
+{
+    __m128i a[4];
+    for (size_t i = 0; i < 4; ++i) {
+        a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + 2 * i));
+    }
+    for (size_t s = 0; s < stripes; ++s, p += 64, ++secret) {
+        for (size_t i = 0; i < 4; ++i) {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+            const __m128i keyed = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret + 2 * i)));
+            const __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+            const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+        }
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 2 * i), a[i]);
+    }
+}
+
+static void scramble(uint64_t* acc, const uint64_t* key)
+{
+    const __m128i prime = _mm_set1_epi32(static_cast<int>(kPrime32_1));
+    for (size_t i = 0; i < 4; ++i) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + 2 * i));
+        a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+        a = _mm_xor_si128(a, _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 2 * i)));
+        // 64x32-bit multiply from two 32x32->64 halves.
+        const __m128i lo = _mm_mul_epu32(a, prime);
+        const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 2 * i), _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+    }
+}
+
+#else
+
+static void accumulate(uint64_t* acc, const uint8_t* p, size_t stripes, const uint64_t* secret)
+{
+    for (size_t s = 0; s < stripes; ++s, p += 64, ++secret) {
+        for (size_t i = 0; i < 8; ++i) {
+            const uint64_t value = read64(p + 8 * i);
+            const uint64_t keyed = value ^ secret[i];
+            acc[i ^ 1] += value;
+            acc[i] += (keyed & 0xffffffffu) * (keyed >> 32);
+        }
+    }
+}
+
+static void scramble(uint64_t* acc, const uint64_t* key)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= key[i];
+        acc[i] = a * kPrime32_1;
+    }
+}
+
+#endif
+
+} // namespace
+
+const char* backend()
+{
+#if defined(__wasm_simd128__)
+    return "simd128";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+std::string Digest::hex() const
+{
+    char buffer[33];
+    std::snprintf(buffer, sizeof(buffer), "%016" PRIx64 "%016" PRIx64, hi, lo);
+    return buffer;
+}
+
+Hasher::Hasher(uint64_t seed) : m_seed(seed)
+{
+    const uint64_t init[8] = {kPrime32_3, kPrime64_1, kPrime64_2, kPrime64_3,
+                              kPrime64_4, kPrime32_2, kPrime64_5, kPrime32_1};
+    for (size_t i = 0; i < 8; ++i) {
+        m_acc[i] = init[i] + ((i & 1) ? ~seed : seed);
+    }
+}
+
+void Hasher::consume(const uint8_t* p, size_t stripes)
+{
+    while (stripes > 0) {
+        const size_t run = std::min(stripes, kStripesPerBlock - m_stripe_in_block);
+        accumulate(m_acc, p, run, kSecret.data() + m_stripe_in_block);
+        p += run * kStripe;
+        stripes -= run;
+        m_stripe_in_block += run;
+        if (m_stripe_in_block == kStripesPerBlock) {
+            scramble(m_acc, kSecret.data() + kScrambleKey);
+            m_stripe_in_block = 0;
+        }
+    }
+}
+
+void Hasher::update(const void* data, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    m_total += len;
+    if (m_buffered > 0) {
+        const size_t take = std::min(len, kStripe - m_buffered);
+        std::memcpy(m_buffer + m_buffered, p, take);
+        m_buffered += take;
+        p += take;
+        len -= take;
+        if (m_buffered < kStripe) {
+            return;
+        }
+        consume(m_buffer, 1);
+        m_buffered = 0;
+    }
+    const size_t stripes = len / kStripe;
+    consume(p, stripes);
+    p += stripes * kStripe;
+    len -= stripes * kStripe;
+    if (len > 0) {
+        std::memcpy(m_buffer, p, len);
+        m_buffered = len;
+    }
+}
+
+void Hasher::field(const std::string& text)
+{
+    const uint64_t size = text.size();
+    update(&size, sizeof(size));
+    update(text.data(), text.size());
+}
+
+void Hasher::field(const Digest& digest)
+{
+    const uint64_t words[2] = {digest.lo, digest.hi};
+    update(words, sizeof(words));
+}
+
+Digest Hasher::finish() const
+{
+    Hasher tail = *this;
+    if (tail.m_buffered > 0) {
+        std::memset(tail.m_buffer + tail.m_buffered, 0, kStripe - tail.m_buffered);
+        tail.consume(tail.m_buffer, 1);
+    }
+    Digest digest;
+    digest.lo = merge(tail.m_acc, kFinalKey, m_total * kPrime64_1 ^ m_seed);
+    digest.hi = merge(tail.m_acc, kFinalKey - 8, ~(m_total * kPrime64_2) ^ m_seed);
+    return digest;
+}
+
+Digest hash128(const void* data, size_t len, uint64_t seed)
+{
+    Hasher hasher(seed);
+    hasher.update(data, len);
+    return hasher.finish();
+}
+
+} // namespace orc::hash
@@ -0,0 +1,68 @@
+#ifndef ORCA_WASM_ORC_HASH_H
+#define ORCA_WASM_ORC_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Fast 128-bit content hash for cache keys. The layout follows XXH3: eight
+// 64-bit lanes absorb 64-byte stripes with one 32x32->64 multiply per lane,
+// the lanes are scrambled every 1 KiB block and folded into two 64-bit
+// halves at the end. The stripe loop runs two lanes per 128-bit vector with
+// wasm simd128 or SSE2 and gives the same digest as the scalar path. Not
+// compatible with xxHash's output and not cryptographic; it only has to make
+// accidental collisions between meshes and configs negligible.
+namespace orc::hash {
+
+struct Digest {
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+
+    bool operator==(const Digest& other) const { return lo == other.lo && hi == other.hi; }
+    bool operator!=(const Digest& other) const { return !(*this == other); }
+
+    // 32 lowercase hex digits, hi first.
+    std::string hex() const;
+};
+
+// For unordered containers keyed by Digest.
+struct DigestHasher {
+    size_t operator()(const Digest& digest) const { return static_cast<size_t>(digest.lo ^ (digest.hi >> 7)); }
+};
+
+// Streaming form; update() may be called with any split of the input and
+// gives the same digest as one call over the concatenation.
+class Hasher {
+public:
+    explicit Hasher(uint64_t seed = 0);
+
+    void update(const void* data, size_t len);
+    // Length-prefixed, so a sequence of fields cannot collide with a
+    // different split of the same bytes.
+    void field(const std::string& text);
+    void field(const Digest& digest);
+
+    Digest finish() const;
+
+private:
+    static constexpr size_t kStripe = 64;
+
+    // Whole stripes, scrambling at block boundaries.
+    void consume(const uint8_t* p, size_t stripes);
+
+    uint64_t m_acc[8];
+    uint8_t m_buffer[kStripe];
+    size_t m_buffered = 0;
+    size_t m_stripe_in_block = 0;
+    uint64_t m_total = 0;
+    uint64_t m_seed;
+};
+
+Digest hash128(const void* data, size_t len, uint64_t seed = 0);
+
+// "simd128", "sse2" or "scalar": the stripe loop compiled in.
+const char* backend();
+
+} // namespace orc::hash
+
+#endif
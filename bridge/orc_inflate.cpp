@@ -0,0 +1,258 @@
+#include "orc_inflate.h"
+
+#include "orc_clock.h"
+
+#include <cctype>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <miniz.h>
+
+namespace orc::inflate {
+
+namespace {
+
+// Inflated bytes handed to the sink per write.
+static constexpr size_t kWindow = 64 * 1024;
+
+static constexpr size_t kGzipHeader = 10;
+static constexpr size_t kGzipTrailer = 8;
+static constexpr uint8_t kGzipDeflate = 8;
+static constexpr uint8_t kGzipHeaderCrc = 0x02;
+static constexpr uint8_t kGzipExtra = 0x04;
+static constexpr uint8_t kGzipName = 0x08;
+static constexpr uint8_t kGzipComment = 0x10;
+static constexpr uint8_t kGzipReserved = 0xe0;
+
+static uint32_t read_le32(const uint8_t* p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+// Keeps the sink's share out of inflate_ms.
+struct Timed {
+    Sink& sink;
+    uint64_t bytes = 0;
+    double sink_ms = 0.0;
+    bool stopped = false;
+
+    bool write(const uint8_t* data, size_t len)
+    {
+        bytes += len;
+        const double start = now_ms();
+        stopped = !sink.write(data, len);
+        sink_ms += now_ms() - start;
+        return !stopped;
+    }
+};
+
+// Offset of the deflate data after the member header, 0 if the header is bad.
+static size_t gzip_data_offset(const uint8_t* data, size_t len)
+{
+    if (len < kGzipHeader + kGzipTrailer || data[2] != kGzipDeflate || (data[3] & kGzipReserved) != 0) {
+        return 0;
+    }
+    const uint8_t flags = data[3];
+    size_t offset = kGzipHeader;
+    if (flags & kGzipExtra) {
+        if (len - offset < 2) {
+            return 0;
+        }
+        offset += 2 + (size_t(data[offset]) | size_t(data[offset + 1]) << 8);
+    }
+    for (const uint8_t flag : {kGzipName, kGzipComment}) {
+        if ((flags & flag) == 0 || offset >= len) {
+            continue;
+        }
+        const void* end = std::memchr(data + offset, 0, len - offset);
+        if (end == nullptr) {
+            return 0;
+        }
+        offset = size_t(static_cast<const uint8_t*>(end) - data) + 1;
+    }
+    if (flags & kGzipHeaderCrc) {
+        offset += 2;
+    }
+    return offset <= len - kGzipTrailer ? offset : 0;
+}
+
+static bool inflate_gzip(const uint8_t* data, size_t len, Timed& out, std::string& error)
+{
+    const size_t offset = gzip_data_offset(data, len);
+    if (offset == 0) {
+        error = "bad gzip header";
+        return false;
+    }
+    const uint32_t expected_crc = read_le32(data + len - kGzipTrailer);
+    const uint32_t expected_size = read_le32(data + len - 4);
+    if (!out.sink.begin(expected_size)) {
+        out.stopped = true;
+        error = "rejected by the reader";
+        return false;
+    }
+
+    mz_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (mz_inflateInit2(&stream, -MZ_DEFAULT_WINDOW_BITS) != MZ_OK) {
+        error = "inflate init failed";
+        return false;
+    }
+    stream.next_in = data + offset;
+    stream.avail_in = static_cast<unsigned int>(len - offset - kGzipTrailer);
+    std::vector<uint8_t> window(kWindow);
+    mz_ulong crc = MZ_CRC32_INIT;
+    int status = MZ_OK;
+    while (status == MZ_OK) {
+        stream.next_out = window.data();
+        stream.avail_out = static_cast<unsigned int>(window.size());
+        status = mz_inflate(&stream, MZ_NO_FLUSH);
+        const size_t produced = window.size() - stream.avail_out;
+        if (produced == 0) {
+            continue;
+        }
+        crc = mz_crc32(crc, window.data(), produced);
+        if (!out.write(window.data(), produced)) {
+            break;
+        }
+    }
+    mz_inflateEnd(&stream);
+
+    if (out.stopped) {
+        error = "rejected by the reader";
+        return false;
+    }
+    if (status != MZ_STREAM_END) {
+        error = "gzip data is corrupt or truncated";
+        return false;
+    }
+    if (stream.avail_in != 0) {
+        error = "multi-member gzip is not supported";
+        return false;
+    }
+    if (uint32_t(crc) != expected_crc || uint32_t(out.bytes) != expected_size) {
+        error = "gzip CRC or length mismatch";
+        return false;
+    }
+    return true;
+}
+
+static bool is_stl_name(const char* name)
+{
+    const size_t n = std::strlen(name);
+    if (n < 4 || name[n - 4] != '.') {
+        return false;
+    }
+    return std::tolower(static_cast<unsigned char>(name[n - 3])) == 's'
+        && std::tolower(static_cast<unsigned char>(name[n - 2])) == 't'
+        && std::tolower(static_cast<unsigned char>(name[n - 1])) == 'l';
+}
+
+static size_t zip_write(void* opaque, mz_uint64 /*offset*/, const void* data, size_t len)
+{
+    return static_cast<Timed*>(opaque)->write(static_cast<const uint8_t*>(data), len) ? len : 0;
+}
+
+static bool inflate_zip(const uint8_t* data, size_t len, Timed& out, Stats& stats, std::string& error)
+{
+    mz_zip_archive zip;
+    mz_zip_zero_struct(&zip);
+    if (!mz_zip_reader_init_mem(&zip, data, len, 0)) {
+        error = std::string("bad zip: ") + mz_zip_get_error_string(mz_zip_get_last_error(&zip));
+        return false;
+    }
+    const std::unique_ptr<mz_zip_archive, mz_bool (*)(mz_zip_archive*)> close(&zip, &mz_zip_reader_end);
+
+    int chosen = -1;
+    int only = -1;
+    mz_uint files = 0;
+    const mz_uint count = mz_zip_reader_get_num_files(&zip);
+    for (mz_uint i = 0; i < count && chosen < 0; ++i) {
+        mz_zip_archive_file_stat stat;
+        if (mz_zip_reader_is_file_a_directory(&zip, i) || !mz_zip_reader_file_stat(&zip, i, &stat)) {
+            continue;
+        }
+        ++files;
+        only = int(i);
+        if (is_stl_name(stat.m_filename)) {
+            chosen = int(i);
+        }
+    }
+    if (chosen < 0 && files == 1) {
+        chosen = only;
+    }
+    if (chosen < 0) {
+        error = "no .stl entry in the zip";
+        return false;
+    }
+    mz_zip_archive_file_stat stat;
+    if (!mz_zip_reader_file_stat(&zip, mz_uint(chosen), &stat)) {
+        error = "bad zip entry";
+        return false;
+    }
+    stats.entry = stat.m_filename;
+    if (!out.sink.begin(stat.m_uncomp_size)) {
+        out.stopped = true;
+        error = "rejected by the reader";
+        return false;
+    }
+    const bool extracted = mz_zip_reader_extract_to_callback(&zip, mz_uint(chosen), &zip_write, &out, 0);
+    if (out.stopped) {
+        error = "rejected by the reader";
+        return false;
+    }
+    if (!extracted) {
+        error = stats.entry + ": " + mz_zip_get_error_string(mz_zip_get_last_error(&zip));
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+Format detect(const uint8_t* data, size_t len)
+{
+    if (len >= 2 && data[0] == 0x1f && data[1] == 0x8b) {
+        return Format::Gzip;
+    }
+    if (len >= 4 && data[0] == 'P' && data[1] == 'K' && data[2] == 3 && data[3] == 4) {
+        return Format::Zip;
+    }
+    return Format::None;
+}
+
+nlohmann::json Stats::to_json() const
+{
+    nlohmann::json out = {
+        {"format", format == Format::Gzip ? "gzip" : format == Format::Zip ? "zip" : "none"},
+        {"compressedBytes", compressed_bytes},
+        {"inflatedBytes", inflated_bytes},
+        {"inflateMs", inflate_ms},
+    };
+    if (!entry.empty()) {
+        out["entry"] = entry;
+    }
+    return out;
+}
+
+bool inflate(const uint8_t* data, size_t len, Sink& sink, Stats& stats, std::string& error)
+{
+    stats = Stats{};
+    stats.format = detect(data, len);
+    stats.compressed_bytes = len;
+    Timed out{sink};
+    const double start = now_ms();
+    bool ok = false;
+    if (stats.format == Format::Gzip) {
+        ok = inflate_gzip(data, len, out, error);
+    } else if (stats.format == Format::Zip) {
+        ok = inflate_zip(data, len, out, stats, error);
+    } else {
+        error = "not gzip or zip";
+    }
+    stats.inflated_bytes = out.bytes;
+    stats.inflate_ms = now_ms() - start - out.sink_ms;
+    return ok;
+}
+
+} // namespace orc::inflate
@@ -0,0 +1,58 @@
+#ifndef ORCA_WASM_ORC_INFLATE_H
+#define ORCA_WASM_ORC_INFLATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+// gzip- and zip-wrapped uploads. The compressed buffer is read where it lies
+// and miniz inflates it through one fixed window that is handed to a Sink
+// piece by piece, so the inflated file never exists in memory as a whole.
+//
+//   - gzip: a single member (RFC 1952). The CRC-32 and the length are checked
+//     against the trailer, whose length field also announces the size up
+//     front (modulo 4 GiB, which wasm32 cannot reach anyway).
+//   - zip: the first entry ending in .stl, or the archive's only file. miniz
+//     checks the entry's CRC-32. 3MF packages are zips as well; callers route
+//     them to orc::threemf first.
+namespace orc::inflate {
+
+enum class Format {
+    None,
+    Gzip,
+    Zip,
+};
+
+// By signature only.
+Format detect(const uint8_t* data, size_t len);
+
+struct Stats {
+    Format format = Format::None;
+    // Zip entry that was read.
+    std::string entry;
+    uint64_t compressed_bytes = 0;
+    uint64_t inflated_bytes = 0;
+    // Time spent inflating, not counting the sink.
+    double inflate_ms = 0.0;
+
+    nlohmann::json to_json() const;
+};
+
+class Sink {
+public:
+    virtual ~Sink() = default;
+    // The inflated size, once, before any data.
+    virtual bool begin(uint64_t size) = 0;
+    // Returning false stops inflating.
+    virtual bool write(const uint8_t* data, size_t len) = 0;
+};
+
+// False when the wrapper is damaged or unsupported, or when the sink stopped;
+// `error` says which.
+bool inflate(const uint8_t* data, size_t len, Sink& sink, Stats& stats, std::string& error);
+
+} // namespace orc::inflate
+
+#endif
@@ -0,0 +1,362 @@
+#include "orc_layer_cache.h"
+
+#include "orc_cache.h"
+#include "orc_log.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <libslic3r/Model.hpp>
+#include <libslic3r/Print.hpp>
+#include <libslic3r/PrintConfig.hpp>
+#include <libslic3r/libslic3r_version.h>
+
+namespace orc::layer_cache {
+
+namespace {
+
+// "ORCL", then the format version. Bump the version whenever Record or the
+// meaning of its fields changes; old records are then treated as misses.
+static constexpr uint32_t kMagic = 0x4c43524f;
+static constexpr uint32_t kFormatVersion = 1;
+static constexpr uint32_t kNoObject = std::numeric_limits<uint32_t>::max();
+
+// Print-wide options read by the object steps: flow widths follow the nozzle
+// and filament, layer heights the printer limits, support the filament roles.
+// Keys this build does not know are skipped.
+static constexpr const char* kPrintKeys[] = {
+    "filament_diameter",
+    "filament_is_support",
+    "filament_shrink",
+    "filament_soluble",
+    "filament_type",
+    "initial_layer_print_height",
+    "max_layer_height",
+    "min_layer_height",
+    "nozzle_diameter",
+    "print_sequence",
+    "printable_area",
+    "printable_height",
+};
+
+// One exported file. Files named after an object's ModelObject id are stored
+// by the object's position in Print::objects() instead, since ids are
+// process-wide counters and differ in the next run.
+struct File {
+    uint32_t object = kNoObject;
+    std::string prefix;
+    std::string suffix;
+    bool msgpack = false;
+    std::string bytes;
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(object, prefix, suffix, msgpack, bytes);
+    }
+};
+
+struct Record {
+    std::string slicer_version;
+    uint32_t objects = 0;
+    std::vector<File> files;
+};
+
+static const std::vector<std::string>& object_step_keys()
+{
+    static const std::vector<std::string> keys = [] {
+        std::vector<std::string> out = Slic3r::PrintObjectConfig().keys();
+        const std::vector<std::string> region = Slic3r::PrintRegionConfig().keys();
+        out.insert(out.end(), region.begin(), region.end());
+        out.insert(out.end(), std::begin(kPrintKeys), std::end(kPrintKeys));
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }();
+    return keys;
+}
+
+static std::vector<std::string> list_files(const std::string& dir)
+{
+    std::vector<std::string> names;
+    if (DIR* handle = opendir(dir.c_str())) {
+        while (const dirent* item = readdir(handle)) {
+            const std::string name = item->d_name;
+            if (name != "." && name != "..") {
+                names.push_back(name);
+            }
+        }
+        closedir(handle);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// Creates `dir` if needed and removes whatever an earlier call left in it.
+static bool prepare_dir(const std::string& dir)
+{
+    if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        ORC_WARN("[orc_layer_cache] cannot create %s\n", dir.c_str());
+        return false;
+    }
+    for (const std::string& name : list_files(dir)) {
+        unlink((dir + "/" + name).c_str());
+    }
+    return true;
+}
+
+// Empties and removes a prepared directory on every way out, exceptions
+// included, so the session's scratch directory can be removed in turn.
+class ScratchDir {
+public:
+    explicit ScratchDir(const std::string& dir) : m_dir(dir) {}
+    ScratchDir(const ScratchDir&) = delete;
+    ScratchDir& operator=(const ScratchDir&) = delete;
+
+    ~ScratchDir() { remove(); }
+
+    // Early, to free the files (memory under MEMFS) as soon as they are read.
+    void remove()
+    {
+        if (m_removed) {
+            return;
+        }
+        m_removed = true;
+        for (const std::string& name : list_files(m_dir)) {
+            unlink((m_dir + "/" + name).c_str());
+        }
+        rmdir(m_dir.c_str());
+    }
+
+private:
+    const std::string& m_dir;
+    bool m_removed = false;
+};
+
+static bool read_file(const std::string& path, std::string& out)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = fseeko(f, 0, SEEK_END) == 0;
+    const off_t size = ok ? ftello(f) : -1;
+    ok = ok && size >= 0 && fseeko(f, 0, SEEK_SET) == 0;
+    if (ok) {
+        out.resize(static_cast<size_t>(size));
+        ok = out.empty() || std::fread(&out[0], 1, out.size(), f) == out.size();
+    }
+    std::fclose(f);
+    return ok;
+}
+
+static bool write_file(const std::string& path, const std::string& data)
+{
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        return false;
+    }
+    const bool written = data.empty() || std::fwrite(data.data(), 1, data.size(), f) == data.size();
+    return std::fclose(f) == 0 && written;
+}
+
+static std::vector<std::string> object_ids(const Slic3r::Print& print)
+{
+    std::vector<std::string> ids;
+    for (const Slic3r::PrintObject* object : print.objects()) {
+        ids.push_back(std::to_string(object->model_object()->id().id));
+    }
+    return ids;
+}
+
+// Splits `name` around the first digit run that is one of `ids`.
+static void split_name(const std::string& name, const std::vector<std::string>& ids, File& file)
+{
+    for (size_t begin = 0; begin < name.size();) {
+        if (!std::isdigit(static_cast<unsigned char>(name[begin]))) {
+            ++begin;
+            continue;
+        }
+        size_t end = begin;
+        while (end < name.size() && std::isdigit(static_cast<unsigned char>(name[end]))) {
+            ++end;
+        }
+        const auto it = std::find(ids.begin(), ids.end(), name.substr(begin, end - begin));
+        if (it != ids.end()) {
+            file.object = static_cast<uint32_t>(it - ids.begin());
+            file.prefix = name.substr(0, begin);
+            file.suffix = name.substr(end);
+            return;
+        }
+        begin = end;
+    }
+    file.prefix = name;
+}
+
+static std::string pack(const Record& record)
+{
+    std::ostringstream stream(std::ios::binary);
+    cereal::BinaryOutputArchive ar(stream);
+    ar(kMagic, kFormatVersion, record.slicer_version, record.objects, record.files);
+    return stream.str();
+}
+
+// False for another format version or a different slicer build; throws
+// cereal::Exception on a truncated record.
+static bool unpack(const std::string& bytes, Record& record)
+{
+    std::istringstream stream(bytes, std::ios::binary);
+    cereal::BinaryInputArchive ar(stream);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    ar(magic, version);
+    if (magic != kMagic || version != kFormatVersion) {
+        return false;
+    }
+    ar(record.slicer_version, record.objects, record.files);
+    return record.slicer_version == SLIC3R_VERSION;
+}
+
+} // namespace
+
+nlohmann::json Report::to_json() const
+{
+    return {
+        {"key", key.hex()},
+        {"objects", objects},
+        {"files", files},
+        {"exportedBytes", exported_bytes},
+        {"recordBytes", record_bytes},
+    };
+}
+
+hash::Digest key(const hash::Digest& mesh, const Slic3r::DynamicPrintConfig& config, const nlohmann::json& extra)
+{
+    hash::Hasher hasher;
+    hasher.field("orc-layers/" + std::to_string(kFormatVersion) + "/" SLIC3R_VERSION);
+    hasher.field(mesh);
+    for (const std::string& name : object_step_keys()) {
+        if (const Slic3r::ConfigOption* option = config.option(name)) {
+            hasher.field(name);
+            hasher.field(option->serialize());
+        }
+    }
+    hasher.field(extra.dump());
+    return hasher.finish();
+}
+
+Outcome restore(Slic3r::Print& print, const hash::Digest& key, const std::string& scratch_dir, Report& report)
+{
+    report.key = key;
+    const std::optional<cache::Entry> entry = cache::find(key);
+    if (!entry) {
+        return Outcome::Miss;
+    }
+    Record record;
+    try {
+        if (!unpack(*entry->data, record)) {
+            ORC_LOG("[orc_layer_cache] record %s is from another build, ignored\n", key.hex().c_str());
+            return Outcome::Miss;
+        }
+    } catch (const cereal::Exception& ex) {
+        ORC_WARN("[orc_layer_cache] record %s unreadable: %s\n", key.hex().c_str(), ex.what());
+        return Outcome::Miss;
+    }
+    const std::vector<std::string> ids = object_ids(print);
+    if (record.objects != ids.size() || !prepare_dir(scratch_dir)) {
+        return Outcome::Miss;
+    }
+    ScratchDir scratch(scratch_dir);
+    for (const File& file : record.files) {
+        if (file.object != kNoObject && file.object >= ids.size()) {
+            return Outcome::Miss;
+        }
+        const std::string name = file.object == kNoObject ? file.prefix : file.prefix + ids[file.object] + file.suffix;
+        std::string contents;
+        if (file.msgpack) {
+            const nlohmann::json parsed = nlohmann::json::from_msgpack(file.bytes, true, false);
+            if (parsed.is_discarded()) {
+                return Outcome::Miss;
+            }
+            contents = parsed.dump();
+        }
+        const std::string& data = file.msgpack ? contents : file.bytes;
+        report.exported_bytes += data.size();
+        if (!write_file(scratch_dir + "/" + name, data)) {
+            ORC_WARN("[orc_layer_cache] cannot write %s/%s\n", scratch_dir.c_str(), name.c_str());
+            return Outcome::Miss;
+        }
+    }
+    const int result = print.load_cached_data(scratch_dir);
+    scratch.remove();
+    if (result != 0) {
+        ORC_WARN("[orc_layer_cache] load_cached_data failed (%d) for %s\n", result, key.hex().c_str());
+        return Outcome::Failed;
+    }
+    report.objects = record.objects;
+    report.files = record.files.size();
+    report.record_bytes = entry->data->size();
+    return Outcome::Restored;
+}
+
+bool save(Slic3r::Print& print, const hash::Digest& key, const std::string& scratch_dir, Report& report)
+{
+    report.key = key;
+    if (!prepare_dir(scratch_dir)) {
+        return false;
+    }
+    ScratchDir scratch(scratch_dir);
+    const int result = print.export_cached_data(scratch_dir, false);
+    if (result != 0) {
+        ORC_WARN("[orc_layer_cache] export_cached_data failed (%d)\n", result);
+        return false;
+    }
+    const std::vector<std::string> ids = object_ids(print);
+    Record record;
+    record.slicer_version = SLIC3R_VERSION;
+    record.objects = static_cast<uint32_t>(ids.size());
+    for (const std::string& name : list_files(scratch_dir)) {
+        File file;
+        split_name(name, ids, file);
+        if (!read_file(scratch_dir + "/" + name, file.bytes)) {
+            ORC_WARN("[orc_layer_cache] cannot read %s/%s\n", scratch_dir.c_str(), name.c_str());
+            return false;
+        }
+        report.exported_bytes += file.bytes.size();
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0) {
+            const nlohmann::json parsed = nlohmann::json::parse(file.bytes, nullptr, false);
+            if (!parsed.is_discarded()) {
+                const std::vector<uint8_t> packed = nlohmann::json::to_msgpack(parsed);
+                file.bytes.assign(packed.begin(), packed.end());
+                file.msgpack = true;
+            }
+        }
+        record.files.push_back(std::move(file));
+    }
+    scratch.remove();
+    const std::string bytes = pack(record);
+    report.objects = record.objects;
+    report.files = record.files.size();
+    report.record_bytes = bytes.size();
+    cache::store(key, key, reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(),
+                 {{"objects", report.objects}, {"exportedBytes", report.exported_bytes}}, cache::Kind::Layers);
+    return true;
+}
+
+} // namespace orc::layer_cache
@@ -0,0 +1,69 @@
+#ifndef ORCA_WASM_ORC_LAYER_CACHE_H
+#define ORCA_WASM_ORC_LAYER_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "orc_hash.h"
+
+namespace Slic3r {
+class DynamicPrintConfig;
+class Print;
+}
+
+// Persistent intermediate results: the per-object layer data of a processed
+// Print (sliced ExPolygons, region surfaces, perimeters, fills, support
+// layers), so a later slice of the same mesh with the same object settings
+// goes straight to the print-wide steps and G-code export.
+//
+// libslic3r owns the layer internals, so the data goes in and out through
+// Print::export_cached_data / load_cached_data (which mark the restored
+// object steps done). The exported files are packed into one versioned
+// cereal binary record, their JSON re-encoded as MessagePack so coordinates
+// are stored as binary integers rather than text, and kept in orc::cache as
+// Kind::Layers: in memory, on disk, or in IndexedDB through the cache's IDBFS
+// directory.
+//
+// The key covers the mesh, the object and region options and the few
+// print-wide options object steps read (nozzle and filament geometry, layer
+// height limits). G-code-only settings such as temperatures, fans or custom
+// G-code templates leave it unchanged, so changing them re-runs only the
+// print-wide steps and the export.
+namespace orc::layer_cache {
+
+enum class Outcome {
+    // No usable record; the print is untouched.
+    Miss,
+    Restored,
+    // load_cached_data ran and failed; the print may hold partial layers and
+    // must be rebuilt before processing.
+    Failed,
+};
+
+struct Report {
+    hash::Digest key;
+    uint64_t objects = 0;
+    uint64_t files = 0;
+    // Size of the files libslic3r wrote and of the packed record.
+    uint64_t exported_bytes = 0;
+    uint64_t record_bytes = 0;
+
+    nlohmann::json to_json() const;
+};
+
+hash::Digest key(const hash::Digest& mesh, const Slic3r::DynamicPrintConfig& config, const nlohmann::json& extra);
+
+// `print` must be applied and not yet processed. `scratch_dir` is created if
+// needed and removed again.
+Outcome restore(Slic3r::Print& print, const hash::Digest& key, const std::string& scratch_dir, Report& report);
+
+// Packs the layers of a processed `print` and stores them under `key`. The
+// export goes through `scratch_dir`, which is removed afterwards.
+bool save(Slic3r::Print& print, const hash::Digest& key, const std::string& scratch_dir, Report& report);
+
+} // namespace orc::layer_cache
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef ORCA_WASM_ORC_LOG_H
+#define ORCA_WASM_ORC_LOG_H
+
+#include <cstdio>
+
+// Progress chatter is compiled out unless ORC_BRIDGE_VERBOSE is set: under
+// Emscripten every flush crosses into JS, and the worker only regex-filters the
+// text again. Timings and progress go to the trace ring instead (orc_trace.h).
+// Warnings and errors stay on stderr in every build.
+#ifndef ORC_BRIDGE_VERBOSE
+#define ORC_BRIDGE_VERBOSE 0
+#endif
+
+#if ORC_BRIDGE_VERBOSE
+#define ORC_LOG(...)                      \
+    do {                                  \
+        std::fprintf(stderr, __VA_ARGS__); \
+        std::fflush(stderr);              \
+    } while (0)
+#else
+#define ORC_LOG(...) \
+    do {             \
+    } while (0)
+#endif
+
+#define ORC_WARN(...)                     \
+    do {                                  \
+        std::fprintf(stderr, __VA_ARGS__); \
+        std::fflush(stderr);              \
+    } while (0)
+
+#endif
@@ -0,0 +1,656 @@
+#include "orc_mesh_load.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+
+namespace orc::mesh {
+
+namespace {
+
+static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+static constexpr size_t kBinaryHeader = 84;
+static constexpr size_t kBinaryFacet = 50;
+
+// Facet records of a binary STL, used in place: the stored normal at +0,
+// corner c at +12 + 12c.
+struct FacetSource {
+    const uint8_t* base = nullptr;
+    size_t stride = 0;
+    size_t count = 0;
+
+    std::array<float, 3> read(size_t facet, size_t offset) const
+    {
+        std::array<float, 3> v;
+        std::memcpy(v.data(), base + facet * stride + offset, sizeof(v));
+        return v;
+    }
+    std::array<float, 3> normal(size_t facet) const { return read(facet, 0); }
+    std::array<float, 3> corner(size_t facet, size_t c) const { return read(facet, 12 + 12 * c); }
+};
+
+// Corners come from the welded vertices, which is what step 1 sees of the
+// input anyway; normals are the stored ones.
+struct WeldedSource {
+    const VertexWelder& welder;
+    const std::vector<uint32_t>& corners;
+    const std::vector<std::array<float, 3>>& normals;
+
+    std::array<float, 3> normal(size_t facet) const { return normals[facet]; }
+    std::array<float, 3> corner(size_t facet, size_t c) const { return welder.vertex(corners[facet * 3 + c]); }
+};
+
+// isspace in the C locale, without the call.
+static inline bool is_space(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline uint32_t fold_zero(float v)
+{
+    uint32_t bits;
+    const float folded = (v == 0.f) ? 0.f : v;
+    std::memcpy(&bits, &folded, sizeof(bits));
+    return bits;
+}
+
+static inline uint64_t mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+static size_t table_size(size_t entries)
+{
+    size_t size = 64;
+    while (size < entries * 2) {
+        size <<= 1;
+    }
+    return size;
+}
+
+// Welded vertex per corner (3 per facet), in input order.
+static std::vector<uint32_t> weld(const FacetSource& src, size_t& unique)
+{
+    // Closed meshes have about half as many vertices as facets.
+    VertexWelder welder(src.count / 2 + 16);
+    std::vector<uint32_t> corners(src.count * 3);
+    for (size_t f = 0; f < src.count; ++f) {
+        for (size_t c = 0; c < 3; ++c) {
+            corners[f * 3 + c] = welder.add(src.corner(f, c));
+        }
+    }
+    unique = welder.size();
+    return corners;
+}
+
+// admesh's stl_check_normal_vector without fixing: 2 when the stored normal
+// is the reverse of the computed one (within 0.001 per component).
+template <class Source>
+static bool stored_normal_reversed(const Source& src, size_t facet)
+{
+    const std::array<float, 3> v0 = src.corner(facet, 0);
+    const std::array<float, 3> v1 = src.corner(facet, 1);
+    const std::array<float, 3> v2 = src.corner(facet, 2);
+    const float a[3] = {v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2]};
+    const float b[3] = {v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2]};
+    float n[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+    const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length > 0.000001f) {
+        for (float& x : n) {
+            x /= length;
+        }
+    }
+    std::array<float, 3> stored = src.normal(facet);
+    auto close = [&n](const std::array<float, 3>& s) {
+        return std::abs(n[0] - s[0]) < 0.001f && std::abs(n[1] - s[1]) < 0.001f && std::abs(n[2] - s[2]) < 0.001f;
+    };
+    if (close(stored)) {
+        return false;
+    }
+    const float stored_length = std::sqrt(stored[0] * stored[0] + stored[1] * stored[1] + stored[2] * stored[2]);
+    if (stored_length > 0.000001f) {
+        for (float& x : stored) {
+            x /= stored_length;
+        }
+    }
+    if (close(stored)) {
+        return false;
+    }
+    for (float& x : stored) {
+        x = -x;
+    }
+    return close(stored);
+}
+
+// Steps 2-5 on the welded corners of `count` facets.
+template <class Source>
+static LoadStatus build(const Source& src, size_t count, std::vector<uint32_t> corners, size_t unique,
+                        indexed_triangle_set& its, LoadStats& stats)
+{
+    // 2) Degenerate facets, removed as stl_check_facets_exact does: the last
+    // facet takes the removed one's place and is checked in turn.
+    std::vector<uint32_t> facet_src(count);
+    for (size_t f = 0; f < count; ++f) {
+        facet_src[f] = uint32_t(f);
+    }
+    size_t facets = count;
+    for (size_t f = 0; f < facets;) {
+        const uint32_t* c = &corners[f * 3];
+        if (c[0] == c[1] || c[1] == c[2] || c[0] == c[2]) {
+            --facets;
+            std::copy_n(&corners[facets * 3], 3, &corners[f * 3]);
+            facet_src[f] = facet_src[facets];
+            ++stats.degenerate_facets;
+        } else {
+            ++f;
+        }
+    }
+    corners.resize(facets * 3);
+    facet_src.resize(facets);
+    if (facets == 0) {
+        return LoadStatus::Malformed;
+    }
+
+    // 3) Adjacency: neighbor[h] is the half-edge paired with h, where half-edge
+    // h = 3 * facet + c runs from corner c to corner c + 1.
+    std::vector<uint32_t> neighbor(facets * 3, kNone);
+    {
+        const size_t half_edges = facets * 3;
+        std::vector<uint32_t> table(table_size(half_edges / 2 + 16), kNone);
+        const size_t mask = table.size() - 1;
+        auto endpoints = [&corners](uint32_t h) {
+            const uint32_t a = corners[h];
+            const uint32_t b = corners[h - h % 3 + (h % 3 + 1) % 3];
+            return std::pair<uint32_t, uint32_t>(std::min(a, b), std::max(a, b));
+        };
+        for (uint32_t h = 0; h < half_edges; ++h) {
+            const auto key = endpoints(h);
+            size_t slot = mix(uint64_t(key.first) << 32 | key.second) & mask;
+            while (table[slot] != kNone && endpoints(table[slot]) != key) {
+                slot = (slot + 1) & mask;
+            }
+            const uint32_t first = table[slot];
+            if (first == kNone) {
+                table[slot] = h;
+            } else if (neighbor[first] == kNone) {
+                neighbor[first] = h;
+                neighbor[h] = first;
+            } else {
+                ++stats.nonmanifold_edges;
+            }
+        }
+        for (uint32_t h = 0; h < half_edges; ++h) {
+            stats.open_edges += neighbor[h] == kNone;
+        }
+    }
+    if (stats.open_edges != 0 || stats.nonmanifold_edges != 0) {
+        return LoadStatus::NeedsRepair;
+    }
+
+    // 4) Orientation, one part at a time from its lowest-numbered facet.
+    std::vector<uint8_t> flipped(facets, 0);
+    std::vector<uint8_t> fixed(facets, 0);
+    std::vector<uint32_t> stack;
+    for (size_t seed = 0; seed < facets && !stats.non_orientable; ++seed) {
+        if (fixed[seed]) {
+            continue;
+        }
+        ++stats.parts;
+        flipped[seed] = stored_normal_reversed(src, facet_src[seed]);
+        fixed[seed] = 1;
+        stack.assign(1, uint32_t(seed));
+        while (!stack.empty() && !stats.non_orientable) {
+            const uint32_t f = stack.back();
+            stack.pop_back();
+            for (uint32_t c = 0; c < 3; ++c) {
+                const uint32_t h = f * 3 + c;
+                const uint32_t other = neighbor[h];
+                const uint32_t g = other / 3;
+                // Both half-edges start at the same vertex: same direction.
+                const bool same_direction = corners[h] == corners[other];
+                const bool agree = same_direction == bool(flipped[f] ^ flipped[g]);
+                if (fixed[g]) {
+                    stats.non_orientable |= !agree;
+                    continue;
+                }
+                flipped[g] = flipped[f] ^ uint8_t(same_direction);
+                fixed[g] = 1;
+                stack.push_back(g);
+            }
+        }
+    }
+    if (stats.non_orientable) {
+        // admesh reverts every flip when it meets a conflict.
+        std::fill(flipped.begin(), flipped.end(), 0);
+    }
+
+    // Signed volume of the oriented mesh; a negative one reverses everything.
+    const double volume = tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(0, facets), 0.,
+        [&](const tbb::blocked_range<size_t>& range, double acc) {
+            for (size_t f = range.begin(); f < range.end(); ++f) {
+                const std::array<float, 3> a = src.corner(facet_src[f], 0);
+                const std::array<float, 3> b = src.corner(facet_src[f], 1);
+                const std::array<float, 3> c = src.corner(facet_src[f], 2);
+                const double triple = double(a[0]) * (double(b[1]) * c[2] - double(b[2]) * c[1])
+                                    - double(a[1]) * (double(b[0]) * c[2] - double(b[2]) * c[0])
+                                    + double(a[2]) * (double(b[0]) * c[1] - double(b[1]) * c[0]);
+                acc += flipped[f] ? -triple : triple;
+            }
+            return acc;
+        },
+        [](double x, double y) { return x + y; });
+    stats.reversed_all = volume < 0.;
+    for (size_t f = 0; f < facets; ++f) {
+        flipped[f] ^= uint8_t(stats.reversed_all);
+        stats.facets_reversed += flipped[f];
+    }
+
+    // 5) Shared vertices in order of first appearance, one per vertex fan.
+    // admesh reverses a facet by swapping corners 0 and 1.
+    auto input_corner = [&flipped](size_t f, int j) { return flipped[f] ? (j == 2 ? 2 : 1 - j) : j; };
+    its.indices.assign(facets, stl_triangle_vertex_indices(-1, -1, -1));
+    its.vertices.reserve(unique);
+    for (size_t f = 0; f < facets; ++f) {
+        for (int j = 0; j < 3; ++j) {
+            if (its.indices[f][j] != -1) {
+                continue;
+            }
+            const int c = input_corner(f, j);
+            const std::array<float, 3> p = src.corner(facet_src[f], size_t(c));
+            its.vertices.emplace_back(p[0] == 0.f ? 0.f : p[0], p[1] == 0.f ? 0.f : p[1], p[2] == 0.f ? 0.f : p[2]);
+            const int index = int(its.vertices.size() - 1);
+            const uint32_t pivot = corners[f * 3 + size_t(c)];
+
+            // Walk the fan around `pivot`: leave each facet through the edge
+            // containing the pivot that we did not enter by.
+            uint32_t facet = uint32_t(f);
+            uint32_t entered = kNone;
+            for (;;) {
+                int k = 0;
+                while (corners[facet * 3 + k] != pivot) {
+                    ++k;
+                }
+                for (int jj = 0; jj < 3; ++jj) {
+                    if (input_corner(facet, jj) == k) {
+                        its.indices[facet][jj] = index;
+                    }
+                }
+                const uint32_t out_a = facet * 3 + uint32_t(k);
+                const uint32_t out_b = facet * 3 + uint32_t((k + 2) % 3);
+                const uint32_t leave = (out_a == entered) ? out_b : out_a;
+                entered = neighbor[leave];
+                facet = entered / 3;
+                if (facet == f || its.indices[facet][0] == index || its.indices[facet][1] == index
+                    || its.indices[facet][2] == index) {
+                    break;
+                }
+            }
+        }
+    }
+    stats.vertices = its.vertices.size();
+    stats.vertices_merged = facets * 3 - its.vertices.size();
+    return LoadStatus::Ok;
+}
+
+} // namespace
+
+nlohmann::json LoadStats::to_json() const
+{
+    return nlohmann::json{
+        {"ascii", ascii},
+        {"facetsRead", facets_read},
+        {"degenerateFacets", degenerate_facets},
+        {"vertices", vertices},
+        {"verticesMerged", vertices_merged},
+        {"openEdges", open_edges},
+        {"nonmanifoldEdges", nonmanifold_edges},
+        {"parts", parts},
+        {"facetsReversed", facets_reversed},
+        {"reversedAll", reversed_all},
+        {"nonOrientable", non_orientable},
+    };
+}
+
+LoadStatus load_stl(const uint8_t* data, size_t len, indexed_triangle_set& its, LoadStats& stats)
+{
+    stats = LoadStats{};
+    its.indices.clear();
+    its.vertices.clear();
+    if (data == nullptr || len == 0) {
+        return LoadStatus::Malformed;
+    }
+
+    // Binary when the size matches the facet count in the header; exporters
+    // that write "solid" into a binary header are common.
+    uint32_t header_count = 0;
+    if (len >= kBinaryHeader) {
+        std::memcpy(&header_count, data + 80, sizeof(header_count));
+    }
+    if (len < kBinaryHeader || (len - kBinaryHeader) % kBinaryFacet != 0
+        || (len - kBinaryHeader) / kBinaryFacet != header_count) {
+        // ASCII has to be parsed anyway; the reader does it without a copy of
+        // the records.
+        StlReader reader(len);
+        reader.feed(data, len);
+        return reader.finish(its, stats);
+    }
+    const FacetSource src{data + kBinaryHeader, kBinaryFacet, header_count};
+    stats.facets_read = src.count;
+    if (src.count == 0 || src.count * 3 >= kNone) {
+        return LoadStatus::Malformed;
+    }
+
+    // 1) Weld.
+    size_t unique = 0;
+    std::vector<uint32_t> corners = weld(src, unique);
+    return build(src, src.count, std::move(corners), unique, its, stats);
+}
+
+VertexWelder::VertexWelder(size_t expected_vertices) : m_table(table_size(expected_vertices), kNone)
+{
+    m_keys.reserve(expected_vertices);
+}
+
+size_t VertexWelder::find_slot(const std::array<uint32_t, 3>& key) const
+{
+    const size_t mask = m_table.size() - 1;
+    size_t slot = mix((uint64_t(key[0]) << 32 | key[1]) ^ mix(key[2])) & mask;
+    while (m_table[slot] != kNone && m_keys[m_table[slot]] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+uint32_t VertexWelder::add(const std::array<float, 3>& v)
+{
+    const std::array<uint32_t, 3> key = {fold_zero(v[0]), fold_zero(v[1]), fold_zero(v[2])};
+    const size_t slot = find_slot(key);
+    if (m_table[slot] != kNone) {
+        return m_table[slot];
+    }
+    const uint32_t id = uint32_t(m_keys.size());
+    m_table[slot] = id;
+    m_keys.push_back(key);
+    // The table doubles whenever it passes half full.
+    if (m_keys.size() * 2 > m_table.size()) {
+        m_table.assign(m_table.size() * 2, kNone);
+        for (uint32_t k = 0; k < m_keys.size(); ++k) {
+            m_table[find_slot(m_keys[k])] = k;
+        }
+    }
+    return id;
+}
+
+std::array<float, 3> VertexWelder::vertex(uint32_t id) const
+{
+    std::array<float, 3> v;
+    std::memcpy(v.data(), m_keys[id].data(), sizeof(v));
+    return v;
+}
+
+StlReader::StlReader(uint64_t size, uint64_t reserve_bytes) : m_size(size), m_reserve_bytes(reserve_bytes)
+{
+    m_pending.reserve(kBinaryHeader);
+}
+
+bool StlReader::feed(const uint8_t* data, size_t len)
+{
+    if (m_mode == Mode::Malformed) {
+        return false;
+    }
+    m_received += len;
+    if (m_mode == Mode::Header) {
+        const size_t take = std::min(len, kBinaryHeader - m_pending.size());
+        m_pending.append(reinterpret_cast<const char*>(data), take);
+        data += take;
+        len -= take;
+        if (m_pending.size() < kBinaryHeader) {
+            return true;
+        }
+        decide();
+    }
+    if (m_mode == Mode::Binary) {
+        feed_binary(data, len);
+    } else if (m_mode == Mode::Ascii) {
+        feed_ascii(reinterpret_cast<const char*>(data), len, false);
+    }
+    return m_mode != Mode::Malformed;
+}
+
+// Same rule as load_stl, on the announced size since the data is not all
+// here yet.
+void StlReader::decide()
+{
+    if (m_size >= kBinaryHeader && m_pending.size() >= kBinaryHeader) {
+        std::memcpy(&m_header_count, m_pending.data() + 80, sizeof(m_header_count));
+        if ((m_size - kBinaryHeader) % kBinaryFacet == 0 && (m_size - kBinaryHeader) / kBinaryFacet == m_header_count) {
+            m_mode = Mode::Binary;
+            m_pending.clear();
+            const size_t reserved = size_t(std::min<uint64_t>(m_header_count, m_reserve_bytes / kBinaryFacet));
+            m_welder = VertexWelder(reserved / 2 + 16);
+            m_corners.reserve(reserved * 3);
+            m_normals.reserve(reserved);
+            return;
+        }
+    }
+    m_mode = Mode::Ascii;
+    std::string header;
+    header.swap(m_pending);
+    feed_ascii(header.data(), header.size(), false);
+}
+
+void StlReader::add_facet(const float* record)
+{
+    m_normals.push_back({record[0], record[1], record[2]});
+    for (size_t c = 0; c < 3; ++c) {
+        m_corners.push_back(m_welder.add({record[3 + 3 * c], record[4 + 3 * c], record[5 + 3 * c]}));
+    }
+}
+
+void StlReader::feed_binary(const uint8_t* data, size_t len)
+{
+    if (m_received > m_size) {
+        m_mode = Mode::Malformed;
+        return;
+    }
+    float record[12];
+    if (!m_pending.empty()) {
+        const size_t take = std::min(len, kBinaryFacet - m_pending.size());
+        m_pending.append(reinterpret_cast<const char*>(data), take);
+        data += take;
+        len -= take;
+        if (m_pending.size() < kBinaryFacet) {
+            return;
+        }
+        std::memcpy(record, m_pending.data(), sizeof(record));
+        add_facet(record);
+        m_pending.clear();
+    }
+    for (; len >= kBinaryFacet; data += kBinaryFacet, len -= kBinaryFacet) {
+        std::memcpy(record, data, sizeof(record));
+        add_facet(record);
+    }
+    m_pending.assign(reinterpret_cast<const char*>(data), len);
+}
+
+void StlReader::feed_ascii(const char* data, size_t len, bool final)
+{
+    if (!m_pending.empty()) {
+        // Finish the token the last piece ended in, then go on in place.
+        size_t take = 0;
+        while (take < len && !is_space(data[take])) {
+            ++take;
+        }
+        const bool complete = take < len || final;
+        m_pending.append(data, take);
+        data += take;
+        len -= take;
+        const size_t used = scan_ascii(m_pending.data(), m_pending.size(), complete);
+        m_pending.erase(0, used);
+        if (!m_pending.empty() || m_mode == Mode::Malformed) {
+            return;
+        }
+    }
+    const size_t used = scan_ascii(data, len, final);
+    if (m_mode != Mode::Malformed) {
+        m_pending.assign(data + used, len - used);
+    }
+}
+
+// "facet normal nx ny nz / outer loop / vertex x y z (x3) / endloop / endfacet",
+// any number of solids. Lines starting with another keyword are skipped.
+// Returns how much of `text` was used; a token running into the end of it is
+// left for the next piece unless `final`.
+size_t StlReader::scan_ascii(const char* text, size_t len, bool final)
+{
+    // Tokens are read in place up to the last space, which also stops strtof
+    // inside the buffer.
+    size_t limit = len;
+    while (limit > 0 && !is_space(text[limit - 1])) {
+        --limit;
+    }
+    size_t i = 0;
+    if (!m_solid_checked) {
+        while (i < len && is_space(text[i])) {
+            ++i;
+        }
+        if (len - i < 5 && !final) {
+            return i;
+        }
+        if (len - i < 5 || std::memcmp(text + i, "solid", 5) != 0) {
+            m_mode = Mode::Malformed;
+            return len;
+        }
+        m_solid_checked = true;
+    }
+    while (i < limit) {
+        if (m_expect == Expect::SkipLine) {
+            const void* eol = std::memchr(text + i, '\n', len - i);
+            if (eol == nullptr) {
+                return len;
+            }
+            i = size_t(static_cast<const char*>(eol) - text) + 1;
+            m_expect = Expect::Keyword;
+        } else if (is_space(text[i])) {
+            ++i;
+        } else if (!ascii_token(text, limit, i)) {
+            m_mode = Mode::Malformed;
+            return len;
+        }
+    }
+    if (i < len && final) {
+        // The last token has no space after it.
+        const std::string tail(text + i, len - i);
+        size_t j = 0;
+        if (m_expect != Expect::SkipLine && !ascii_token(tail.c_str(), tail.size(), j)) {
+            m_mode = Mode::Malformed;
+        }
+        return len;
+    }
+    return std::max(i, limit);
+}
+
+// Reads the token at `text[i]` and moves `i` past it. `text[len]` is a space
+// or the string's terminator.
+bool StlReader::ascii_token(const char* text, size_t len, size_t& i)
+{
+    const char* token = text + i;
+    if (m_expect == Expect::Number) {
+        char* next = nullptr;
+        m_record[m_numbers++] = std::strtof(token, &next);
+        if (next == token) {
+            return false;
+        }
+        // Trailing junk in a number is dropped with it.
+        for (i = size_t(next - text); i < len && !is_space(text[i]); ++i) {
+        }
+        if (m_numbers % 3 == 0) {
+            m_expect = Expect::Keyword;
+            if (m_numbers > 3 && ++m_vertices == 3) {
+                add_facet(m_record);
+            }
+        }
+        return true;
+    }
+    size_t end = i;
+    while (end < len && !is_space(text[end])) {
+        ++end;
+    }
+    const size_t size = end - i;
+    i = end;
+    auto is = [token, size](const char* keyword) {
+        return std::strlen(keyword) == size && std::memcmp(token, keyword, size) == 0;
+    };
+    if (m_expect == Expect::Normal) {
+        m_expect = Expect::Number;
+        return is("normal");
+    }
+    if (is("facet")) {
+        if (m_facet_open && m_vertices != 3) {
+            return false;
+        }
+        m_facet_open = true;
+        m_vertices = 0;
+        m_numbers = 0;
+        m_expect = Expect::Normal;
+    } else if (is("vertex")) {
+        if (!m_facet_open || m_vertices == 3) {
+            return false;
+        }
+        m_expect = Expect::Number;
+    } else if (is("endfacet")) {
+        return m_facet_open && m_vertices == 3;
+    } else {
+        // solid <name>, outer loop, endloop, endsolid <name>
+        m_expect = Expect::SkipLine;
+    }
+    return true;
+}
+
+LoadStatus StlReader::finish(indexed_triangle_set& its, LoadStats& stats)
+{
+    stats = LoadStats{};
+    its.indices.clear();
+    its.vertices.clear();
+    if (m_mode == Mode::Header) {
+        // Shorter than a binary header.
+        decide();
+    }
+    if (m_mode == Mode::Ascii) {
+        feed_ascii(nullptr, 0, true);
+        if (m_mode == Mode::Ascii
+            && (!m_solid_checked || m_expect == Expect::Normal || m_expect == Expect::Number
+                || (m_facet_open && m_vertices != 3))) {
+            m_mode = Mode::Malformed;
+        }
+    } else if (m_mode == Mode::Binary && (m_received != m_size || !m_pending.empty())) {
+        m_mode = Mode::Malformed;
+    }
+    if (m_mode == Mode::Malformed) {
+        return LoadStatus::Malformed;
+    }
+    const size_t count = m_normals.size();
+    if (count == 0 || count * 3 >= kNone) {
+        return LoadStatus::Malformed;
+    }
+    stats.ascii = m_mode == Mode::Ascii;
+    stats.facets_read = count;
+    const WeldedSource src{m_welder, m_corners, m_normals};
+    return build(src, count, m_corners, m_welder.size(), its, stats);
+}
+
+} // namespace orc::mesh
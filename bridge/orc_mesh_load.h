@@ -0,0 +1,134 @@
+#ifndef ORCA_WASM_ORC_MESH_LOAD_H
+#define ORCA_WASM_ORC_MESH_LOAD_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <admesh/stl.h>
+#include <nlohmann/json.hpp>
+
+// Load-time welding and repair for STL buffers, replacing the admesh pass
+// that load_stl() runs (stl_check_facets_exact, stl_fix_normal_directions,
+// volume check, stl_generate_shared_vertices) for the common case of a
+// closed mesh:
+//
+//   1. Vertices are welded through an open-addressing table keyed by the bit
+//      pattern of their coordinates, -0 folded into 0, so exactly the vertices
+//      admesh considers equal merge. Binary STL is read in place.
+//   2. Facets with two equal corners are removed the way admesh does it (the
+//      last facet moves into the hole).
+//   3. Edge-to-facet adjacency comes from one pass over a second table that
+//      stores half-edge ids only.
+//   4. Orientation follows admesh: each connected part takes its first facet's
+//      stored normal as the reference, the rest of the part is flipped to
+//      agree, a non-orientable mesh keeps its original orientation, and a
+//      negative volume reverses everything.
+//   5. Shared vertices are numbered by walking vertex fans in facet order, as
+//      stl_generate_shared_vertices does, so the indexed mesh is the one the
+//      legacy path produces.
+//
+// Meshes with open or non-manifold edges need admesh's tolerance-based
+// repair; load() reports NeedsRepair for them and the caller falls back to
+// the legacy loader.
+namespace orc::mesh {
+
+struct LoadStats {
+    bool ascii = false;
+    uint64_t facets_read = 0;
+    uint64_t degenerate_facets = 0;
+    uint64_t vertices = 0;
+    // Corners that were folded into an existing vertex.
+    uint64_t vertices_merged = 0;
+    uint64_t open_edges = 0;
+    uint64_t nonmanifold_edges = 0;
+    uint64_t parts = 0;
+    uint64_t facets_reversed = 0;
+    bool reversed_all = false;
+    bool non_orientable = false;
+
+    nlohmann::json to_json() const;
+};
+
+enum class LoadStatus {
+    Ok,
+    // Not an STL this reader understands (the legacy loader may still).
+    Malformed,
+    // Valid STL with open or non-manifold edges; `its` is left empty.
+    NeedsRepair,
+};
+
+LoadStatus load_stl(const uint8_t* data, size_t len, indexed_triangle_set& its, LoadStats& stats);
+
+// Step 1's table: vertices keyed by the bit pattern of their coordinates.
+class VertexWelder {
+public:
+    explicit VertexWelder(size_t expected_vertices = 0);
+
+    // Id of the vertex, a new one for a position not seen before.
+    uint32_t add(const std::array<float, 3>& v);
+    size_t size() const { return m_keys.size(); }
+    // The position with -0 folded into 0.
+    std::array<float, 3> vertex(uint32_t id) const;
+
+private:
+    size_t find_slot(const std::array<uint32_t, 3>& key) const;
+
+    std::vector<std::array<uint32_t, 3>> m_keys;
+    std::vector<uint32_t> m_table;
+};
+
+// load_stl for input that arrives in pieces, such as an STL inflated from a
+// gzip or zip wrapper. Facets are welded as they come in, so the reader keeps
+// the unique vertices, three corner ids and the stored normal per facet and
+// never the file itself. The result is the one load_stl gives for the same
+// bytes.
+class StlReader {
+public:
+    // `size` is the STL's total length, which tells binary from ASCII the way
+    // load_stl does. A binary header's facet count is only trusted for
+    // preallocation up to `reserve_bytes` of facet records; past that the
+    // vectors grow as facets arrive.
+    explicit StlReader(uint64_t size, uint64_t reserve_bytes = UINT64_MAX);
+
+    // False once the input cannot be an STL; later calls are ignored.
+    bool feed(const uint8_t* data, size_t len);
+    LoadStatus finish(indexed_triangle_set& its, LoadStats& stats);
+
+private:
+    enum class Mode { Header, Binary, Ascii, Malformed };
+    enum class Expect { Keyword, Normal, Number, SkipLine };
+
+    void decide();
+    void add_facet(const float* record);
+    void feed_binary(const uint8_t* data, size_t len);
+    void feed_ascii(const char* data, size_t len, bool final);
+    size_t scan_ascii(const char* text, size_t len, bool final);
+    bool ascii_token(const char* text, size_t len, size_t& i);
+
+    uint64_t m_size = 0;
+    uint64_t m_reserve_bytes = 0;
+    uint64_t m_received = 0;
+    uint32_t m_header_count = 0;
+    Mode m_mode = Mode::Header;
+    // The binary header, a partial facet record, or ASCII text after the last
+    // whole token.
+    std::string m_pending;
+
+    Expect m_expect = Expect::Keyword;
+    bool m_solid_checked = false;
+    bool m_facet_open = false;
+    int m_vertices = 0;
+    int m_numbers = 0;
+    float m_record[12] = {};
+
+    VertexWelder m_welder;
+    std::vector<uint32_t> m_corners;
+    std::vector<std::array<float, 3>> m_normals;
+};
+
+} // namespace orc::mesh
+
+#endif
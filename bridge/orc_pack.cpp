@@ -0,0 +1,150 @@
+#include "orc_pack.h"
+
+#include "orc_log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace orc::pack {
+
+namespace {
+
+static constexpr char kMagic[8] = {'O', 'R', 'C', 'P', 'A', 'C', 'K', '1'};
+static constexpr uint32_t kVersion = 1;
+static constexpr size_t kHeaderBytes = 48;
+static constexpr size_t kIndexEntryBytes = 32;
+static constexpr uint32_t kFlagCore = 1;
+
+// The pack is little-endian and entries are only 4-byte aligned in the index,
+// so fields are read byte-wise rather than through struct casts.
+static uint32_t load_u32(const uint8_t* p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+static uint64_t load_u64(const uint8_t* p)
+{
+    return uint64_t(load_u32(p)) | uint64_t(load_u32(p + 4)) << 32;
+}
+
+struct IndexEntry {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t path_offset;
+    uint32_t path_length;
+    uint32_t flags;
+};
+
+static IndexEntry index_entry(const uint8_t* index, size_t i)
+{
+    const uint8_t* p = index + i * kIndexEntryBytes;
+    return IndexEntry{load_u64(p), load_u64(p + 8), load_u32(p + 16), load_u32(p + 20), load_u32(p + 24)};
+}
+
+} // namespace
+
+Archive::~Archive()
+{
+    close();
+}
+
+bool Archive::open(const std::string& path)
+{
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ORC_WARN("[orc_pack] cannot open %s\n", path.c_str());
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderBytes)) {
+        ::close(fd);
+        ORC_WARN("[orc_pack] %s is too short for a resource pack\n", path.c_str());
+        return false;
+    }
+    const size_t length = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (map == MAP_FAILED) {
+        ORC_WARN("[orc_pack] cannot map %s\n", path.c_str());
+        return false;
+    }
+
+    const auto* base = static_cast<const uint8_t*>(map);
+    const uint64_t count = load_u32(base + 12);
+    const uint64_t index_offset = load_u64(base + 16);
+    const uint64_t index_bytes = load_u64(base + 24);
+    const uint64_t data_offset = load_u64(base + 32);
+    const uint64_t core_bytes = load_u64(base + 40);
+    const uint64_t table_bytes = count * kIndexEntryBytes;
+    bool valid = std::memcmp(base, kMagic, sizeof(kMagic)) == 0 && load_u32(base + 8) == kVersion &&
+                 index_offset >= kHeaderBytes && index_bytes >= table_bytes && index_offset <= length &&
+                 index_bytes <= length - index_offset && data_offset <= length && core_bytes <= length - data_offset;
+    const uint8_t* index = base + index_offset;
+    const uint64_t string_bytes = index_bytes - table_bytes;
+    for (uint64_t i = 0; valid && i < count; ++i) {
+        const IndexEntry e = index_entry(index, i);
+        valid = e.offset <= length && e.size <= length - e.offset &&
+                uint64_t(e.path_offset) + e.path_length <= string_bytes;
+    }
+    if (!valid) {
+        munmap(map, length);
+        ORC_WARN("[orc_pack] %s is not a valid version %u resource pack\n", path.c_str(), kVersion);
+        return false;
+    }
+
+    m_base = base;
+    m_length = length;
+    m_index = index;
+    m_strings = reinterpret_cast<const char*>(index + table_bytes);
+    m_count = static_cast<size_t>(count);
+    m_core_bytes = core_bytes;
+    return true;
+}
+
+void Archive::close()
+{
+    if (m_base != nullptr) {
+        munmap(const_cast<uint8_t*>(m_base), m_length);
+    }
+    m_base = nullptr;
+    m_length = 0;
+    m_index = nullptr;
+    m_strings = nullptr;
+    m_count = 0;
+    m_core_bytes = 0;
+}
+
+Entry Archive::entry(size_t i) const
+{
+    const IndexEntry e = index_entry(m_index, i);
+    return Entry{std::string_view(m_strings + e.path_offset, e.path_length), m_base + e.offset,
+                 static_cast<size_t>(e.size), (e.flags & kFlagCore) != 0};
+}
+
+std::optional<Entry> Archive::find(std::string_view path) const
+{
+    size_t lo = 0;
+    size_t hi = m_count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const IndexEntry e = index_entry(m_index, mid);
+        // string_view compares as unsigned bytes, matching the packer's sort.
+        const int cmp = std::string_view(m_strings + e.path_offset, e.path_length).compare(path);
+        if (cmp == 0) {
+            return entry(mid);
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace orc::pack
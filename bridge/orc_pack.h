@@ -0,0 +1,57 @@
+#ifndef ORCA_WASM_ORC_PACK_H
+#define ORCA_WASM_ORC_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Reader for the indexed resource pack written by scripts/pack-resources.js.
+// The WASM module mounts the same file lazily (wasm/orc_pack_fs.js); native
+// hosts map it read-only and hand out pointers straight into the mapping, so
+// an entry costs no allocation or copy and the pages are shared by every
+// process that maps the pack.
+namespace orc::pack {
+
+struct Entry {
+    std::string_view path; // relative to the resources root
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    bool core = false; // touched by a plain slice (wasm/resources-core.txt)
+};
+
+class Archive {
+public:
+    Archive() = default;
+    ~Archive();
+    Archive(const Archive&) = delete;
+    Archive& operator=(const Archive&) = delete;
+
+    // Maps `path` and validates the header and every index entry. On failure
+    // the archive stays closed and a warning is printed.
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return m_base != nullptr; }
+
+    size_t size() const { return m_count; }
+    Entry entry(size_t index) const;
+
+    // Binary search over the sorted index; paths use '/' separators.
+    std::optional<Entry> find(std::string_view path) const;
+
+    // Length of the core range at the start of the data area.
+    uint64_t core_bytes() const { return m_core_bytes; }
+
+private:
+    const uint8_t* m_base = nullptr;
+    size_t m_length = 0;
+    const uint8_t* m_index = nullptr;
+    const char* m_strings = nullptr;
+    size_t m_count = 0;
+    uint64_t m_core_bytes = 0;
+};
+
+} // namespace orc::pack
+
+#endif
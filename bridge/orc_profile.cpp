@@ -0,0 +1,353 @@
+#include "orc_profile.h"
+
+#include "orc_clock.h"
+#include "orc_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__GLIBC__) && !defined(__EMSCRIPTEN__)
+#include <malloc.h>
+#endif
+
+#include "libslic3r/Print.hpp"
+#include "libslic3r/Layer.hpp"
+
+namespace orc::profile {
+
+namespace {
+
+static constexpr unsigned kWatermarkCount = static_cast<unsigned>(Watermark::Count);
+
+static std::atomic<size_t> g_live_bytes{0};
+static std::atomic<size_t> g_watermarks[kWatermarkCount];
+// Flipped by the first note_alloc(); until then heap figures are sampled.
+static std::atomic<bool> g_hooks_active{false};
+
+static size_t sampled_heap_in_use()
+{
+#if defined(__GLIBC__) && !defined(__EMSCRIPTEN__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return static_cast<size_t>(mallinfo2().uordblks);
+#else
+    return 0;
+#endif
+}
+
+static void raise_watermark(std::atomic<size_t>& mark, size_t value)
+{
+    size_t peak = mark.load(std::memory_order_relaxed);
+    while (value > peak && !mark.compare_exchange_weak(peak, value, std::memory_order_relaxed)) {
+    }
+}
+
+static void raise_watermarks(size_t live)
+{
+    for (auto& mark : g_watermarks) {
+        raise_watermark(mark, live);
+    }
+}
+
+static void sample_if_unhooked()
+{
+    if (!g_hooks_active.load(std::memory_order_relaxed)) {
+        raise_watermarks(sampled_heap_in_use());
+    }
+}
+
+// PrintObjectStep values reported in the profile, in execution order.
+struct StepInfo {
+    Slic3r::PrintObjectStep step;
+    const char* name;
+};
+
+static const StepInfo kSteps[] = {
+    {Slic3r::posSlice, "slice"},
+    {Slic3r::posPerimeters, "perimeters"},
+    {Slic3r::posPrepareInfill, "prepare_infill"},
+    {Slic3r::posInfill, "infill"},
+    {Slic3r::posSupportMaterial, "support"},
+    {Slic3r::posEstimateCurledExtrusions, "estimate_curled_extrusions"},
+};
+
+static SliceProfile g_fallback;
+static thread_local SliceProfile* t_current = nullptr;
+
+} // namespace
+
+void note_alloc(size_t bytes)
+{
+    g_hooks_active.store(true, std::memory_order_relaxed);
+    const size_t live = g_live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    raise_watermarks(live);
+}
+
+void note_free(size_t bytes)
+{
+    g_live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+size_t heap_in_use()
+{
+    if (g_hooks_active.load(std::memory_order_relaxed)) {
+        return g_live_bytes.load(std::memory_order_relaxed);
+    }
+    return sampled_heap_in_use();
+}
+
+size_t reset_watermark(Watermark mark)
+{
+    sample_if_unhooked();
+    const size_t live = heap_in_use();
+    return std::max(g_watermarks[static_cast<unsigned>(mark)].exchange(live, std::memory_order_relaxed), live);
+}
+
+size_t peek_watermark(Watermark mark)
+{
+    sample_if_unhooked();
+    return g_watermarks[static_cast<unsigned>(mark)].load(std::memory_order_relaxed);
+}
+
+void SliceProfile::reset()
+{
+    m_origin_ms = now_ms();
+    m_phases.clear();
+    m_open.clear();
+    m_counters.clear();
+    m_memory_budget = 0;
+    m_budget_peak = 0;
+    m_input = nullptr;
+    m_decimation = nullptr;
+    m_output = nullptr;
+    m_cache = nullptr;
+    m_layer_cache = nullptr;
+    m_steps_closed = 0;
+    m_step_cursor_ms = m_origin_ms;
+    m_stage = nullptr;
+    m_stage_start_ms = 0.0;
+    reset_watermark(Watermark::Phase);
+    reset_watermark(Watermark::Step);
+    reset_watermark(Watermark::Stage);
+}
+
+Phase& SliceProfile::find_or_add(const char* group, const char* name)
+{
+    for (Phase& phase : m_phases) {
+        if (phase.group == group && phase.name == name) {
+            return phase;
+        }
+    }
+    Phase phase;
+    phase.group = group;
+    phase.name = name;
+    m_phases.push_back(std::move(phase));
+    return m_phases.back();
+}
+
+void SliceProfile::begin(const char* name)
+{
+    trace::begin(name);
+    const size_t outer_peak = reset_watermark(Watermark::Phase);
+    m_open.push_back(OpenPhase{name, now_ms(), outer_peak});
+    if (std::strcmp(name, "process") == 0) {
+        m_step_cursor_ms = m_open.back().start_ms;
+        reset_watermark(Watermark::Step);
+    }
+}
+
+void SliceProfile::end(const char* name)
+{
+    const double now = now_ms();
+    trace::end(name);
+    if (m_open.empty()) {
+        return;
+    }
+    const OpenPhase open = m_open.back();
+    m_open.pop_back();
+    const size_t peak = reset_watermark(Watermark::Phase);
+
+    Phase& phase = find_or_add("bridge", open.name);
+    phase.start_ms = open.start_ms - m_origin_ms;
+    phase.duration_ms += now - open.start_ms;
+    phase.peak_heap_bytes = std::max(phase.peak_heap_bytes, peak);
+    phase.calls += 1;
+
+    // Let the enclosing phase keep the larger of both peaks.
+    if (!m_open.empty()) {
+        raise_watermark(g_watermarks[static_cast<unsigned>(Watermark::Phase)], std::max(open.outer_peak, peak));
+    }
+}
+
+void SliceProfile::observe_print(const Slic3r::Print& print)
+{
+    const auto& objects = print.objects();
+    if (objects.empty()) {
+        return;
+    }
+    for (size_t idx = 0; idx < sizeof(kSteps) / sizeof(kSteps[0]); ++idx) {
+        const uint32_t bit = 1u << idx;
+        if (m_steps_closed & bit) {
+            continue;
+        }
+        const bool done = std::all_of(objects.begin(), objects.end(), [&](const Slic3r::PrintObject* object) {
+            return object->is_step_done(kSteps[idx].step);
+        });
+        if (!done) {
+            continue;
+        }
+        const double now = now_ms();
+        Phase& phase = find_or_add("print_object_step", kSteps[idx].name);
+        phase.start_ms = m_step_cursor_ms - m_origin_ms;
+        phase.duration_ms = now - m_step_cursor_ms;
+        phase.peak_heap_bytes = reset_watermark(Watermark::Step);
+        phase.calls = objects.size();
+        m_step_cursor_ms = now;
+        m_steps_closed |= bit;
+        trace::instant(kSteps[idx].name, static_cast<int64_t>(phase.duration_ms * 1000.0));
+    }
+}
+
+void SliceProfile::stage_begin(const char* stage)
+{
+    m_stage = stage;
+    m_stage_start_ms = now_ms();
+    reset_watermark(Watermark::Stage);
+}
+
+void SliceProfile::stage_end(const char* stage, size_t output_bytes)
+{
+    if (m_stage == nullptr || std::strcmp(m_stage, stage) != 0) {
+        return;
+    }
+    const double now = now_ms();
+    Phase& phase = find_or_add("gcode_stage", stage);
+    if (phase.calls == 0) {
+        phase.start_ms = m_stage_start_ms - m_origin_ms;
+    }
+    phase.duration_ms += now - m_stage_start_ms;
+    phase.peak_heap_bytes = std::max(phase.peak_heap_bytes, reset_watermark(Watermark::Stage));
+    phase.calls += 1;
+    phase.output_bytes += output_bytes;
+    m_stage = nullptr;
+}
+
+void SliceProfile::set_counter(const char* name, uint64_t value)
+{
+    for (auto& counter : m_counters) {
+        if (counter.first == name) {
+            counter.second = value;
+            return;
+        }
+    }
+    m_counters.emplace_back(name, value);
+    trace::counter(name, static_cast<int64_t>(value));
+}
+
+size_t SliceProfile::peak_heap_bytes() const
+{
+    size_t peak = 0;
+    for (const Phase& phase : m_phases) {
+        if (phase.group == "bridge") {
+            peak = std::max(peak, phase.peak_heap_bytes);
+        }
+    }
+    return peak;
+}
+
+nlohmann::json SliceProfile::to_json() const
+{
+    using json = nlohmann::json;
+    json groups = json::object();
+    for (const Phase& phase : m_phases) {
+        json& group = groups[phase.group];
+        if (group.is_null()) {
+            group = json::array();
+        }
+        json entry = {
+            {"name", phase.name},
+            {"startMs", phase.start_ms},
+            {"durationMs", phase.duration_ms},
+            {"peakHeapBytes", phase.peak_heap_bytes},
+            {"calls", phase.calls},
+        };
+        if (phase.output_bytes > 0) {
+            entry["outputBytes"] = phase.output_bytes;
+        }
+        group.push_back(std::move(entry));
+    }
+    json counters = json::object();
+    for (const auto& counter : m_counters) {
+        counters[counter.first] = counter.second;
+    }
+    json result{
+        {"version", 1},
+        {"phases", std::move(groups)},
+        {"counters", std::move(counters)},
+        {"heapInUseBytes", heap_in_use()},
+    };
+    if (m_memory_budget > 0) {
+        result["memoryBudget"] = {
+            {"budgetBytes", m_memory_budget},
+            {"peakChargedBytes", m_budget_peak},
+            {"peakHeapBytes", peak_heap_bytes()},
+            {"headroomBytes", m_budget_peak < m_memory_budget ? m_memory_budget - m_budget_peak : 0},
+        };
+    }
+    if (!m_input.is_null()) {
+        result["input"] = m_input;
+    }
+    if (!m_decimation.is_null()) {
+        result["decimation"] = m_decimation;
+    }
+    if (!m_output.is_null()) {
+        result["output"] = m_output;
+    }
+    if (!m_cache.is_null()) {
+        result["cache"] = m_cache;
+    }
+    if (!m_layer_cache.is_null()) {
+        result["layerCache"] = m_layer_cache;
+    }
+    return result;
+}
+
+SliceProfile& current()
+{
+    return t_current != nullptr ? *t_current : g_fallback;
+}
+
+ScopedCurrent::ScopedCurrent(SliceProfile& profile) : m_previous(t_current)
+{
+    t_current = &profile;
+}
+
+ScopedCurrent::~ScopedCurrent()
+{
+    t_current = m_previous;
+}
+
+void collect_print_counters(SliceProfile& profile, const Slic3r::Print& print)
+{
+    uint64_t layers = 0;
+    uint64_t polygons = 0;
+    uint64_t paths = 0;
+    for (const Slic3r::PrintObject* object : print.objects()) {
+        layers += object->layer_count() + object->support_layer_count();
+        for (const Slic3r::Layer* layer : object->layers()) {
+            for (const Slic3r::ExPolygon& island : layer->lslices) {
+                polygons += 1 + island.holes.size();
+            }
+            for (const Slic3r::LayerRegion* region : layer->regions()) {
+                paths += region->perimeters.items_count() + region->fills.items_count();
+            }
+        }
+        for (const Slic3r::SupportLayer* layer : object->support_layers()) {
+            paths += layer->support_fills.items_count();
+        }
+    }
+    profile.set_counter("layers", layers);
+    profile.set_counter("polygons", polygons);
+    profile.set_counter("extrusion_paths", paths);
+}
+
+} // namespace orc::profile
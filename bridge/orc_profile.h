@@ -0,0 +1,152 @@
+#ifndef ORCA_WASM_ORC_PROFILE_H
+#define ORCA_WASM_ORC_PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace Slic3r {
+class Print;
+}
+
+// Structured per-slice profile returned by orc_get_profile: wall time and heap
+// high-water mark for each bridge phase, PrintObjectStep and G-code
+// post-processing stage, plus workload counters.
+namespace orc::profile {
+
+// Heap accounting fed by the allocation hooks in orc_alloc.cpp. Builds without
+// the hooks fall back to sampling the C library's own statistics where available.
+void note_alloc(size_t bytes);
+void note_free(size_t bytes);
+size_t heap_in_use();
+
+// Independent high-water marks so bridge phases, print steps and G-code stages
+// can each reset their own peak without disturbing the others. Heap figures
+// are process-wide: with several sessions slicing at once, each profile sees
+// the combined heap.
+enum class Watermark : unsigned {
+    Phase,
+    Step,
+    Stage,
+    // Since the last orc::alloc::reset(); reported by orc_get_alloc_profile.
+    Process,
+    Count,
+};
+
+// Returns the peak heap seen on `mark` since its last reset, then restarts the
+// mark from the current heap size.
+size_t reset_watermark(Watermark mark);
+size_t peek_watermark(Watermark mark);
+
+struct Phase {
+    std::string group;
+    std::string name;
+    double start_ms = 0.0;
+    double duration_ms = 0.0;
+    size_t peak_heap_bytes = 0;
+    size_t calls = 0;
+    size_t output_bytes = 0;
+};
+
+class SliceProfile {
+public:
+    void reset();
+
+    // Bridge phases (load, apply, process, export). Also mirrored into the trace ring.
+    void begin(const char* name);
+    void end(const char* name);
+
+    // Polls PrintObjectStep states. Called from the Print status callback, so
+    // step boundaries are resolved at status-update granularity.
+    void observe_print(const Slic3r::Print& print);
+
+    // G-code post-processing stages run once per layer; calls are aggregated.
+    void stage_begin(const char* stage);
+    void stage_end(const char* stage, size_t output_bytes);
+
+    void set_counter(const char* name, uint64_t value);
+
+    // Budget the slice ran under (0 = none) and the most it was charged at
+    // once; to_json reports both with the slice's peak heap.
+    void set_memory_budget(size_t bytes) { m_memory_budget = bytes; }
+    void set_budget_peak(size_t bytes) { m_budget_peak = bytes; }
+
+    // Compressed upload (orc::inflate::Stats), reported as "input".
+    void set_input(nlohmann::json input) { m_input = std::move(input); }
+
+    // orc::decimate::Report of the slice, reported as "decimation".
+    void set_decimation(nlohmann::json report) { m_decimation = std::move(report); }
+
+    // Binary G-code encoding (orc::bgcode::Stats), reported as "output".
+    void set_output(nlohmann::json output) { m_output = std::move(output); }
+
+    // Result cache lookup of the slice (hit, key, hashing time), reported as "cache".
+    void set_cache(nlohmann::json lookup) { m_cache = std::move(lookup); }
+    // Intermediate layer restore or save (see orc::layer_cache), reported as
+    // "layerCache".
+    void set_layer_cache(nlohmann::json layers) { m_layer_cache = std::move(layers); }
+
+    // Highest peak of any bridge phase, i.e. the slice's heap high-water mark.
+    size_t peak_heap_bytes() const;
+
+    nlohmann::json to_json() const;
+
+private:
+    struct OpenPhase {
+        const char* name;
+        double start_ms;
+        size_t outer_peak;
+    };
+
+    Phase& find_or_add(const char* group, const char* name);
+
+    double m_origin_ms = 0.0;
+    std::vector<Phase> m_phases;
+    std::vector<OpenPhase> m_open;
+    std::vector<std::pair<std::string, uint64_t>> m_counters;
+    size_t m_memory_budget = 0;
+    size_t m_budget_peak = 0;
+    nlohmann::json m_input;
+    nlohmann::json m_decimation;
+    nlohmann::json m_output;
+    nlohmann::json m_cache;
+    nlohmann::json m_layer_cache;
+
+    // PrintObjectStep bookkeeping.
+    uint32_t m_steps_closed = 0;
+    double m_step_cursor_ms = 0.0;
+
+    // Post-processing stage in flight (stages never nest).
+    const char* m_stage = nullptr;
+    double m_stage_start_ms = 0.0;
+};
+
+// Profile the calling thread is recording into: the one bound by
+// ScopedCurrent, or a process-wide fallback outside of any slice. Hooks that
+// fire deep inside libslic3r (G-code stages, which only report from the
+// sequential Emscripten pipeline) find their session this way.
+SliceProfile& current();
+
+// Binds `profile` as current() on this thread for the lifetime of the scope.
+class ScopedCurrent {
+public:
+    explicit ScopedCurrent(SliceProfile& profile);
+    ~ScopedCurrent();
+    ScopedCurrent(const ScopedCurrent&) = delete;
+    ScopedCurrent& operator=(const ScopedCurrent&) = delete;
+
+private:
+    SliceProfile* m_previous;
+};
+
+// Collects triangles, layers, polygons and extrusion path counts from a
+// processed print into `profile`.
+void collect_print_counters(SliceProfile& profile, const Slic3r::Print& print);
+
+} // namespace orc::profile
+
+#endif
@@ -0,0 +1,130 @@
+#include "orc_session.h"
+
+#include "orc_log.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <unordered_map>
+
+namespace orc::session {
+
+namespace {
+
+// Owns the scratch directory of a non-default session. Runs when the last
+// shared_ptr goes away, i.e. after destroy() and any call still in flight.
+struct SessionDeleter {
+    void operator()(Session* session) const
+    {
+        if (!session->scratch_dir.empty() && rmdir(session->scratch_dir.c_str()) != 0) {
+            ORC_LOG("[orc_session] scratch dir %s not removed\n", session->scratch_dir.c_str());
+        }
+        delete session;
+    }
+};
+
+static std::mutex g_registry_mutex;
+static std::unordered_map<Handle, std::shared_ptr<Session>> g_registry;
+static std::atomic<Handle> g_next_handle{kDefaultHandle + 1};
+
+static std::string scratch_base()
+{
+    const char* dir = std::getenv("ORC_SCRATCH_DIR");
+    return (dir != nullptr && *dir != '\0') ? dir : "/tmp";
+}
+
+static std::string session_dir(Handle handle)
+{
+    return scratch_base() + "/orc-session-" + std::to_string(static_cast<long>(getpid())) + "-" +
+           std::to_string(handle);
+}
+
+static std::shared_ptr<Session>& default_session()
+{
+    static std::shared_ptr<Session> session = std::make_shared<Session>();
+    return session;
+}
+
+// Scratch directory of the default session, orc-session-<pid>-0. Made on
+// first use in each process rather than when the session is, so workers
+// forked after warm-up (each with its own ORC_SCRATCH_DIR) never share it.
+// A directory left behind by an earlier process with the same pid is reused
+// only if it is a real directory owned by us.
+static std::string default_scratch_dir()
+{
+    static std::mutex mutex;
+    static std::string current;
+    std::string dir = session_dir(kDefaultHandle);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (dir == current) {
+        return dir;
+    }
+    struct stat st;
+    if (mkdir(dir.c_str(), 0700) != 0 &&
+        (errno != EEXIST || lstat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != geteuid())) {
+        // Keep the path anyway: writes under it fail instead of landing in
+        // the shared base directory.
+        ORC_WARN("[orc_session] cannot create scratch dir %s\n", dir.c_str());
+        return dir;
+    }
+    current = dir;
+    return dir;
+}
+
+} // namespace
+
+std::string Session::scratch_path(const char* name) const
+{
+    std::string path = handle == kDefaultHandle ? default_scratch_dir() : scratch_dir;
+    path += '/';
+    path += name;
+    return path;
+}
+
+std::shared_ptr<Session> create()
+{
+    const Handle handle = g_next_handle.fetch_add(1, std::memory_order_relaxed);
+    std::string dir = session_dir(handle);
+    if (mkdir(dir.c_str(), 0700) != 0) {
+        ORC_WARN("[orc_session] cannot create scratch dir %s\n", dir.c_str());
+        return nullptr;
+    }
+
+    std::shared_ptr<Session> session(new Session(), SessionDeleter{});
+    session->handle = handle;
+    session->scratch_dir = std::move(dir);
+
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    g_registry.emplace(handle, session);
+    return session;
+}
+
+std::shared_ptr<Session> find(Handle handle)
+{
+    if (handle == kDefaultHandle) {
+        return default_session();
+    }
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    const auto it = g_registry.find(handle);
+    return it == g_registry.end() ? nullptr : it->second;
+}
+
+void destroy(Handle handle)
+{
+    std::shared_ptr<Session> released;
+    {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        const auto it = g_registry.find(handle);
+        if (it == g_registry.end()) {
+            return;
+        }
+        released = std::move(it->second);
+        g_registry.erase(it);
+    }
+    // `released` may be the last owner; let the deleter run outside the lock.
+}
+
+} // namespace orc::session
@@ -0,0 +1,94 @@
+#ifndef ORCA_WASM_ORC_SESSION_H
+#define ORCA_WASM_ORC_SESSION_H
+
+#include "orc_bgcode.h"
+#include "orc_profile.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+// Per-job bridge state. Everything a slice reads or writes besides the
+// immutable, process-wide data (PrintConfigDef, resources, the cached default
+// config) lives in a Session, so independent sessions can slice concurrently
+// on different threads of one process.
+//
+// Handles are small integers rather than pointers: they survive the JS
+// boundary unchanged and a stale handle fails lookup instead of touching freed
+// memory.
+namespace orc::session {
+
+using Handle = uint32_t;
+
+// The session behind orc_init / orc_slice / orc_get_profile.
+constexpr Handle kDefaultHandle = 0;
+
+struct Session {
+    Handle handle = kDefaultHandle;
+
+    // Bridge behaviour requested through the payload's "bridge" object.
+    struct Options {
+        // Serve the slice's small allocations from orc::arena.
+        bool arena = false;
+        // Heap cap for the slice in bytes (0 = none), see orc::alloc::BudgetScope.
+        size_t memory_budget = 0;
+        // Load STL through admesh even when orc::mesh could weld it.
+        bool legacy_stl_loader = false;
+        // Use the process-wide result cache when one is configured.
+        bool cache = true;
+        // Also keep and reuse the sliced layers, see orc::layer_cache.
+        bool layer_cache = false;
+        // Decimate dense meshes before slicing, see orc::decimate. A zero
+        // tolerance derives it from the print config.
+        bool decimate = false;
+        double decimate_tolerance_mm = 0.0;
+        // Slice meshes with orc::slice instead of libslic3r's slice_mesh()
+        // where the optional slice kernel patch is applied.
+        bool slice_kernel = false;
+        // Return binary G-code (orc::bgcode) instead of text.
+        bool binary_gcode = false;
+        bgcode::Options bgcode;
+    };
+
+    // Payload captured by the last init call.
+    bool dump_config = false;
+    std::optional<nlohmann::json> payload;
+    Options options;
+
+    profile::SliceProfile profile;
+    // Time and filament estimates of the last slice (see orc_get_slice_stats);
+    // null when it failed.
+    nlohmann::json slice_stats;
+
+    // Private directory for temp files. Empty for the default session, whose
+    // orc-session-<pid>-0 directory is made per process on first use so
+    // forked processes can each point ORC_SCRATCH_DIR somewhere else.
+    std::string scratch_dir;
+
+    // Held for the duration of each call; concurrent calls on one session
+    // run one after another.
+    std::mutex busy;
+
+    std::string scratch_path(const char* name) const;
+};
+
+// Creates a session with its own scratch directory. Returns nullptr if the
+// directory cannot be created.
+std::shared_ptr<Session> create();
+
+// Looks up a live session; kDefaultHandle always resolves. Callers keep the
+// returned pointer for the whole call so a concurrent destroy() cannot free
+// the session under them.
+std::shared_ptr<Session> find(Handle handle);
+
+// Forgets the session and removes its scratch directory once the last
+// in-flight call returns. The default session cannot be destroyed.
+void destroy(Handle handle);
+
+} // namespace orc::session
+
+#endif
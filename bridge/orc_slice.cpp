@@ -0,0 +1,442 @@
+#include "orc_slice.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace orc::slice {
+
+namespace {
+
+static constexpr uint32_t kNoEdge = std::numeric_limits<uint32_t>::max();
+static constexpr int32_t kNoSegment = -1;
+static constexpr size_t kLanes = 4;
+
+static thread_local bool t_enabled = false;
+
+// Four floats and the few operations the kernel needs on them.
+#if defined(__wasm_simd128__)
+using f32x4 = v128_t;
+static inline f32x4 load4(const float* p) { return wasm_v128_load(p); }
+static inline void store4(float* p, f32x4 v) { wasm_v128_store(p, v); }
+static inline f32x4 splat4(float v) { return wasm_f32x4_splat(v); }
+static inline f32x4 add4(f32x4 a, f32x4 b) { return wasm_f32x4_add(a, b); }
+static inline f32x4 sub4(f32x4 a, f32x4 b) { return wasm_f32x4_sub(a, b); }
+static inline f32x4 mul4(f32x4 a, f32x4 b) { return wasm_f32x4_mul(a, b); }
+static inline f32x4 div4(f32x4 a, f32x4 b) { return wasm_f32x4_div(a, b); }
+static inline unsigned ge_mask4(f32x4 a, f32x4 b) { return wasm_i32x4_bitmask(wasm_f32x4_ge(a, b)); }
+#elif defined(__SSE2__)
+using f32x4 = __m128;
+static inline f32x4 load4(const float* p) { return _mm_loadu_ps(p); }
+static inline void store4(float* p, f32x4 v) { _mm_storeu_ps(p, v); }
+static inline f32x4 splat4(float v) { return _mm_set1_ps(v); }
+static inline f32x4 add4(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+static inline f32x4 sub4(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+static inline f32x4 mul4(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+static inline f32x4 div4(f32x4 a, f32x4 b) { return _mm_div_ps(a, b); }
+static inline unsigned ge_mask4(f32x4 a, f32x4 b) { return unsigned(_mm_movemask_ps(_mm_cmpge_ps(a, b))); }
+#else
+struct f32x4 {
+    float v[kLanes];
+};
+template<class Op>
+static inline f32x4 map4(f32x4 a, f32x4 b, Op op)
+{
+    f32x4 r;
+    for (size_t i = 0; i < kLanes; ++i) {
+        r.v[i] = op(a.v[i], b.v[i]);
+    }
+    return r;
+}
+static inline f32x4 load4(const float* p) { return f32x4{{p[0], p[1], p[2], p[3]}}; }
+static inline void store4(float* p, f32x4 v) { std::copy(v.v, v.v + kLanes, p); }
+static inline f32x4 splat4(float v) { return f32x4{{v, v, v, v}}; }
+static inline f32x4 add4(f32x4 a, f32x4 b) { return map4(a, b, [](float x, float y) { return x + y; }); }
+static inline f32x4 sub4(f32x4 a, f32x4 b) { return map4(a, b, [](float x, float y) { return x - y; }); }
+static inline f32x4 mul4(f32x4 a, f32x4 b) { return map4(a, b, [](float x, float y) { return x * y; }); }
+static inline f32x4 div4(f32x4 a, f32x4 b) { return map4(a, b, [](float x, float y) { return x / y; }); }
+static inline unsigned ge_mask4(f32x4 a, f32x4 b)
+{
+    unsigned mask = 0;
+    for (size_t i = 0; i < kLanes; ++i) {
+        mask |= unsigned(a.v[i] >= b.v[i]) << i;
+    }
+    return mask;
+}
+#endif
+
+// Facets the sweep currently intersects, one array per coordinate so four
+// facets load into one register. Sized to a multiple of kLanes; the tail is
+// padded with facets far above every plane, which never cross.
+struct ActiveSet {
+    std::array<std::vector<float>, 3> x;
+    std::array<std::vector<float>, 3> y;
+    std::array<std::vector<float>, 3> z;
+    std::vector<float> max_z;
+    std::vector<uint32_t> facet;
+    size_t size = 0;
+
+    void push(const std::vector<stl_triangle_vertex_indices>& indices, const std::vector<stl_vertex>& vertices,
+              uint32_t f, float top)
+    {
+        if (facet.size() < size + kLanes) {
+            resize(std::max<size_t>(64, 2 * facet.size()));
+        }
+        const stl_triangle_vertex_indices& idx = indices[f];
+        for (size_t c = 0; c < 3; ++c) {
+            const stl_vertex& v = vertices[idx[c]];
+            x[c][size] = v.x();
+            y[c][size] = v.y();
+            z[c][size] = v.z();
+        }
+        max_z[size] = top;
+        facet[size] = f;
+        ++size;
+    }
+
+    // Drops facets entirely below `plane`, keeping the order of the rest.
+    void retire_below(float plane)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (max_z[i] < plane) {
+                continue;
+            }
+            if (kept != i) {
+                for (size_t c = 0; c < 3; ++c) {
+                    x[c][kept] = x[c][i];
+                    y[c][kept] = y[c][i];
+                    z[c][kept] = z[c][i];
+                }
+                max_z[kept] = max_z[i];
+                facet[kept] = facet[i];
+            }
+            ++kept;
+        }
+        size = kept;
+    }
+
+    void pad()
+    {
+        const float inf = std::numeric_limits<float>::infinity();
+        for (size_t i = size; i < (size + kLanes - 1) / kLanes * kLanes; ++i) {
+            for (size_t c = 0; c < 3; ++c) {
+                z[c][i] = inf;
+            }
+        }
+    }
+
+private:
+    void resize(size_t capacity)
+    {
+        for (size_t c = 0; c < 3; ++c) {
+            x[c].resize(capacity);
+            y[c].resize(capacity);
+            z[c].resize(capacity);
+        }
+        max_z.resize(capacity);
+        facet.resize(capacity);
+    }
+};
+
+// Facet section from the crossing of its downward edge (start) to that of its
+// upward edge (end), named by mesh edge.
+struct Segment {
+    float x;
+    float y;
+    uint32_t from;
+    uint32_t to;
+};
+
+// Intersects every active facet with `plane` and appends one segment per
+// crossed facet.
+static void intersect(const ActiveSet& active, const std::vector<uint32_t>& facet_edges, float plane,
+                      std::vector<Segment>& segments)
+{
+    const f32x4 p = splat4(plane);
+    alignas(16) float ex[3][kLanes];
+    alignas(16) float ey[3][kLanes];
+    for (size_t i = 0; i < active.size; i += kLanes) {
+        const f32x4 z0 = load4(&active.z[0][i]);
+        const f32x4 z1 = load4(&active.z[1][i]);
+        const f32x4 z2 = load4(&active.z[2][i]);
+        const std::array<unsigned, 3> above = {ge_mask4(z0, p), ge_mask4(z1, p), ge_mask4(z2, p)};
+        // Lanes whose corners are not all on the same side.
+        const unsigned crossed = (above[0] ^ above[1]) | (above[1] ^ above[2]);
+        if (crossed == 0) {
+            continue;
+        }
+        // Crossing point of every edge c -> c+1, meaningful only on crossed
+        // edges; 0/0 on flat edges is a NaN nobody reads.
+        const f32x4 zs[3] = {z0, z1, z2};
+        for (size_t c = 0; c < 3; ++c) {
+            const size_t n = (c + 1) % 3;
+            const f32x4 t = div4(sub4(p, zs[c]), sub4(zs[n], zs[c]));
+            const f32x4 xa = load4(&active.x[c][i]);
+            const f32x4 ya = load4(&active.y[c][i]);
+            store4(ex[c], add4(xa, mul4(t, sub4(load4(&active.x[n][i]), xa))));
+            store4(ey[c], add4(ya, mul4(t, sub4(load4(&active.y[n][i]), ya))));
+        }
+        for (unsigned lanes = crossed; lanes != 0; lanes &= lanes - 1) {
+            const unsigned lane = unsigned(__builtin_ctz(lanes));
+            size_t down = 0;
+            size_t up = 0;
+            for (size_t c = 0; c < 3; ++c) {
+                const bool a = (above[c] >> lane) & 1;
+                const bool b = (above[(c + 1) % 3] >> lane) & 1;
+                if (a && !b) {
+                    down = c;
+                } else if (!a && b) {
+                    up = c;
+                }
+            }
+            const uint32_t* edges = &facet_edges[size_t(active.facet[i + lane]) * 3];
+            segments.push_back(Segment{ex[down][lane], ey[down][lane], edges[down], edges[up]});
+        }
+    }
+}
+
+// Follows segments end edge to start edge. `start_by_edge` has one slot per
+// mesh edge, all kNoSegment on entry and on return.
+static Slic3r::Polygons chain(const std::vector<Segment>& segments, std::vector<int32_t>& start_by_edge, Stats& stats)
+{
+    Slic3r::Polygons loops;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        int32_t& slot = start_by_edge[segments[i].from];
+        if (slot != kNoSegment) {
+            ++stats.nonmanifold_edges;
+            continue;
+        }
+        slot = int32_t(i);
+    }
+
+    std::vector<bool> visited(segments.size(), false);
+    for (size_t first = 0; first < segments.size(); ++first) {
+        if (visited[first]) {
+            continue;
+        }
+        Slic3r::Polygon loop;
+        int32_t current = int32_t(first);
+        bool closed = false;
+        while (!visited[current]) {
+            visited[current] = true;
+            const Segment& segment = segments[current];
+            const Slic3r::Point point(Slic3r::scaled<Slic3r::coord_t>(double(segment.x)),
+                                      Slic3r::scaled<Slic3r::coord_t>(double(segment.y)));
+            if (loop.points.empty() || loop.points.back() != point) {
+                loop.points.push_back(point);
+            }
+            current = start_by_edge[segment.to];
+            if (current == kNoSegment) {
+                break;
+            }
+            closed = current == int32_t(first);
+        }
+        if (!closed) {
+            ++stats.open_chains;
+            continue;
+        }
+        if (loop.points.size() > 1 && loop.points.front() == loop.points.back()) {
+            loop.points.pop_back();
+        }
+        if (loop.points.size() >= 3) {
+            loops.emplace_back(std::move(loop));
+        }
+    }
+
+    for (const Segment& segment : segments) {
+        start_by_edge[segment.from] = kNoSegment;
+    }
+    stats.loops += loops.size();
+    return loops;
+}
+
+} // namespace
+
+MeshSlicer::MeshSlicer(const indexed_triangle_set& mesh) : MeshSlicer(mesh.indices, mesh.vertices)
+{
+}
+
+MeshSlicer::MeshSlicer(const std::vector<stl_triangle_vertex_indices>& indices, const std::vector<stl_vertex>& vertices)
+    : m_indices(indices), m_vertices(vertices)
+{
+    const size_t facets = indices.size();
+
+    // Facets around each vertex (CSR), then one id per undirected edge shared
+    // by every facet that has it.
+    std::vector<uint32_t> offsets(vertices.size() + 1, 0);
+    for (const stl_triangle_vertex_indices& idx : indices) {
+        for (size_t c = 0; c < 3; ++c) {
+            ++offsets[size_t(idx[c]) + 1];
+        }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<uint32_t> incident(offsets.back());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t f = 0; f < facets; ++f) {
+            for (size_t c = 0; c < 3; ++c) {
+                incident[fill[indices[f][c]]++] = uint32_t(f);
+            }
+        }
+    }
+
+    m_facet_edges.assign(facets * 3, kNoEdge);
+    for (size_t f = 0; f < facets; ++f) {
+        const stl_triangle_vertex_indices& idx = indices[f];
+        for (size_t c = 0; c < 3; ++c) {
+            if (m_facet_edges[f * 3 + c] != kNoEdge) {
+                continue;
+            }
+            const uint32_t id = uint32_t(m_edge_count++);
+            m_facet_edges[f * 3 + c] = id;
+            const int a = idx[c];
+            const int b = idx[(c + 1) % 3];
+            for (uint32_t k = offsets[a]; k < offsets[a + 1]; ++k) {
+                const uint32_t g = incident[k];
+                if (g == f) {
+                    continue;
+                }
+                const stl_triangle_vertex_indices& other = indices[g];
+                for (size_t e = 0; e < 3; ++e) {
+                    const int u = other[e];
+                    const int v = other[(e + 1) % 3];
+                    if (((u == b && v == a) || (u == a && v == b)) && m_facet_edges[g * 3 + e] == kNoEdge) {
+                        m_facet_edges[g * 3 + e] = id;
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<float> min_z(facets);
+    for (size_t f = 0; f < facets; ++f) {
+        const stl_triangle_vertex_indices& idx = indices[f];
+        min_z[f] = std::min({vertices[idx[0]].z(), vertices[idx[1]].z(), vertices[idx[2]].z()});
+    }
+    m_order.resize(facets);
+    std::iota(m_order.begin(), m_order.end(), 0u);
+    std::sort(m_order.begin(), m_order.end(), [&min_z](uint32_t a, uint32_t b) { return min_z[a] < min_z[b]; });
+    m_min_z.resize(facets);
+    for (size_t i = 0; i < facets; ++i) {
+        m_min_z[i] = min_z[m_order[i]];
+    }
+}
+
+std::vector<Slic3r::Polygons> MeshSlicer::slice(const std::vector<float>& zs, Stats* stats) const
+{
+    Stats local;
+    local.facets = m_indices.size();
+    local.edges = m_edge_count;
+    local.layers = zs.size();
+
+    std::vector<size_t> layer_order(zs.size());
+    std::iota(layer_order.begin(), layer_order.end(), size_t(0));
+    if (!std::is_sorted(zs.begin(), zs.end())) {
+        std::sort(layer_order.begin(), layer_order.end(), [&zs](size_t a, size_t b) { return zs[a] < zs[b]; });
+    }
+
+    std::vector<Slic3r::Polygons> layers(zs.size());
+    std::vector<int32_t> start_by_edge(m_edge_count, kNoSegment);
+    std::vector<Segment> segments;
+    ActiveSet active;
+    size_t next = 0;
+    for (size_t layer : layer_order) {
+        const float plane = zs[layer];
+        active.retire_below(plane);
+        for (; next < m_order.size() && m_min_z[next] <= plane; ++next) {
+            const stl_triangle_vertex_indices& idx = m_indices[m_order[next]];
+            const float top = std::max({m_vertices[idx[0]].z(), m_vertices[idx[1]].z(), m_vertices[idx[2]].z()});
+            // Facets that fit between two planes never cross one.
+            if (top >= plane) {
+                active.push(m_indices, m_vertices, m_order[next], top);
+            }
+        }
+        active.pad();
+
+        segments.clear();
+        intersect(active, m_facet_edges, plane, segments);
+        local.segments += segments.size();
+        layers[layer] = chain(segments, start_by_edge, local);
+    }
+
+    if (stats != nullptr) {
+        *stats = local;
+    }
+    return layers;
+}
+
+std::vector<Slic3r::Polygons> slice_mesh(const indexed_triangle_set& mesh, const std::vector<float>& zs, Stats* stats)
+{
+    return MeshSlicer(mesh).slice(zs, stats);
+}
+
+bool slice_transformed(const indexed_triangle_set& mesh, const Slic3r::Transform3d& trafo,
+                       const std::vector<float>& zs, std::vector<Slic3r::Polygons>& layers, Stats* stats)
+{
+    std::vector<stl_vertex> vertices(mesh.vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = (trafo * mesh.vertices[i].cast<double>()).cast<float>();
+    }
+    Stats local;
+    std::vector<Slic3r::Polygons> sliced = MeshSlicer(mesh.indices, vertices).slice(zs, &local);
+    if (stats != nullptr) {
+        *stats = local;
+    }
+    if (local.open_chains != 0 || local.nonmanifold_edges != 0) {
+        return false;
+    }
+    // A mirroring trafo turns the facets inside out, and the loops with them.
+    if (trafo.matrix().block<3, 3>(0, 0).determinant() < 0.0) {
+        for (Slic3r::Polygons& loops : sliced) {
+            for (Slic3r::Polygon& loop : loops) {
+                loop.reverse();
+            }
+        }
+    }
+    layers = std::move(sliced);
+    return true;
+}
+
+KernelScope::KernelScope(bool enabled) : m_previous(t_enabled)
+{
+    t_enabled = m_previous || enabled;
+}
+
+KernelScope::~KernelScope()
+{
+    t_enabled = m_previous;
+}
+
+bool thread_enabled()
+{
+    return t_enabled;
+}
+
+bool exchange_thread_enabled(bool enabled)
+{
+    const bool previous = t_enabled;
+    t_enabled = enabled;
+    return previous;
+}
+
+const char* simd_backend()
+{
+#if defined(__wasm_simd128__)
+    return "simd128";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace orc::slice
@@ -0,0 +1,106 @@
+#ifndef ORCA_WASM_ORC_SLICE_H
+#define ORCA_WASM_ORC_SLICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <admesh/stl.h>
+#include <libslic3r/Polygon.hpp>
+
+// Triangle-plane slicing kernel, an alternative to libslic3r's slice_mesh()
+// for large meshes. Differences from TriangleMeshSlicer:
+//
+//   - Facets are sorted by min Z once. Sweeping the (ascending) planes keeps an
+//     active set in structure-of-arrays form: a facet is gathered from the mesh
+//     when the sweep reaches it and dropped when the sweep passes its max Z,
+//     instead of re-reading every facet for every layer it spans.
+//   - Each plane classifies and intersects four active facets at a time with
+//     128-bit SIMD (wasm simd128, SSE2 natively, scalar otherwise).
+//   - Segments are chained into loops by the index of the mesh edge they start
+//     and end on, so no coordinate hashing or snapping is involved and every
+//     closed 2-manifold cross section comes out as exact closed loops.
+//
+// A vertex lying exactly on a plane counts as above it, so each crossed facet
+// yields exactly one segment and horizontal facets yield none. Loops follow
+// the facet orientation: contours CCW, holes CW. Chains that do not close
+// (open or non-manifold meshes) are dropped and counted in Stats; slice_mesh()
+// remains the tool for repairing those.
+//
+// With patches/orca-wasm-slice-kernel.patch applied, libslic3r's slice_mesh_ex()
+// asks slice_transformed() first on threads a KernelScope enables, and falls
+// back to its own slice_mesh() whenever the kernel declines the mesh.
+namespace orc::slice {
+
+struct Stats {
+    size_t facets = 0;
+    size_t edges = 0;
+    size_t layers = 0;
+    size_t segments = 0;
+    size_t loops = 0;
+    size_t open_chains = 0;
+    size_t nonmanifold_edges = 0;
+};
+
+class MeshSlicer {
+public:
+    // Builds the edge index and the min-Z order. `mesh` must outlive the
+    // slicer and is expected in print coordinates (mm, already transformed).
+    explicit MeshSlicer(const indexed_triangle_set& mesh);
+    // Same for facets whose vertices are stored apart from them, e.g. a mesh
+    // moved into print coordinates without copying its indices.
+    MeshSlicer(const std::vector<stl_triangle_vertex_indices>& indices, const std::vector<stl_vertex>& vertices);
+
+    // One Polygons per entry of `zs`, in the same order. Ascending `zs` is
+    // the fast path; other orders are sorted internally.
+    std::vector<Slic3r::Polygons> slice(const std::vector<float>& zs, Stats* stats = nullptr) const;
+
+    size_t edge_count() const { return m_edge_count; }
+
+private:
+    const std::vector<stl_triangle_vertex_indices>& m_indices;
+    const std::vector<stl_vertex>& m_vertices;
+    // Mesh edge id of edge i (vertex i -> vertex i+1) of every facet.
+    std::vector<uint32_t> m_facet_edges;
+    std::vector<uint32_t> m_order;
+    std::vector<float> m_min_z;
+    size_t m_edge_count = 0;
+};
+
+// Convenience for a one-off slice.
+std::vector<Slic3r::Polygons> slice_mesh(const indexed_triangle_set& mesh, const std::vector<float>& zs,
+                                         Stats* stats = nullptr);
+
+// Slices `mesh` placed by `trafo` (object to print coordinates) the way
+// slice_mesh_ex() expects: one Polygons per entry of `zs`, contours CCW even
+// under a mirroring `trafo`. Returns false and leaves `layers` alone when a
+// chain does not close or an edge has more than two facets, so the caller can
+// hand the mesh to slice_mesh(), which closes gaps.
+bool slice_transformed(const indexed_triangle_set& mesh, const Slic3r::Transform3d& trafo,
+                       const std::vector<float>& zs, std::vector<Slic3r::Polygons>& layers, Stats* stats = nullptr);
+
+// Lets slice_mesh_ex() use slice_transformed() on the calling thread for its
+// lifetime when `enabled`; TBB workers running the slice's tasks in an
+// orc::workers::TaskArena follow it. Scopes nest.
+class KernelScope {
+public:
+    explicit KernelScope(bool enabled);
+    ~KernelScope();
+    KernelScope(const KernelScope&) = delete;
+    KernelScope& operator=(const KernelScope&) = delete;
+
+private:
+    bool m_previous;
+};
+
+// Whether a KernelScope enables the calling thread, and a way to install
+// another thread's setting: how a worker joins a slice and leaves it again.
+bool thread_enabled();
+bool exchange_thread_enabled(bool enabled);
+
+// "simd128", "sse2" or "scalar": the intersection path compiled in.
+const char* simd_backend();
+
+} // namespace orc::slice
+
+#endif
@@ -0,0 +1,169 @@
+#include "orc_trace.h"
+
+#include "orc_clock.h"
+
+#include <atomic>
+
+#include <nlohmann/json.hpp>
+
+namespace orc::trace {
+
+#if ORC_BRIDGE_TRACE
+
+namespace {
+
+static_assert((ORC_TRACE_CAPACITY & (ORC_TRACE_CAPACITY - 1)) == 0, "ORC_TRACE_CAPACITY must be a power of two");
+
+static constexpr uint64_t kCapacity = ORC_TRACE_CAPACITY;
+static constexpr uint64_t kMask = kCapacity - 1;
+
+// Each slot is a seqlock. A writer claims it by swapping the committed tag for
+// (index + 1) | kWriting, writes the fields, then publishes index + 1. A slot
+// that another writer holds, or that already has a newer event, is left alone
+// and the event is lost, as it would be to the next lap of the ring anyway.
+// Readers take an event only if the tag they expect is there both before and
+// after they copy the fields. The fields are relaxed atomics, so a copy racing
+// a writer is torn rather than undefined, and the second check drops it.
+struct Event {
+    std::atomic<uint64_t> commit{0};
+    std::atomic<double> ts_ms{0.0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> value{0};
+    std::atomic<uint32_t> tid{0};
+    std::atomic<EventType> type{EventType::Instant};
+};
+
+static constexpr uint64_t kWriting = uint64_t(1) << 63;
+
+static Event g_ring[kCapacity];
+static std::atomic<uint64_t> g_head{0};
+// Events older than this index were discarded by clear().
+static std::atomic<uint64_t> g_floor{0};
+static std::atomic<uint32_t> g_next_tid{1};
+
+// Small per-thread numbers, in the order threads first record, so the TBB
+// workers' events land on their own tracks.
+static uint32_t thread_id()
+{
+    thread_local const uint32_t id = g_next_tid.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+static const char* phase_code(EventType type)
+{
+    switch (type) {
+    case EventType::Begin: return "B";
+    case EventType::End: return "E";
+    case EventType::Instant: return "i";
+    case EventType::Counter: return "C";
+    }
+    return "i";
+}
+
+} // namespace
+
+void record(EventType type, const char* name, int64_t value)
+{
+    const uint64_t index = g_head.fetch_add(1, std::memory_order_relaxed);
+    Event& slot = g_ring[index & kMask];
+    uint64_t tag = slot.commit.load(std::memory_order_relaxed);
+    do {
+        if ((tag & kWriting) != 0 || tag > index) {
+            return;
+        }
+    } while (!slot.commit.compare_exchange_weak(tag, (index + 1) | kWriting, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.ts_ms.store(now_ms(), std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.tid.store(thread_id(), std::memory_order_relaxed);
+    slot.type.store(type, std::memory_order_relaxed);
+    slot.commit.store(index + 1, std::memory_order_release);
+}
+
+void clear()
+{
+    g_floor.store(g_head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+size_t size()
+{
+    const uint64_t head = g_head.load(std::memory_order_acquire);
+    const uint64_t floor = g_floor.load(std::memory_order_acquire);
+    const uint64_t held = head - floor;
+    return static_cast<size_t>(held < kCapacity ? held : kCapacity);
+}
+
+size_t capacity()
+{
+    return static_cast<size_t>(kCapacity);
+}
+
+std::string export_chrome_json()
+{
+    using json = nlohmann::json;
+
+    const uint64_t head = g_head.load(std::memory_order_acquire);
+    uint64_t first = g_floor.load(std::memory_order_acquire);
+    uint64_t dropped = 0;
+    if (head - first > kCapacity) {
+        dropped = head - first - kCapacity;
+        first = head - kCapacity;
+    }
+
+    json events = json::array();
+    for (uint64_t index = first; index < head; ++index) {
+        const Event& slot = g_ring[index & kMask];
+        if (slot.commit.load(std::memory_order_acquire) != index + 1) {
+            // Overwritten by a newer event or still being written.
+            continue;
+        }
+        const double ts_ms = slot.ts_ms.load(std::memory_order_relaxed);
+        const char* name = slot.name.load(std::memory_order_relaxed);
+        const int64_t value = slot.value.load(std::memory_order_relaxed);
+        const uint32_t tid = slot.tid.load(std::memory_order_relaxed);
+        const EventType type = slot.type.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.commit.load(std::memory_order_relaxed) != index + 1) {
+            // A writer took the slot while it was being copied.
+            continue;
+        }
+        json entry = {
+            {"name", name != nullptr ? name : "(null)"},
+            {"ph", phase_code(type)},
+            {"ts", ts_ms * 1000.0},
+            {"pid", 1},
+            {"tid", tid},
+        };
+        switch (type) {
+        case EventType::Counter:
+            entry["args"] = {{"value", value}};
+            break;
+        case EventType::Instant:
+            entry["s"] = "t";
+            entry["args"] = {{"value", value}};
+            break;
+        default:
+            break;
+        }
+        events.push_back(std::move(entry));
+    }
+
+    json doc = {
+        {"traceEvents", std::move(events)},
+        {"displayTimeUnit", "ms"},
+        {"otherData", {{"capacity", kCapacity}, {"dropped", dropped}}},
+    };
+    return doc.dump();
+}
+
+#else // ORC_BRIDGE_TRACE
+
+void clear() {}
+size_t size() { return 0; }
+size_t capacity() { return 0; }
+std::string export_chrome_json() { return "{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}"; }
+
+#endif // ORC_BRIDGE_TRACE
+
+} // namespace orc::trace
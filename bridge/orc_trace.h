@@ -0,0 +1,69 @@
+#ifndef ORCA_WASM_ORC_TRACE_H
+#define ORCA_WASM_ORC_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Fixed-size, lock-free ring of typed trace events. Recording is a relaxed
+// fetch_add, a compare-exchange to claim the slot and a handful of relaxed
+// stores, so it is cheap enough to leave enabled in release builds; the ring is
+// only turned into text when a caller asks for it.
+// Events carry the recording thread's number as their Chrome "tid".
+//
+// Event names must have static storage duration (string literals): the ring
+// stores the pointer, never a copy.
+#ifndef ORC_BRIDGE_TRACE
+#define ORC_BRIDGE_TRACE 1
+#endif
+
+#ifndef ORC_TRACE_CAPACITY
+#define ORC_TRACE_CAPACITY (1u << 14)
+#endif
+
+namespace orc::trace {
+
+enum class EventType : uint8_t {
+    Begin,
+    End,
+    Instant,
+    Counter,
+};
+
+#if ORC_BRIDGE_TRACE
+void record(EventType type, const char* name, int64_t value = 0);
+#else
+inline void record(EventType, const char*, int64_t = 0) {}
+#endif
+
+inline void begin(const char* name) { record(EventType::Begin, name); }
+inline void end(const char* name) { record(EventType::End, name); }
+inline void instant(const char* name, int64_t value = 0) { record(EventType::Instant, name, value); }
+inline void counter(const char* name, int64_t value) { record(EventType::Counter, name, value); }
+
+// Brackets a phase with Begin/End events.
+class Scope {
+public:
+    explicit Scope(const char* name) : m_name(name) { begin(m_name); }
+    ~Scope() { end(m_name); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* m_name;
+};
+
+// Drops every recorded event.
+void clear();
+
+// Number of events currently held (at most capacity()).
+size_t size();
+size_t capacity();
+
+// Serialises the ring, oldest event first, in Chrome trace_event format so the
+// result loads directly into chrome://tracing or Perfetto.
+std::string export_chrome_json();
+
+} // namespace orc::trace
+
+#endif
@@ -0,0 +1,72 @@
+#include "orc_workers.h"
+
+#include "orc_arena.h"
+#include "orc_slice.h"
+
+#include <thread>
+
+namespace orc::workers {
+
+namespace {
+
+// What the worker had before it joined; workers are in one arena at a time.
+static thread_local alloc::Budget* t_saved_budget = nullptr;
+static thread_local int t_saved_arena_depth = 0;
+static thread_local bool t_saved_slice_kernel = false;
+
+} // namespace
+
+TaskArena::Observer::Observer(tbb::task_arena& arena, alloc::Budget* budget, int arena_depth, bool slice_kernel)
+    : tbb::task_scheduler_observer(arena), m_budget(budget), m_arena_depth(arena_depth), m_slice_kernel(slice_kernel)
+{
+    observe(true);
+}
+
+TaskArena::Observer::~Observer()
+{
+    observe(false);
+}
+
+// The thread that calls execute() already has the state; only workers
+// switch.
+void TaskArena::Observer::on_scheduler_entry(bool worker)
+{
+    if (!worker) {
+        return;
+    }
+    t_saved_budget = alloc::exchange_budget(m_budget);
+    t_saved_arena_depth = arena::exchange_thread_depth(m_arena_depth);
+    t_saved_slice_kernel = slice::exchange_thread_enabled(m_slice_kernel);
+    inside.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TaskArena::Observer::on_scheduler_exit(bool worker)
+{
+    if (!worker) {
+        return;
+    }
+    alloc::exchange_budget(t_saved_budget);
+    arena::exchange_thread_depth(t_saved_arena_depth);
+    slice::exchange_thread_enabled(t_saved_slice_kernel);
+    t_saved_budget = nullptr;
+    t_saved_arena_depth = 0;
+    t_saved_slice_kernel = false;
+    inside.fetch_sub(1, std::memory_order_release);
+}
+
+TaskArena::TaskArena()
+    : m_observer(m_arena, alloc::current_budget(), arena::thread_depth(), slice::thread_enabled())
+{
+}
+
+TaskArena::~TaskArena()
+{
+    // Workers leave an arena soon after its work runs out. One still inside
+    // when the observer stops observing would never get on_scheduler_exit and
+    // keep pointing at the slice's scopes, so wait for them here.
+    while (m_observer.inside.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace orc::workers
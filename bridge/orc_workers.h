@@ -0,0 +1,62 @@
+#ifndef ORCA_WASM_ORC_WORKERS_H
+#define ORCA_WASM_ORC_WORKERS_H
+
+#include "orc_alloc.h"
+
+#include <atomic>
+#include <utility>
+
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
+
+// Runs a slice's parallel work in a TBB arena of its own. The allocation hooks
+// route by thread-local state (the BudgetScope the bytes are charged to, the
+// orc::arena scopes that send small objects to the slab pages, and the
+// orc::slice::KernelScope that hands slice_mesh_ex() to the bridge kernel), which
+// TBB's shared worker threads would otherwise not have: a worker takes the
+// slice thread's state over when it joins the arena and puts its own back when
+// it leaves, so the slice's tasks are charged to the slice wherever they run
+// and other sessions' tasks, in their own arenas, are not.
+namespace orc::workers {
+
+class TaskArena {
+public:
+    // Captures the calling thread's state; the scopes behind it must outlive
+    // the TaskArena.
+    TaskArena();
+    // Waits for the workers still in the arena to leave it.
+    ~TaskArena();
+    TaskArena(const TaskArena&) = delete;
+    TaskArena& operator=(const TaskArena&) = delete;
+
+    template <typename F>
+    decltype(auto) execute(F&& f)
+    {
+        return m_arena.execute(std::forward<F>(f));
+    }
+
+private:
+    class Observer : public tbb::task_scheduler_observer {
+    public:
+        Observer(tbb::task_arena& arena, alloc::Budget* budget, int arena_depth, bool slice_kernel);
+        ~Observer() override;
+
+        void on_scheduler_entry(bool worker) override;
+        void on_scheduler_exit(bool worker) override;
+
+        // Workers that joined and have not left yet.
+        std::atomic<int> inside{0};
+
+    private:
+        alloc::Budget* m_budget;
+        int m_arena_depth;
+        bool m_slice_kernel;
+    };
+
+    tbb::task_arena m_arena;
+    Observer m_observer;
+};
+
+} // namespace orc::workers
+
+#endif
@@ -17,11 +17,31 @@
 #include <map>
 #include <sstream>
 #include <ctime>
+#include <memory>
+#include <mutex>
 
 #include <chrono>
 
 #include <nlohmann/json.hpp>
 
+#include "orc_3mf.h"
+#include "orc_alloc.h"
+#include "orc_arena.h"
+#include "orc_bgcode.h"
+#include "orc_cache.h"
+#include "orc_clock.h"
+#include "orc_decimate.h"
+#include "orc_hash.h"
+#include "orc_inflate.h"
+#include "orc_layer_cache.h"
+#include "orc_log.h"
+#include "orc_mesh_load.h"
+#include "orc_profile.h"
+#include "orc_session.h"
+#include "orc_slice.h"
+#include "orc_trace.h"
+#include "orc_workers.h"
+
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #include <emscripten/heap.h>
@@ -33,16 +53,10 @@
 extern "C" char __heap_base;
 #endif
 
-static double now_ms()
-{
-#ifdef __EMSCRIPTEN__
-    return emscripten_get_now();
-#else
-    using clock = std::chrono::steady_clock;
-    return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
-#endif
-}
+using orc::now_ms;
 
+// Records the heap span as trace counters; the stderr line is only emitted in
+// verbose builds.
 static void log_memory_usage(const char* label)
 {
 #ifdef __EMSCRIPTEN__
@@ -57,6 +71,11 @@ static void log_memory_usage(const char* label)
     }
     const size_t slack_bytes = heap_bytes > used_bytes ? heap_bytes - used_bytes : 0;
     const size_t reported_free = slack_bytes; // best effort estimate without mallinfo
+    orc::trace::counter("heap_size", static_cast<int64_t>(heap_bytes));
+    orc::trace::counter("heap_used", static_cast<int64_t>(used_bytes));
+    if (!ORC_BRIDGE_VERBOSE) {
+        return;
+    }
     fprintf(stderr,
         "[orc_slice] memory %s: heap=%zu used=%zu slack=%zu fordblks=%zu\n",
         label,
@@ -70,347 +89,6 @@ static void log_memory_usage(const char* label)
 #endif
 }
 
-#ifdef __EMSCRIPTEN__
-// Instrument global new/delete so we can observe failing allocations at runtime.
-namespace {
-
-static constexpr std::size_t kLargeAllocLogThreshold = std::numeric_limits<std::size_t>::max(); // Disable alloc attempt spam in release
-static constexpr unsigned int kMaxLoggedAllocations = 0;
-static constexpr std::size_t kAllocTableSize = 1 << 17; // 131072 entries for pointer tracking
-static constexpr std::size_t kAllocTableMask = kAllocTableSize - 1;
-
-struct AllocationRecord {
-    void* ptr;
-    std::size_t size;
-    std::size_t alignment;
-    unsigned long long id;
-    const char* kind;
-};
-
-static AllocationRecord g_alloc_table[kAllocTableSize] = {};
-static unsigned long long g_allocation_sequence = 0;
-static unsigned int g_logged_large_allocations = 0;
-
-static inline std::size_t hash_pointer(const void* ptr)
-{
-    return (static_cast<std::size_t>(reinterpret_cast<uintptr_t>(ptr) >> 4) & kAllocTableMask);
-}
-
-static void record_allocation(void* ptr, std::size_t size, std::size_t alignment, unsigned long long id, const char* kind)
-{
-    if (ptr == nullptr) {
-        return;
-    }
-    const std::size_t start = hash_pointer(ptr);
-    for (std::size_t probe = 0; probe < kAllocTableSize; ++probe) {
-        const std::size_t idx = (start + probe) & kAllocTableMask;
-        AllocationRecord& slot = g_alloc_table[idx];
-        if (slot.ptr == nullptr) {
-            slot.ptr = ptr;
-            slot.size = size;
-            slot.alignment = alignment;
-            slot.id = id;
-            slot.kind = kind;
-            return;
-        }
-        if (slot.ptr == ptr) {
-            fprintf(stderr, "[orc_alloc] warning: pointer reused without free ptr=%p old_id=%" PRIu64 " new_id=%" PRIu64 " size=%zu\n",
-                ptr,
-                slot.id,
-                id,
-                size);
-            slot.size = size;
-            slot.alignment = alignment;
-            slot.id = id;
-            slot.kind = kind;
-            return;
-        }
-    }
-    fprintf(stderr, "[orc_alloc] error: allocation tracking table exhausted for ptr=%p size=%zu id=%" PRIu64 "\n",
-        ptr,
-        size,
-        id);
-}
-
-static void record_free(void* ptr, const char* kind)
-{
-    if (ptr == nullptr) {
-        return;
-    }
-    const std::size_t start = hash_pointer(ptr);
-    for (std::size_t probe = 0; probe < kAllocTableSize; ++probe) {
-        const std::size_t idx = (start + probe) & kAllocTableMask;
-        AllocationRecord& slot = g_alloc_table[idx];
-        if (slot.ptr == ptr) {
-            slot.ptr = nullptr;
-            slot.size = 0;
-            slot.id = 0;
-            slot.alignment = 0;
-            slot.kind = nullptr;
-            return;
-        }
-        if (slot.ptr == nullptr) {
-            fprintf(stderr, "[orc_alloc] warning: %s freeing untracked pointer ptr=%p\n", kind, ptr);
-            return;
-        }
-    }
-    fprintf(stderr, "[orc_alloc] warning: %s freeing pointer not found in tracking table ptr=%p\n", kind, ptr);
-}
-
-static void dump_allocation_summary(unsigned long long failure_id)
-{
-    struct TopEntry {
-        std::size_t size;
-        unsigned long long id;
-        void* ptr;
-        const char* kind;
-        std::size_t alignment;
-    };
-
-    TopEntry top[8] = {};
-    std::size_t active = 0;
-    std::size_t total_bytes = 0;
-    unsigned long long oldest_id = std::numeric_limits<unsigned long long>::max();
-    unsigned long long newest_id = 0;
-
-    struct KindStats {
-        const char* kind;
-        std::size_t count;
-        std::size_t bytes;
-    };
-
-    KindStats kind_stats[16] = {};
-    std::size_t kind_stats_used = 0;
-
-    for (std::size_t idx = 0; idx < kAllocTableSize; ++idx) {
-        const AllocationRecord& slot = g_alloc_table[idx];
-        if (slot.ptr == nullptr) {
-            continue;
-        }
-
-        ++active;
-        total_bytes += slot.size;
-        if (slot.id < oldest_id) {
-            oldest_id = slot.id;
-        }
-        if (slot.id > newest_id) {
-            newest_id = slot.id;
-        }
-
-        const TopEntry candidate{slot.size, slot.id, slot.ptr, slot.kind, slot.alignment};
-        for (std::size_t pos = 0; pos < sizeof(top) / sizeof(top[0]); ++pos) {
-            if (candidate.size > top[pos].size) {
-                for (std::size_t shift = (sizeof(top) / sizeof(top[0])) - 1; shift > pos; --shift) {
-                    top[shift] = top[shift - 1];
-                }
-                top[pos] = candidate;
-                break;
-            }
-        }
-
-        if (slot.kind != nullptr) {
-            std::size_t kind_idx = 0;
-            for (; kind_idx < kind_stats_used; ++kind_idx) {
-                if (kind_stats[kind_idx].kind == slot.kind) {
-                    break;
-                }
-            }
-            if (kind_idx == kind_stats_used && kind_stats_used < (sizeof(kind_stats) / sizeof(kind_stats[0]))) {
-                kind_stats[kind_idx].kind = slot.kind;
-                kind_stats[kind_idx].count = 0;
-                kind_stats[kind_idx].bytes = 0;
-                ++kind_stats_used;
-            }
-            if (kind_idx < kind_stats_used) {
-                kind_stats[kind_idx].count += 1;
-                kind_stats[kind_idx].bytes += slot.size;
-            }
-        }
-    }
-
-    const double load = static_cast<double>(active) * 100.0 / static_cast<double>(kAllocTableSize);
-    fprintf(stderr,
-        "[orc_alloc] failure summary #%" PRIu64 ": active=%zu total_bytes=%zu table_load=%.2f%% oldest_id=%" PRIu64 " newest_id=%" PRIu64 "\n",
-        failure_id,
-        active,
-        total_bytes,
-        load,
-        (oldest_id == std::numeric_limits<unsigned long long>::max()) ? 0 : oldest_id,
-        newest_id);
-
-    if (active > 0) {
-        fprintf(stderr, "[orc_alloc] outstanding allocations by kind:\n");
-        for (std::size_t i = 0; i < kind_stats_used; ++i) {
-            fprintf(stderr, "  kind=%s count=%zu bytes=%zu\n",
-                kind_stats[i].kind != nullptr ? kind_stats[i].kind : "(unknown)",
-                kind_stats[i].count,
-                kind_stats[i].bytes);
-        }
-
-        fprintf(stderr, "[orc_alloc] largest outstanding allocations:\n");
-        for (std::size_t i = 0; i < sizeof(top) / sizeof(top[0]); ++i) {
-            if (top[i].size == 0) {
-                break;
-            }
-            fprintf(stderr,
-                "  #%zu ptr=%p size=%zu align=%zu kind=%s id=%" PRIu64 "\n",
-                i,
-                top[i].ptr,
-                top[i].size,
-                top[i].alignment,
-                top[i].kind != nullptr ? top[i].kind : "(unknown)",
-                top[i].id);
-        }
-    }
-    fflush(stderr);
-}
-
-static void* instrumented_allocate(std::size_t size, std::size_t alignment, bool nothrow, const char* kind)
-{
-    const unsigned long long alloc_id = ++g_allocation_sequence;
-    if (size >= kLargeAllocLogThreshold && g_logged_large_allocations < kMaxLoggedAllocations) {
-        ++g_logged_large_allocations;
-        fprintf(stderr, "[orc_alloc] #%" PRIu64 " attempt size=%zu align=%zu kind=%s nothrow=%s\n",
-            alloc_id,
-            size,
-            alignment,
-            kind,
-            nothrow ? "true" : "false");
-        char pre_stack_buffer[2048] = {0};
-        int attempt_written = emscripten_get_callstack(EM_LOG_C_STACK | EM_LOG_JS_STACK, pre_stack_buffer, static_cast<int>(sizeof(pre_stack_buffer)));
-        if (attempt_written > 0) {
-            pre_stack_buffer[sizeof(pre_stack_buffer) - 1] = '\0';
-            fprintf(stderr, "[orc_alloc] #%" PRIu64 " callstack (attempt):\n%s\n", alloc_id, pre_stack_buffer);
-        }
-        log_memory_usage("before large alloc");
-    }
-
-    void* ptr = nullptr;
-    if (alignment > 0) {
-        ptr = memalign(alignment, size);
-    } else {
-        ptr = std::malloc(size);
-    }
-
-    if (ptr == nullptr) {
-        fprintf(stderr, "[orc_alloc] #%" PRIu64 " %s failed size=%zu align=%zu\n", alloc_id, kind, size, alignment);
-        log_memory_usage("alloc failure");
-        dump_allocation_summary(alloc_id);
-        char stack_buffer[4096] = {0};
-        int written = emscripten_get_callstack(EM_LOG_C_STACK | EM_LOG_JS_STACK, stack_buffer, static_cast<int>(sizeof(stack_buffer)));
-        if (written > 0) {
-            stack_buffer[sizeof(stack_buffer) - 1] = '\0';
-            fprintf(stderr, "[orc_alloc] #%" PRIu64 " callstack (failure):\n%s\n", alloc_id, stack_buffer);
-        }
-        errno = ENOMEM;
-        if (!nothrow) {
-            throw std::bad_alloc();
-        }
-    }
-
-    record_allocation(ptr, size, alignment, alloc_id, kind);
-
-    return ptr;
-}
-
-static void instrumented_deallocate(void* ptr, const char* kind) noexcept
-{
-    record_free(ptr, kind);
-    std::free(ptr);
-}
-
-} // namespace
-
-void* operator new(std::size_t size)
-{
-    return instrumented_allocate(size, 0, false, "operator new");
-}
-
-void* operator new[](std::size_t size)
-{
-    return instrumented_allocate(size, 0, false, "operator new[]");
-}
-
-void* operator new(std::size_t size, const std::nothrow_t&) noexcept
-{
-    return instrumented_allocate(size, 0, true, "operator new (nothrow)");
-}
-
-void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
-{
-    return instrumented_allocate(size, 0, true, "operator new[] (nothrow)");
-}
-
-#if defined(__cpp_aligned_new)
-void* operator new(std::size_t size, std::align_val_t alignment)
-{
-    return instrumented_allocate(size, static_cast<std::size_t>(alignment), false, "operator new aligned");
-}
-
-void* operator new[](std::size_t size, std::align_val_t alignment)
-{
-    return instrumented_allocate(size, static_cast<std::size_t>(alignment), false, "operator new[] aligned");
-}
-
-void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
-{
-    return instrumented_allocate(size, static_cast<std::size_t>(alignment), true, "operator new aligned (nothrow)");
-}
-
-void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
-{
-    return instrumented_allocate(size, static_cast<std::size_t>(alignment), true, "operator new[] aligned (nothrow)");
-}
-#endif
-
-void operator delete(void* ptr) noexcept
-{
-    instrumented_deallocate(ptr, "operator delete");
-}
-
-void operator delete[](void* ptr) noexcept
-{
-    instrumented_deallocate(ptr, "operator delete[]");
-}
-
-#if defined(__cpp_sized_deallocation)
-void operator delete(void* ptr, std::size_t) noexcept
-{
-    instrumented_deallocate(ptr, "operator delete sized");
-}
-
-void operator delete[](void* ptr, std::size_t) noexcept
-{
-    instrumented_deallocate(ptr, "operator delete[] sized");
-}
-#endif
-
-#if defined(__cpp_aligned_new)
-void operator delete(void* ptr, std::align_val_t) noexcept
-{
-    instrumented_deallocate(ptr, "operator delete aligned");
-}
-
-void operator delete[](void* ptr, std::align_val_t) noexcept
-{
-    instrumented_deallocate(ptr, "operator delete[] aligned");
-}
-
-#if defined(__cpp_sized_deallocation)
-void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
-{
-    instrumented_deallocate(ptr, "operator delete sized aligned");
-}
-
-void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
-{
-    instrumented_deallocate(ptr, "operator delete[] sized aligned");
-}
-#endif
-#endif // __cpp_aligned_new
-
-#endif // __EMSCRIPTEN__
-
 // Include Orca slicer headers
 #include "libslic3r/libslic3r_version.h"
 #include "../orca/src/libslic3r/TriangleMesh.hpp"
@@ -418,41 +96,108 @@ void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
 #include "../orca/src/libslic3r/Print.hpp"
 #include "../orca/src/libslic3r/PrintConfig.hpp"
 #include "../orca/src/libslic3r/GCode.hpp"
+#include "../orca/src/libslic3r/Layer.hpp"
 #include "../orca/src/libslic3r/Format/STL.hpp"
 #include "../orca/src/libslic3r/PresetBundle.hpp"
 #include "../orca/src/libslic3r/BoundingBox.hpp"
 #include "../orca/src/libslic3r/Utils.hpp"
 
+// The call site in slice_mesh_ex() comes from the optional
+// patches/orca-wasm-slice-kernel.patch; without it bridge.sliceKernel is ignored.
+#if __has_include("../orca/src/libslic3r/SliceMeshHooks.hpp")
+#include "../orca/src/libslic3r/SliceMeshHooks.hpp"
+#define ORC_BRIDGE_SLICE_KERNEL 1
+#else
+#define ORC_BRIDGE_SLICE_KERNEL 0
+#endif
+
 using namespace Slic3r;
 using json = nlohmann::json;
 
-static bool g_dump_config = false;
-static std::optional<json> g_last_slice_payload;
-
-static void ensure_resources_initialized()
+// Export-phase release: G-code export calls this once a layer's G-code
+// exists. Under a memory budget the layer's extrusions and fill surfaces go right away: the Print is
+// cleared after export and no later layer reads them. The slices stay, since
+// the next layers' overhang and travel planning reads them. The slice's budget
+// is installed on every thread that exports (orc::workers::TaskArena), so
+// unbudgeted slices keep their layers until print.clear().
+static void release_printed_layer(Layer *layer, SupportLayer *support_layer)
 {
-    static bool initialized = false;
-    if (initialized) {
+    if (orc::alloc::current_budget() == nullptr) {
         return;
     }
+    if (layer != nullptr) {
+        for (LayerRegion *region : layer->regions()) {
+            region->perimeters.clear();
+            region->thin_fills.clear();
+            region->fills.clear();
+            region->fill_surfaces.clear();
+            ExPolygons().swap(region->fill_expolygons);
+        }
+    }
+    if (support_layer != nullptr) {
+        support_layer->support_fills.clear();
+    }
+}
 
-    set_resources_dir("/resources");
-    set_var_dir("/resources/images");
-    set_local_dir("/resources/i18n");
-    set_sys_shapes_dir("/resources/shapes");
-    set_custom_gcodes_dir("/resources/custom_gcodes");
-    set_temporary_dir("/tmp");
+#if ORC_BRIDGE_SLICE_KERNEL
+// slice_mesh_ex() asks this before running its own slice_mesh(). Only threads of
+// a slice that set bridge.sliceKernel answer (orc::slice::KernelScope); a mesh
+// whose sections do not all close is declined and goes to slice_mesh(), which
+// closes the gaps as before.
+static bool slice_with_kernel(const indexed_triangle_set &mesh, const Transform3d &trafo, const std::vector<float> &zs,
+                              std::vector<Polygons> &layers)
+{
+    if (!orc::slice::thread_enabled()) {
+        return false;
+    }
+    orc::slice::Stats stats;
+    if (!orc::slice::slice_transformed(mesh, trafo, zs, layers, &stats)) {
+        orc::trace::instant("slice_kernel_fallback", static_cast<int64_t>(stats.facets));
+        ORC_LOG("[orc_slice] slice kernel declined %zu facets (%zu open chains, %zu non-manifold edges), using slice_mesh\n",
+                stats.facets, stats.open_chains, stats.nonmanifold_edges);
+        return false;
+    }
+    orc::trace::instant("slice_kernel", static_cast<int64_t>(stats.facets));
+    return true;
+}
+#endif
 
-    initialized = true;
+// Resource directories are process-wide and never change after the first
+// call, so concurrent sessions share them read-only.
+static void ensure_resources_initialized()
+{
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        // The WASM module mounts resources at /resources (lazily from the resource
+        // pack, or via --preload-file); native builds point ORC_RESOURCES_DIR at
+        // orca/resources instead.
+        const char *override_dir = std::getenv("ORC_RESOURCES_DIR");
+        const std::string resources = (override_dir != nullptr && *override_dir != '\0') ? override_dir : "/resources";
+        set_resources_dir(resources);
+        set_var_dir(resources + "/images");
+        set_local_dir(resources + "/i18n");
+        set_sys_shapes_dir(resources + "/shapes");
+        set_custom_gcodes_dir(resources + "/custom_gcodes");
+        set_temporary_dir("/tmp");
+
+        // The G-code stage hooks are process-wide; they record into whichever
+        // profile the exporting thread has bound (see orc::profile::current).
+        gcode_stage_hooks.begin = [](const char *stage) { orc::profile::current().stage_begin(stage); };
+        gcode_stage_hooks.end = [](const char *stage, size_t output_bytes) { orc::profile::current().stage_end(stage, output_bytes); };
+        gcode_layer_hooks.printed = release_printed_layer;
+#if ORC_BRIDGE_SLICE_KERNEL
+        slice_mesh_hooks.slice = slice_with_kernel;
+#endif
+    });
 }
 
-static bool payload_requests_config_dump(const uint8_t *cfg, int len)
+static bool payload_requests_config_dump(const uint8_t *cfg, size_t len)
 {
-    if (cfg == nullptr || len <= 0) {
+    if (cfg == nullptr || len == 0) {
         return false;
     }
     try {
-        std::string payload(reinterpret_cast<const char*>(cfg), static_cast<size_t>(len));
+        std::string payload(reinterpret_cast<const char*>(cfg), len);
         if (payload.find("dumpConfig") != std::string::npos) {
             return payload.find("true") != std::string::npos || payload.find('1') != std::string::npos;
         }
@@ -490,22 +235,211 @@ static const char* option_type_name(ConfigOptionType type)
     }
 }
 
-// Simple helper for STL loading
-static bool load_stl_from_buffer(const uint8_t* data, size_t len, Model& model) {
+// Simple helper for STL loading. `temp_path` lives in the calling session's
+// scratch directory.
+static bool load_stl_from_buffer(const uint8_t* data, size_t len, const std::string& temp_path, Model& model) {
     try {
         // For now, write to temp location - in production we'd use memory stream
-        std::string temp_path = "/tmp/model.stl";
         FILE* f = fopen(temp_path.c_str(), "wb");
         if (!f) return false;
         fwrite(data, 1, len, f);
         fclose(f);
 
-        return Slic3r::load_stl(temp_path.c_str(), &model);
+        const bool loaded = Slic3r::load_stl(temp_path.c_str(), &model);
+        unlink(temp_path.c_str());
+        return loaded;
     } catch (...) {
         return false;
     }
 }
 
+// Counters for a mesh orc::mesh loaded, and the object when the mesh can be
+// used as is; false sends the caller to admesh.
+static bool add_loaded_stl(orc::mesh::LoadStatus status, indexed_triangle_set& its, const orc::mesh::LoadStats& stats,
+                           Model& model, orc::profile::SliceProfile& profile)
+{
+    profile.set_counter("vertices_merged", stats.vertices_merged);
+    profile.set_counter("open_edges", stats.open_edges + stats.nonmanifold_edges);
+    profile.set_counter("facets_reversed", stats.facets_reversed);
+    profile.set_counter("degenerate_facets", stats.degenerate_facets);
+    if (status == orc::mesh::LoadStatus::Ok && !its.indices.empty()) {
+        RepairedMeshErrors errors;
+        errors.degenerate_facets = int(stats.degenerate_facets);
+        errors.facets_removed = int(stats.degenerate_facets);
+        errors.facets_reversed = int(stats.facets_reversed);
+        // Same object name the file-based loader derives from model.stl.
+        model.add_object("model.stl", "", TriangleMesh(std::move(its), errors));
+        profile.set_counter("legacy_stl_load", 0);
+        return true;
+    }
+    ORC_LOG("[orc_slice] mesh loader: %s, using admesh\n",
+            status == orc::mesh::LoadStatus::Malformed ? "malformed" : "needs repair");
+    return false;
+}
+
+// Loads the STL through orc::mesh, which welds and orients in one pass, and
+// falls back to load_stl_from_buffer (admesh) for meshes that need repair or
+// when the payload asks for the legacy loader.
+static bool load_stl_model(const uint8_t* data, size_t len, orc::session::Session& session, Model& model,
+                           orc::profile::SliceProfile& profile)
+{
+    bool legacy = session.options.legacy_stl_loader;
+    if (!legacy) {
+        try {
+            indexed_triangle_set its;
+            orc::mesh::LoadStats stats;
+            const orc::mesh::LoadStatus status = orc::mesh::load_stl(data, len, its, stats);
+            if (add_loaded_stl(status, its, stats, model, profile)) {
+                return true;
+            }
+        } catch (const std::exception& ex) {
+            ORC_WARN("[orc_slice] mesh loader failed: %s, using admesh\n", ex.what());
+        }
+        legacy = true;
+    }
+    profile.set_counter("legacy_stl_load", legacy ? 1 : 0);
+    return load_stl_from_buffer(data, len, session.scratch_path("model.stl"), model);
+}
+
+// Binary STL rarely deflates past 4:1; the facet count of a header that
+// claims more than this ratio of the upload is not preallocated.
+static constexpr uint64_t kStlReserveRatio = 8;
+
+// Feeds the inflated STL to orc::mesh as it comes out of miniz.
+class StlReaderSink : public orc::inflate::Sink {
+public:
+    explicit StlReaderSink(size_t compressed) : m_compressed(compressed) {}
+
+    std::optional<orc::mesh::StlReader> reader;
+    // The reader gave up on the data, as opposed to the wrapper being damaged.
+    bool refused = false;
+
+    // The inflated size comes from the wrapper (gzip ISIZE, zip header) and
+    // is not checked until the data is in, so it only bounds what the
+    // compressed bytes already could.
+    bool begin(uint64_t size) override
+    {
+        reader.emplace(size, uint64_t(m_compressed) * kStlReserveRatio);
+        return true;
+    }
+
+    bool write(const uint8_t* data, size_t len) override
+    {
+        refused = !reader->feed(data, len);
+        return !refused;
+    }
+
+private:
+    size_t m_compressed;
+};
+
+// Inflates into the scratch file admesh reads.
+class FileSink : public orc::inflate::Sink {
+public:
+    explicit FileSink(FILE* file) : m_file(file) {}
+
+    bool begin(uint64_t /*size*/) override { return true; }
+
+    bool write(const uint8_t* data, size_t len) override { return fwrite(data, 1, len, m_file) == len; }
+
+private:
+    FILE* m_file;
+};
+
+// gzip- or zip-wrapped STL. orc::mesh parses the data while it inflates; the
+// admesh fallback needs the whole file, so that path inflates a second time
+// into the scratch file.
+static bool load_compressed_stl_model(const uint8_t* data, size_t len, orc::session::Session& session, Model& model,
+                                      orc::profile::SliceProfile& profile)
+{
+    orc::inflate::Stats stats;
+    std::string error;
+    bool legacy = session.options.legacy_stl_loader;
+    if (!legacy) {
+        try {
+            StlReaderSink sink(len);
+            const bool inflated = orc::inflate::inflate(data, len, sink, stats, error);
+            profile.set_input(stats.to_json());
+            if (inflated) {
+                indexed_triangle_set its;
+                orc::mesh::LoadStats mesh_stats;
+                const orc::mesh::LoadStatus status = sink.reader->finish(its, mesh_stats);
+                if (add_loaded_stl(status, its, mesh_stats, model, profile)) {
+                    return true;
+                }
+            } else if (!sink.refused) {
+                ORC_WARN("[orc_slice] inflate failed: %s\n", error.c_str());
+                return false;
+            } else {
+                ORC_LOG("[orc_slice] mesh loader: malformed, using admesh\n");
+            }
+        } catch (const std::exception& ex) {
+            ORC_WARN("[orc_slice] mesh loader failed: %s, using admesh\n", ex.what());
+        }
+        legacy = true;
+    }
+    profile.set_counter("legacy_stl_load", legacy ? 1 : 0);
+
+    const std::string temp_path = session.scratch_path("model.stl");
+    FILE* f = fopen(temp_path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    FileSink sink(f);
+    const bool inflated = orc::inflate::inflate(data, len, sink, stats, error);
+    fclose(f);
+    profile.set_input(stats.to_json());
+    bool loaded = false;
+    if (!inflated) {
+        ORC_WARN("[orc_slice] inflate failed: %s\n", error.c_str());
+    } else {
+        try {
+            loaded = Slic3r::load_stl(temp_path.c_str(), &model);
+        } catch (...) {
+            loaded = false;
+        }
+    }
+    unlink(temp_path.c_str());
+    return loaded;
+}
+
+// 3MF packages load from the buffer as well. Their build items already carry
+// the instances, so add_default_instances leaves those objects alone.
+static bool load_3mf_model(const uint8_t* data, size_t len, Model& model, orc::profile::SliceProfile& profile)
+{
+    orc::threemf::LoadStats stats;
+    std::string error;
+    bool loaded = false;
+    try {
+        loaded = orc::threemf::load_3mf(data, len, model, stats, error);
+    } catch (const std::exception& ex) {
+        error = ex.what();
+    }
+    profile.set_counter("threemf_parts", stats.parts);
+    profile.set_counter("threemf_objects", stats.objects);
+    profile.set_counter("threemf_instances", stats.instances);
+    profile.set_counter("threemf_settings", stats.settings);
+    if (!loaded) {
+        ORC_WARN("[orc_slice] 3MF load failed: %s\n", error.c_str());
+        model.clear_objects();
+    }
+    return loaded;
+}
+
+// Mirror Print status updates into the trace ring. G-code export reports one
+// status per layer, which is the only place the layer index surfaces here.
+static void record_status_event(const PrintBase::SlicingStatus& status)
+{
+    if (status.percent >= 0) {
+        orc::trace::counter("progress", status.percent);
+    }
+    static constexpr const char kLayerPrefix[] = "Generating G-code: layer ";
+    if (status.text.compare(0, sizeof(kLayerPrefix) - 1, kLayerPrefix) == 0) {
+        const long layer = std::strtol(status.text.c_str() + sizeof(kLayerPrefix) - 1, nullptr, 10);
+        orc::trace::counter("gcode_layer", layer);
+    }
+}
+
 // Emit a concise config summary focused on tweaks applied for the WASM build.
 static void log_config(const DynamicPrintConfig& config) {
     fprintf(stderr, "[orc_slice] config dump begin\n");
@@ -1123,8 +1057,7 @@ static bool apply_config_value_by_key(DynamicPrintConfig &config, const ConfigDe
 
 // Simple default config
 static DynamicPrintConfig get_default_config() {
-    fprintf(stderr, "[orc_schema] get_default_config start\n");
-    fflush(stderr);
+    ORC_LOG("[orc_schema] get_default_config start\n");
     // Seed with the full preset so overrides match real option types.
     DynamicPrintConfig config;
     config.apply(FullPrintConfig::defaults());
@@ -1140,7 +1073,7 @@ static DynamicPrintConfig get_default_config() {
                 existing = defaults.option(key);
             }
             const char *type_name = existing ? option_type_name(existing->type()) : "missing";
-            fprintf(stderr, "[orc_slice] warning: failed to override %s (type=%s)\n", key, type_name);
+            ORC_WARN("[orc_slice] warning: failed to override %s (type=%s)\n", key, type_name);
         }
     };
 
@@ -1157,11 +1090,83 @@ static DynamicPrintConfig get_default_config() {
     ensure(set_bool_option(config, "precise_outer_wall", false), "precise_outer_wall");
     ensure(set_bool_option(config, "thick_internal_bridges", false), "thick_internal_bridges");
 
-    fprintf(stderr, "[orc_schema] get_default_config done\n");
-    fflush(stderr);
+    ORC_LOG("[orc_schema] get_default_config done\n");
+    return config;
+}
+
+// get_default_config() walks the whole PrintConfigDef; build it once and hand
+// out copies.
+static const DynamicPrintConfig &cached_default_config()
+{
+    static const DynamicPrintConfig config = get_default_config();
     return config;
 }
 
+// Set only by orc_snapshot_init, which runs at build time (wasm-ctor-eval) and
+// is never called at run time. Reading true means the initialized state below
+// came out of the snapshot rather than from this process.
+static bool g_snapshot_initialized = false;
+
+// 64-bit FNV-1a, chained across calls.
+static uint64_t fingerprint_mix(uint64_t hash, const std::string &text)
+{
+    for (const unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    // Separator so {"ab","c"} and {"a","bc"} hash differently.
+    return (hash ^ 0xffu) * 1099511628211ull;
+}
+
+static std::string fingerprint_hex(uint64_t hash)
+{
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016" PRIx64, hash);
+    return buffer;
+}
+
+// Digest of everything start-up initialization produces: the PrintConfigDef
+// (keys, types, labels, tooltips, enums, defaults), the cached default config
+// and the resource directories. A snapshotted module and a freshly initialized
+// one must report the same digests.
+static json config_fingerprint()
+{
+    ensure_resources_initialized();
+    uint64_t def_hash = 14695981039346656037ull;
+    for (const auto &kv : print_config_def.options) {
+        const ConfigOptionDef &def = kv.second;
+        def_hash = fingerprint_mix(def_hash, kv.first);
+        def_hash = fingerprint_mix(def_hash, std::to_string(int(def.type)));
+        def_hash = fingerprint_mix(def_hash, def.label);
+        def_hash = fingerprint_mix(def_hash, def.full_label);
+        def_hash = fingerprint_mix(def_hash, def.tooltip);
+        def_hash = fingerprint_mix(def_hash, def.sidetext);
+        for (const std::string &value : def.enum_values) {
+            def_hash = fingerprint_mix(def_hash, value);
+        }
+        for (const std::string &label : def.enum_labels) {
+            def_hash = fingerprint_mix(def_hash, label);
+        }
+        def_hash = fingerprint_mix(def_hash, def.default_value ? def.default_value->serialize() : std::string());
+    }
+
+    const DynamicPrintConfig &defaults = cached_default_config();
+    uint64_t config_hash = 14695981039346656037ull;
+    for (const std::string &key : defaults.keys()) {
+        config_hash = fingerprint_mix(config_hash, key);
+        config_hash = fingerprint_mix(config_hash, defaults.option(key)->serialize());
+    }
+
+    json result = json::object();
+    result["snapshot"] = g_snapshot_initialized;
+    result["options"] = print_config_def.options.size();
+    result["configDef"] = fingerprint_hex(def_hash);
+    result["defaultConfig"] = fingerprint_hex(config_hash);
+    result["defaultConfigKeys"] = defaults.keys().size();
+    result["resourcesDir"] = resources_dir();
+    result["temporaryDir"] = temporary_dir();
+    return result;
+}
+
 static std::optional<InfillPattern> parse_infill_pattern(std::string value)
 {
     std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
@@ -1225,14 +1230,12 @@ static void apply_config_overrides(DynamicPrintConfig &config, const json &paylo
 
     const ConfigDef *defs = config.def();
     if (defs == nullptr) {
-        fprintf(stderr, "[orc_slice] warning: print configuration metadata unavailable; overrides skipped\n");
-        fflush(stderr);
+        ORC_WARN("[orc_slice] warning: print configuration metadata unavailable; overrides skipped\n");
         return;
     };
 
     auto warn_override = [](const std::string &key) {
-        fprintf(stderr, "[orc_slice] warning: failed to apply override for %s\n", key.c_str());
-        fflush(stderr);
+        ORC_WARN("[orc_slice] warning: failed to apply override for %s\n", key.c_str());
     };
 
     static const std::map<std::string, std::vector<std::string>> kLegacyAliasMap = {
@@ -1267,7 +1270,7 @@ static void apply_config_overrides(DynamicPrintConfig &config, const json &paylo
     };
 
     auto apply_entry = [&](const std::string &key, const json &value) {
-        if (key == "rotation_deg" || key == "config") {
+        if (key == "rotation_deg" || key == "config" || key == "bridge") {
             return;
         }
         if (apply_config_value_by_key(config, *defs, key, value)) {
@@ -1287,7 +1290,7 @@ static void apply_config_overrides(DynamicPrintConfig &config, const json &paylo
 
     for (const auto &entry : payload.items()) {
         const std::string &key = entry.key();
-        if (key == "config" || key == "rotation_deg") {
+        if (key == "config" || key == "rotation_deg" || key == "bridge") {
             continue;
         }
         apply_entry(key, entry.value());
@@ -1336,11 +1339,9 @@ static std::string iso8601_now_utc()
 
 static json build_config_schema()
 {
-    fprintf(stderr, "[orc_schema] build start\n");
-    fflush(stderr);
+    ORC_LOG("[orc_schema] build start\n");
     DynamicPrintConfig config = get_default_config();
-    fprintf(stderr, "[orc_schema] defaults acquired\n");
-    fflush(stderr);
+    ORC_LOG("[orc_schema] defaults acquired\n");
     const ConfigDef *defs = config.def();
     json result = json::object();
     if (defs == nullptr) {
@@ -1490,144 +1491,363 @@ static json build_config_schema()
     result["generatedAt"] = iso8601_now_utc();
     result["categories"] = categories;
     result["optionCount"] = entries.size();
-    fprintf(stderr, "[orc_schema] build done optionCount=%zu\n", entries.size());
-    fflush(stderr);
+    ORC_LOG("[orc_schema] build done optionCount=%zu\n", entries.size());
     return result;
 }
 
-// Helper function to create STL from memory buffer using Orca's STL loader
-bool load_stl_from_memory(const uint8_t* data, size_t len, Model* model, std::string& error) {
-    try {
-        // Write data to a temporary file since Orca's STL loader expects a file path
-        // In a production version, we'd extend Orca to support memory buffers
-        std::string temp_filename = "/tmp/temp_model.stl";
-
-        FILE* temp_file = fopen(temp_filename.c_str(), "wb");
-        if (!temp_file) {
-            error = "Failed to create temporary file";
-            return false;
+// The "bgcode*" keys of the payload's "bridge" object; unknown names keep
+// the default with a warning.
+static orc::bgcode::Options parse_bgcode_options(const json& bridge)
+{
+    orc::bgcode::Options options;
+    options.producer = std::string(SLIC3R_APP_NAME " ") + SoftFever_VERSION;
+    const std::string compression = bridge.value("bgcodeCompression", std::string("heatshrink12"));
+    if (compression == "none") {
+        options.gcode_compression = orc::bgcode::Compression::None;
+    } else if (compression == "deflate") {
+        options.gcode_compression = orc::bgcode::Compression::Deflate;
+    } else if (compression == "heatshrink11") {
+        options.gcode_compression = orc::bgcode::Compression::Heatshrink11;
+    } else if (compression != "heatshrink12") {
+        ORC_WARN("[orc_slice] unknown bgcodeCompression '%s', using heatshrink12\n", compression.c_str());
+    }
+    const std::string encoding = bridge.value("bgcodeEncoding", std::string("meatpackComments"));
+    if (encoding == "none") {
+        options.encoding = orc::bgcode::Encoding::None;
+    } else if (encoding == "meatpack") {
+        options.encoding = orc::bgcode::Encoding::MeatPack;
+    } else if (encoding != "meatpackComments") {
+        ORC_WARN("[orc_slice] unknown bgcodeEncoding '%s', using meatpackComments\n", encoding.c_str());
+    }
+    options.level = std::clamp(bridge.value("bgcodeLevel", options.level), 0, 9);
+    const auto thumbnail = bridge.find("bgcodeThumbnail");
+    if (thumbnail != bridge.end() && thumbnail->is_string()) {
+        orc::bgcode::Thumbnail png;
+        if (orc::bgcode::png_thumbnail(thumbnail->get_ref<const std::string&>(), png)) {
+            options.thumbnails.push_back(std::move(png));
+        } else {
+            ORC_WARN("[orc_slice] bgcodeThumbnail is not a base64 PNG, ignored\n");
         }
+    }
+    return options;
+}
 
-        size_t written = fwrite(data, 1, len, temp_file);
-        fclose(temp_file);
+// Reads the payload's "bridge" object, which tunes the bridge itself rather
+// than the print config.
+static orc::session::Session::Options parse_bridge_options(const std::optional<json> &payload)
+{
+    orc::session::Session::Options options;
+    if (!payload || !payload->is_object()) {
+        return options;
+    }
+    const auto it = payload->find("bridge");
+    if (it == payload->end() || !it->is_object()) {
+        return options;
+    }
+    options.arena = it->value("arena", false);
+    options.legacy_stl_loader = it->value("legacyStlLoader", false);
+    options.cache = it->value("cache", true);
+    options.layer_cache = it->value("layerCache", false);
+    options.decimate = it->value("decimate", false);
+    options.decimate_tolerance_mm = std::max(0.0, it->value("decimateToleranceMm", 0.0));
+    options.slice_kernel = it->value("sliceKernel", false);
+    const double budget_mb = it->value("memoryBudgetMb", 0.0);
+    if (budget_mb > 0.0) {
+        options.memory_budget = static_cast<size_t>(budget_mb * 1024.0 * 1024.0);
+    }
+    options.binary_gcode = it->value("gcodeFormat", std::string("text")) == "binary";
+    if (options.binary_gcode) {
+        options.bgcode = parse_bgcode_options(*it);
+    }
+    return options;
+}
 
-        if (written != len) {
-            error = "Failed to write complete file data";
-            return false;
+// Capture the config payload (JSON/TOML) applied to the session's next slices.
+static int init_session(orc::session::Session& session, const uint8_t* cfg, size_t len) {
+    ensure_resources_initialized();
+    std::lock_guard<std::mutex> busy(session.busy);
+    session.dump_config = payload_requests_config_dump(cfg, len);
+    if (!session.dump_config && std::getenv("ORC_DUMP_CONFIG")) {
+        session.dump_config = true;
+    }
+    if (cfg != nullptr && len != 0) {
+        try {
+            std::string payload(reinterpret_cast<const char*>(cfg), len);
+            if (!payload.empty()) {
+                session.payload = json::parse(payload, nullptr, true, true);
+            } else {
+                session.payload.reset();
+            }
+        } catch (const std::exception &ex) {
+            ORC_WARN("[orc_slice] warning: failed to parse config payload: %s\n", ex.what());
+            session.payload.reset();
         }
+    } else {
+        session.payload.reset();
+    }
+    session.options = parse_bridge_options(session.payload);
+    return 0;
+}
 
-        // Use Orca's built-in STL loader
-        bool success = load_stl(temp_filename.c_str(), model, "imported_object", nullptr, 80);
-
-        // Clean up temporary file
-        unlink(temp_filename.c_str());
-
-        if (!success) {
-            error = "Failed to load STL using Orca's loader";
-            return false;
+// Payload settings outside the print config that change the G-code; part of
+// the cache's content key.
+static json cache_key_extras(const orc::session::Session& session)
+{
+    json extras = json::object();
+    if (session.payload && session.payload->is_object()) {
+        const auto rotation = session.payload->find("rotation_deg");
+        if (rotation != session.payload->end()) {
+            extras["rotation_deg"] = *rotation;
+        }
+    }
+    if (session.options.decimate) {
+        extras["decimateToleranceMm"] = session.options.decimate_tolerance_mm;
+    }
+    if (session.options.slice_kernel && ORC_BRIDGE_SLICE_KERNEL) {
+        extras["sliceKernel"] = true;
+    }
+    if (session.options.binary_gcode) {
+        const json& bridge = session.payload->at("bridge");
+        for (auto item = bridge.begin(); item != bridge.end(); ++item) {
+            if (item.key() == "gcodeFormat" || item.key().compare(0, 6, "bgcode") == 0) {
+                extras[item.key()] = item.value();
+            }
         }
+    }
+    return extras;
+}
 
-        return true;
+// Time and filament estimates GCode::do_export leaves in the processor result
+// and the Print statistics, so callers need not scan the G-code text for them.
+// Times are in seconds, one entry per machine-limits mode the processor ran.
+static json slice_statistics(const Print& print, const GCodeProcessorResult& result)
+{
+    const PrintStatistics& totals = print.print_statistics();
+    const PrintConfig& config = print.config();
+    const PrintEstimatedStatistics& estimates = result.print_statistics;
+
+    // Same length, weight and cost arithmetic as the G-code footer.
+    json extruders = json::array();
+    for (const auto& [extruder, volume] : estimates.volumes_per_extruder) {
+        const double diameter = config.filament_diameter.get_at(extruder);
+        const double weight = volume * config.filament_density.get_at(extruder) / 1000.0;
+        extruders.push_back({
+            {"extruder", extruder},
+            {"volumeMm3", volume},
+            {"lengthMm", diameter > 0.0 ? volume / (PI * diameter * diameter / 4.0) : 0.0},
+            {"weightG", weight},
+            {"cost", weight / 1000.0 * config.filament_cost.get_at(extruder)},
+        });
+    }
 
-    } catch (const std::exception& e) {
-        error = std::string("Exception: ") + e.what();
-        return false;
-    } catch (...) {
-        error = "Unknown exception during STL loading";
-        return false;
+    json roles = json::object();
+    for (const auto& [role, used] : estimates.used_filaments_per_role) {
+        roles[ExtrusionEntity::role_to_string(role)] = {{"lengthM", used.first}, {"weightG", used.second}};
     }
+
+    static constexpr const char* kModeNames[] = {"normal", "stealth"};
+    json modes = json::object();
+    for (size_t i = 0; i < estimates.modes.size() && i < std::size(kModeNames); ++i) {
+        const PrintEstimatedStatistics::Mode& mode = estimates.modes[i];
+        if (mode.time <= 0.0f) {
+            continue;
+        }
+        json role_times = json::object();
+        for (const auto& [role, seconds] : mode.roles_times) {
+            role_times[ExtrusionEntity::role_to_string(role)] = seconds;
+        }
+        modes[kModeNames[i]] = {
+            {"timeS", mode.time},
+            {"prepareTimeS", mode.prepare_time},
+            {"roleTimesS", std::move(role_times)},
+            {"layerTimesS", mode.layers_times},
+        };
+    }
+
+    const PrintEstimatedStatistics::Mode& normal =
+        estimates.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)];
+    return {
+        {"layers", normal.layers_times.size()},
+        {"timeS", normal.time},
+        {"filament",
+         {
+             {"lengthMm", totals.total_used_filament},
+             {"volumeMm3", totals.total_extruded_volume},
+             {"weightG", totals.total_weight},
+             {"cost", totals.total_cost},
+             {"toolchanges", totals.total_toolchanges},
+         }},
+        {"extruders", std::move(extruders)},
+        {"filamentPerRole", std::move(roles)},
+        {"modes", std::move(modes)},
+    };
 }
 
-extern "C" {
+// Exported text read back per binary G-code encode.
+static constexpr size_t kBgcodeReadChunk = 256 * 1024;
 
-__attribute__((used)) int orc_describe_config(uint8_t **json_out, int *json_len)
+// Streams the exported text through orc::bgcode a chunk at a time, twice: the
+// first pass collects the metadata the file starts with, the second encodes the
+// G-code blocks straight into the malloc'd `buf` handed to the caller.
+static bool encode_bgcode(FILE* file, const orc::bgcode::Options& options, orc::profile::SliceProfile& profile,
+                          uint8_t*& buf, size_t& size)
 {
-    if (json_out == nullptr || json_len == nullptr) {
-        return -1;
+    orc::bgcode::Writer writer(options);
+    std::vector<char> chunk(kBgcodeReadChunk);
+    size_t got = 0;
+    while ((got = fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+        writer.scan(chunk.data(), got);
     }
-    ensure_resources_initialized();
-    try {
-        json schema = build_config_schema();
-        const std::string dump = schema.dump();
-        if (dump.empty()) {
-            *json_out = nullptr;
-            *json_len = 0;
-            return 0;
-        }
-        uint8_t *buffer = static_cast<uint8_t *>(std::malloc(dump.size()));
-        if (buffer == nullptr) {
-            *json_out = nullptr;
-            *json_len = 0;
-            return -2;
-        }
-        std::memcpy(buffer, dump.data(), dump.size());
-        *json_out = buffer;
-        *json_len = static_cast<int>(dump.size());
-        return 0;
-    } catch (const std::exception &ex) {
-        fprintf(stderr, "[orc_slice] error: describe_config exception %s\n", ex.what());
-        fflush(stderr);
-        *json_out = nullptr;
-        *json_len = 0;
-        return -3;
-    } catch (...) {
-        fprintf(stderr, "[orc_slice] error: describe_config unknown exception\n");
-        fflush(stderr);
-        *json_out = nullptr;
-        *json_len = 0;
-        return -3;
+    if (ferror(file)) {
+        return false;
+    }
+    rewind(file);
+    while ((got = fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+        writer.feed(chunk.data(), got);
     }
+    if (ferror(file)) {
+        return false;
+    }
+    writer.finish();
+    buf = writer.release(size);
+    const orc::bgcode::Stats& stats = writer.stats();
+    profile.set_output(stats.to_json(options));
+    ORC_LOG("[orc_slice] bgcode %" PRIu64 " -> %" PRIu64 " bytes in %.2f ms\n", stats.text_bytes, stats.bytes,
+            stats.encode_ms);
+    return true;
 }
 
-// Optional: capture config (JSON/TOML) once
-__attribute__((used)) int orc_init(const uint8_t* cfg, int len) {
-    ensure_resources_initialized();
-    g_dump_config = payload_requests_config_dump(cfg, len);
-    if (!g_dump_config && std::getenv("ORC_DUMP_CONFIG")) {
-        g_dump_config = true;
+// Answers a slice from the cache: copies the stored G-code into a malloc'd
+// buffer for the caller and restores the slice statistics stored with it.
+static int serve_cached_slice(const orc::hash::Digest& key, const orc::cache::Entry& entry, double hash_ms,
+                              orc::profile::SliceProfile& profile, json& slice_stats, uint8_t** gcode_out,
+                              size_t* gcode_len)
+{
+    profile.begin("cache");
+    const std::string& gcode = *entry.data;
+    uint8_t* buf = gcode.empty() ? nullptr : static_cast<uint8_t*>(malloc(gcode.size()));
+    if (!gcode.empty() && buf == nullptr) {
+        profile.end("cache");
+        *gcode_out = nullptr;
+        return -3;
     }
-    if (cfg != nullptr && len > 0) {
-        try {
-            std::string payload(reinterpret_cast<const char*>(cfg), static_cast<size_t>(len));
-            if (!payload.empty()) {
-                g_last_slice_payload = json::parse(payload, nullptr, true, true);
-            } else {
-                g_last_slice_payload.reset();
-            }
-        } catch (const std::exception &ex) {
-            fprintf(stderr, "[orc_slice] warning: failed to parse config payload: %s\n", ex.what());
-            fflush(stderr);
-            g_last_slice_payload.reset();
-        }
+    if (!gcode.empty()) {
+        std::memcpy(buf, gcode.data(), gcode.size());
+    }
+    profile.end("cache");
+    *gcode_out = buf;
+    *gcode_len = gcode.size();
+    json stored = entry.stats;
+    const auto stats = stored.find("slice");
+    if (stats != stored.end()) {
+        slice_stats = std::move(*stats);
+        stored.erase(stats);
     } else {
-        g_last_slice_payload.reset();
+        slice_stats = nullptr;
     }
+    profile.set_counter("bytes_emitted", gcode.size());
+    profile.set_cache({{"hit", true}, {"key", key.hex()}, {"hashMs", hash_ms}, {"stored", std::move(stored)}});
+    ORC_LOG("[orc_slice] cache hit %s (%zu bytes)\n", key.hex().c_str(), gcode.size());
     return 0;
 }
 
-// Slice: model bytes in, gcode out
-__attribute__((used)) int orc_slice(const uint8_t* model, int len,
-                                   uint8_t** gcode_out, int* gcode_len) {
+// Hands the budget's peak to the profile however the slice ends.
+struct BudgetReport {
+    const orc::alloc::BudgetScope& budget;
+    orc::profile::SliceProfile& profile;
+
+    ~BudgetReport() { profile.set_budget_peak(budget.peak_bytes()); }
+};
+
+// Slice: model bytes in, gcode out. Everything mutable lives in `session` or
+// on this stack frame, so different sessions may slice on different threads.
+static int slice_in_session(orc::session::Session& session, const uint8_t* model, size_t len,
+                            uint8_t** gcode_out, size_t* gcode_len) {
     ensure_resources_initialized();
+    std::lock_guard<std::mutex> busy(session.busy);
+    orc::trace::Scope slice_scope("orc_slice");
+    orc::profile::SliceProfile &profile = session.profile;
+    const orc::profile::ScopedCurrent bind_profile(profile);
+    profile.reset();
+    session.slice_stats = nullptr;
+    // Build the shared default config outside the arena: it lives for the
+    // whole process and would pin arena pages.
+    (void)cached_default_config();
+    const orc::arena::Scope arena(session.options.arena);
+    const size_t memory_budget = session.options.memory_budget;
+    if (memory_budget > 0 && !orc::alloc::kBudgetsEnforced) {
+        ORC_WARN("[orc_slice] memoryBudgetMb needs the allocation hooks; this build has ORC_BRIDGE_ALLOC_PROFILE=off\n");
+        return -6;
+    }
+    profile.set_memory_budget(memory_budget);
+    if (session.options.slice_kernel && !ORC_BRIDGE_SLICE_KERNEL) {
+        ORC_WARN("[orc_slice] sliceKernel needs patches/orca-wasm-slice-kernel.patch; slicing with slice_mesh\n");
+    }
+    // Outlives the try block so the handler can tell a refusal from a real
+    // out-of-memory.
+    const orc::alloc::BudgetScope budget(memory_budget);
+    const BudgetReport budget_report{budget, profile};
+    const orc::slice::KernelScope slice_kernel(session.options.slice_kernel);
     try {
-        fprintf(stderr, "[orc_slice] start len=%d\n", len);
-        fflush(stderr);
+        // Loading, decimation, slicing and export run their parallel loops
+        // here, so TBB workers are charged to this slice's budget and use its
+        // arena and slice kernel settings.
+        orc::workers::TaskArena workers;
+        ORC_LOG("[orc_slice] start len=%zu\n", len);
+        profile.set_counter("input_bytes", static_cast<uint64_t>(len));
+        const double slice_start_ms = now_ms();
+        // 0) A repeat of an earlier request is answered before loading.
+        const bool use_cache = session.options.cache && orc::cache::enabled();
+        orc::hash::Digest mesh_digest;
+        orc::hash::Digest input_key;
+        orc::hash::Digest content_key;
+        double cache_hash_ms = 0.0;
+        if (use_cache) {
+            const double hash_start_ms = now_ms();
+            mesh_digest = orc::hash::hash128(model, len);
+            input_key = orc::cache::input_key(mesh_digest, session.payload ? session.payload->dump() : std::string());
+            cache_hash_ms += now_ms() - hash_start_ms;
+            if (const std::optional<orc::hash::Digest> key = orc::cache::resolve(input_key)) {
+                if (const std::optional<orc::cache::Entry> hit = orc::cache::find(*key)) {
+                    return serve_cached_slice(*key, *hit, cache_hash_ms, profile, session.slice_stats, gcode_out,
+                                              gcode_len);
+                }
+            }
+        }
         // 1) Load model from buffer
         Model orca_model;
-        if (!load_stl_from_buffer(model, len, orca_model)) {
-            fprintf(stderr, "[orc_slice] load_stl_from_buffer failed\n");
-            fflush(stderr);
+        profile.begin("load");
+        const bool is_3mf = orc::threemf::is_3mf(model, len);
+        const bool compressed = !is_3mf && orc::inflate::detect(model, len) != orc::inflate::Format::None;
+        const bool loaded = workers.execute([&] {
+            if (is_3mf) {
+                return load_3mf_model(model, len, orca_model, profile);
+            }
+            if (compressed) {
+                return load_compressed_stl_model(model, len, session, orca_model, profile);
+            }
+            return load_stl_model(model, len, session, orca_model, profile);
+        });
+        profile.end("load");
+        if (!loaded) {
+            ORC_WARN("[orc_slice] %s load failed\n", is_3mf ? "3MF" : compressed ? "compressed STL" : "STL");
             return -1; // Failed to load
         }
 
         if (orca_model.objects.empty()) {
-            fprintf(stderr, "[orc_slice] model empty\n");
-            fflush(stderr);
+            ORC_WARN("[orc_slice] model empty\n");
             return -2; // No objects in model
         }
+        uint64_t triangles = 0;
+        for (const ModelObject *object : orca_model.objects) {
+            for (const ModelVolume *volume : object->volumes) {
+                triangles += volume->mesh().facets_count();
+            }
+        }
+        profile.set_counter("triangles", triangles);
 
-        if (g_last_slice_payload) {
-            apply_model_rotation(orca_model, *g_last_slice_payload);
+        if (session.payload) {
+            apply_model_rotation(orca_model, *session.payload);
         }
 
         const BoundingBoxf3 bbox = orca_model.bounding_box_exact();
@@ -1636,8 +1856,7 @@ __attribute__((used)) int orc_slice(const uint8_t* model, int len,
         if (min_dim > 0.0 && min_dim < 0.5) {
             const double target = 20.0;
             const double scale_factor = target / std::max(min_dim, 1e-3);
-            fprintf(stderr, "[orc_slice] auto-scaling model by %.3fx to reach %.1fmm min dimension\n", scale_factor, target);
-            fflush(stderr);
+            ORC_LOG("[orc_slice] auto-scaling model by %.3fx to reach %.1fmm min dimension\n", scale_factor, target);
             for (ModelObject *object : orca_model.objects) {
                 if (object != nullptr) {
                     object->scale(scale_factor);
@@ -1646,13 +1865,12 @@ __attribute__((used)) int orc_slice(const uint8_t* model, int len,
         }
 
         if (!orca_model.add_default_instances()) {
-            fprintf(stderr, "[orc_slice] add_default_instances failed\n");
-            fflush(stderr);
+            ORC_WARN("[orc_slice] add_default_instances failed\n");
             return -2;
         }
 
         // 2) Create print with default config
-        DynamicPrintConfig config = get_default_config();
+        DynamicPrintConfig config = cached_default_config();
         auto update_object_counts = [&]() {
             int printable_objects = 0;
             int printable_instances = 0;
@@ -1672,64 +1890,149 @@ __attribute__((used)) int orc_slice(const uint8_t* model, int len,
                 }
             }
             if (!set_int_option(config, "num_objects", printable_objects)) {
-                fprintf(stderr, "[orc_slice] warning: failed to seed num_objects option (value=%d)\n", printable_objects);
+                ORC_WARN("[orc_slice] warning: failed to seed num_objects option (value=%d)\n", printable_objects);
             }
             if (!set_int_option(config, "num_instances", printable_instances)) {
-                fprintf(stderr, "[orc_slice] warning: failed to seed num_instances option (value=%d)\n", printable_instances);
+                ORC_WARN("[orc_slice] warning: failed to seed num_instances option (value=%d)\n", printable_instances);
             }
         };
         update_object_counts();
-        if (g_last_slice_payload) {
-            apply_config_overrides(config, *g_last_slice_payload);
+        if (session.payload) {
+            apply_config_overrides(config, *session.payload);
         }
-        const bool dump_config = g_dump_config || (std::getenv("ORC_DUMP_CONFIG") != nullptr);
+        const bool dump_config = session.dump_config || (std::getenv("ORC_DUMP_CONFIG") != nullptr);
         if (dump_config) {
             log_config(config);
         }
+        if (use_cache) {
+            // Same resolved config from a different payload.
+            const double hash_start_ms = now_ms();
+            content_key = orc::cache::content_key(mesh_digest, config, cache_key_extras(session));
+            cache_hash_ms += now_ms() - hash_start_ms;
+            if (const std::optional<orc::cache::Entry> hit = orc::cache::find(content_key)) {
+                orc::cache::alias(input_key, content_key);
+                return serve_cached_slice(content_key, *hit, cache_hash_ms, profile, session.slice_stats, gcode_out,
+                                          gcode_len);
+            }
+            orc::cache::note_miss();
+        }
+        if (session.options.decimate) {
+            const double tolerance = session.options.decimate_tolerance_mm > 0.0 ?
+                                         session.options.decimate_tolerance_mm :
+                                         orc::decimate::tolerance_from_config(config);
+            profile.begin("decimate");
+            const orc::decimate::Report report =
+                workers.execute([&] { return orc::decimate::decimate_model(orca_model, tolerance); });
+            profile.end("decimate");
+            profile.set_decimation(report.to_json());
+            ORC_LOG("[orc_slice] decimated %" PRIu64 " -> %" PRIu64 " triangles, tolerance %.3fmm, hausdorff %.4fmm\n",
+                    report.triangles_before, report.triangles_after, report.tolerance_mm, report.hausdorff_mm);
+        }
         Print print;
-        print.set_status_callback([](const PrintBase::SlicingStatus& status) {
+        print.set_status_callback([&print, &profile](const PrintBase::SlicingStatus& status) {
+            record_status_event(status);
+            profile.observe_print(print);
             if (status.percent >= 0) {
-                fprintf(stderr, "[orc_slice] status %d%% %s\n", status.percent, status.text.c_str());
+                ORC_LOG("[orc_slice] status %d%% %s\n", status.percent, status.text.c_str());
             } else {
-                fprintf(stderr, "[orc_slice] status %s\n", status.text.c_str());
+                ORC_LOG("[orc_slice] status %s\n", status.text.c_str());
             }
-            fflush(stderr);
         });
-    fprintf(stderr, "[orc_slice] applying config\n");
-        fflush(stderr);
-    log_memory_usage("before apply");
-    print.apply(orca_model, config);
-    log_memory_usage("after apply");
+        ORC_LOG("[orc_slice] applying config\n");
+        log_memory_usage("before apply");
+        profile.begin("apply");
+        print.apply(orca_model, config);
+        profile.end("apply");
+
+        // Layers of an earlier slice with the same object settings; the
+        // restored steps are skipped by process().
+        const bool use_layer_cache = use_cache && session.options.layer_cache;
+        const std::string layers_dir = use_layer_cache ? session.scratch_path("layers") : std::string();
+        orc::hash::Digest layers_key;
+        orc::layer_cache::Outcome layers = orc::layer_cache::Outcome::Miss;
+        if (use_layer_cache) {
+            layers_key = orc::layer_cache::key(mesh_digest, config, cache_key_extras(session));
+            orc::layer_cache::Report report;
+            profile.begin("restore");
+            try {
+                layers = workers.execute([&] { return orc::layer_cache::restore(print, layers_key, layers_dir, report); });
+            } catch (const std::bad_alloc&) {
+                ORC_WARN("[orc_slice] layer restore skipped: out of memory\n");
+                layers = orc::layer_cache::Outcome::Failed;
+            }
+            if (layers == orc::layer_cache::Outcome::Failed) {
+                // Start over from a clean print.
+                print.clear();
+                print.apply(orca_model, config);
+            }
+            profile.end("restore");
+            json lookup = report.to_json();
+            lookup["restored"] = layers == orc::layer_cache::Outcome::Restored;
+            profile.set_layer_cache(std::move(lookup));
+        }
+        if (memory_budget > 0) {
+            // Print::apply keeps its own copy of the model.
+            orca_model.clear_objects();
+        }
+        log_memory_usage("after apply");
 
         // 3) Process (slice)
-        fprintf(stderr, "[orc_slice] processing\n");
-        fflush(stderr);
-    log_memory_usage("before process");
-    const double process_start_ms = now_ms();
-        print.process();
-    const double process_ms = now_ms() - process_start_ms;
-        fprintf(stderr, "[orc_slice] process complete\n");
-        fflush(stderr);
-    log_memory_usage("after process");
-    fprintf(stderr, "[orc_slice] process wall_time_ms=%.2f\n", process_ms);
-    fflush(stderr);
+        ORC_LOG("[orc_slice] processing\n");
+        log_memory_usage("before process");
+        const double process_start_ms = now_ms();
+        profile.begin("process");
+        workers.execute([&] { print.process(); });
+        profile.observe_print(print);
+        profile.end("process");
+        const double process_ms = now_ms() - process_start_ms;
+        orc::profile::collect_print_counters(profile, print);
+        log_memory_usage("after process");
+        ORC_LOG("[orc_slice] process wall_time_ms=%.2f\n", process_ms);
+
+        if (use_layer_cache && layers != orc::layer_cache::Outcome::Restored) {
+            orc::layer_cache::Report report;
+            bool saved = false;
+            profile.begin("persist");
+            try {
+                saved = workers.execute([&] { return orc::layer_cache::save(print, layers_key, layers_dir, report); });
+            } catch (const std::bad_alloc&) {
+                ORC_WARN("[orc_slice] layer save skipped: out of memory\n");
+            }
+            profile.end("persist");
+            json lookup = report.to_json();
+            lookup["restored"] = false;
+            lookup["saved"] = saved;
+            profile.set_layer_cache(std::move(lookup));
+        }
 
         // 4) Generate G-code into a temporary file and read it back
-        GCode gcode_generator;
+        std::optional<GCode> gcode_generator;
+        gcode_generator.emplace();
+        std::optional<GCodeProcessorResult> processor_result;
+        processor_result.emplace();
         const Vec3d plate_origin = print.get_plate_origin();
-        gcode_generator.set_gcode_offset(plate_origin(0), plate_origin(1));
-        fprintf(stderr, "[orc_slice] exporting gcode\n");
-        fflush(stderr);
-    log_memory_usage("before export");
-    const double export_start_ms = now_ms();
+        gcode_generator->set_gcode_offset(plate_origin(0), plate_origin(1));
+        ORC_LOG("[orc_slice] exporting gcode\n");
+        log_memory_usage("before export");
+        const double export_start_ms = now_ms();
 
-        const std::string temp_gcode_path = "/tmp/wasm_output.gcode";
+        const std::string temp_gcode_path = session.scratch_path("wasm_output.gcode");
         const auto remove_temp_file = [&]() { unlink(temp_gcode_path.c_str()); };
-        gcode_generator.do_export(&print, temp_gcode_path.c_str());
-    const double export_ms = now_ms() - export_start_ms;
-    fprintf(stderr, "[orc_slice] export complete wall_time_ms=%.2f\n", export_ms);
-    fflush(stderr);
-    log_memory_usage("after export");
+        profile.begin("export");
+        workers.execute([&] { gcode_generator->do_export(&print, temp_gcode_path.c_str(), &*processor_result); });
+        profile.end("export");
+        json slice_stats = slice_statistics(print, *processor_result);
+        const double export_ms = now_ms() - export_start_ms;
+        ORC_LOG("[orc_slice] export complete wall_time_ms=%.2f\n", export_ms);
+
+        // Drop every layer, the G-code processor's move list and the model
+        // before the output buffer is allocated, so the slice peaks at the
+        // larger of the two instead of their sum.
+        gcode_generator.reset();
+        processor_result.reset();
+        print.clear();
+        orca_model.clear_objects();
+        log_memory_usage("after export");
 
         FILE* gcode_file = fopen(temp_gcode_path.c_str(), "rb");
         if (!gcode_file) {
@@ -1738,14 +2041,15 @@ __attribute__((used)) int orc_slice(const uint8_t* model, int len,
             return -3;
         }
 
-        if (fseek(gcode_file, 0, SEEK_END) != 0) {
+        if (fseeko(gcode_file, 0, SEEK_END) != 0) {
             fclose(gcode_file);
             remove_temp_file();
             *gcode_out = nullptr;
             return -3;
         }
 
-        long file_length = ftell(gcode_file);
+        // off_t is 64-bit on every target, so outputs past 2 GiB read back whole.
+        const off_t file_length = ftello(gcode_file);
         if (file_length < 0) {
             fclose(gcode_file);
             remove_temp_file();
@@ -1754,12 +2058,29 @@ __attribute__((used)) int orc_slice(const uint8_t* model, int len,
         }
         rewind(gcode_file);
 
-        std::string gcode_str;
-        gcode_str.resize(static_cast<size_t>(file_length));
-
-        if (file_length > 0) {
-            size_t read_bytes = fread(gcode_str.data(), 1, gcode_str.size(), gcode_file);
-            if (read_bytes != gcode_str.size()) {
+        size_t gcode_size = static_cast<size_t>(file_length);
+        uint8_t* buf = nullptr;
+        if (session.options.binary_gcode) {
+            profile.begin("bgcode");
+            const bool encoded = encode_bgcode(gcode_file, session.options.bgcode, profile, buf, gcode_size);
+            profile.end("bgcode");
+            if (!encoded) {
+                fclose(gcode_file);
+                remove_temp_file();
+                *gcode_out = nullptr;
+                return -3;
+            }
+        } else {
+            // Read straight into the buffer handed to the caller; no intermediate copy.
+            buf = gcode_size > 0 ? static_cast<uint8_t*>(malloc(gcode_size)) : nullptr;
+            if (gcode_size > 0 && buf == nullptr) {
+                fclose(gcode_file);
+                remove_temp_file();
+                *gcode_out = nullptr;
+                return -3;
+            }
+            if (gcode_size > 0 && fread(buf, 1, gcode_size, gcode_file) != gcode_size) {
+                free(buf);
                 fclose(gcode_file);
                 remove_temp_file();
                 *gcode_out = nullptr;
@@ -1770,41 +2091,423 @@ __attribute__((used)) int orc_slice(const uint8_t* model, int len,
         fclose(gcode_file);
         remove_temp_file();
 
-        *gcode_len = static_cast<int>(gcode_str.size());
-        if (*gcode_len == 0) {
-            *gcode_out = nullptr;
-            return 0;
-        }
-
-        uint8_t* buf = static_cast<uint8_t*>(malloc(gcode_str.size()));
-        if (!buf) {
-            *gcode_out = nullptr;
-            return -3;
-        }
-
-        std::memcpy(buf, gcode_str.data(), gcode_str.size());
         *gcode_out = buf;
+        *gcode_len = gcode_size;
+        profile.set_counter("bytes_emitted", gcode_size);
+        session.slice_stats = std::move(slice_stats);
+
+        if (use_cache) {
+            json stats = json::object();
+            stats["sliceMs"] = now_ms() - slice_start_ms;
+            stats["counters"] = profile.to_json()["counters"];
+            stats["slice"] = session.slice_stats;
+            try {
+                orc::cache::store(input_key, content_key, buf, gcode_size, std::move(stats));
+            } catch (const std::bad_alloc&) {
+                // Over the memory budget; the slice itself succeeded.
+                ORC_WARN("[orc_slice] cache store skipped: out of memory\n");
+            }
+            profile.set_cache({{"hit", false}, {"key", content_key.hex()}, {"hashMs", cache_hash_ms}});
+        }
 
         return 0; // Success
 
+    } catch (const std::bad_alloc&) {
+        if (budget.refusals() != 0) {
+            ORC_WARN("[orc_slice] memory budget of %zu bytes exceeded (peak %zu)\n", memory_budget, budget.peak_bytes());
+            return -6; // Over budget
+        }
+        ORC_WARN("[orc_slice] exception: out of memory\n");
+        return -4; // Exception
     } catch (const std::exception& e) {
-        fprintf(stderr, "[orc_slice] exception: %s\n", e.what());
-        fflush(stderr);
+        ORC_WARN("[orc_slice] exception: %s\n", e.what());
         return -4; // Exception
     } catch (...) {
-        fprintf(stderr, "[orc_slice] unknown exception\n");
-        fflush(stderr);
+        ORC_WARN("[orc_slice] unknown exception\n");
         return -4; // Exception
     }
 }
 
+// Serializes the session's last slice statistics into a malloc'd buffer; -4
+// when the last slice failed or none ran yet.
+static int session_slice_stats_json(orc::session::Session& session, uint8_t **json_out, size_t *json_len)
+{
+    if (json_out == nullptr || json_len == nullptr) {
+        return -1;
+    }
+    *json_out = nullptr;
+    *json_len = 0;
+    try {
+        std::lock_guard<std::mutex> busy(session.busy);
+        if (session.slice_stats.is_null()) {
+            return -4;
+        }
+        const std::string dump = session.slice_stats.dump();
+        uint8_t *buffer = static_cast<uint8_t *>(std::malloc(dump.size()));
+        if (buffer == nullptr) {
+            return -2;
+        }
+        std::memcpy(buffer, dump.data(), dump.size());
+        *json_out = buffer;
+        *json_len = dump.size();
+        return 0;
+    } catch (...) {
+        return -3;
+    }
+}
+
+// Serializes the session's last slice profile into a malloc'd buffer.
+static int session_profile_json(orc::session::Session& session, uint8_t **json_out, size_t *json_len)
+{
+    if (json_out == nullptr || json_len == nullptr) {
+        return -1;
+    }
+    *json_out = nullptr;
+    *json_len = 0;
+    try {
+        std::lock_guard<std::mutex> busy(session.busy);
+        const std::string dump = session.profile.to_json().dump();
+        uint8_t *buffer = static_cast<uint8_t *>(std::malloc(dump.size()));
+        if (buffer == nullptr) {
+            return -2;
+        }
+        std::memcpy(buffer, dump.data(), dump.size());
+        *json_out = buffer;
+        *json_len = dump.size();
+        return 0;
+    } catch (...) {
+        return -3;
+    }
+}
+
+extern "C" {
+
+__attribute__((used)) int orc_describe_config(uint8_t **json_out, size_t *json_len)
+{
+    if (json_out == nullptr || json_len == nullptr) {
+        return -1;
+    }
+    ensure_resources_initialized();
+    try {
+        json schema = build_config_schema();
+        const std::string dump = schema.dump();
+        if (dump.empty()) {
+            *json_out = nullptr;
+            *json_len = 0;
+            return 0;
+        }
+        uint8_t *buffer = static_cast<uint8_t *>(std::malloc(dump.size()));
+        if (buffer == nullptr) {
+            *json_out = nullptr;
+            *json_len = 0;
+            return -2;
+        }
+        std::memcpy(buffer, dump.data(), dump.size());
+        *json_out = buffer;
+        *json_len = dump.size();
+        return 0;
+    } catch (const std::exception &ex) {
+        ORC_WARN("[orc_slice] error: describe_config exception %s\n", ex.what());
+        *json_out = nullptr;
+        *json_len = 0;
+        return -3;
+    } catch (...) {
+        ORC_WARN("[orc_slice] error: describe_config unknown exception\n");
+        *json_out = nullptr;
+        *json_len = 0;
+        return -3;
+    }
+}
+
+// Load resources and build the default print config ahead of the first slice.
+// Hosts that fork or snapshot after start-up call this once so every job
+// starts warm.
+__attribute__((used)) int orc_warmup() {
+    try {
+        ensure_resources_initialized();
+        (void)cached_default_config();
+        return 0;
+    } catch (const std::exception &ex) {
+        ORC_WARN("[orc_warmup] failed: %s\n", ex.what());
+        return -1;
+    }
+}
+
+// Pre-initialization entry point for the module snapshot (ORC_WASM_SNAPSHOT).
+// wasm-ctor-eval runs it at build time after the static constructors and
+// bakes the resulting linear memory into slicer.wasm, so PrintConfigDef, the
+// default config and the resource dirs are ready the moment the module is
+// instantiated. It must not touch imports (clock, trace, files); evaluation
+// stops at the first one. Not for use at run time.
+__attribute__((used)) void orc_snapshot_init()
+{
+    ensure_resources_initialized();
+    (void)cached_default_config();
+    g_snapshot_initialized = true;
+}
+
+// Start-up state digests as JSON (see config_fingerprint);
+// scripts/verify-snapshot.js compares a snapshotted and a fresh module.
+__attribute__((used)) int orc_config_fingerprint(uint8_t **json_out, size_t *json_len)
+{
+    if (json_out == nullptr || json_len == nullptr) {
+        return -1;
+    }
+    *json_out = nullptr;
+    *json_len = 0;
+    try {
+        const std::string dump = config_fingerprint().dump();
+        uint8_t *buffer = static_cast<uint8_t *>(std::malloc(dump.size()));
+        if (buffer == nullptr) {
+            return -2;
+        }
+        std::memcpy(buffer, dump.data(), dump.size());
+        *json_out = buffer;
+        *json_len = dump.size();
+        return 0;
+    } catch (...) {
+        return -3;
+    }
+}
+
+// Optional: capture config (JSON/TOML) once for the default session
+__attribute__((used)) int orc_init(const uint8_t* cfg, size_t len) {
+    return init_session(*orc::session::find(orc::session::kDefaultHandle), cfg, len);
+}
+
+// Slice on the default session: model bytes in, gcode out
+__attribute__((used)) int orc_slice(const uint8_t* model, size_t len,
+                                   uint8_t** gcode_out, size_t* gcode_len) {
+    return slice_in_session(*orc::session::find(orc::session::kDefaultHandle), model, len, gcode_out, gcode_len);
+}
+
+// Independent slicing contexts. Each session has its own config payload,
+// profile and scratch directory; calls on different sessions may run
+// concurrently. Returns 0 if the session could not be created.
+__attribute__((used)) uint32_t orc_session_create()
+{
+    try {
+        const std::shared_ptr<orc::session::Session> session = orc::session::create();
+        return session != nullptr ? session->handle : orc::session::kDefaultHandle;
+    } catch (...) {
+        return orc::session::kDefaultHandle;
+    }
+}
+
+__attribute__((used)) int orc_session_init(uint32_t handle, const uint8_t* cfg, size_t len)
+{
+    const std::shared_ptr<orc::session::Session> session = orc::session::find(handle);
+    if (session == nullptr) {
+        return -5;
+    }
+    return init_session(*session, cfg, len);
+}
+
+// Same return codes as orc_slice, plus -5 for an unknown session handle.
+__attribute__((used)) int orc_session_slice(uint32_t handle, const uint8_t* model, size_t len,
+                                           uint8_t** gcode_out, size_t* gcode_len)
+{
+    const std::shared_ptr<orc::session::Session> session = orc::session::find(handle);
+    if (session == nullptr) {
+        return -5;
+    }
+    return slice_in_session(*session, model, len, gcode_out, gcode_len);
+}
+
+__attribute__((used)) int orc_session_get_profile(uint32_t handle, uint8_t **json_out, size_t *json_len)
+{
+    const std::shared_ptr<orc::session::Session> session = orc::session::find(handle);
+    if (session == nullptr) {
+        return -5;
+    }
+    return session_profile_json(*session, json_out, json_len);
+}
+
+__attribute__((used)) int orc_session_get_slice_stats(uint32_t handle, uint8_t **json_out, size_t *json_len)
+{
+    const std::shared_ptr<orc::session::Session> session = orc::session::find(handle);
+    if (session == nullptr) {
+        return -5;
+    }
+    return session_slice_stats_json(*session, json_out, json_len);
+}
+
+// Releases a session created by orc_session_create. Unknown handles and the
+// default session are ignored.
+__attribute__((used)) void orc_session_destroy(uint32_t handle)
+{
+    orc::session::destroy(handle);
+}
+
 __attribute__((used)) void orc_free(void* p) {
     free(p);
 }
 
+// Export the trace ring as Chrome trace_event JSON. The buffer is malloc'd and
+// must be released with orc_free.
+__attribute__((used)) int orc_trace_export(uint8_t **json_out, size_t *json_len)
+{
+    if (json_out == nullptr || json_len == nullptr) {
+        return -1;
+    }
+    *json_out = nullptr;
+    *json_len = 0;
+    try {
+        const std::string dump = orc::trace::export_chrome_json();
+        uint8_t *buffer = static_cast<uint8_t *>(std::malloc(dump.size()));
+        if (buffer == nullptr) {
+            return -2;
+        }
+        std::memcpy(buffer, dump.data(), dump.size());
+        *json_out = buffer;
+        *json_len = dump.size();
+        return 0;
+    } catch (...) {
+        return -3;
+    }
+}
+
+__attribute__((used)) void orc_trace_clear()
+{
+    orc::trace::clear();
+}
+
+// Profile of the most recent orc_slice as JSON: per-phase wall time and peak heap
+// for bridge phases, PrintObjectSteps and G-code stages, plus workload counters.
+__attribute__((used)) int orc_get_profile(uint8_t **json_out, size_t *json_len)
+{
+    return session_profile_json(*orc::session::find(orc::session::kDefaultHandle), json_out, json_len);
+}
+
+// Estimates of the most recent successful orc_slice as JSON: layer count,
+// filament per extruder and per role, and total, per-role and per-layer time
+// for each machine-limits mode. Returns -4 after a failed slice.
+__attribute__((used)) int orc_get_slice_stats(uint8_t **json_out, size_t *json_len)
+{
+    return session_slice_stats_json(*orc::session::find(orc::session::kDefaultHandle), json_out, json_len);
+}
+
+// Allocation profile as JSON: process-wide counters and peak since the last
+// orc_reset_alloc_profile, the heap high-water mark of each phase of the
+// default session's last slice and, in sampling builds, the heaviest call
+// sites. The mode is chosen at build time (ORC_BRIDGE_ALLOC_PROFILE).
+__attribute__((used)) int orc_get_alloc_profile(uint8_t **json_out, size_t *json_len)
+{
+    if (json_out == nullptr || json_len == nullptr) {
+        return -1;
+    }
+    *json_out = nullptr;
+    *json_len = 0;
+    try {
+        json result = orc::alloc::to_json();
+        json phases = json::object();
+        {
+            const std::shared_ptr<orc::session::Session> session = orc::session::find(orc::session::kDefaultHandle);
+            std::lock_guard<std::mutex> busy(session->busy);
+            const json profile = session->profile.to_json();
+            for (const auto &group : profile["phases"].items()) {
+                json &marks = phases[group.key()];
+                marks = json::object();
+                for (const json &phase : group.value()) {
+                    marks[phase["name"].get<std::string>()] = phase["peakHeapBytes"];
+                }
+            }
+        }
+        result["phasePeakBytes"] = std::move(phases);
+        const std::string dump = result.dump();
+        uint8_t *buffer = static_cast<uint8_t *>(std::malloc(dump.size()));
+        if (buffer == nullptr) {
+            return -2;
+        }
+        std::memcpy(buffer, dump.data(), dump.size());
+        *json_out = buffer;
+        *json_len = dump.size();
+        return 0;
+    } catch (...) {
+        return -3;
+    }
+}
+
+__attribute__((used)) void orc_reset_alloc_profile()
+{
+    orc::alloc::reset();
+}
+
+// Hand free heap space back to the allocator and report fragmentation: total
+// free bytes against the largest free block, plus the slice arena's pages.
+// Call between jobs; long-lived workers use it instead of being recycled.
+__attribute__((used)) int orc_trim_heap(uint8_t **json_out, size_t *json_len)
+{
+    if (json_out == nullptr || json_len == nullptr) {
+        return -1;
+    }
+    *json_out = nullptr;
+    *json_len = 0;
+    try {
+        json result = orc::alloc::trim_heap();
+        result["arena"] = orc::arena::to_json();
+        const std::string dump = result.dump();
+        uint8_t *buffer = static_cast<uint8_t *>(std::malloc(dump.size()));
+        if (buffer == nullptr) {
+            return -2;
+        }
+        std::memcpy(buffer, dump.data(), dump.size());
+        *json_out = buffer;
+        *json_len = dump.size();
+        return 0;
+    } catch (...) {
+        return -3;
+    }
+}
+
+// Sizes the process-wide slice result cache (see orc_cache.h). max_bytes 0
+// turns it off; max_entries 0 means no count limit; a non-empty `dir`
+// persists entries there (an IDBFS mount on the web).
+__attribute__((used)) int orc_cache_configure(size_t max_bytes, uint32_t max_entries, const char* dir)
+{
+    try {
+        orc::cache::Limits limits;
+        limits.max_bytes = max_bytes;
+        limits.max_entries = max_entries;
+        limits.dir = dir != nullptr ? dir : "";
+        orc::cache::configure(limits);
+        return 0;
+    } catch (...) {
+        return -3;
+    }
+}
+
+// Cache limits, occupancy and hit/miss/eviction counters as JSON.
+__attribute__((used)) int orc_cache_stats(uint8_t **json_out, size_t *json_len)
+{
+    if (json_out == nullptr || json_len == nullptr) {
+        return -1;
+    }
+    *json_out = nullptr;
+    *json_len = 0;
+    try {
+        const std::string dump = orc::cache::to_json().dump();
+        uint8_t *buffer = static_cast<uint8_t *>(std::malloc(dump.size()));
+        if (buffer == nullptr) {
+            return -2;
+        }
+        std::memcpy(buffer, dump.data(), dump.size());
+        *json_out = buffer;
+        *json_len = dump.size();
+        return 0;
+    } catch (...) {
+        return -3;
+    }
+}
+
+__attribute__((used)) void orc_cache_clear()
+{
+    orc::cache::clear();
+}
+
 __attribute__((used)) const char* orc_decode_exception(void* exception_ptr)
 {
-    static std::string last_exception_message;
+    thread_local std::string last_exception_message;
     if (exception_ptr == nullptr) {
         last_exception_message = "(null exception)";
         return last_exception_message.c_str();
@@ -33,6 +33,76 @@ void      os_free_mesh(OS_Mesh m);
 // Free result memory  
 void      os_free_result(OS_Result r);
 
+// --- orc_* API exported by the slicer module ---
+// Buffers returned through out-parameters are malloc'd; release them with orc_free.
+// Lengths are size_t, so the wasm64 build (ORC_WASM_MEMORY64) passes them as BigInt.
+
+// Describe every print option as JSON (the schema consumed by the web UI)
+int         orc_describe_config(uint8_t** json_out, size_t* json_len);
+
+// Load resources and the default print config ahead of the first slice
+int         orc_warmup(void);
+
+// Build-time pre-initialization for the module snapshot; not for use at run time
+void        orc_snapshot_init(void);
+
+// Digests of start-up state (config definitions, default config, resource dirs) as JSON
+int         orc_config_fingerprint(uint8_t** json_out, size_t* json_len);
+
+// Store the JSON override payload used by subsequent orc_slice calls
+int         orc_init(const uint8_t* cfg, size_t len);
+
+// Slice an STL (plain, gzip or zip) or 3MF buffer into text or binary G-code (bridge.gcodeFormat);
+// returns 0 on success, negative error codes otherwise
+// (-6 when the slice exceeded the payload's bridge.memoryBudgetMb, or the build
+// cannot enforce one)
+int         orc_slice(const uint8_t* model, size_t len, uint8_t** gcode_out, size_t* gcode_len);
+
+void        orc_free(void* p);
+
+// Resolve a thrown std::exception pointer to its what() message
+const char* orc_decode_exception(void* exception_ptr);
+
+// Export the trace ring as Chrome trace_event JSON
+int         orc_trace_export(uint8_t** json_out, size_t* json_len);
+
+// Drop all recorded trace events
+void        orc_trace_clear(void);
+
+// Profile of the most recent orc_slice as JSON (phases, peak heap, counters)
+int         orc_get_profile(uint8_t** json_out, size_t* json_len);
+
+// Layer count, filament and time estimates of the most recent successful orc_slice as JSON
+// (-4 after a failed slice)
+int         orc_get_slice_stats(uint8_t** json_out, size_t* json_len);
+
+// Allocation counters, per-phase heap peaks and (sampling builds) call sites as JSON
+int         orc_get_alloc_profile(uint8_t** json_out, size_t* json_len);
+
+// Restart the allocation counters, peak and samples
+void        orc_reset_alloc_profile(void);
+
+// Trim the heap and report free bytes, largest free block and arena pages as JSON
+int         orc_trim_heap(uint8_t** json_out, size_t* json_len);
+
+// Slice result cache keyed by mesh and resolved config. max_bytes 0 disables
+// it, max_entries 0 leaves the count unbounded, a non-empty dir persists
+// entries there. Sessions opt out with bridge.cache = false.
+int         orc_cache_configure(size_t max_bytes, uint32_t max_entries, const char* dir);
+int         orc_cache_stats(uint8_t** json_out, size_t* json_len);
+void        orc_cache_clear(void);
+
+// Independent slicing sessions; calls on different sessions may run on
+// different threads. orc_init/orc_slice/orc_get_profile/orc_get_slice_stats
+// use the default session. create returns 0 on failure; the others return -5
+// for an unknown handle.
+uint32_t    orc_session_create(void);
+int         orc_session_init(uint32_t session, const uint8_t* cfg, size_t len);
+int         orc_session_slice(uint32_t session, const uint8_t* model, size_t len, uint8_t** gcode_out, size_t* gcode_len);
+int         orc_session_get_profile(uint32_t session, uint8_t** json_out, size_t* json_len);
+int         orc_session_get_slice_stats(uint32_t session, uint8_t** json_out, size_t* json_len);
+void        orc_session_destroy(uint32_t session);
+
 #ifdef __cplusplus
 }
 #endif
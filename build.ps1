@@ -148,6 +148,28 @@ if (Test-Path $patchFile) {
     }
 }
 
+# Optional hook for the bridge's slicing kernel (bridge.sliceKernel)
+$kernelPatchFile = Join-Path $PWD "patches/orca-wasm-slice-kernel.patch"
+if (Test-Path $kernelPatchFile) {
+    try {
+        Push-Location (Join-Path $PWD "orca")
+        & git apply --reverse --check "..\patches\orca-wasm-slice-kernel.patch" 2>$null
+        if ($LASTEXITCODE -eq 0) {
+            Write-Info "Orca slice kernel patch already applied"
+        } else {
+            & git apply --check "..\patches\orca-wasm-slice-kernel.patch" 2>$null
+            if ($LASTEXITCODE -eq 0) {
+                & git apply "..\patches\orca-wasm-slice-kernel.patch"
+                if ($LASTEXITCODE -eq 0) { Write-Success "Applied Orca slice kernel patch" } else { Write-Warning "Failed to apply Orca slice kernel patch (git apply). Continuing." }
+            } else {
+                Write-Warning "Orca slice kernel patch did not apply cleanly; bridge.sliceKernel will be ignored"
+            }
+        }
+    } finally {
+        Pop-Location
+    }
+}
+
 # Ensure Boost headers exist (auto-fetch headers if missing)
 $boostPrefix = Join-Path $PWD "deps/boost-wasm/install"
 $boostInclude = Join-Path $boostPrefix "include"
@@ -386,7 +408,9 @@ if (!(Test-Path $webWasmDir)) {
     New-Item -ItemType Directory -Path $webWasmDir -Force | Out-Null
 }
 
-$wasmFiles = @("slicer.js", "slicer.wasm", "slicer.data")
+# Resources ship as resources.orcpack, or slicer.data with -DORC_WASM_RESOURCE_PACK=OFF
+$resourceFile = if (Test-Path "build-wasm/resources.orcpack") { "resources.orcpack" } else { "slicer.data" }
+$wasmFiles = @("slicer.js", "slicer.wasm", $resourceFile)
 $allFilesExist = $true
 
 foreach ($file in $wasmFiles) {
@@ -409,7 +433,7 @@ if ($allFilesExist) {
 Build artifacts available at:
 - web/public/wasm/slicer.js
 - web/public/wasm/slicer.wasm
-- web/public/wasm/slicer.data
+- web/public/wasm/$resourceFile
 
 You can now serve the web application or use these files in your web worker.
 "@
@@ -1,6 +1,6 @@
 #!/usr/bin/env bash
 # Build Boost for Emscripten (WASM) with pthreads enabled (Emscripten 4.x).
-# Output prefix: deps/boost-wasm/install
+# Output prefix: deps/boost-wasm/install (install64 with ORC_WASM_MEMORY64=1)
 set -euo pipefail
 
 # -------- config --------
@@ -11,6 +11,12 @@ NPROC="${NPROC:-$(nproc)}"
 BOOST_DIR="boost_${BOOST_VER//./_}"
 SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
 PREFIX="${SCRIPT_DIR}/install"
+MEMORY64_FLAGS=""
+if [ "${ORC_WASM_MEMORY64:-0}" = "1" ]; then
+  # wasm64 objects cannot link into the wasm32 slicer; keep them apart.
+  PREFIX="${SCRIPT_DIR}/install64"
+  MEMORY64_FLAGS=" -sMEMORY64=1"
+fi
 
 say() { printf '%s\n' "$*" ; }
 
@@ -60,8 +66,8 @@ say "🔨 Building Boost components for Emscripten (this can take a while)..."
   link=static runtime-link=static \
   threading=multi \
   variant=release \
-  cxxflags="-pthread -Wno-unused-command-line-argument" \
-  linkflags="-pthread -Wno-unused-command-line-argument" \
+  cxxflags="-pthread -Wno-unused-command-line-argument${MEMORY64_FLAGS}" \
+  linkflags="-pthread -Wno-unused-command-line-argument${MEMORY64_FLAGS}" \
   ${COMPONENTS} \
   -j"${NPROC}" \
   install --prefix="${PREFIX}"
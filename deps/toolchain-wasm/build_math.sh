@@ -4,11 +4,29 @@ set -euo pipefail
 
 ROOT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)
 REPO_DIR=$(cd "${ROOT_DIR}/.." && pwd)
-PREFIX="${ROOT_DIR}/toolchain-wasm/install"
-BUILD_DIR="${ROOT_DIR}/toolchain-wasm/build"
-SRC_DIR="${ROOT_DIR}/toolchain-wasm/src"
+# ORC_WASM_MEMORY64=1 stages a wasm64 copy under install64 for the memory64 slicer.
+DEPS_SUFFIX=""
+if [[ "${ORC_WASM_MEMORY64:-0}" == "1" ]]; then
+  DEPS_SUFFIX="64"
+  export CFLAGS="${CFLAGS:-} -sMEMORY64=1"
+  export CXXFLAGS="${CXXFLAGS:-} -sMEMORY64=1"
+  export LDFLAGS="${LDFLAGS:-} -sMEMORY64=1"
+fi
+# ORC_WASM_PTHREADS=1 builds with -pthread into install-mt (install64-mt) for
+# the pthreads slicer variant, whose shared memory needs atomics-enabled objects.
+# Boost is always built with -pthread and has no -mt prefix.
+MATH_SUFFIX="${DEPS_SUFFIX}"
+if [[ "${ORC_WASM_PTHREADS:-0}" == "1" ]]; then
+  MATH_SUFFIX="${DEPS_SUFFIX}-mt"
+  export CFLAGS="${CFLAGS:-} -pthread"
+  export CXXFLAGS="${CXXFLAGS:-} -pthread"
+  export LDFLAGS="${LDFLAGS:-} -pthread"
+fi
+PREFIX="${ROOT_DIR}/toolchain-wasm/install${MATH_SUFFIX}"
+BUILD_DIR="${ROOT_DIR}/toolchain-wasm/build${MATH_SUFFIX}"
+SRC_DIR="${ROOT_DIR}/toolchain-wasm/src${MATH_SUFFIX}"
 DL_DIR="${ROOT_DIR}/toolchain-wasm/downloads"
-BOOST_PREFIX="${ROOT_DIR}/boost-wasm/install"
+BOOST_PREFIX="${ROOT_DIR}/boost-wasm/install${DEPS_SUFFIX}"
 
 mkdir -p "${PREFIX}" "${BUILD_DIR}" "${SRC_DIR}" "${DL_DIR}"
 
@@ -173,7 +191,7 @@ build_mpfr() {
   extract "${DL_DIR}/${tarball}" "${src}"
   if [[ ! -f "${PREFIX}/lib/libmpfr.a" ]]; then
     pushd "${src}" >/dev/null
-    CPPFLAGS="-I${PREFIX}/include" LDFLAGS="-L${PREFIX}/lib" \
+    CPPFLAGS="-I${PREFIX}/include" LDFLAGS="${LDFLAGS:-} -L${PREFIX}/lib" \
     CC_FOR_BUILD=gcc CXX_FOR_BUILD=g++ \
     ac_cv_prog_cc_works=yes ac_cv_prog_cxx_works=yes ac_cv_c_bigendian=no \
     CC=emcc CXX=em++ AR=emar RANLIB=emranlib NM=llvm-nm \
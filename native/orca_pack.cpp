@@ -0,0 +1,98 @@
+// Inspects a resource pack (scripts/pack-resources.js) through the bridge's
+// mmap reader.
+//
+//   orca_pack list PACK           one line per entry: size, core flag, path
+//   orca_pack cat PACK PATH       write an entry to stdout from the mapping
+//   orca_pack verify PACK ROOT    compare every entry with the file under ROOT
+//
+// verify exits non-zero when the pack and the tree disagree, which makes it a
+// cheap check that a deployed pack matches the resources it was built from.
+
+#include "orc_pack.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+int list(const orc::pack::Archive &pack)
+{
+    for (size_t i = 0; i < pack.size(); ++i) {
+        const orc::pack::Entry e = pack.entry(i);
+        std::printf("%10zu %s %.*s\n", e.size, e.core ? "core" : "    ", int(e.path.size()), e.path.data());
+    }
+    std::printf("%zu entries, %llu core bytes\n", pack.size(), static_cast<unsigned long long>(pack.core_bytes()));
+    return 0;
+}
+
+int cat(const orc::pack::Archive &pack, const char *path)
+{
+    const auto e = pack.find(path);
+    if (!e) {
+        std::fprintf(stderr, "[orca_pack] %s: no such entry\n", path);
+        return 1;
+    }
+    return std::fwrite(e->data, 1, e->size, stdout) == e->size ? 0 : 1;
+}
+
+int verify(const orc::pack::Archive &pack, const std::string &root)
+{
+    size_t mismatches = 0;
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i < pack.size(); ++i) {
+        const orc::pack::Entry e = pack.entry(i);
+        const std::string file = root + "/" + std::string(e.path);
+        FILE *f = std::fopen(file.c_str(), "rb");
+        bool same = false;
+        if (f != nullptr) {
+            bytes.resize(e.size + 1);
+            // Reading one byte past the entry catches files that grew.
+            same = std::fread(bytes.data(), 1, bytes.size(), f) == e.size &&
+                   (e.size == 0 || std::memcmp(bytes.data(), e.data, e.size) == 0);
+            std::fclose(f);
+        }
+        if (!same) {
+            std::fprintf(stderr, "[orca_pack] mismatch: %s\n", file.c_str());
+            ++mismatches;
+        }
+    }
+    std::printf("%zu entries, %zu mismatches\n", pack.size(), mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+                 "usage: %s list PACK\n"
+                 "       %s cat PACK PATH\n"
+                 "       %s verify PACK ROOT\n",
+                 argv0, argv0, argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+    const std::string command = argv[1];
+    orc::pack::Archive pack;
+    if (!pack.open(argv[2])) {
+        return 1;
+    }
+    if (command == "list" && argc == 3) {
+        return list(pack);
+    }
+    if (command == "cat" && argc == 4) {
+        return cat(pack, argv[3]);
+    }
+    if (command == "verify" && argc == 4) {
+        return verify(pack, argv[3]);
+    }
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,463 @@
+// Headless slicing daemon.
+//
+// Loads resources and the default print config once (orc_warmup), then
+// preforks worker processes that inherit the warm state copy-on-write. Each
+// worker accepts connections on a Unix socket and serves jobs one after
+// another; with --stdio a single in-process worker serves jobs framed on
+// stdin/stdout instead.
+//
+// The bridge is reentrant through orc_session_*, but workers are still
+// processes rather than threads: a crash or heap blow-up in libslic3r takes
+// down one job instead of the daemon, --max-jobs can recycle a worker to
+// return its fragmented heap, and the heap figures in each job's profile,
+// which are process-wide, stay per job. Each worker gets its own
+// ORC_SCRATCH_DIR so their temp files never collide.
+//
+// Wire format (all integers little-endian):
+//
+//   request   "ORC1"  u32 config_len  u64 model_len  config[config_len]  model[model_len]
+//   response  one or more frames: u8 type, u8[3] zero, u32 length, payload[length]
+//               'G'  G-code chunk; concatenate in order
+//               'P'  profile JSON (orc_get_profile) for the job
+//               'S'  slice statistics JSON (orc_get_slice_stats), successful jobs only
+//               'D'  done: i32 rc (orc_slice return code), then an optional UTF-8 message
+//
+// A connection may carry any number of requests; the daemon answers them in
+// order and closes when the client does.
+
+#include "wasm_wrap.h"
+
+#include <ftw.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr char     kRequestMagic[4] = {'O', 'R', 'C', '1'};
+constexpr size_t   kRequestHeaderSize = 16;
+constexpr size_t   kFrameHeaderSize = 8;
+constexpr uint32_t kMaxConfigBytes = 16u << 20;
+
+struct Options
+{
+    std::string socket_path;
+    bool        stdio       = false;
+    int         workers     = 0;
+    uint64_t    max_jobs    = 0;
+    uint64_t    max_model   = 512ull << 20;
+    size_t      chunk_bytes = 1u << 20;
+};
+
+volatile sig_atomic_t g_stop = 0;
+
+void on_stop_signal(int)
+{
+    g_stop = 1;
+}
+
+// No SA_RESTART: a blocking accept()/read() returns EINTR so the loop can
+// notice g_stop.
+void install_stop_handlers()
+{
+    struct sigaction action{};
+    action.sa_handler = on_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+}
+
+uint32_t load_u32(const uint8_t *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+uint64_t load_u64(const uint8_t *p)
+{
+    return uint64_t(load_u32(p)) | (uint64_t(load_u32(p + 4)) << 32);
+}
+
+void store_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = uint8_t(v >> (8 * i));
+}
+
+// Reads exactly `len` bytes. Returns the number read, which is short only on
+// EOF or error.
+size_t read_full(int fd, void *buffer, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        const ssize_t n = read(fd, static_cast<uint8_t *>(buffer) + done, len - done);
+        if (n > 0) {
+            done += size_t(n);
+        } else if (n < 0 && errno == EINTR && !g_stop) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    return done;
+}
+
+bool write_full(int fd, const void *buffer, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        const ssize_t n = write(fd, static_cast<const uint8_t *>(buffer) + done, len - done);
+        if (n > 0) {
+            done += size_t(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool write_frame(int fd, char type, const void *payload, size_t len)
+{
+    uint8_t header[kFrameHeaderSize] = {uint8_t(type), 0, 0, 0};
+    store_u32(header + 4, uint32_t(len));
+    return write_full(fd, header, sizeof(header)) && (len == 0 || write_full(fd, payload, len));
+}
+
+bool write_done(int fd, int rc, const std::string &message)
+{
+    std::vector<uint8_t> payload(4 + message.size());
+    store_u32(payload.data(), uint32_t(rc));
+    std::memcpy(payload.data() + 4, message.data(), message.size());
+    return write_frame(fd, 'D', payload.data(), payload.size());
+}
+
+const char *describe_rc(int rc)
+{
+    switch (rc) {
+    case 0: return "";
+    case -1: return "failed to load model";
+    case -2: return "model has no printable objects";
+    case -3: return "G-code export failed";
+    case -4: return "slicing raised an exception";
+    case -5: return "unknown session";
+    case -6: return "memory budget exceeded or not supported by this build";
+    default: return "slicing failed";
+    }
+}
+
+// Runs one job and streams its frames. Returns false if the client went away.
+bool run_job(int out_fd, const std::vector<uint8_t> &config, const std::vector<uint8_t> &model, const Options &opts)
+{
+    orc_init(config.empty() ? nullptr : config.data(), config.size());
+
+    uint8_t *gcode = nullptr;
+    size_t   gcode_len = 0;
+    int      rc = -4;
+    std::string message;
+    try {
+        rc = orc_slice(model.data(), model.size(), &gcode, &gcode_len);
+        message = describe_rc(rc);
+    } catch (const std::exception &ex) {
+        message = ex.what();
+    } catch (...) {
+        message = "unknown exception";
+    }
+
+    bool ok = true;
+    if (rc == 0 && gcode != nullptr) {
+        for (size_t offset = 0; ok && offset < gcode_len; offset += opts.chunk_bytes) {
+            const size_t n = std::min(opts.chunk_bytes, gcode_len - offset);
+            ok = write_frame(out_fd, 'G', gcode + offset, n);
+        }
+    }
+    orc_free(gcode);
+
+    uint8_t *profile = nullptr;
+    size_t   profile_len = 0;
+    if (ok && orc_get_profile(&profile, &profile_len) == 0) {
+        ok = write_frame(out_fd, 'P', profile, profile_len);
+        orc_free(profile);
+    }
+
+    uint8_t *stats = nullptr;
+    size_t   stats_len = 0;
+    if (ok && rc == 0 && orc_get_slice_stats(&stats, &stats_len) == 0) {
+        ok = write_frame(out_fd, 'S', stats, stats_len);
+        orc_free(stats);
+    }
+    return ok && write_done(out_fd, rc, message);
+}
+
+// Serves requests until the client closes, a protocol error, or g_stop.
+// Returns the number of jobs completed.
+uint64_t serve_connection(int in_fd, int out_fd, const Options &opts)
+{
+    uint64_t jobs = 0;
+    std::vector<uint8_t> config;
+    std::vector<uint8_t> model;
+    while (!g_stop) {
+        uint8_t header[kRequestHeaderSize];
+        const size_t got = read_full(in_fd, header, sizeof(header));
+        if (got == 0) {
+            break; // clean close between requests
+        }
+        if (got != sizeof(header) || std::memcmp(header, kRequestMagic, sizeof(kRequestMagic)) != 0) {
+            write_done(out_fd, -100, "malformed request header");
+            break;
+        }
+        const uint32_t config_len = load_u32(header + 4);
+        const uint64_t model_len = load_u64(header + 8);
+        if (config_len > kMaxConfigBytes || model_len > opts.max_model) {
+            write_done(out_fd, -101, "request exceeds size limits");
+            break;
+        }
+        config.resize(config_len);
+        model.resize(size_t(model_len));
+        if (read_full(in_fd, config.data(), config.size()) != config.size() ||
+            read_full(in_fd, model.data(), model.size()) != model.size()) {
+            break;
+        }
+        ++jobs;
+        if (!run_job(out_fd, config, model, opts)) {
+            break;
+        }
+        // Don't hold on to the largest model seen for the worker's lifetime.
+        std::vector<uint8_t>().swap(model);
+    }
+    return jobs;
+}
+
+int remove_entry(const char *path, const struct stat *, int, struct FTW *)
+{
+    remove(path);
+    return 0;
+}
+
+// The scratch directory with the session directories and files left in it.
+void remove_scratch_dir(const std::string &dir)
+{
+    if (!dir.empty()) {
+        nftw(dir.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+}
+
+// Private scratch directory for this process's bridge temp files.
+std::string make_scratch_dir()
+{
+    char pattern[] = "/tmp/orca_slicerd.XXXXXX";
+    if (mkdtemp(pattern) == nullptr) {
+        std::fprintf(stderr, "[orca_slicerd] mkdtemp failed: %s\n", std::strerror(errno));
+        return {};
+    }
+    setenv("ORC_SCRATCH_DIR", pattern, 1);
+    return pattern;
+}
+
+[[noreturn]] void worker_main(int listen_fd, const Options &opts)
+{
+    install_stop_handlers();
+    const std::string scratch = make_scratch_dir();
+    uint64_t served = 0;
+    while (!g_stop && (opts.max_jobs == 0 || served < opts.max_jobs)) {
+        const int client = accept(listen_fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::fprintf(stderr, "[orca_slicerd] accept failed: %s\n", std::strerror(errno));
+            break;
+        }
+        served += serve_connection(client, client, opts);
+        close(client);
+    }
+    remove_scratch_dir(scratch);
+    std::_Exit(0);
+}
+
+int open_listen_socket(const std::string &path)
+{
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::fprintf(stderr, "[orca_slicerd] socket path too long: %s\n", path.c_str());
+        return -1;
+    }
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::fprintf(stderr, "[orca_slicerd] socket failed: %s\n", std::strerror(errno));
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str());
+    // Owner-only regardless of umask; connections are refused until listen(),
+    // so nobody else can get in before the chmod.
+    if (bind(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 || chmod(path.c_str(), 0600) != 0 ||
+        listen(fd, 128) != 0) {
+        std::fprintf(stderr, "[orca_slicerd] cannot listen on %s: %s\n", path.c_str(), std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int run_socket_server(const Options &opts)
+{
+    const int listen_fd = open_listen_socket(opts.socket_path);
+    if (listen_fd < 0) {
+        return 1;
+    }
+    install_stop_handlers();
+
+    std::vector<pid_t> workers(size_t(opts.workers), 0);
+    std::vector<time_t> started(workers.size(), 0);
+    auto spawn = [&](size_t slot) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            worker_main(listen_fd, opts);
+        }
+        if (pid < 0) {
+            std::fprintf(stderr, "[orca_slicerd] fork failed: %s\n", std::strerror(errno));
+        }
+        workers[slot] = std::max<pid_t>(pid, 0);
+        started[slot] = std::time(nullptr);
+    };
+    for (size_t slot = 0; slot < workers.size(); ++slot) {
+        spawn(slot);
+    }
+    std::fprintf(stderr, "[orca_slicerd] listening on %s with %d workers\n", opts.socket_path.c_str(), opts.workers);
+
+    while (!g_stop) {
+        int status = 0;
+        const pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == ECHILD) {
+                // Every fork failed; back off and retry.
+                sleep(1);
+                for (size_t slot = 0; slot < workers.size(); ++slot)
+                    if (workers[slot] == 0)
+                        spawn(slot);
+                continue;
+            }
+            break;
+        }
+        const auto it = std::find(workers.begin(), workers.end(), pid);
+        if (it == workers.end() || g_stop) {
+            continue;
+        }
+        const size_t slot = size_t(it - workers.begin());
+        if (WIFSIGNALED(status)) {
+            std::fprintf(stderr, "[orca_slicerd] worker %d killed by signal %d; respawning\n", int(pid), WTERMSIG(status));
+        }
+        // A worker that dies right after starting would otherwise spin.
+        if (std::time(nullptr) - started[slot] < 1) {
+            sleep(1);
+        }
+        spawn(slot);
+    }
+
+    for (pid_t pid : workers) {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+        }
+    }
+    while (waitpid(-1, nullptr, 0) > 0 || errno == EINTR) {
+    }
+    close(listen_fd);
+    unlink(opts.socket_path.c_str());
+    return 0;
+}
+
+// Frames go to the original stdout; anything else the engine prints is sent
+// to stderr so it cannot corrupt the stream.
+int run_stdio_server(const Options &opts)
+{
+    const int out_fd = dup(STDOUT_FILENO);
+    if (out_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        std::fprintf(stderr, "[orca_slicerd] cannot redirect stdout: %s\n", std::strerror(errno));
+        return 1;
+    }
+    install_stop_handlers();
+    const std::string scratch = make_scratch_dir();
+    serve_connection(STDIN_FILENO, out_fd, opts);
+    remove_scratch_dir(scratch);
+    close(out_fd);
+    return 0;
+}
+
+void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+                 "usage: %s (--socket=PATH | --stdio) [--workers=N] [--max-jobs=N]\n"
+                 "          [--max-model-mb=N] [--chunk-kb=N]\n"
+                 "\n"
+                 "  --socket=PATH     listen on a Unix socket with N preforked workers\n"
+                 "  --stdio           serve jobs framed on stdin/stdout in this process\n"
+                 "  --workers=N       worker processes (default: online CPUs)\n"
+                 "  --max-jobs=N      recycle a worker once it has served N jobs, checked\n"
+                 "                    between connections (default: never)\n"
+                 "  --max-model-mb=N  reject larger models (default: 512)\n"
+                 "  --chunk-kb=N      G-code frame size (default: 1024)\n",
+                 argv0);
+}
+
+bool parse_args(int argc, char **argv, Options &opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value_of = [&](const char *prefix) -> const char * {
+            const size_t n = std::strlen(prefix);
+            return arg.compare(0, n, prefix) == 0 ? arg.c_str() + n : nullptr;
+        };
+        if (const char *v = value_of("--socket=")) opts.socket_path = v;
+        else if (arg == "--stdio") opts.stdio = true;
+        else if (const char *v = value_of("--workers=")) opts.workers = std::atoi(v);
+        else if (const char *v = value_of("--max-jobs=")) opts.max_jobs = std::strtoull(v, nullptr, 10);
+        else if (const char *v = value_of("--max-model-mb=")) opts.max_model = std::strtoull(v, nullptr, 10) << 20;
+        else if (const char *v = value_of("--chunk-kb=")) opts.chunk_bytes = std::max<size_t>(1, std::strtoull(v, nullptr, 10)) << 10;
+        else return false;
+    }
+    if (opts.stdio == !opts.socket_path.empty()) {
+        return false;
+    }
+    if (opts.workers <= 0) {
+        opts.workers = std::max(1, int(sysconf(_SC_NPROCESSORS_ONLN)));
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!parse_args(argc, argv, opts)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    setenv("ORC_RESOURCES_DIR", ORC_DEFAULT_RESOURCES_DIR, 0);
+    if (orc_warmup() != 0) {
+        std::fprintf(stderr, "[orca_slicerd] warm-up failed; check ORC_RESOURCES_DIR\n");
+        return 1;
+    }
+
+    return opts.stdio ? run_stdio_server(opts) : run_socket_server(opts);
+}
@@ -0,0 +1,270 @@
+#!/usr/bin/env node
+// End-to-end WASM slicing benchmark. Drives web/public/wasm/slicer.js under
+// node over the corpus in bench/corpus/corpus.json and writes results in the
+// same schema as bench/native/slice_bench.cpp.
+//
+// Every run gets a freshly instantiated module so linear memory size (which
+// only grows) is a per-run peak. Instantiation is excluded from wallMs.
+//
+// --variant=wasm64 drives slicer64.js (ORC_WASM_MEMORY64) instead; compare its
+// results against a wasm32 run with bench/compare.js to price the 64-bit build.
+// A capability variant from wasm/build.sh (simd, eh, mt, simd-eh, ...) drives
+// slicer-<variant>.js the same way.
+//
+// --cache enables the bridge's result cache and slices every case twice:
+// results gain cache.hashMs (keying cost inside the first, missing slice) and
+// cache.hitWallMs (the repeat, answered from the cache), to weigh against
+// wallMs.
+//
+// Usage: node scripts/bench-slicer.js [--corpus=FILE] [--models=DIR]
+//          [--out=FILE] [--case=ID] [--preset=NAME] [--repeat=N]
+//          [--variant=wasm32|wasm64|simd|eh|mt|simd-eh|...] [--cache]
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { performance } = require('perf_hooks');
+
+const repoRoot = path.resolve(__dirname, '..');
+const wasmDir = path.join(repoRoot, 'web/public/wasm');
+
+const args = process.argv.slice(2);
+const argValue = (name, fallback) => {
+  const hit = args.find((value) => value.startsWith(`--${name}=`));
+  return hit ? hit.slice(name.length + 3) : fallback;
+};
+
+const variant = argValue('variant', 'wasm32');
+if (variant !== 'wasm32' && variant !== 'wasm64' && !/^(simd|eh|mt)(-(simd|eh|mt))*$/.test(variant)) {
+  console.error(`[bench-slicer] unknown --variant=${variant} (wasm32, wasm64 or capabilities such as simd-eh)`);
+  process.exit(2);
+}
+const memory64 = variant === 'wasm64';
+const artifact = { wasm32: 'slicer', wasm64: 'slicer64' }[variant] ?? `slicer-${variant}`;
+
+const opts = {
+  corpus: path.resolve(argValue('corpus', path.join(repoRoot, 'bench/corpus/corpus.json'))),
+  models: path.resolve(argValue('models', path.join(repoRoot, 'build-bench/corpus'))),
+  out: path.resolve(argValue('out', path.join(repoRoot, `build-bench/results-${{ wasm32: 'wasm', wasm64: 'wasm64' }[variant] ?? `wasm-${variant}`}.json`))),
+  onlyCase: argValue('case', null),
+  onlyPreset: argValue('preset', null),
+  repeat: Math.max(1, Number.parseInt(argValue('repeat', '1'), 10) || 1),
+  cache: args.includes('--cache'),
+};
+
+async function instantiate() {
+  const OrcaModuleFactory = require(path.join(wasmDir, `${artifact}.js`));
+  const module = await OrcaModuleFactory({
+    wasmBinary: fs.readFileSync(path.join(wasmDir, `${artifact}.wasm`)),
+    locateFile: (filename) => path.join(wasmDir, filename),
+    print: () => {},
+    printErr: (...line) => {
+      if (process.env.ORC_BENCH_VERBOSE === '1') {
+        console.error('[emscripten-err]', ...line);
+      }
+    },
+  });
+  if (module && typeof module.ready?.then === 'function') {
+    await module.ready;
+  }
+  return module;
+}
+
+// Pointers and size_t are BigInt on wasm64 and 8 bytes wide in memory.
+const wordBytes = memory64 ? 8 : 4;
+const toWasm = (value) => (memory64 ? BigInt(value) : value);
+const readWord = (module, addr) => (memory64 ? Number(module.HEAPU64[addr / 8]) : module.HEAPU32[addr >> 2]);
+const writeWord = (module, addr, value) => {
+  if (memory64) {
+    module.HEAPU64[addr / 8] = BigInt(value);
+  } else {
+    module.HEAPU32[addr >> 2] = value;
+  }
+};
+const malloc = (module, size) => Number(module._malloc(toWasm(size)));
+const free = (module, ptr) => module._free(toWasm(ptr));
+
+function copyIn(module, bytes) {
+  const ptr = malloc(module, bytes.length);
+  if (!ptr) {
+    throw new Error(`malloc(${bytes.length}) failed`);
+  }
+  module.HEAPU8.set(bytes, ptr);
+  return ptr;
+}
+
+// Calls one of the bridge's `int fn(uint8_t** out, size_t* len)` exports and
+// returns the decoded JSON, or null.
+function readBridgeJson(module, fnName) {
+  if (typeof module[fnName] !== 'function') {
+    return null;
+  }
+  const outPtrPtr = malloc(module, 2 * wordBytes);
+  const outLenPtr = outPtrPtr + wordBytes;
+  try {
+    writeWord(module, outPtrPtr, 0);
+    writeWord(module, outLenPtr, 0);
+    if (module[fnName](toWasm(outPtrPtr), toWasm(outLenPtr)) !== 0) {
+      return null;
+    }
+    const ptr = readWord(module, outPtrPtr);
+    const len = readWord(module, outLenPtr);
+    const text = Buffer.from(module.HEAPU8.subarray(ptr, ptr + len)).toString('utf-8');
+    module._orc_free(toWasm(ptr));
+    return JSON.parse(text);
+  } finally {
+    free(module, outPtrPtr);
+  }
+}
+
+// JS exception builds throw the thrown object's address; native exception
+// (eh) builds throw a WebAssembly.Exception, which only getExceptionMessage
+// can decode.
+function describeException(module, err) {
+  const thrownByWasm = typeof err === 'number' || typeof err === 'bigint'
+    || (typeof WebAssembly.Exception === 'function' && err instanceof WebAssembly.Exception);
+  if (thrownByWasm && typeof module.getExceptionMessage === 'function') {
+    const [type, message] = module.getExceptionMessage(err);
+    return message ? `${type}: ${message}` : type;
+  }
+  if ((typeof err === 'number' || typeof err === 'bigint') && module.UTF8ToString) {
+    return module.UTF8ToString(Number(module._orc_decode_exception(toWasm(Number(err)))));
+  }
+  return String(err?.message ?? err);
+}
+
+function summarizeProfile(profile, result) {
+  if (!profile || typeof profile !== 'object') {
+    return;
+  }
+  const phases = {};
+  let peakHeap = 0;
+  for (const [group, entries] of Object.entries(profile.phases ?? {})) {
+    for (const phase of entries) {
+      phases[`${group}/${phase.name}`] = phase.durationMs ?? 0;
+      peakHeap = Math.max(peakHeap, phase.peakHeapBytes ?? 0);
+    }
+  }
+  result.phases = phases;
+  result.peakHeapBytes = peakHeap;
+  result.counters = profile.counters ?? {};
+}
+
+async function runOnce(caseId, presetName, modelBytes, preset) {
+  const result = { case: caseId, preset: presetName, ok: false };
+  const module = await instantiate();
+
+  const payload = Buffer.from(JSON.stringify({ config: preset }), 'utf-8');
+  const payloadPtr = copyIn(module, payload);
+  const modelPtr = copyIn(module, modelBytes);
+  const outPtrPtr = malloc(module, 2 * wordBytes);
+  const outLenPtr = outPtrPtr + wordBytes;
+  writeWord(module, outPtrPtr, 0);
+  writeWord(module, outLenPtr, 0);
+
+  if (opts.cache) {
+    // Memory only, large enough for any corpus output.
+    module._orc_cache_configure(toWasm(0x7fffffff), 0, toWasm(0));
+  }
+
+  try {
+    const started = performance.now();
+    module._orc_init(toWasm(payloadPtr), toWasm(payload.length));
+    const rc = module._orc_slice(toWasm(modelPtr), toWasm(modelBytes.length), toWasm(outPtrPtr), toWasm(outLenPtr));
+    result.wallMs = performance.now() - started;
+
+    const gcodePtr = readWord(module, outPtrPtr);
+    const gcodeLen = readWord(module, outLenPtr);
+    if (gcodePtr) {
+      module._orc_free(toWasm(gcodePtr));
+    }
+    result.rc = rc;
+    result.ok = rc === 0;
+    result.outputBytes = rc === 0 ? gcodeLen : 0;
+  } catch (err) {
+    result.error = describeException(module, err);
+  }
+
+  // WebAssembly memory never shrinks, so its size after the run is the peak.
+  result.peakRssBytes = module.HEAPU8.length;
+  const profile = readBridgeJson(module, '_orc_get_profile');
+  summarizeProfile(profile, result);
+
+  if (opts.cache && result.ok) {
+    result.cache = { hashMs: profile?.cache?.hashMs ?? null };
+    try {
+      const started = performance.now();
+      const rc = module._orc_slice(toWasm(modelPtr), toWasm(modelBytes.length), toWasm(outPtrPtr), toWasm(outLenPtr));
+      result.cache.hitWallMs = performance.now() - started;
+      const gcodePtr = readWord(module, outPtrPtr);
+      if (gcodePtr) {
+        module._orc_free(toWasm(gcodePtr));
+      }
+      result.cache.hit = rc === 0 && readBridgeJson(module, '_orc_get_profile')?.cache?.hit === true;
+    } catch (err) {
+      result.cache.error = describeException(module, err);
+    }
+  }
+
+  free(module, payloadPtr);
+  free(module, modelPtr);
+  free(module, outPtrPtr);
+  return result;
+}
+
+async function main() {
+  const manifest = JSON.parse(fs.readFileSync(opts.corpus, 'utf-8'));
+  const results = [];
+  let failures = 0;
+
+  for (const entry of manifest.cases) {
+    if (opts.onlyCase && opts.onlyCase !== entry.id) {
+      continue;
+    }
+    const modelPath = path.join(opts.models, entry.file ?? `${entry.id}.stl`);
+    if (!fs.existsSync(modelPath)) {
+      console.error(`[bench-slicer] ${entry.id}: missing ${modelPath} (run bench/corpus/generate.js)`);
+      failures += 1;
+      continue;
+    }
+    const modelBytes = fs.readFileSync(modelPath);
+
+    for (const presetName of entry.presets ?? manifest.defaultPresets ?? []) {
+      if (opts.onlyPreset && opts.onlyPreset !== presetName) {
+        continue;
+      }
+      for (let iteration = 0; iteration < opts.repeat; iteration += 1) {
+        const result = await runOnce(entry.id, presetName, modelBytes, manifest.presets[presetName]);
+        result.iteration = iteration;
+        console.error(
+          `[bench-slicer] ${entry.id.padEnd(20)} ${presetName.padEnd(12)} rc=${String(result.rc ?? '-').padEnd(3)} `
+          + `${(result.wallMs ?? 0).toFixed(1).padStart(9)} ms  mem=${(result.peakRssBytes / 1048576).toFixed(1).padStart(6)} MiB  `
+          + `out=${result.outputBytes ?? 0}`
+          + (result.cache ? `  hash=${(result.cache.hashMs ?? 0).toFixed(2)} ms hit=${(result.cache.hitWallMs ?? 0).toFixed(2)} ms` : ''),
+        );
+        if (!result.ok) {
+          failures += 1;
+        }
+        results.push(result);
+      }
+    }
+  }
+
+  const document = {
+    schema: 1,
+    runner: 'wasm-node',
+    variant,
+    timestamp: new Date().toISOString().replace(/\.\d{3}Z$/, 'Z'),
+    host: { os: os.type(), release: os.release(), arch: os.arch(), cpus: os.cpus().length, node: process.version },
+    results,
+  };
+  fs.mkdirSync(path.dirname(opts.out), { recursive: true });
+  fs.writeFileSync(opts.out, `${JSON.stringify(document, null, 2)}\n`);
+  console.error(`[bench-slicer] wrote ${path.relative(repoRoot, opts.out)} (${failures} failing runs)`);
+  process.exitCode = failures === 0 ? 0 : 1;
+}
+
+main().catch((err) => {
+  console.error('[bench-slicer] failed:', err);
+  process.exit(1);
+});
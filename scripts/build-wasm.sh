@@ -43,14 +43,33 @@ if [[ -f ${PATCH_FILE} ]]; then
   popd >/dev/null
 fi
 
+# Optional: lets bridge.sliceKernel route slice_mesh_ex() through the bridge's
+# kernel. Builds without it slice as upstream does.
+KERNEL_PATCH_FILE="patches/orca-wasm-slice-kernel.patch"
+if [[ -f ${KERNEL_PATCH_FILE} ]]; then
+  pushd orca >/dev/null
+  if git apply --reverse --check "../${KERNEL_PATCH_FILE}" >/dev/null 2>&1; then
+    echo "INFO: Orca slice kernel patch already applied"
+  elif git apply --check "../${KERNEL_PATCH_FILE}" >/dev/null 2>&1; then
+    git apply "../${KERNEL_PATCH_FILE}"
+    echo "INFO: Applied Orca slice kernel patch"
+  else
+    echo "WARN: Orca slice kernel patch did not apply cleanly; bridge.sliceKernel will be ignored" >&2
+  fi
+  popd >/dev/null
+fi
+
 # 4) Configure and build with Emscripten
 emcmake cmake -S wasm -B build-wasm -DCMAKE_BUILD_TYPE=Release
 cmake --build build-wasm -j
 
 # 5) Validate artifacts and stage for the web app
 mkdir -p web/public/wasm
-if [[ -f build-wasm/slicer.js && -f build-wasm/slicer.wasm && -f build-wasm/slicer.data ]]; then
-  cp build-wasm/slicer.js build-wasm/slicer.wasm build-wasm/slicer.data web/public/wasm/
+# Resources come as resources.orcpack, or slicer.data with ORC_WASM_RESOURCE_PACK=OFF
+RESOURCES=build-wasm/resources.orcpack
+[[ -f "$RESOURCES" ]] || RESOURCES=build-wasm/slicer.data
+if [[ -f build-wasm/slicer.js && -f build-wasm/slicer.wasm && -f "$RESOURCES" ]]; then
+  cp build-wasm/slicer.js build-wasm/slicer.wasm "$RESOURCES" web/public/wasm/
   echo "✅ WASM build complete"
 else
   echo "❌ WASM build failed: required build artifacts missing" >&2
@@ -0,0 +1,98 @@
+#!/usr/bin/env node
+// Download size and compile time of a split slicer module against the
+// unsplit one (ORC_WASM_SPLIT, scripts/split-module.js).
+//
+// For <name>.wasm.orig (everything), <name>.wasm (core) and
+// <name>.deferred.wasm it reports raw, gzip and brotli sizes and the median
+// WebAssembly.compile time under node. The core's numbers are what a worker
+// pays before its first slice; the deferred module is only fetched when a
+// slice reaches a function outside the core.
+//
+// Usage: node scripts/measure-split.js [--dir=build-wasm] [--name=slicer]
+//          [--runs=N] [--out=FILE]
+
+const fs = require('fs');
+const path = require('path');
+const zlib = require('zlib');
+const { performance } = require('perf_hooks');
+
+const repoRoot = path.resolve(__dirname, '..');
+
+const args = process.argv.slice(2);
+const argValue = (name, fallback) => {
+  const hit = args.find((value) => value.startsWith(`--${name}=`));
+  return hit ? hit.slice(name.length + 3) : fallback;
+};
+
+const dir = path.resolve(argValue('dir', path.join(repoRoot, 'build-wasm')));
+const name = argValue('name', 'slicer');
+const runs = Math.max(1, Number.parseInt(argValue('runs', '5'), 10) || 1);
+const out = argValue('out', null);
+
+async function measure(label, file) {
+  const bytes = fs.readFileSync(file);
+  const times = [];
+  for (let i = 0; i < runs; i += 1) {
+    const start = performance.now();
+    await WebAssembly.compile(bytes);
+    times.push(performance.now() - start);
+  }
+  times.sort((a, b) => a - b);
+  return {
+    module: label,
+    file: path.basename(file),
+    bytes: bytes.length,
+    gzipBytes: zlib.gzipSync(bytes, { level: 9 }).length,
+    brotliBytes: zlib.brotliCompressSync(bytes, {
+      params: { [zlib.constants.BROTLI_PARAM_QUALITY]: 11, [zlib.constants.BROTLI_PARAM_SIZE_HINT]: bytes.length },
+    }).length,
+    compileMs: Number(times[Math.floor(times.length / 2)].toFixed(1)),
+  };
+}
+
+async function main() {
+  const files = [
+    ['full', path.join(dir, `${name}.wasm.orig`)],
+    ['core', path.join(dir, `${name}.wasm`)],
+    ['deferred', path.join(dir, `${name}.deferred.wasm`)],
+  ];
+  for (const [, file] of files) {
+    if (!fs.existsSync(file)) {
+      throw new Error(`${file} not found; build with -DORC_WASM_SPLIT=ON and run scripts/split-module.js`);
+    }
+  }
+
+  const rows = [];
+  for (const [label, file] of files) {
+    rows.push(await measure(label, file));
+  }
+  const kib = (value) => `${(value / 1024).toFixed(0)} KiB`.padStart(11);
+  for (const row of rows) {
+    console.error(
+      `[measure-split] ${row.module.padEnd(8)} raw ${kib(row.bytes)}  gzip ${kib(row.gzipBytes)}  `
+      + `br ${kib(row.brotliBytes)}  compile ${row.compileMs.toFixed(1).padStart(8)} ms`,
+    );
+  }
+  const [full, core] = rows;
+  const document = {
+    schema: 1,
+    runs,
+    node: process.version,
+    modules: rows,
+    coreShare: {
+      brotliBytes: Number((core.brotliBytes / full.brotliBytes).toFixed(3)),
+      compileMs: Number((core.compileMs / full.compileMs).toFixed(3)),
+    },
+  };
+  if (out) {
+    fs.mkdirSync(path.dirname(path.resolve(out)), { recursive: true });
+    fs.writeFileSync(out, `${JSON.stringify(document, null, 2)}\n`);
+  } else {
+    console.log(JSON.stringify(document, null, 2));
+  }
+}
+
+main().catch((err) => {
+  console.error('[measure-split] failed:', err.message ?? err);
+  process.exit(1);
+});
@@ -0,0 +1,156 @@
+#!/usr/bin/env node
+// Packs orca/resources into one indexed archive (resources.orcpack) that the
+// WASM module fetches entry by entry (wasm/orc_pack_fs.js) and native builds
+// memory-map (bridge/orc_pack.h), instead of preloading the whole tree.
+//
+// Layout, little-endian:
+//   header   48 bytes  "ORCPACK1", version, entry count, index offset/bytes,
+//                      data offset, core bytes
+//   index    32 bytes per entry, sorted by path: data offset, size, path
+//                      offset/length into the string table, flags
+//   strings  UTF-8 paths relative to the resources root
+//   data     page-aligned; every entry 16-byte aligned. Core entries (the
+//            ones a slice touches, see --core) come first, so a worker can
+//            fetch all of them with one range request.
+//
+// Usage: node scripts/pack-resources.js [--root=DIR] [--out=FILE]
+//          [--core=FILE] [--exclude=PREFIX,...]
+
+const fs = require('fs');
+const path = require('path');
+
+const repoRoot = path.resolve(__dirname, '..');
+
+const args = process.argv.slice(2);
+const argValue = (name, fallback) => {
+  const hit = args.find((value) => value.startsWith(`--${name}=`));
+  return hit ? hit.slice(name.length + 3) : fallback;
+};
+
+const opts = {
+  root: path.resolve(argValue('root', path.join(repoRoot, 'orca/resources'))),
+  out: path.resolve(argValue('out', path.join(repoRoot, 'build-wasm/resources.orcpack'))),
+  core: path.resolve(argValue('core', path.join(repoRoot, 'wasm/resources-core.txt'))),
+  exclude: argValue('exclude', '').split(',').filter(Boolean),
+};
+
+const MAGIC = 'ORCPACK1';
+const VERSION = 1;
+const HEADER_BYTES = 48;
+const INDEX_ENTRY_BYTES = 32;
+const DATA_ALIGN = 4096;
+const ENTRY_ALIGN = 16;
+const FLAG_CORE = 1;
+
+const alignUp = (value, alignment) => Math.ceil(value / alignment) * alignment;
+
+function walk(dir, prefix, out) {
+  for (const dirent of fs.readdirSync(dir, { withFileTypes: true })) {
+    const relative = prefix ? `${prefix}/${dirent.name}` : dirent.name;
+    const absolute = path.join(dir, dirent.name);
+    if (dirent.isDirectory()) {
+      walk(absolute, relative, out);
+    } else if (dirent.isFile()) {
+      out.push({ path: relative, absolute });
+    }
+  }
+  return out;
+}
+
+// One entry per line: a path, or a directory prefix ending in '/'. '#' starts
+// a comment. A missing file means no core entries.
+function readCoreList(file) {
+  if (!fs.existsSync(file)) {
+    return [];
+  }
+  return fs.readFileSync(file, 'utf-8')
+    .split('\n')
+    .map((line) => line.replace(/#.*/, '').trim())
+    .filter(Boolean);
+}
+
+function main() {
+  if (!fs.existsSync(opts.root)) {
+    throw new Error(`resources root ${opts.root} not found`);
+  }
+  const core = readCoreList(opts.core);
+  const isCore = (entry) => core.some((item) => (item.endsWith('/') ? entry.startsWith(item) : entry === item));
+
+  const entries = walk(opts.root, '', [])
+    .filter((entry) => !opts.exclude.some((prefix) => entry.path.startsWith(prefix)))
+    .map((entry) => ({ ...entry, size: fs.statSync(entry.absolute).size, core: isCore(entry.path) }));
+  // Binary search in the readers compares raw UTF-8 bytes.
+  entries.sort((a, b) => Buffer.compare(Buffer.from(a.path), Buffer.from(b.path)));
+
+  const strings = [];
+  let stringBytes = 0;
+  for (const entry of entries) {
+    const encoded = Buffer.from(entry.path, 'utf-8');
+    entry.pathOffset = stringBytes;
+    entry.pathLength = encoded.length;
+    strings.push(encoded);
+    stringBytes += encoded.length;
+  }
+
+  const indexBytes = entries.length * INDEX_ENTRY_BYTES + stringBytes;
+  const dataOffset = alignUp(HEADER_BYTES + indexBytes, DATA_ALIGN);
+
+  // Core first, then the rest, each in path order.
+  let cursor = dataOffset;
+  let coreBytes = 0;
+  for (const pass of [true, false]) {
+    for (const entry of entries.filter((item) => item.core === pass)) {
+      cursor = alignUp(cursor, ENTRY_ALIGN);
+      entry.offset = cursor;
+      cursor += entry.size;
+    }
+    if (pass) {
+      coreBytes = cursor - dataOffset;
+    }
+  }
+
+  const head = Buffer.alloc(dataOffset);
+  head.write(MAGIC, 0, 'latin1');
+  head.writeUInt32LE(VERSION, 8);
+  head.writeUInt32LE(entries.length, 12);
+  head.writeBigUInt64LE(BigInt(HEADER_BYTES), 16);
+  head.writeBigUInt64LE(BigInt(indexBytes), 24);
+  head.writeBigUInt64LE(BigInt(dataOffset), 32);
+  head.writeBigUInt64LE(BigInt(coreBytes), 40);
+  entries.forEach((entry, i) => {
+    const at = HEADER_BYTES + i * INDEX_ENTRY_BYTES;
+    head.writeBigUInt64LE(BigInt(entry.offset), at);
+    head.writeBigUInt64LE(BigInt(entry.size), at + 8);
+    head.writeUInt32LE(entry.pathOffset, at + 16);
+    head.writeUInt32LE(entry.pathLength, at + 20);
+    head.writeUInt32LE(entry.core ? FLAG_CORE : 0, at + 24);
+  });
+  Buffer.concat(strings).copy(head, HEADER_BYTES + entries.length * INDEX_ENTRY_BYTES);
+
+  fs.mkdirSync(path.dirname(opts.out), { recursive: true });
+  const fd = fs.openSync(opts.out, 'w');
+  try {
+    fs.writeSync(fd, head, 0, head.length, 0);
+    for (const entry of entries) {
+      if (entry.size > 0) {
+        fs.writeSync(fd, fs.readFileSync(entry.absolute), 0, entry.size, entry.offset);
+      }
+    }
+    fs.ftruncateSync(fd, cursor);
+  } finally {
+    fs.closeSync(fd);
+  }
+
+  const coreCount = entries.filter((entry) => entry.core).length;
+  console.error(
+    `[pack-resources] ${entries.length} entries, ${(cursor / 1048576).toFixed(1)} MiB `
+    + `(core: ${coreCount} entries, ${(coreBytes / 1024).toFixed(1)} KiB) -> ${path.relative(repoRoot, opts.out)}`,
+  );
+}
+
+try {
+  main();
+} catch (err) {
+  console.error('[pack-resources] failed:', err.message ?? err);
+  process.exit(1);
+}
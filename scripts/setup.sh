@@ -112,6 +112,21 @@ else
     warning "WASM patch file not found: ${PATCH_FILE}"
 fi
 
+# Optional hook for the bridge's slicing kernel (bridge.sliceKernel)
+KERNEL_PATCH_FILE="patches/orca-wasm-slice-kernel.patch"
+if [[ -f ${KERNEL_PATCH_FILE} ]]; then
+    pushd orca >/dev/null
+    if git apply --reverse --check "../${KERNEL_PATCH_FILE}" >/dev/null 2>&1; then
+        info "Slice kernel patch already applied"
+    elif git apply --check "../${KERNEL_PATCH_FILE}" >/dev/null 2>&1; then
+        git apply "../${KERNEL_PATCH_FILE}"
+        success "Applied slice kernel patch"
+    else
+        warning "Slice kernel patch did not apply cleanly - bridge.sliceKernel will be ignored"
+    fi
+    popd >/dev/null
+fi
+
 success "Setup complete! 🎉"
 info ""
 info "Next steps:"
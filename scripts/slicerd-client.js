@@ -0,0 +1,110 @@
+#!/usr/bin/env node
+// Minimal client for native/orca_slicerd. Sends one STL (plus optional
+// override JSON) over the daemon's Unix socket and writes the G-code it
+// streams back.
+//
+// Usage: node scripts/slicerd-client.js --socket=/run/orca.sock model.stl
+//          [--config=overrides.json] [--out=model.gcode] [--jobs=N]
+
+const fs = require('fs');
+const net = require('net');
+const path = require('path');
+
+const args = process.argv.slice(2);
+const argValue = (name, fallback) => {
+  const hit = args.find((value) => value.startsWith(`--${name}=`));
+  return hit ? hit.slice(name.length + 3) : fallback;
+};
+const modelPath = args.find((value) => !value.startsWith('--'));
+const socketPath = argValue('socket', null);
+if (!modelPath || !socketPath) {
+  console.error('usage: node scripts/slicerd-client.js --socket=PATH model.stl [--config=FILE] [--out=FILE] [--jobs=N]');
+  process.exit(2);
+}
+const configPath = argValue('config', null);
+const outPath = argValue('out', null);
+const jobs = Math.max(1, Number.parseInt(argValue('jobs', '1'), 10) || 1);
+
+function encodeRequest(config, model) {
+  const header = Buffer.alloc(16);
+  header.write('ORC1', 0, 'ascii');
+  header.writeUInt32LE(config.length, 4);
+  header.writeBigUInt64LE(BigInt(model.length), 8);
+  return Buffer.concat([header, config, model]);
+}
+
+// Splits the response stream into frames and resolves one job per 'D' frame.
+function createFrameReader(onJob) {
+  let pending = Buffer.alloc(0);
+  let job = { gcode: [], profile: null, stats: null, started: process.hrtime.bigint() };
+  return (chunk) => {
+    pending = pending.length ? Buffer.concat([pending, chunk]) : chunk;
+    while (pending.length >= 8) {
+      const type = String.fromCharCode(pending[0]);
+      const length = pending.readUInt32LE(4);
+      if (pending.length < 8 + length) {
+        break;
+      }
+      const payload = pending.subarray(8, 8 + length);
+      pending = pending.subarray(8 + length);
+      if (type === 'G') {
+        job.gcode.push(Buffer.from(payload));
+      } else if (type === 'P') {
+        job.profile = JSON.parse(payload.toString('utf-8'));
+      } else if (type === 'S') {
+        job.stats = JSON.parse(payload.toString('utf-8'));
+      } else if (type === 'D') {
+        job.rc = payload.readInt32LE(0);
+        job.message = payload.subarray(4).toString('utf-8');
+        job.wallMs = Number(process.hrtime.bigint() - job.started) / 1e6;
+        onJob(job);
+        job = { gcode: [], profile: null, stats: null, started: process.hrtime.bigint() };
+      }
+    }
+  };
+}
+
+const config = configPath ? fs.readFileSync(configPath) : Buffer.alloc(0);
+const model = fs.readFileSync(modelPath);
+const request = encodeRequest(config, model);
+
+const socket = net.createConnection(socketPath);
+let completed = 0;
+let failed = 0;
+socket.on('data', createFrameReader((job) => {
+  completed += 1;
+  const gcode = Buffer.concat(job.gcode);
+  const phases = job.profile?.phases?.bridge ?? [];
+  const summary = phases.map((phase) => `${phase.name}=${phase.durationMs.toFixed(0)}ms`).join(' ');
+  const estimate = job.stats
+    ? ` layers=${job.stats.layers} print=${job.stats.timeS.toFixed(0)}s filament=${job.stats.filament.lengthMm.toFixed(0)}mm`
+    : '';
+  console.log(`[slicerd-client] job ${completed}: rc=${job.rc} ${job.message || 'ok'} `
+    + `gcode=${gcode.length}B wall=${job.wallMs.toFixed(1)}ms ${summary}${estimate}`);
+  if (job.rc !== 0) {
+    failed += 1;
+  } else if (outPath && completed === 1) {
+    fs.mkdirSync(path.dirname(path.resolve(outPath)), { recursive: true });
+    fs.writeFileSync(outPath, gcode);
+  }
+  if (completed === jobs) {
+    socket.end();
+  }
+}));
+socket.on('error', (err) => {
+  console.error('[slicerd-client]', err.message);
+  process.exit(1);
+});
+socket.on('close', () => {
+  if (completed !== jobs) {
+    console.error(`[slicerd-client] connection closed after ${completed}/${jobs} jobs`);
+    process.exitCode = 1;
+  } else {
+    process.exitCode = failed === 0 ? 0 : 1;
+  }
+});
+socket.on('connect', () => {
+  for (let i = 0; i < jobs; i += 1) {
+    socket.write(request);
+  }
+});
@@ -0,0 +1,142 @@
+#!/usr/bin/env node
+// Build-time pre-initialization of the slicer module (ORC_WASM_SNAPSHOT).
+//
+// Runs the static constructors and orc_snapshot_init inside Binaryen's
+// wasm-ctor-eval interpreter and writes the resulting linear memory back into
+// the .wasm as data segments, the way Wizer does for WASI modules. Both
+// exports are kept with empty bodies, so the glue's call to the constructors
+// at start-up becomes a no-op. The unsnapshotted module is kept next to it as
+// <name>.fresh.wasm for scripts/verify-snapshot.js.
+//
+// At -O2 and above emcc minifies export names; they are resolved through the
+// JS glue, which maps every C symbol to its wasm export.
+//
+// Usage: node scripts/snapshot-module.js --module=build-wasm/slicer.js
+//          [--ctor-eval=PATH]
+
+const fs = require('fs');
+const path = require('path');
+const { spawnSync } = require('child_process');
+
+const args = process.argv.slice(2);
+const argValue = (name, fallback) => {
+  const hit = args.find((value) => value.startsWith(`--${name}=`));
+  return hit ? hit.slice(name.length + 3) : fallback;
+};
+
+const modulePath = argValue('module', null);
+const ctorEval = argValue('ctor-eval', 'wasm-ctor-eval');
+
+// Evaluated in this order; the snapshot init needs the constructed globals.
+const ENTRY_POINTS = ['__wasm_call_ctors', 'orc_snapshot_init'];
+
+function readLeb(bytes, at) {
+  let value = 0;
+  let shift = 0;
+  for (;;) {
+    const byte = bytes[at.offset++];
+    value += (byte & 0x7f) * 2 ** shift;
+    if ((byte & 0x80) === 0) {
+      return value;
+    }
+    shift += 7;
+  }
+}
+
+// Names in the module's export section.
+function wasmExports(bytes) {
+  const names = new Set();
+  const at = { offset: 8 };
+  while (at.offset < bytes.length) {
+    const id = bytes[at.offset++];
+    const size = readLeb(bytes, at);
+    const end = at.offset + size;
+    if (id === 7) {
+      const count = readLeb(bytes, at);
+      for (let i = 0; i < count; i += 1) {
+        const length = readLeb(bytes, at);
+        names.add(Buffer.from(bytes.subarray(at.offset, at.offset + length)).toString('utf-8'));
+        at.offset += length;
+        at.offset += 1; // kind
+        readLeb(bytes, at); // index
+      }
+      break;
+    }
+    at.offset = end;
+  }
+  return names;
+}
+
+// C symbol -> wasm export name, from assignments such as
+//   _orc_snapshot_init = Module['_orc_snapshot_init'] = wasmExports['Ab']
+function resolveExport(glue, exportsInWasm, symbol) {
+  if (exportsInWasm.has(symbol)) {
+    return symbol;
+  }
+  const jsName = `_${symbol}`;
+  const pattern = new RegExp(
+    `\\b${jsName.replace(/\$/g, '\\$')}\\s*=\\s*(?:Module\\[['"]${jsName}['"]\\]\\s*=\\s*)?`
+    + `(?:createExportWrapper\\()?(?:wasmExports|Module\\[['"]asm['"]\\])\\[['"]([^'"]+)['"]\\]`,
+  );
+  const match = glue.match(pattern);
+  if (match && exportsInWasm.has(match[1])) {
+    return match[1];
+  }
+  throw new Error(`cannot find the wasm export for ${symbol}; is it in -sEXPORTED_FUNCTIONS?`);
+}
+
+function main() {
+  if (!modulePath) {
+    throw new Error('--module=PATH/slicer.js is required');
+  }
+  const glue = fs.readFileSync(modulePath, 'utf-8');
+  const base = modulePath.replace(/\.js$/, '');
+  const wasmPath = `${base}.wasm`;
+  const freshPath = `${base}.fresh.wasm`;
+  const tempPath = `${base}.snapshot.tmp.wasm`;
+
+  const bytes = fs.readFileSync(wasmPath);
+  const exportsInWasm = wasmExports(bytes);
+  const names = ENTRY_POINTS.map((symbol) => resolveExport(glue, exportsInWasm, symbol));
+  fs.copyFileSync(wasmPath, freshPath);
+
+  const run = spawnSync(ctorEval, [
+    freshPath,
+    '-o', tempPath,
+    '-all',
+    `--ctors=${names.join(',')}`,
+    `--kept-exports=${names.join(',')}`,
+    '--ignore-external-input',
+  ], { encoding: 'utf-8' });
+  if (run.error) {
+    throw new Error(`cannot run ${ctorEval}: ${run.error.message}`);
+  }
+  const log = `${run.stdout ?? ''}${run.stderr ?? ''}`;
+  if (run.status !== 0) {
+    throw new Error(`${ctorEval} exited with ${run.status}\n${log}`);
+  }
+
+  // wasm-ctor-eval stops at the first import call (clock, file, exception
+  // helper) and leaves the rest to run at start-up; that is a broken snapshot
+  // as far as this build is concerned.
+  const missed = ENTRY_POINTS.filter((symbol, i) => !log.includes(`success on ${names[i]}`));
+  if (missed.length > 0) {
+    fs.rmSync(tempPath, { force: true });
+    throw new Error(`could not evaluate ${missed.join(', ')} at build time:\n${log}`);
+  }
+
+  fs.renameSync(tempPath, wasmPath);
+  const before = fs.statSync(freshPath).size;
+  const after = fs.statSync(wasmPath).size;
+  console.error(
+    `[snapshot-module] ${path.basename(wasmPath)}: evaluated ${ENTRY_POINTS.join(', ')} `
+    + `(${(before / 1048576).toFixed(1)} MiB -> ${(after / 1048576).toFixed(1)} MiB)`,
+  );
+}
+
+try {
+  main();
+} catch (err) {
+  console.error('[snapshot-module] failed:', err.message ?? err);
+  process.exit(1);
+}
@@ -0,0 +1,201 @@
+#!/usr/bin/env node
+// Profile-guided split of the slicer module (ORC_WASM_SPLIT).
+//
+// With -sSPLIT_MODULE emcc leaves two modules in the build directory: the
+// instrumented <name>.wasm, which records the first call of every function,
+// and the untouched <name>.wasm.orig. This script
+//   1. runs a core workload (corpus models with classic walls and the common
+//      infill presets) through the instrumented module under node and reads
+//      the profile back through its __write_profile export;
+//   2. runs wasm-split on <name>.wasm.orig with that profile. Functions the
+//      workload reached stay in <name>.wasm (the core). Everything else goes
+//      to <name>.deferred.wasm, which the glue fetches and instantiates the
+//      first time one of those functions is called (tree supports, Arachne,
+//      rarer fill patterns, multi-material segmentation, SLA, text shapes...).
+//
+// The instrumented module is kept as <name>.instrumented.wasm so the split can
+// be redone with another workload without relinking.
+//
+// Usage: node scripts/split-module.js --module=build-wasm/slicer.js
+//          [--wasm-split=PATH] [--corpus=FILE] [--models=DIR]
+//          [--presets=draft,standard,fine] [--config=JSON]
+
+const fs = require('fs');
+const path = require('path');
+
+const repoRoot = path.resolve(__dirname, '..');
+
+const args = process.argv.slice(2);
+const argValue = (name, fallback) => {
+  const hit = args.find((value) => value.startsWith(`--${name}=`));
+  return hit ? hit.slice(name.length + 3) : fallback;
+};
+
+const opts = {
+  module: argValue('module', null),
+  wasmSplit: argValue('wasm-split', 'wasm-split'),
+  corpus: path.resolve(argValue('corpus', path.join(repoRoot, 'bench/corpus/corpus.json'))),
+  models: path.resolve(argValue('models', path.join(repoRoot, 'build-bench/corpus'))),
+  presets: argValue('presets', 'draft,standard,fine').split(',').filter(Boolean),
+  // Overrides applied on top of every preset; the core is the classic wall
+  // generator, so Arachne lands in the deferred module.
+  config: JSON.parse(argValue('config', '{"wall_generator":"classic"}')),
+};
+
+const PROFILE_EXPORT = '__write_profile';
+const PROFILE_CAPACITY = 16 * 1024 * 1024;
+
+// 20 mm binary STL cube, used when the corpus has not been generated.
+function cubeStl() {
+  const s = 20;
+  const v = [[0, 0, 0], [s, 0, 0], [s, s, 0], [0, s, 0], [0, 0, s], [s, 0, s], [s, s, s], [0, s, s]];
+  const faces = [[0, 2, 1], [0, 3, 2], [4, 5, 6], [4, 6, 7], [0, 1, 5], [0, 5, 4],
+    [1, 2, 6], [1, 6, 5], [2, 3, 7], [2, 7, 6], [3, 0, 4], [3, 4, 7]];
+  const buffer = Buffer.alloc(84 + faces.length * 50);
+  buffer.writeUInt32LE(faces.length, 80);
+  faces.forEach((face, i) => {
+    const at = 84 + i * 50 + 12;
+    face.forEach((index, corner) => {
+      v[index].forEach((value, axis) => buffer.writeFloatLE(value, at + corner * 12 + axis * 4));
+    });
+  });
+  return buffer;
+}
+
+function workload() {
+  const manifest = JSON.parse(fs.readFileSync(opts.corpus, 'utf-8'));
+  const jobs = [];
+  for (const entry of manifest.cases) {
+    const modelPath = path.join(opts.models, entry.file ?? `${entry.id}.stl`);
+    if (!fs.existsSync(modelPath)) {
+      continue;
+    }
+    const presets = (entry.presets ?? manifest.defaultPresets ?? []).filter((name) => opts.presets.includes(name));
+    for (const name of presets) {
+      jobs.push({ id: `${entry.id}/${name}`, model: modelPath, config: { ...manifest.presets[name], ...opts.config } });
+    }
+  }
+  if (jobs.length === 0) {
+    console.error(`[split-module] no corpus models in ${opts.models} (bench/corpus/generate.js); profiling a cube`);
+    for (const name of opts.presets) {
+      jobs.push({ id: `cube/${name}`, model: null, config: { ...manifest.presets[name], ...opts.config } });
+    }
+  }
+  return jobs;
+}
+
+async function profile(glue, instrumentedPath, profilePath) {
+  const dir = path.dirname(glue);
+  const wasmBinary = fs.readFileSync(instrumentedPath);
+  let exports = null;
+  const OrcaModuleFactory = require(glue);
+  const module = await OrcaModuleFactory({
+    wasmBinary,
+    locateFile: (filename) => path.join(dir, filename),
+    print: () => {},
+    printErr: () => {},
+    instantiateWasm(imports, receiveInstance) {
+      WebAssembly.instantiate(wasmBinary, imports).then(({ instance, module: compiled }) => {
+        exports = instance.exports;
+        receiveInstance(instance, compiled);
+      });
+      return {};
+    },
+  });
+  if (module && typeof module.ready?.then === 'function') {
+    await module.ready;
+  }
+  if (typeof exports?.[PROFILE_EXPORT] !== 'function') {
+    throw new Error(`${path.basename(instrumentedPath)} has no ${PROFILE_EXPORT} export; link with -sSPLIT_MODULE`);
+  }
+
+  const copyIn = (bytes) => {
+    const ptr = module._malloc(bytes.length);
+    module.HEAPU8.set(bytes, ptr);
+    return ptr;
+  };
+  const outPtr = module._malloc(8);
+  const outLen = outPtr + 4;
+  for (const job of workload()) {
+    const payloadBytes = Buffer.from(JSON.stringify({ config: job.config }), 'utf-8');
+    const modelBytes = job.model ? fs.readFileSync(job.model) : cubeStl();
+    const payload = copyIn(payloadBytes);
+    const model = copyIn(modelBytes);
+    module.HEAPU32[outPtr >> 2] = 0;
+    module._orc_init(payload, payloadBytes.length);
+    const rc = module._orc_slice(model, modelBytes.length, outPtr, outLen);
+    const gcode = module.HEAPU32[outPtr >> 2];
+    if (gcode) {
+      module._orc_free(gcode);
+    }
+    module._free(payload);
+    module._free(model);
+    console.error(`[split-module] profiled ${job.id} rc=${rc}`);
+  }
+  module._free(outPtr);
+
+  const buffer = module._malloc(PROFILE_CAPACITY);
+  const written = exports[PROFILE_EXPORT](buffer, PROFILE_CAPACITY);
+  if (written <= 0 || written > PROFILE_CAPACITY) {
+    throw new Error(`${PROFILE_EXPORT} returned ${written}`);
+  }
+  fs.writeFileSync(profilePath, module.HEAPU8.subarray(buffer, buffer + written));
+  module._free(buffer);
+}
+
+function split(origPath, primaryPath, deferredPath, profilePath) {
+  const { spawnSync } = require('child_process');
+  const run = spawnSync(opts.wasmSplit, [
+    '-all',
+    '--export-prefix=%',
+    origPath,
+    '-o1', primaryPath,
+    '-o2', deferredPath,
+    `--profile=${profilePath}`,
+  ], { encoding: 'utf-8' });
+  if (run.error) {
+    throw new Error(`cannot run ${opts.wasmSplit}: ${run.error.message}`);
+  }
+  if (run.status !== 0) {
+    throw new Error(`${opts.wasmSplit} exited with ${run.status}\n${run.stdout}${run.stderr}`);
+  }
+}
+
+async function main() {
+  if (!opts.module) {
+    throw new Error('--module=PATH/slicer.js is required');
+  }
+  const glue = path.resolve(opts.module);
+  const base = glue.replace(/\.js$/, '');
+  const wasmPath = `${base}.wasm`;
+  const origPath = `${base}.wasm.orig`;
+  const instrumentedPath = `${base}.instrumented.wasm`;
+  const deferredPath = `${base}.deferred.wasm`;
+  const profilePath = `${base}.profile.data`;
+  if (!fs.existsSync(origPath)) {
+    throw new Error(`${origPath} not found; configure with -DORC_WASM_SPLIT=ON`);
+  }
+
+  // A fresh link leaves the instrumented module in <name>.wasm; after a split
+  // it holds the core, and the copy saved by the previous run is used.
+  if (fs.readFileSync(wasmPath).includes(Buffer.from(PROFILE_EXPORT))) {
+    fs.copyFileSync(wasmPath, instrumentedPath);
+  } else if (!fs.existsSync(instrumentedPath)) {
+    throw new Error(`${wasmPath} is not instrumented and no ${path.basename(instrumentedPath)} was saved; relink`);
+  }
+
+  await profile(glue, instrumentedPath, profilePath);
+  split(origPath, wasmPath, deferredPath, profilePath);
+
+  const mib = (file) => (fs.statSync(file).size / 1048576).toFixed(1);
+  console.error(
+    `[split-module] ${path.basename(origPath)} ${mib(origPath)} MiB -> core ${path.basename(wasmPath)} ${mib(wasmPath)} MiB`
+    + ` + deferred ${path.basename(deferredPath)} ${mib(deferredPath)} MiB`,
+  );
+  console.error('[split-module] node scripts/measure-split.js compares download size and compile time');
+}
+
+main().catch((err) => {
+  console.error('[split-module] failed:', err.message ?? err);
+  process.exit(1);
+});
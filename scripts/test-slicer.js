@@ -12,6 +12,10 @@ const wantConfigDump = process.env.ORC_DUMP_CONFIG === '1' || args.includes('--d
 const stlArg = args.find((value) => !value.startsWith('--'));
 const outArg = args.find((value) => value.startsWith('--out='));
 const outputPath = outArg ? path.resolve(outArg.slice('--out='.length)) : null;
+// --pack-touched=FILE writes the resource pack entries the slice opened, in the
+// format of wasm/resources-core.txt.
+const touchedArg = args.find((value) => value.startsWith('--pack-touched='));
+const touchedPath = touchedArg ? path.resolve(touchedArg.slice('--pack-touched='.length)) : null;
 
 function dumpPointer(ptr, maxBytes = 128) {
   if (!Number.isInteger(ptr) || ptr <= 0) {
@@ -376,6 +380,17 @@ async function main() {
       fs.writeFileSync(outputPath, gcodeText, 'utf-8');
       console.log(`[test-slicer] full G-code written to ${outputPath}`);
     }
+    if (touchedPath) {
+      if (typeof module.orcPackTouched !== 'function') {
+        throw new Error('--pack-touched needs a build with ORC_WASM_RESOURCE_PACK=ON');
+      }
+      const touched = module.orcPackTouched();
+      // Keep the leading comment block of an existing list.
+      const previous = fs.existsSync(touchedPath) ? fs.readFileSync(touchedPath, 'utf-8').split('\n') : [];
+      const header = previous.slice(0, Math.max(0, previous.findIndex((line) => !line.startsWith('#'))));
+      fs.writeFileSync(touchedPath, [...header, ...touched, ''].join('\n'), 'utf-8');
+      console.log(`[test-slicer] ${touched.length} touched resource entries written to ${touchedPath}`, module.orcPackStats());
+    }
   } finally {
     module._free(inPtr);
     module._free(outPtrPtr);
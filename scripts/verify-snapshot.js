@@ -0,0 +1,148 @@
+#!/usr/bin/env node
+// Checks a snapshotted module (ORC_WASM_SNAPSHOT) against a fresh start.
+//
+// Instantiates <artifact>.fresh.wasm and the snapshotted <artifact>.wasm with
+// the same glue, then compares orc_config_fingerprint: the PrintConfigDef,
+// default config and resource dir digests must match, and only the snapshot
+// may report snapshot=true (set solely by the build-time orc_snapshot_init).
+// Also times instantiation and orc_warmup for both, which is the start-up cost
+// the snapshot removes from the first slice.
+//
+// Snapshots need the native exceptions variant, so the defaults point at the
+// eh build (ORC_WASM_VARIANTS=eh with -DORC_WASM_SNAPSHOT=ON); pass --dir and
+// --name for another one, e.g. --name=slicer64-simd-eh.
+//
+// Usage: node scripts/verify-snapshot.js [--dir=build-wasm-eh]
+//          [--name=slicer-eh] [--runs=N]
+// Exits 1 if the snapshot is missing, stale or differs from a fresh start.
+
+const fs = require('fs');
+const path = require('path');
+const { performance } = require('perf_hooks');
+
+const repoRoot = path.resolve(__dirname, '..');
+
+const args = process.argv.slice(2);
+const argValue = (name, fallback) => {
+  const hit = args.find((value) => value.startsWith(`--${name}=`));
+  return hit ? hit.slice(name.length + 3) : fallback;
+};
+
+const artifact = argValue('name', 'slicer-eh');
+const memory64 = artifact.startsWith('slicer64');
+const dir = path.resolve(argValue('dir', path.join(repoRoot, 'build-wasm-eh')));
+const runs = Math.max(1, Number.parseInt(argValue('runs', '3'), 10) || 1);
+
+// Pointers and size_t are BigInt on wasm64 and 8 bytes wide in memory.
+const wordBytes = memory64 ? 8 : 4;
+const toWasm = (value) => (memory64 ? BigInt(value) : value);
+const readWord = (module, addr) => (memory64 ? Number(module.HEAPU64[addr / 8]) : module.HEAPU32[addr >> 2]);
+const writeWord = (module, addr, value) => {
+  if (memory64) {
+    module.HEAPU64[addr / 8] = BigInt(value);
+  } else {
+    module.HEAPU32[addr >> 2] = value;
+  }
+};
+
+async function instantiate(wasmFile) {
+  const OrcaModuleFactory = require(path.join(dir, `${artifact}.js`));
+  const module = await OrcaModuleFactory({
+    wasmBinary: fs.readFileSync(path.join(dir, wasmFile)),
+    locateFile: (filename) => path.join(dir, filename),
+    print: () => {},
+    printErr: () => {},
+  });
+  if (module && typeof module.ready?.then === 'function') {
+    await module.ready;
+  }
+  return module;
+}
+
+function fingerprint(module) {
+  const outPtrPtr = Number(module._malloc(toWasm(2 * wordBytes)));
+  const outLenPtr = outPtrPtr + wordBytes;
+  try {
+    writeWord(module, outPtrPtr, 0);
+    writeWord(module, outLenPtr, 0);
+    const rc = module._orc_config_fingerprint(toWasm(outPtrPtr), toWasm(outLenPtr));
+    if (rc !== 0) {
+      throw new Error(`orc_config_fingerprint returned ${rc}`);
+    }
+    const ptr = readWord(module, outPtrPtr);
+    const len = readWord(module, outLenPtr);
+    const text = Buffer.from(module.HEAPU8.subarray(ptr, ptr + len)).toString('utf-8');
+    module._orc_free(toWasm(ptr));
+    return JSON.parse(text);
+  } finally {
+    module._free(toWasm(outPtrPtr));
+  }
+}
+
+// Instantiation plus warm-up is what a worker pays before its first slice.
+async function measure(wasmFile) {
+  const samples = [];
+  let print = null;
+  for (let i = 0; i < runs; i += 1) {
+    const start = performance.now();
+    const module = await instantiate(wasmFile);
+    const instantiated = performance.now();
+    const rc = module._orc_warmup();
+    const warm = performance.now();
+    if (rc !== 0) {
+      throw new Error(`${wasmFile}: orc_warmup returned ${rc}`);
+    }
+    samples.push({ instantiateMs: instantiated - start, warmupMs: warm - instantiated });
+    print = fingerprint(module);
+  }
+  const median = (key) => samples.map((s) => s[key]).sort((a, b) => a - b)[Math.floor(samples.length / 2)];
+  return {
+    wasm: wasmFile,
+    bytes: fs.statSync(path.join(dir, wasmFile)).size,
+    instantiateMs: Number(median('instantiateMs').toFixed(2)),
+    warmupMs: Number(median('warmupMs').toFixed(2)),
+    fingerprint: print,
+  };
+}
+
+async function main() {
+  const freshFile = `${artifact}.fresh.wasm`;
+  if (!fs.existsSync(path.join(dir, freshFile))) {
+    throw new Error(`${path.join(dir, freshFile)} not found; configure with -DORC_WASM_EH=ON -DORC_WASM_SNAPSHOT=ON`);
+  }
+  const fresh = await measure(freshFile);
+  const snapshot = await measure(`${artifact}.wasm`);
+
+  const problems = [];
+  if (fresh.fingerprint.snapshot) {
+    problems.push(`${freshFile} reports snapshot=true`);
+  }
+  if (!snapshot.fingerprint.snapshot) {
+    problems.push(`${artifact}.wasm was not pre-initialized (snapshot=false)`);
+  }
+  for (const key of Object.keys(fresh.fingerprint)) {
+    if (key !== 'snapshot' && fresh.fingerprint[key] !== snapshot.fingerprint[key]) {
+      problems.push(`${key}: fresh ${fresh.fingerprint[key]} != snapshot ${snapshot.fingerprint[key]}`);
+    }
+  }
+
+  const startFresh = fresh.instantiateMs + fresh.warmupMs;
+  const startSnapshot = snapshot.instantiateMs + snapshot.warmupMs;
+  console.log(JSON.stringify({
+    module: artifact,
+    runs,
+    fresh,
+    snapshot,
+    savedMs: Number((startFresh - startSnapshot).toFixed(2)),
+    ok: problems.length === 0,
+    problems,
+  }, null, 2));
+  if (problems.length > 0) {
+    process.exit(1);
+  }
+}
+
+main().catch((err) => {
+  console.error('[verify-snapshot] failed:', err.message ?? err);
+  process.exit(1);
+});
@@ -3,19 +3,98 @@ set -euo pipefail
 
 BUILD_SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 PROJECT_ROOT="$(cd "${BUILD_SCRIPT_DIR}/.." && pwd)"
+WEB_WASM_DIR="${PROJECT_ROOT}/web/public/wasm"
 
 if ! source "${BUILD_SCRIPT_DIR}/toolchain/emsdk.env"; then
 	source /opt/emsdk/emsdk_env.sh || true
 fi
 
-emcmake cmake -S "${BUILD_SCRIPT_DIR}" -B "${PROJECT_ROOT}/build-wasm" -DCMAKE_BUILD_TYPE=Release
+# ORC_WASM_MEMORY64=1 builds the wasm64 variant (slicer64.*) into build-wasm64.
+BUILD_ROOT="${PROJECT_ROOT}/build-wasm"
+ARTIFACT_BASE="slicer"
+MEMORY64=OFF
+if [[ "${ORC_WASM_MEMORY64:-0}" == "1" ]]; then
+	BUILD_ROOT="${PROJECT_ROOT}/build-wasm64"
+	ARTIFACT_BASE="slicer64"
+	MEMORY64=ON
+fi
+
+# ORC_WASM_VARIANTS picks the capability variants to build, e.g.
+# "baseline simd-eh simd-eh-mt"; "all" builds the full matrix. Each variant
+# gets its own build directory (build-wasm, build-wasm-simd-eh, ...).
+ALL_VARIANTS="baseline simd eh mt simd-eh simd-eh-mt"
+VARIANTS="${ORC_WASM_VARIANTS:-baseline}"
+if [[ "${VARIANTS}" == "all" ]]; then
+	VARIANTS="${ALL_VARIANTS}"
+fi
+
+build_variant() {
+	local variant="$1"
+	local simd=OFF eh=OFF mt=OFF suffix="" build_dir="${BUILD_ROOT}"
+	if [[ "${variant}" != "baseline" ]]; then
+		for capability in ${variant//-/ }; do
+			case "${capability}" in
+				simd) simd=ON ;;
+				eh) eh=ON ;;
+				mt) mt=ON ;;
+				*) echo "Unknown capability '${capability}' in variant '${variant}'" >&2; exit 1 ;;
+			esac
+		done
+		suffix="-${variant}"
+		build_dir="${BUILD_ROOT}${suffix}"
+	fi
+	local artifact="${ARTIFACT_BASE}${suffix}"
+
+	emcmake cmake -S "${BUILD_SCRIPT_DIR}" -B "${build_dir}" -DCMAKE_BUILD_TYPE=Release \
+		-DORC_WASM_MEMORY64=${MEMORY64} -DORC_WASM_SIMD=${simd} -DORC_WASM_EH=${eh} -DORC_WASM_PTHREADS=${mt}
 
-cmake --build "${PROJECT_ROOT}/build-wasm" -j
+	cmake --build "${build_dir}" -j
+	# Split builds (-DORC_WASM_SPLIT=ON) profile and split after linking.
+	if grep -q '^ORC_WASM_SPLIT:BOOL=ON' "${build_dir}/CMakeCache.txt"; then
+		cmake --build "${build_dir}" --target slicer_split
+	fi
 
-mkdir -p "${PROJECT_ROOT}/web/public/wasm"
-cp "${PROJECT_ROOT}/build-wasm/slicer.js" \
-	"${PROJECT_ROOT}/build-wasm/slicer.wasm" \
-	"${PROJECT_ROOT}/build-wasm/slicer.data" \
-	"${PROJECT_ROOT}/web/public/wasm/"
+	# Resources ship as resources.orcpack (shared by every variant), or as
+	# ${artifact}.data when configured with -DORC_WASM_RESOURCE_PACK=OFF.
+	local resources="${build_dir}/resources.orcpack"
+	if [[ ! -f "${resources}" ]]; then
+		resources="${build_dir}/${artifact}.data"
+	fi
+
+	mkdir -p "${WEB_WASM_DIR}"
+	cp "${build_dir}/${artifact}.js" \
+		"${build_dir}/${artifact}.wasm" \
+		"${resources}" \
+		"${WEB_WASM_DIR}/"
+	if [[ -f "${build_dir}/${artifact}.deferred.wasm" ]]; then
+		cp "${build_dir}/${artifact}.deferred.wasm" "${WEB_WASM_DIR}/"
+	fi
+}
+
+for variant in ${VARIANTS}; do
+	build_variant "${variant}"
+done
+
+# List the wasm32 variants present, most capable first. The worker loads the
+# first one whose capabilities the browser has; reorder after benchmarking
+# (bench/README.md) if a variant turns out slower than one below it.
+if [[ "${MEMORY64}" == "OFF" ]]; then
+	manifest="${WEB_WASM_DIR}/slicer-variants.json"
+	entries=""
+	for variant in simd-eh-mt simd-eh eh-mt simd-mt simd eh mt baseline; do
+		script="slicer-${variant}.js"
+		features="${variant//-/\",\"}"
+		if [[ "${variant}" == "baseline" ]]; then
+			script="slicer.js"
+			features=""
+		else
+			features="\"${features}\""
+		fi
+		if [[ -f "${WEB_WASM_DIR}/${script}" ]]; then
+			entries+="${entries:+,}"$'\n'"    {\"name\": \"${variant}\", \"script\": \"${script}\", \"features\": [${features}]}"
+		fi
+	done
+	printf '{\n  "schema": 1,\n  "variants": [%s\n  ]\n}\n' "${entries}" > "${manifest}"
+fi
 
 echo "WASM build complete."
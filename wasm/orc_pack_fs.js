@@ -0,0 +1,175 @@
+// Lazy resource pack mount, linked with --pre-js. Replaces --preload-file of
+// the whole orca/resources tree: before main() only the pack's header and
+// index are fetched, the tree is created under /resources with every file
+// empty, and a file's bytes are fetched with a range request the first time it
+// is opened. Core entries (wasm/resources-core.txt) arrive in one request up
+// front, so a slicing-only worker normally never fetches anything else.
+//
+// Module options:
+//   orcResourcePack      URL (web) or path (node) of the pack; default
+//                        locateFile('resources.orcpack')
+//   orcPrefetchCore      fetch core entries before main(); default true
+//
+// Module.orcPackStats() reports fetches; Module.orcPackTouched() lists the
+// entries opened so far, which is how resources-core.txt is produced.
+
+(function () {
+  const MOUNT = '/resources';
+  const HEADER_BYTES = 48;
+  const INDEX_ENTRY_BYTES = 32;
+  const FLAG_CORE = 1;
+  const FIRST_FETCH_BYTES = 256 * 1024;
+
+  const isNode = typeof process === 'object' && typeof process.versions === 'object' && typeof process.versions.node === 'string';
+  const stats = { indexBytes: 0, fetches: 0, fetchedBytes: 0, coreBytes: 0, touched: new Set() };
+
+  function packLocation() {
+    if (Module['orcResourcePack']) {
+      return Module['orcResourcePack'];
+    }
+    return typeof locateFile === 'function' ? locateFile('resources.orcpack') : 'resources.orcpack';
+  }
+
+  // Reads [begin, end) of the pack. Asynchronous reads happen before main();
+  // lazy opens run inside a syscall and must be synchronous, which workers
+  // (sync XHR) and node (readSync) both allow.
+  function readRangeSync(location, begin, end) {
+    stats.fetches += 1;
+    if (isNode) {
+      const fs = require('fs');
+      const fd = fs.openSync(location, 'r');
+      try {
+        const bytes = new Uint8Array(end - begin);
+        const read = fs.readSync(fd, bytes, 0, bytes.length, begin);
+        stats.fetchedBytes += read;
+        return bytes.subarray(0, read);
+      } finally {
+        fs.closeSync(fd);
+      }
+    }
+    stats.fetchedBytes += end - begin;
+    const xhr = new XMLHttpRequest();
+    xhr.open('GET', location, false);
+    xhr.responseType = 'arraybuffer';
+    xhr.setRequestHeader('Range', `bytes=${begin}-${end - 1}`);
+    xhr.send(null);
+    if (xhr.status === 206) {
+      return new Uint8Array(xhr.response);
+    }
+    if (xhr.status === 200) {
+      return new Uint8Array(xhr.response, begin, end - begin);
+    }
+    throw new Error(`[orc_pack] ${location}: HTTP ${xhr.status} for bytes ${begin}-${end - 1}`);
+  }
+
+  async function readRange(location, begin, end) {
+    if (isNode) {
+      return readRangeSync(location, begin, end);
+    }
+    stats.fetches += 1;
+    stats.fetchedBytes += end - begin;
+    const response = await fetch(location, { headers: { Range: `bytes=${begin}-${end - 1}` } });
+    if (!response.ok) {
+      throw new Error(`[orc_pack] ${location}: HTTP ${response.status}`);
+    }
+    const body = new Uint8Array(await response.arrayBuffer());
+    // A server without range support sends the whole pack.
+    return response.status === 206 ? body : body.subarray(begin, end);
+  }
+
+  function parseIndex(bytes) {
+    const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    const magic = String.fromCharCode(...bytes.subarray(0, 8));
+    if (magic !== 'ORCPACK1' || view.getUint32(8, true) !== 1) {
+      throw new Error('[orc_pack] not a version 1 resource pack');
+    }
+    const count = view.getUint32(12, true);
+    const indexOffset = Number(view.getBigUint64(16, true));
+    const indexBytes = Number(view.getBigUint64(24, true));
+    const dataOffset = Number(view.getBigUint64(32, true));
+    const coreBytes = Number(view.getBigUint64(40, true));
+    return { view, count, indexOffset, indexBytes, dataOffset, coreBytes };
+  }
+
+  function entriesOf(header, bytes) {
+    const decoder = new TextDecoder();
+    const strings = header.indexOffset + header.count * INDEX_ENTRY_BYTES;
+    const entries = [];
+    for (let i = 0; i < header.count; i += 1) {
+      const at = header.indexOffset + i * INDEX_ENTRY_BYTES;
+      const pathOffset = strings + header.view.getUint32(at + 16, true);
+      const pathLength = header.view.getUint32(at + 20, true);
+      entries.push({
+        offset: Number(header.view.getBigUint64(at, true)),
+        size: Number(header.view.getBigUint64(at + 8, true)),
+        core: (header.view.getUint32(at + 24, true) & FLAG_CORE) !== 0,
+        path: decoder.decode(bytes.subarray(pathOffset, pathOffset + pathLength)),
+      });
+    }
+    return entries;
+  }
+
+  function createNode(location, entry) {
+    const slash = entry.path.lastIndexOf('/');
+    const dir = slash < 0 ? MOUNT : `${MOUNT}/${entry.path.slice(0, slash)}`;
+    FS.mkdirTree(dir);
+    const node = FS.create(`${MOUNT}/${entry.path}`, 0o444);
+    // MEMFS reports usedBytes as the file size; contents stay null until the
+    // first open.
+    node.contents = null;
+    node.usedBytes = entry.size;
+    node.stream_ops = Object.assign({}, node.stream_ops, {
+      open(stream) {
+        stats.touched.add(entry.path);
+        if (stream.node.contents === null) {
+          stream.node.contents = entry.size > 0 ? readRangeSync(location, entry.offset, entry.offset + entry.size) : new Uint8Array(0);
+        }
+      },
+    });
+    return node;
+  }
+
+  async function mount() {
+    const location = packLocation();
+    let head = await readRange(location, 0, FIRST_FETCH_BYTES);
+    let header = parseIndex(head);
+    const indexEnd = header.indexOffset + header.indexBytes;
+    if (indexEnd > head.length) {
+      head = await readRange(location, 0, indexEnd);
+      header = parseIndex(head);
+    }
+    stats.indexBytes = indexEnd;
+
+    const entries = entriesOf(header, head);
+    const nodes = entries.map((entry) => createNode(location, entry));
+
+    if (Module['orcPrefetchCore'] !== false && header.coreBytes > 0) {
+      const begin = header.dataOffset;
+      const core = await readRange(location, begin, begin + header.coreBytes);
+      entries.forEach((entry, i) => {
+        if (entry.core) {
+          nodes[i].contents = core.subarray(entry.offset - begin, entry.offset - begin + entry.size);
+        }
+      });
+      stats.coreBytes = header.coreBytes;
+    }
+  }
+
+  Module['orcPackStats'] = () => ({
+    indexBytes: stats.indexBytes,
+    coreBytes: stats.coreBytes,
+    fetches: stats.fetches,
+    fetchedBytes: stats.fetchedBytes,
+    touchedEntries: stats.touched.size,
+  });
+  Module['orcPackTouched'] = () => Array.from(stats.touched).sort();
+
+  Module['preRun'] = [].concat(Module['preRun'] || [], () => {
+    addRunDependency('orc_pack');
+    mount()
+      .catch((error) => {
+        err(`[orc_pack] mount failed: ${error.message ?? error}`);
+      })
+      .finally(() => removeRunDependency('orc_pack'));
+  });
+})();
@@ -1,43 +1,304 @@
 #pragma once
-// Minimal cereal shim for WASM builds.
-// Provides stubs for the subset of the API exercised by the bridge build.
+// Minimal cereal for WASM builds: the subset of the API libslic3r and the
+// bridge use, with working binary archives.
+//
+// Values are written as raw native-endian bytes (every target we ship is
+// little-endian) and sizes as uint64_t, so archives move between wasm32 and
+// native builds. Dispatch follows cereal's order: arithmetic types and
+// binary_data, then member serialize/save/load, then non-member
+// serialize/save/load found by ADL (the archive pulls in namespace cereal).
+// Versioned forms receive the version from CEREAL_CLASS_VERSION, which is
+// stored inline ahead of each such object. Polymorphic and smart pointers are
+// not supported; a type with no serialization path throws cereal::Exception
+// when it is reached, so code that merely mentions an archive still compiles.
 
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <utility>
 
 namespace cereal {
 
-// --- Archive stubs -------------------------------------------------------
+struct Exception : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
 
-class BinaryOutputArchive {
-public:
-    template <typename T>
-    BinaryOutputArchive& operator&(const T&) { return *this; }
+// Contiguous raw bytes, written without a size prefix.
+template <class T>
+struct BinaryData {
+    T data;
+    uint64_t size;
+};
 
-    template <typename T>
-    BinaryOutputArchive& operator()(const T&) { return *this; }
+template <class T>
+inline BinaryData<T> binary_data(T&& data, size_t size)
+{
+    return {std::forward<T>(data), static_cast<uint64_t>(size)};
+}
+
+using size_type = uint64_t;
+
+template <class T>
+struct SizeTag {
+    T size;
 };
 
-class BinaryInputArchive {
-public:
-    template <typename T>
-    BinaryInputArchive& operator&(T&) { return *this; }
+template <class T>
+inline SizeTag<T&> make_size_tag(T&& size)
+{
+    return {size};
+}
+
+template <class T>
+inline T&& make_nvp(const char*, T&& value)
+{
+    return std::forward<T>(value);
+}
+
+namespace detail {
 
-    template <typename T>
-    BinaryInputArchive& operator()(T&) { return *this; }
+template <class T>
+struct Version {
+    static constexpr uint32_t value = 0;
 };
 
+template <class T>
+struct is_binary_data : std::false_type {};
+template <class T>
+struct is_binary_data<BinaryData<T>> : std::true_type {};
+
+template <class T>
+struct is_size_tag : std::false_type {};
+template <class T>
+struct is_size_tag<SizeTag<T>> : std::true_type {};
+
+} // namespace detail
+
 // --- Access helpers ------------------------------------------------------
 
+// Friend of classes with private serialize/save/load members.
 class access {
 public:
     template <class Archive, class T>
-    static void serialize(Archive&, T&) {}
-
+    static auto member_serialize(Archive& ar, T& t) -> decltype(t.serialize(ar))
+    {
+        return t.serialize(ar);
+    }
     template <class Archive, class T>
-    static void save(Archive&, const T&) {}
-
+    static auto member_serialize(Archive& ar, T& t, uint32_t version) -> decltype(t.serialize(ar, version))
+    {
+        return t.serialize(ar, version);
+    }
     template <class Archive, class T>
-    static void load(Archive&, T&) {}
+    static auto member_save(Archive& ar, const T& t) -> decltype(t.save(ar))
+    {
+        return t.save(ar);
+    }
+    template <class Archive, class T>
+    static auto member_save(Archive& ar, const T& t, uint32_t version) -> decltype(t.save(ar, version))
+    {
+        return t.save(ar, version);
+    }
+    template <class Archive, class T>
+    static auto member_load(Archive& ar, T& t) -> decltype(t.load(ar))
+    {
+        return t.load(ar);
+    }
+    template <class Archive, class T>
+    static auto member_load(Archive& ar, T& t, uint32_t version) -> decltype(t.load(ar, version))
+    {
+        return t.load(ar, version);
+    }
+};
+
+namespace detail {
+
+#define CEREAL_SHIM_TRAIT(name, expr)                                                                    \
+    template <class A, class T, class = void>                                                            \
+    struct name : std::false_type {};                                                                    \
+    template <class A, class T>                                                                          \
+    struct name<A, T, std::void_t<decltype(expr)>> : std::true_type {};
+
+CEREAL_SHIM_TRAIT(has_member_serialize, access::member_serialize(std::declval<A&>(), std::declval<T&>()))
+CEREAL_SHIM_TRAIT(has_member_versioned_serialize,
+                  access::member_serialize(std::declval<A&>(), std::declval<T&>(), uint32_t()))
+CEREAL_SHIM_TRAIT(has_member_save, access::member_save(std::declval<A&>(), std::declval<const T&>()))
+CEREAL_SHIM_TRAIT(has_member_versioned_save,
+                  access::member_save(std::declval<A&>(), std::declval<const T&>(), uint32_t()))
+CEREAL_SHIM_TRAIT(has_member_load, access::member_load(std::declval<A&>(), std::declval<T&>()))
+CEREAL_SHIM_TRAIT(has_member_versioned_load,
+                  access::member_load(std::declval<A&>(), std::declval<T&>(), uint32_t()))
+CEREAL_SHIM_TRAIT(has_non_member_serialize, serialize(std::declval<A&>(), std::declval<T&>()))
+CEREAL_SHIM_TRAIT(has_non_member_versioned_serialize,
+                  serialize(std::declval<A&>(), std::declval<T&>(), uint32_t()))
+CEREAL_SHIM_TRAIT(has_non_member_save, save(std::declval<A&>(), std::declval<const T&>()))
+CEREAL_SHIM_TRAIT(has_non_member_load, load(std::declval<A&>(), std::declval<T&>()))
+
+#undef CEREAL_SHIM_TRAIT
+
+} // namespace detail
+
+// --- Archives ------------------------------------------------------------
+
+class BinaryOutputArchive {
+public:
+    static constexpr bool is_loading = false;
+    static constexpr bool is_saving = true;
+
+    explicit BinaryOutputArchive(std::ostream& stream) : m_stream(&stream) {}
+
+    template <class... Types>
+    BinaryOutputArchive& operator()(Types&&... args)
+    {
+        (process(args), ...);
+        return *this;
+    }
+
+    template <class T>
+    BinaryOutputArchive& operator&(T&& value)
+    {
+        process(value);
+        return *this;
+    }
+
+    template <class T>
+    BinaryOutputArchive& operator<<(T&& value)
+    {
+        process(value);
+        return *this;
+    }
+
+    void saveBinary(const void* data, size_t size)
+    {
+        if (size != 0 && !m_stream->write(static_cast<const char*>(data), static_cast<std::streamsize>(size))) {
+            throw Exception("cereal: failed to write " + std::to_string(size) + " bytes");
+        }
+    }
+
+private:
+    template <class T>
+    void process(const T& t)
+    {
+        using A = BinaryOutputArchive;
+        // cereal's serialize() members are non-const and shared with loading.
+        T& value = const_cast<T&>(t);
+        (void)value;
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+            saveBinary(&t, sizeof(T));
+        } else if constexpr (detail::is_binary_data<T>::value) {
+            saveBinary(t.data, static_cast<size_t>(t.size));
+        } else if constexpr (detail::is_size_tag<T>::value) {
+            const size_type size = static_cast<size_type>(t.size);
+            saveBinary(&size, sizeof(size));
+        } else if constexpr (detail::has_member_versioned_serialize<A, T>::value) {
+            access::member_serialize(*this, value, save_version<T>());
+        } else if constexpr (detail::has_member_serialize<A, T>::value) {
+            access::member_serialize(*this, value);
+        } else if constexpr (detail::has_member_versioned_save<A, T>::value) {
+            access::member_save(*this, t, save_version<T>());
+        } else if constexpr (detail::has_member_save<A, T>::value) {
+            access::member_save(*this, t);
+        } else if constexpr (detail::has_non_member_versioned_serialize<A, T>::value) {
+            serialize(*this, value, save_version<T>());
+        } else if constexpr (detail::has_non_member_serialize<A, T>::value) {
+            serialize(*this, value);
+        } else if constexpr (detail::has_non_member_save<A, T>::value) {
+            save(*this, t);
+        } else {
+            throw Exception("cereal: no save path for this type");
+        }
+    }
+
+    template <class T>
+    uint32_t save_version()
+    {
+        const uint32_t version = detail::Version<T>::value;
+        saveBinary(&version, sizeof(version));
+        return version;
+    }
+
+    std::ostream* m_stream;
+};
+
+class BinaryInputArchive {
+public:
+    static constexpr bool is_loading = true;
+    static constexpr bool is_saving = false;
+
+    explicit BinaryInputArchive(std::istream& stream) : m_stream(&stream) {}
+
+    template <class... Types>
+    BinaryInputArchive& operator()(Types&&... args)
+    {
+        (process(args), ...);
+        return *this;
+    }
+
+    template <class T>
+    BinaryInputArchive& operator&(T&& value)
+    {
+        process(value);
+        return *this;
+    }
+
+    template <class T>
+    BinaryInputArchive& operator>>(T&& value)
+    {
+        process(value);
+        return *this;
+    }
+
+    void loadBinary(void* data, size_t size)
+    {
+        if (size != 0 && !m_stream->read(static_cast<char*>(data), static_cast<std::streamsize>(size))) {
+            throw Exception("cereal: failed to read " + std::to_string(size) + " bytes");
+        }
+    }
+
+private:
+    template <class T>
+    void process(T& t)
+    {
+        using A = BinaryInputArchive;
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+            loadBinary(&t, sizeof(T));
+        } else if constexpr (detail::is_binary_data<T>::value) {
+            loadBinary(t.data, static_cast<size_t>(t.size));
+        } else if constexpr (detail::is_size_tag<T>::value) {
+            size_type size = 0;
+            loadBinary(&size, sizeof(size));
+            t.size = static_cast<std::remove_reference_t<decltype(t.size)>>(size);
+        } else if constexpr (detail::has_member_versioned_serialize<A, T>::value) {
+            access::member_serialize(*this, t, load_version());
+        } else if constexpr (detail::has_member_serialize<A, T>::value) {
+            access::member_serialize(*this, t);
+        } else if constexpr (detail::has_member_versioned_load<A, T>::value) {
+            access::member_load(*this, t, load_version());
+        } else if constexpr (detail::has_member_load<A, T>::value) {
+            access::member_load(*this, t);
+        } else if constexpr (detail::has_non_member_versioned_serialize<A, T>::value) {
+            serialize(*this, t, load_version());
+        } else if constexpr (detail::has_non_member_serialize<A, T>::value) {
+            serialize(*this, t);
+        } else if constexpr (detail::has_non_member_load<A, T>::value) {
+            load(*this, t);
+        } else {
+            throw Exception("cereal: no load path for this type");
+        }
+    }
+
+    uint32_t load_version()
+    {
+        uint32_t version = 0;
+        loadBinary(&version, sizeof(version));
+        return version;
+    }
+
+    std::istream* m_stream;
 };
 
 template <class T>
@@ -80,6 +341,14 @@ struct specialize {
 
 }  // namespace cereal
 
-#define CEREAL_CLASS_VERSION(cls, version)
+#define CEREAL_CLASS_VERSION(cls, version)                                                                \
+    namespace cereal {                                                                                    \
+    namespace detail {                                                                                    \
+    template <>                                                                                           \
+    struct Version<cls> {                                                                                 \
+        static constexpr std::uint32_t value = version;                                                        \
+    };                                                                                                    \
+    }                                                                                                     \
+    }
 #define CEREAL_REGISTER_TYPE(type)
-#define CEREAL_REGISTER_POLYMORPHIC_RELATION(base, derived)
\ No newline at end of file
+#define CEREAL_REGISTER_POLYMORPHIC_RELATION(base, derived)
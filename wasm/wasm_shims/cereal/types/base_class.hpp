@@ -3,14 +3,19 @@
 
 namespace cereal {
 
-template <class Base, class Derived = Base>
+// ar(cereal::base_class<Base>(this)) serializes the Base part of *this with
+// Base's own serialize/save/load.
+template <class Base>
 class base_class {
 public:
-  explicit base_class(Derived*) {}
-  explicit base_class(const Derived*) {}
+  template <class Derived>
+  explicit base_class(const Derived* derived)
+      : base_ptr(const_cast<Base*>(static_cast<const Base*>(derived))) {}
 
   template <class Archive>
-  void serialize(Archive&) {}
+  void serialize(Archive& ar) { ar(*base_ptr); }
+
+  Base* base_ptr;
 };
 
 }  // namespace cereal
@@ -5,16 +5,20 @@
 
 namespace cereal {
 
-template <class Archive>
-inline void save(Archive &ar, const std::string &value)
+template <class Archive, class CharT, class Traits, class Alloc>
+inline void save(Archive &ar, const std::basic_string<CharT, Traits, Alloc> &value)
 {
-    ar(value);
+    ar(make_size_tag(static_cast<size_type>(value.size())));
+    ar(binary_data(value.data(), value.size() * sizeof(CharT)));
 }
 
-template <class Archive>
-inline void load(Archive &ar, std::string &value)
+template <class Archive, class CharT, class Traits, class Alloc>
+inline void load(Archive &ar, std::basic_string<CharT, Traits, Alloc> &value)
 {
-    ar(value);
+    size_type size = 0;
+    ar(make_size_tag(size));
+    value.resize(static_cast<std::size_t>(size));
+    ar(binary_data(&value[0], static_cast<std::size_t>(size) * sizeof(CharT)));
 }
 
 } // namespace cereal
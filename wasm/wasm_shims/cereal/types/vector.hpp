@@ -1,28 +1,43 @@
 #pragma once
 
 #include <cereal/cereal.hpp>
+#include <type_traits>
 #include <vector>
 
 namespace cereal {
 
-template <class Archive, class T>
-inline void save(Archive& ar, const std::vector<T>& vec)
+// Arithmetic elements go out as one block; everything else element by element.
+template <class Archive, class T, class Alloc>
+inline void save(Archive& ar, const std::vector<T, Alloc>& vec)
 {
-    const std::size_t size = vec.size();
-    ar(size);
-    for (const auto& value : vec)
-        ar(value);
+    ar(make_size_tag(static_cast<size_type>(vec.size())));
+    if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+        ar(binary_data(vec.data(), vec.size() * sizeof(T)));
+    } else {
+        for (const auto& value : vec)
+            ar(static_cast<const T&>(value));
+    }
 }
 
-template <class Archive, class T>
-inline void load(Archive& ar, std::vector<T>& vec)
+template <class Archive, class T, class Alloc>
+inline void load(Archive& ar, std::vector<T, Alloc>& vec)
 {
-    std::size_t size = 0;
-    ar(size);
+    size_type size = 0;
+    ar(make_size_tag(size));
     vec.clear();
-    vec.resize(size);
-    for (auto& value : vec)
-        ar(value);
+    vec.resize(static_cast<std::size_t>(size));
+    if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+        ar(binary_data(vec.data(), vec.size() * sizeof(T)));
+    } else if constexpr (std::is_same_v<T, bool>) {
+        for (std::size_t i = 0; i < vec.size(); ++i) {
+            bool value = false;
+            ar(value);
+            vec[i] = value;
+        }
+    } else {
+        for (auto& value : vec)
+            ar(value);
+    }
 }
 
 } // namespace cereal
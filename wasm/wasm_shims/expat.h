@@ -1,62 +1,563 @@
 #ifndef ORCA_WASM_SHIMS_EXPAT_H
 #define ORCA_WASM_SHIMS_EXPAT_H
 
-#include <stddef.h>
-#include <stdlib.h>
-#ifdef __cplusplus
+/* Streaming, non-validating XML parser behind the subset of expat's API that
+ * Orca and the bridge use. Input may arrive in chunks of any size (XML_Parse,
+ * or XML_GetBuffer + XML_ParseBuffer). Start/end element and character data
+ * handlers are called in document order as soon as a token is complete;
+ * the unfinished tail of a chunk is kept for the next call.
+ *
+ * Supported: elements and attributes (duplicates rejected, whitespace in
+ * values normalized), the five predefined entities and numeric character
+ * references, CDATA sections. Comments, processing instructions, the XML
+ * declaration and DOCTYPE (internal subset included) are skipped. Namespaces
+ * are not processed: prefixed names reach the handlers as written, which is
+ * what expat does for parsers created with XML_ParserCreate. The input must
+ * be UTF-8 (or ASCII); no DTD entity expansion.
+ *
+ * C++ only; the implementation keeps its buffers in std::string. */
+
+#ifndef __cplusplus
+#error "the expat shim needs C++"
+#endif
+
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
-#else
-#include <stdint.h>
-#endif
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
 
-#ifdef __cplusplus
 extern "C" {
-#endif
 
 typedef char XML_Char;
 #define XMLCALL
 
+/* Pointer-width like upstream expat, so positions stay exact on wasm64. */
+typedef long XML_Index;
+typedef unsigned long XML_Size;
+
 typedef enum {
     XML_STATUS_ERROR = 0,
     XML_STATUS_OK = 1
 } XML_Status;
 
+/* Upstream's numbering, for the codes this parser can report. */
 typedef enum {
     XML_ERROR_NONE = 0,
-    XML_ERROR_GENERIC = 1
+    XML_ERROR_NO_MEMORY = 1,
+    XML_ERROR_SYNTAX = 2,
+    XML_ERROR_NO_ELEMENTS = 3,
+    XML_ERROR_INVALID_TOKEN = 4,
+    XML_ERROR_UNCLOSED_TOKEN = 5,
+    XML_ERROR_TAG_MISMATCH = 7,
+    XML_ERROR_DUPLICATE_ATTRIBUTE = 8,
+    XML_ERROR_JUNK_AFTER_DOC_ELEMENT = 9,
+    XML_ERROR_UNDEFINED_ENTITY = 11,
+    XML_ERROR_BAD_CHAR_REF = 14,
+    XML_ERROR_UNCLOSED_CDATA_SECTION = 20,
+    XML_ERROR_ABORTED = 35,
+    XML_ERROR_FINISHED = 36
 } XML_Error;
 
 typedef struct XML_ParserStruct* XML_Parser;
 
-typedef void (*XML_StartElementHandler)(void* userData, const char* name, const char** atts);
-typedef void (*XML_EndElementHandler)(void* userData, const char* name);
-typedef void (*XML_CharacterDataHandler)(void* userData, const XML_Char* s, int len);
+/* Exactly upstream's handler types. The module links without
+ * -sEMULATE_FUNCTION_POINTER_CASTS, so a handler that only matches after a
+ * cast would trap on its first call instead of being adapted. */
+typedef void (XMLCALL *XML_StartElementHandler)(void* userData, const XML_Char* name, const XML_Char** atts);
+typedef void (XMLCALL *XML_EndElementHandler)(void* userData, const XML_Char* name);
+typedef void (XMLCALL *XML_CharacterDataHandler)(void* userData, const XML_Char* s, int len);
+
+} /* extern "C" */
 
 struct XML_ParserStruct {
-    void* user_data;
-    XML_StartElementHandler start_handler;
-    XML_EndElementHandler end_handler;
-    XML_CharacterDataHandler character_handler;
-    XML_Error last_error;
-    long current_line;
-    int stopped;
+    void* user_data = nullptr;
+    XML_StartElementHandler start_handler = nullptr;
+    XML_EndElementHandler end_handler = nullptr;
+    XML_CharacterDataHandler character_handler = nullptr;
+    XML_Error last_error = XML_ERROR_NONE;
+    XML_Size current_line = 1;
+    XML_Size current_column = 0;
+    XML_Index consumed = 0;
+    bool stopped = false;
+    bool finished = false;
+    bool seen_root = false;
+    unsigned specified_attributes = 0;
+    // Unconsumed tail of the previous chunk.
+    std::string pending;
+    std::string get_buffer;
+    // Open element names, each NUL-terminated, innermost last.
+    std::string stack;
+    std::vector<size_t> stack_starts;
+    // Scratch for decoded text and for a start tag's names and values.
+    std::string text;
+    std::string tag;
+    std::vector<size_t> tag_offsets;
+    std::vector<const XML_Char*> atts;
 };
 
-static inline XML_Parser XML_ParserCreate(const XML_Char* /*encoding*/)
+namespace orc_expat_detail {
+
+static inline bool is_space(char c)
 {
-    struct XML_ParserStruct* parser = (struct XML_ParserStruct*)malloc(sizeof(struct XML_ParserStruct));
-    if (parser != NULL) {
-        parser->user_data = NULL;
-        parser->start_handler = NULL;
-        parser->end_handler = NULL;
-        parser->character_handler = NULL;
-        parser->last_error = XML_ERROR_NONE;
-        parser->current_line = 0;
-        parser->stopped = 0;
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool is_name_end(char c)
+{
+    return is_space(c) || c == '/' || c == '>' || c == '=';
+}
+
+static inline void append_utf8(std::string& out, uint32_t cp)
+{
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Appends s[0, n) to `out` with references resolved, CR LF and lone CR turned
+// into LF and, in attribute values, tabs and newlines into spaces.
+static inline XML_Error decode(const char* s, size_t n, std::string& out, bool attribute)
+{
+    for (size_t i = 0; i < n;) {
+        size_t run = i;
+        while (run < n && s[run] != '&' && s[run] != '\r' && (!attribute || (s[run] != '\t' && s[run] != '\n'))) {
+            ++run;
+        }
+        out.append(s + i, run - i);
+        i = run;
+        if (i == n) {
+            break;
+        }
+        const char c = s[i];
+        if (c == '\r') {
+            out += attribute ? ' ' : '\n';
+            i += (i + 1 < n && s[i + 1] == '\n') ? 2 : 1;
+            continue;
+        }
+        if (c != '&') {
+            out += (attribute && (c == '\t' || c == '\n')) ? ' ' : c;
+            ++i;
+            continue;
+        }
+        const char* semi = static_cast<const char*>(std::memchr(s + i, ';', n - i));
+        if (semi == nullptr) {
+            return XML_ERROR_INVALID_TOKEN;
+        }
+        const char* ref = s + i + 1;
+        const size_t len = static_cast<size_t>(semi - ref);
+        if (len > 1 && ref[0] == '#') {
+            const bool hex = ref[1] == 'x';
+            uint32_t cp = 0;
+            size_t digits = 0;
+            for (const char* d = ref + (hex ? 2 : 1); d < semi; ++d, ++digits) {
+                int value;
+                if (*d >= '0' && *d <= '9') {
+                    value = *d - '0';
+                } else if (hex && *d >= 'a' && *d <= 'f') {
+                    value = *d - 'a' + 10;
+                } else if (hex && *d >= 'A' && *d <= 'F') {
+                    value = *d - 'A' + 10;
+                } else {
+                    return XML_ERROR_BAD_CHAR_REF;
+                }
+                cp = cp * (hex ? 16 : 10) + static_cast<uint32_t>(value);
+                if (cp > 0x10FFFF) {
+                    return XML_ERROR_BAD_CHAR_REF;
+                }
+            }
+            if (digits == 0 || cp == 0 || (cp >= 0xD800 && cp <= 0xDFFF)) {
+                return XML_ERROR_BAD_CHAR_REF;
+            }
+            append_utf8(out, cp);
+        } else if (len == 2 && std::memcmp(ref, "lt", 2) == 0) {
+            out += '<';
+        } else if (len == 2 && std::memcmp(ref, "gt", 2) == 0) {
+            out += '>';
+        } else if (len == 3 && std::memcmp(ref, "amp", 3) == 0) {
+            out += '&';
+        } else if (len == 4 && std::memcmp(ref, "quot", 4) == 0) {
+            out += '"';
+        } else if (len == 4 && std::memcmp(ref, "apos", 4) == 0) {
+            out += '\'';
+        } else {
+            return XML_ERROR_UNDEFINED_ENTITY;
+        }
+        i = static_cast<size_t>(semi - s) + 1;
+    }
+    return XML_ERROR_NONE;
+}
+
+static inline void advance(XML_Parser parser, const char* s, size_t n)
+{
+    const char* last_newline = nullptr;
+    for (const char* p = s; (p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(s + n - p)))) != nullptr; ++p) {
+        ++parser->current_line;
+        last_newline = p;
+    }
+    if (last_newline != nullptr) {
+        parser->current_column = static_cast<XML_Size>(s + n - last_newline - 1);
+    } else {
+        parser->current_column += static_cast<XML_Size>(n);
+    }
+    parser->consumed += static_cast<XML_Index>(n);
+}
+
+static inline bool fail(XML_Parser parser, XML_Error error)
+{
+    parser->last_error = error;
+    return false;
+}
+
+static inline bool character_data(XML_Parser parser, const char* s, size_t n)
+{
+    if (parser->stack_starts.empty()) {
+        // Only whitespace may surround the root element.
+        for (size_t i = 0; i < n; ++i) {
+            if (!is_space(s[i])) {
+                return fail(parser, parser->seen_root ? XML_ERROR_JUNK_AFTER_DOC_ELEMENT : XML_ERROR_SYNTAX);
+            }
+        }
+        return true;
+    }
+    if (parser->character_handler == nullptr) {
+        return true;
+    }
+    if (std::memchr(s, '&', n) == nullptr && std::memchr(s, '\r', n) == nullptr) {
+        parser->character_handler(parser->user_data, s, static_cast<int>(n));
+        return true;
+    }
+    parser->text.clear();
+    const XML_Error error = decode(s, n, parser->text, false);
+    if (error != XML_ERROR_NONE) {
+        return fail(parser, error);
+    }
+    if (!parser->text.empty()) {
+        parser->character_handler(parser->user_data, parser->text.data(), static_cast<int>(parser->text.size()));
+    }
+    return true;
+}
+
+// s[0, n) is a whole start tag without its '<' and '>'.
+static inline bool start_element(XML_Parser parser, const char* s, size_t n)
+{
+    if (parser->stack_starts.empty() && parser->seen_root) {
+        return fail(parser, XML_ERROR_JUNK_AFTER_DOC_ELEMENT);
+    }
+    const bool empty = n > 0 && s[n - 1] == '/';
+    if (empty) {
+        --n;
+    }
+    std::string& tag = parser->tag;
+    std::vector<size_t>& offsets = parser->tag_offsets;
+    tag.clear();
+    offsets.clear();
+    size_t i = 0;
+    while (i < n && !is_name_end(s[i])) {
+        ++i;
+    }
+    if (i == 0) {
+        return fail(parser, XML_ERROR_INVALID_TOKEN);
+    }
+    tag.append(s, i);
+    tag += '\0';
+    for (;;) {
+        const size_t before = i;
+        while (i < n && is_space(s[i])) {
+            ++i;
+        }
+        if (i == n) {
+            break;
+        }
+        if (i == before) {
+            return fail(parser, XML_ERROR_SYNTAX);
+        }
+        const size_t name_start = i;
+        while (i < n && !is_name_end(s[i])) {
+            ++i;
+        }
+        const size_t name_end = i;
+        while (i < n && is_space(s[i])) {
+            ++i;
+        }
+        if (name_end == name_start || i == n || s[i] != '=') {
+            return fail(parser, XML_ERROR_SYNTAX);
+        }
+        ++i;
+        while (i < n && is_space(s[i])) {
+            ++i;
+        }
+        if (i == n || (s[i] != '"' && s[i] != '\'')) {
+            return fail(parser, XML_ERROR_SYNTAX);
+        }
+        const char quote = s[i++];
+        const char* close = static_cast<const char*>(std::memchr(s + i, quote, n - i));
+        if (close == nullptr) {
+            return fail(parser, XML_ERROR_SYNTAX);
+        }
+        const size_t value_end = static_cast<size_t>(close - s);
+        for (size_t k = 0; k < offsets.size(); k += 2) {
+            if (std::strlen(tag.data() + offsets[k]) == name_end - name_start &&
+                std::memcmp(tag.data() + offsets[k], s + name_start, name_end - name_start) == 0) {
+                return fail(parser, XML_ERROR_DUPLICATE_ATTRIBUTE);
+            }
+        }
+        if (std::memchr(s + i, '<', value_end - i) != nullptr) {
+            return fail(parser, XML_ERROR_INVALID_TOKEN);
+        }
+        offsets.push_back(tag.size());
+        tag.append(s + name_start, name_end - name_start);
+        tag += '\0';
+        offsets.push_back(tag.size());
+        const XML_Error error = decode(s + i, value_end - i, tag, true);
+        if (error != XML_ERROR_NONE) {
+            return fail(parser, error);
+        }
+        tag += '\0';
+        i = value_end + 1;
+    }
+
+    parser->seen_root = true;
+    parser->stack_starts.push_back(parser->stack.size());
+    parser->stack.append(tag.data(), std::strlen(tag.data()) + 1);
+    parser->specified_attributes = static_cast<unsigned>(offsets.size());
+    if (parser->start_handler != nullptr) {
+        parser->atts.clear();
+        for (size_t offset : offsets) {
+            parser->atts.push_back(tag.data() + offset);
+        }
+        parser->atts.push_back(nullptr);
+        parser->start_handler(parser->user_data, tag.data(), parser->atts.data());
+    }
+    if (empty && !parser->stopped) {
+        if (parser->end_handler != nullptr) {
+            parser->end_handler(parser->user_data, parser->stack.data() + parser->stack_starts.back());
+        }
+        parser->stack.resize(parser->stack_starts.back());
+        parser->stack_starts.pop_back();
+    }
+    return true;
+}
+
+// s[0, n) is an end tag without its "</" and '>'.
+static inline bool end_element(XML_Parser parser, const char* s, size_t n)
+{
+    while (n > 0 && is_space(s[n - 1])) {
+        --n;
+    }
+    if (parser->stack_starts.empty()) {
+        return fail(parser, parser->seen_root ? XML_ERROR_JUNK_AFTER_DOC_ELEMENT : XML_ERROR_SYNTAX);
     }
-    return parser;
+    const char* open = parser->stack.data() + parser->stack_starts.back();
+    if (std::strlen(open) != n || std::memcmp(open, s, n) != 0) {
+        return fail(parser, XML_ERROR_TAG_MISMATCH);
+    }
+    if (parser->end_handler != nullptr) {
+        parser->end_handler(parser->user_data, open);
+    }
+    parser->stack.resize(parser->stack_starts.back());
+    parser->stack_starts.pop_back();
+    return true;
+}
+
+static inline const char* find(const char* s, size_t n, const char* needle, size_t needle_len)
+{
+    while (n >= needle_len) {
+        const char* hit = static_cast<const char*>(std::memchr(s, needle[0], n - needle_len + 1));
+        if (hit == nullptr) {
+            return nullptr;
+        }
+        if (std::memcmp(hit, needle, needle_len) == 0) {
+            return hit;
+        }
+        n -= static_cast<size_t>(hit + 1 - s);
+        s = hit + 1;
+    }
+    return nullptr;
+}
+
+// End of the tag that starts at s[0] == '<', one past its '>', or 0 if the
+// tag is not complete in s[0, n). Quoted '>' do not end a tag.
+static inline size_t tag_end(const char* s, size_t n)
+{
+    const char* p = s + 1;
+    const char* end = s + n;
+    for (;;) {
+        const char* gt = static_cast<const char*>(std::memchr(p, '>', static_cast<size_t>(end - p)));
+        const size_t span = static_cast<size_t>((gt != nullptr ? gt : end) - p);
+        const char* dq = static_cast<const char*>(std::memchr(p, '"', span));
+        const char* sq = static_cast<const char*>(std::memchr(p, '\'', dq != nullptr ? static_cast<size_t>(dq - p) : span));
+        const char* quote = sq != nullptr ? sq : dq;
+        if (quote == nullptr) {
+            return gt != nullptr ? static_cast<size_t>(gt - s) + 1 : 0;
+        }
+        const char* close = static_cast<const char*>(std::memchr(quote + 1, *quote, static_cast<size_t>(end - quote - 1)));
+        if (close == nullptr) {
+            return 0;
+        }
+        p = close + 1;
+    }
+}
+
+// Consumes complete tokens of s[0, n) and returns how many bytes were used;
+// the rest waits for more input unless `final`.
+static inline size_t scan(XML_Parser parser, const char* s, size_t n, bool final)
+{
+    size_t p = 0;
+    while (p < n && !parser->stopped) {
+        if (s[p] != '<') {
+            const char* lt = static_cast<const char*>(std::memchr(s + p, '<', n - p));
+            size_t end = lt != nullptr ? static_cast<size_t>(lt - s) : n;
+            if (lt == nullptr && !final) {
+                // Hold back a reference or CR cut off by the chunk boundary.
+                for (size_t k = end; k > p && end - k < 16; --k) {
+                    if (s[k - 1] == ';') {
+                        break;
+                    }
+                    if (s[k - 1] == '&') {
+                        end = k - 1;
+                        break;
+                    }
+                }
+                if (end > p && s[end - 1] == '\r') {
+                    --end;
+                }
+            }
+            if (end > p && !character_data(parser, s + p, end - p)) {
+                return p;
+            }
+            advance(parser, s + p, end - p);
+            p = end;
+            if (lt == nullptr) {
+                break;
+            }
+            continue;
+        }
+        const char* t = s + p;
+        const size_t avail = n - p;
+        size_t len = 0;
+        if (avail >= 2 && t[1] == '/') {
+            len = tag_end(t, avail);
+            if (len != 0 && !end_element(parser, t + 2, len - 3)) {
+                return p;
+            }
+        } else if (avail >= 2 && t[1] == '?') {
+            const char* close = find(t + 2, avail - 2, "?>", 2);
+            len = close != nullptr ? static_cast<size_t>(close - t) + 2 : 0;
+        } else if (avail >= 2 && t[1] == '!') {
+            if (avail >= 4 && std::memcmp(t, "<!--", 4) == 0) {
+                const char* close = find(t + 4, avail - 4, "-->", 3);
+                len = close != nullptr ? static_cast<size_t>(close - t) + 3 : 0;
+            } else if (avail >= 9 && std::memcmp(t, "<![CDATA[", 9) == 0) {
+                const char* close = find(t + 9, avail - 9, "]]>", 3);
+                len = close != nullptr ? static_cast<size_t>(close - t) + 3 : 0;
+                if (len != 0) {
+                    if (parser->stack_starts.empty()) {
+                        fail(parser, XML_ERROR_SYNTAX);
+                        return p;
+                    }
+                    if (parser->character_handler != nullptr && len > 12) {
+                        parser->character_handler(parser->user_data, t + 9, static_cast<int>(len - 12));
+                    }
+                } else if (final) {
+                    fail(parser, XML_ERROR_UNCLOSED_CDATA_SECTION);
+                    return p;
+                }
+            } else if (avail >= 9 || final) {
+                // DOCTYPE and other declarations; an internal subset ends at "]>".
+                const char* bracket = static_cast<const char*>(std::memchr(t, '[', avail));
+                const char* gt = static_cast<const char*>(std::memchr(t, '>', avail));
+                if (bracket != nullptr && (gt == nullptr || bracket < gt)) {
+                    const char* close = find(bracket, avail - static_cast<size_t>(bracket - t), "]>", 2);
+                    len = close != nullptr ? static_cast<size_t>(close - t) + 2 : 0;
+                } else {
+                    len = gt != nullptr ? static_cast<size_t>(gt - t) + 1 : 0;
+                }
+            }
+        } else {
+            len = tag_end(t, avail);
+            if (len != 0 && !start_element(parser, t + 1, len - 2)) {
+                return p;
+            }
+        }
+        if (len == 0) {
+            if (final) {
+                fail(parser, XML_ERROR_UNCLOSED_TOKEN);
+            }
+            return p;
+        }
+        advance(parser, t, len);
+        p += len;
+    }
+    return p;
+}
+
+static inline XML_Status parse(XML_Parser parser, const char* s, size_t n, bool final)
+{
+    if (parser->finished) {
+        parser->last_error = XML_ERROR_FINISHED;
+        return XML_STATUS_ERROR;
+    }
+    if (parser->last_error != XML_ERROR_NONE) {
+        return XML_STATUS_ERROR;
+    }
+    try {
+        size_t used;
+        if (parser->pending.empty()) {
+            used = scan(parser, s, n, final);
+            if (parser->last_error == XML_ERROR_NONE && !parser->stopped) {
+                parser->pending.assign(s + used, n - used);
+            }
+        } else {
+            parser->pending.append(s, n);
+            used = scan(parser, parser->pending.data(), parser->pending.size(), final);
+            parser->pending.erase(0, used);
+        }
+    } catch (const std::bad_alloc&) {
+        parser->last_error = XML_ERROR_NO_MEMORY;
+    }
+    if (parser->stopped && parser->last_error == XML_ERROR_NONE) {
+        parser->last_error = XML_ERROR_ABORTED;
+    }
+    if (parser->last_error != XML_ERROR_NONE) {
+        return XML_STATUS_ERROR;
+    }
+    if (final) {
+        parser->finished = true;
+        // Upstream's codes: a cut-off token, else a missing (end of the) root.
+        if (!parser->pending.empty()) {
+            parser->last_error = XML_ERROR_UNCLOSED_TOKEN;
+        } else if (!parser->seen_root || !parser->stack_starts.empty()) {
+            parser->last_error = XML_ERROR_NO_ELEMENTS;
+        }
+        if (parser->last_error != XML_ERROR_NONE) {
+            return XML_STATUS_ERROR;
+        }
+    }
+    return XML_STATUS_OK;
+}
+
+} // namespace orc_expat_detail
+
+extern "C" {
+
+static inline XML_Parser XML_ParserCreate(const XML_Char* /*encoding*/)
+{
+    return new (std::nothrow) XML_ParserStruct();
 }
 
 static inline void XML_SetUserData(XML_Parser parser, void* userData)
@@ -72,79 +573,126 @@ static inline void XML_SetElementHandler(XML_Parser parser, XML_StartElementHand
     }
 }
 
+static inline void XML_SetStartElementHandler(XML_Parser parser, XML_StartElementHandler start)
+{
+    if (parser != NULL) parser->start_handler = start;
+}
+
+static inline void XML_SetEndElementHandler(XML_Parser parser, XML_EndElementHandler end)
+{
+    if (parser != NULL) parser->end_handler = end;
+}
+
 static inline void XML_SetCharacterDataHandler(XML_Parser parser, XML_CharacterDataHandler handler)
 {
     if (parser != NULL) parser->character_handler = handler;
 }
 
-static inline void* XML_GetBuffer(XML_Parser /*parser*/, int size)
+/* Owned by the parser and valid until the next XML_GetBuffer call. */
+static inline void* XML_GetBuffer(XML_Parser parser, int size)
 {
-    if (size <= 0) return NULL;
-    return malloc((size_t)size);
+    if (parser == NULL || size < 0) return NULL;
+    try {
+        parser->get_buffer.resize(static_cast<size_t>(size));
+    } catch (const std::bad_alloc&) {
+        parser->last_error = XML_ERROR_NO_MEMORY;
+        return NULL;
+    }
+    return &parser->get_buffer[0];
 }
 
-static inline XML_Status XML_ParseBuffer(XML_Parser parser, int len, int /*isFinal*/)
+static inline XML_Status XML_ParseBuffer(XML_Parser parser, int len, int isFinal)
 {
-    if (parser == NULL || len < 0) return XML_STATUS_ERROR;
-    if (parser->character_handler != NULL && len > 0) {
-        XML_Char* dummy = (XML_Char*)malloc((size_t)len);
-        if (dummy == NULL) return XML_STATUS_ERROR;
-        parser->character_handler(parser->user_data, dummy, len);
-        free(dummy);
-    }
-    return XML_STATUS_OK;
+    if (parser == NULL || len < 0 || static_cast<size_t>(len) > parser->get_buffer.size()) return XML_STATUS_ERROR;
+    return orc_expat_detail::parse(parser, parser->get_buffer.data(), static_cast<size_t>(len), isFinal != 0);
 }
 
-static inline XML_Status XML_Parse(XML_Parser parser, const char* s, int len, int /*isFinal*/)
+static inline XML_Status XML_Parse(XML_Parser parser, const char* s, int len, int isFinal)
 {
-    if (parser == NULL || len < 0) return XML_STATUS_ERROR;
-    if (parser->character_handler != NULL && s != NULL && len > 0) {
-        parser->character_handler(parser->user_data, s, len);
-    }
-    return XML_STATUS_OK;
+    if (parser == NULL || len < 0 || (s == NULL && len > 0)) return XML_STATUS_ERROR;
+    return orc_expat_detail::parse(parser, s, static_cast<size_t>(len), isFinal != 0);
 }
 
-static inline unsigned XML_GetSpecifiedAttributeCount(XML_Parser /*parser*/)
+/* Attribute names and values passed to the last start handler call, i.e.
+ * twice the number of attributes. */
+static inline int XML_GetSpecifiedAttributeCount(XML_Parser parser)
 {
-    return 0;
+    return (parser != NULL) ? static_cast<int>(parser->specified_attributes) : -1;
 }
 
-static inline long XML_GetCurrentLineNumber(XML_Parser parser)
+static inline XML_Size XML_GetCurrentLineNumber(XML_Parser parser)
 {
     return (parser != NULL) ? parser->current_line : 0;
 }
 
-static inline void XML_StopParser(XML_Parser parser, int /*resumable*/)
+static inline XML_Size XML_GetCurrentColumnNumber(XML_Parser parser)
 {
-    if (parser != NULL) parser->stopped = 1;
+    return (parser != NULL) ? parser->current_column : 0;
+}
+
+static inline XML_Index XML_GetCurrentByteIndex(XML_Parser parser)
+{
+    return (parser != NULL) ? parser->consumed : -1;
+}
+
+/* Not resumable: the current XML_Parse call returns XML_STATUS_ERROR with
+ * XML_ERROR_ABORTED once the running handler returns. */
+static inline XML_Status XML_StopParser(XML_Parser parser, int /*resumable*/)
+{
+    if (parser == NULL) return XML_STATUS_ERROR;
+    parser->stopped = true;
+    return XML_STATUS_OK;
 }
 
 static inline void XML_ParserFree(XML_Parser parser)
 {
-    if (parser != NULL) free(parser);
+    delete parser;
 }
 
 static inline XML_Error XML_GetErrorCode(XML_Parser parser)
 {
-    return (parser != NULL) ? parser->last_error : XML_ERROR_GENERIC;
+    return (parser != NULL) ? parser->last_error : XML_ERROR_NO_MEMORY;
 }
 
-static inline const XML_Char* XML_ErrorString(XML_Error /*code*/)
+static inline const XML_Char* XML_ErrorString(XML_Error code)
 {
-    return "expat unavailable";
+    switch (code) {
+    case XML_ERROR_NONE: return NULL;
+    case XML_ERROR_NO_MEMORY: return "out of memory";
+    case XML_ERROR_SYNTAX: return "syntax error";
+    case XML_ERROR_NO_ELEMENTS: return "no element found";
+    case XML_ERROR_INVALID_TOKEN: return "not well-formed (invalid token)";
+    case XML_ERROR_UNCLOSED_TOKEN: return "unclosed token";
+    case XML_ERROR_TAG_MISMATCH: return "mismatched tag";
+    case XML_ERROR_DUPLICATE_ATTRIBUTE: return "duplicate attribute";
+    case XML_ERROR_JUNK_AFTER_DOC_ELEMENT: return "junk after document element";
+    case XML_ERROR_UNDEFINED_ENTITY: return "undefined entity";
+    case XML_ERROR_BAD_CHAR_REF: return "reference to invalid character number";
+    case XML_ERROR_UNCLOSED_CDATA_SECTION: return "unclosed CDATA section";
+    case XML_ERROR_ABORTED: return "parsing aborted";
+    case XML_ERROR_FINISHED: return "parsing finished";
+    }
+    return "unknown error";
 }
 
+/* Keeps the handlers and user data, like upstream. */
 static inline int XML_ParserReset(XML_Parser parser, const XML_Char* /*encoding*/)
 {
     if (parser == NULL) return 0;
+    parser->pending.clear();
+    parser->stack.clear();
+    parser->stack_starts.clear();
     parser->last_error = XML_ERROR_NONE;
-    parser->current_line = 0;
-    parser->stopped = 0;
+    parser->current_line = 1;
+    parser->current_column = 0;
+    parser->consumed = 0;
+    parser->stopped = false;
+    parser->finished = false;
+    parser->seen_root = false;
+    parser->specified_attributes = 0;
     return 1;
 }
 
-#ifdef __cplusplus
-}
-#endif
+} /* extern "C" */
 
 #endif /* ORCA_WASM_SHIMS_EXPAT_H */
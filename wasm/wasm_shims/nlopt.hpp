@@ -38,14 +38,18 @@ public:
 
 class opt {
 public:
+    // Both objective forms upstream accepts. Keeping the C form as its own
+    // overload means callers never cast a func to a vfunc, which only worked
+    // under -sEMULATE_FUNCTION_POINTER_CASTS.
+    using func = nlopt_func;
     using vfunc = double (*)(const std::vector<double>&, std::vector<double>&, void*);
 
     opt()
-        : alg_(GN_DIRECT), dim_(0), objective_(nullptr), objective_data_(nullptr),
+        : alg_(GN_DIRECT), dim_(0), objective_(nullptr), cobjective_(nullptr), objective_data_(nullptr),
           maximize_(false), force_stop_(false), ftol_abs_(0.0), ftol_rel_(0.0), stopval_(0.0), maxeval_(0) {}
 
     opt(algorithm alg, unsigned dim)
-        : alg_(alg), dim_(dim), objective_(nullptr), objective_data_(nullptr),
+        : alg_(alg), dim_(dim), objective_(nullptr), cobjective_(nullptr), objective_data_(nullptr),
           maximize_(false), force_stop_(false), ftol_abs_(0.0), ftol_rel_(0.0), stopval_(0.0), maxeval_(0) {}
 
     algorithm get_algorithm() const { return alg_; }
@@ -60,19 +64,10 @@ public:
     void set_stopval(double val) { stopval_ = val; }
     void set_maxeval(int maxeval) { maxeval_ = maxeval; }
 
-    void set_min_objective(vfunc fn, void *data)
-    {
-        objective_ = fn;
-        objective_data_ = data;
-        maximize_ = false;
-    }
-
-    void set_max_objective(vfunc fn, void *data)
-    {
-        objective_ = fn;
-        objective_data_ = data;
-        maximize_ = true;
-    }
+    void set_min_objective(vfunc fn, void *data) { set_objective(fn, nullptr, data, false); }
+    void set_min_objective(func fn, void *data) { set_objective(nullptr, fn, data, false); }
+    void set_max_objective(vfunc fn, void *data) { set_objective(fn, nullptr, data, true); }
+    void set_max_objective(func fn, void *data) { set_objective(nullptr, fn, data, true); }
 
     void force_stop() { force_stop_ = true; }
 
@@ -83,13 +78,14 @@ public:
             throw forced_stop();
         }
 
-        if (!objective_) {
+        if (!objective_ && !cobjective_) {
             value = 0.0;
             return SUCCESS;
         }
 
         std::vector<double> grad(x.size(), 0.0);
-        double raw = objective_(x, grad, objective_data_);
+        double raw = objective_ ? objective_(x, grad, objective_data_)
+                                : cobjective_(unsigned(x.size()), x.data(), grad.data(), objective_data_);
 
         if (force_stop_) {
             force_stop_ = false;
@@ -106,9 +102,18 @@ public:
     }
 
 private:
+    void set_objective(vfunc vfn, func cfn, void *data, bool maximize)
+    {
+        objective_ = vfn;
+        cobjective_ = cfn;
+        objective_data_ = data;
+        maximize_ = maximize;
+    }
+
     algorithm alg_;
     unsigned dim_;
     vfunc objective_;
+    func cobjective_;
     void *objective_data_;
     bool maximize_;
     bool force_stop_;
@@ -1,58 +1,236 @@
 #pragma once
-// WASM-friendly OpenSSL MD5 replacement
+// WASM replacement for OpenSSL's MD5 (RFC 1321), same API and digests.
+//
+// MD5_Update hashes whole 64-byte blocks straight from the caller's buffer and
+// only copies a partial block at either end, so its cost is the compression
+// function alone. The block loop keeps the state in locals, reads message words
+// with memcpy (a plain load on little-endian WASM) and has every round
+// unrolled with constant shifts and sines.
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
-#include <array>
-
-// Simple MD5 implementation for WASM (or use a lighter hash)
-// For WASM builds, we'll use a simple hash function instead of full MD5
 
+#define MD5_CBLOCK 64
+#define MD5_LBLOCK (MD5_CBLOCK / 4)
 #define MD5_DIGEST_LENGTH 16
 
+typedef uint32_t MD5_LONG;
+
+// Field layout follows OpenSSL's.
 typedef struct MD5state_st {
-    std::array<uint8_t, MD5_DIGEST_LENGTH> digest;
-    uint32_t state[4];
-    uint64_t count;
-    uint8_t buffer[64];
+    MD5_LONG A, B, C, D;
+    MD5_LONG Nl, Nh;
+    MD5_LONG data[MD5_LBLOCK];
+    unsigned int num;
 } MD5_CTX;
 
-// Simple hash functions for WASM compatibility
-inline int MD5_Init(MD5_CTX* ctx) {
+namespace orc_md5_detail {
+
+inline uint32_t rotl(uint32_t x, int s) { return (x << s) | (x >> (32 - s)); }
+
+inline uint32_t load_le32(const unsigned char* p)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+#else
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+#endif
+}
+
+inline void store_le32(unsigned char* p, uint32_t v)
+{
+    p[0] = static_cast<unsigned char>(v);
+    p[1] = static_cast<unsigned char>(v >> 8);
+    p[2] = static_cast<unsigned char>(v >> 16);
+    p[3] = static_cast<unsigned char>(v >> 24);
+}
+
+#define ORC_MD5_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define ORC_MD5_G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define ORC_MD5_H(x, y, z) ((x) ^ (y) ^ (z))
+#define ORC_MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+#define ORC_MD5_STEP(f, a, b, c, d, x, t, s) \
+    (a) += f((b), (c), (d)) + (x) + (t);     \
+    (a) = rotl((a), (s)) + (b)
+
+// Compresses `blocks` consecutive 64-byte blocks into the state.
+inline void md5_blocks(MD5_CTX* ctx, const unsigned char* p, size_t blocks)
+{
+    uint32_t a = ctx->A, b = ctx->B, c = ctx->C, d = ctx->D;
+    for (; blocks > 0; --blocks, p += MD5_CBLOCK) {
+        uint32_t x[16];
+        for (int i = 0; i < 16; ++i) {
+            x[i] = load_le32(p + 4 * i);
+        }
+        const uint32_t aa = a, bb = b, cc = c, dd = d;
+
+        ORC_MD5_STEP(ORC_MD5_F, a, b, c, d, x[0], 0xd76aa478, 7);
+        ORC_MD5_STEP(ORC_MD5_F, d, a, b, c, x[1], 0xe8c7b756, 12);
+        ORC_MD5_STEP(ORC_MD5_F, c, d, a, b, x[2], 0x242070db, 17);
+        ORC_MD5_STEP(ORC_MD5_F, b, c, d, a, x[3], 0xc1bdceee, 22);
+        ORC_MD5_STEP(ORC_MD5_F, a, b, c, d, x[4], 0xf57c0faf, 7);
+        ORC_MD5_STEP(ORC_MD5_F, d, a, b, c, x[5], 0x4787c62a, 12);
+        ORC_MD5_STEP(ORC_MD5_F, c, d, a, b, x[6], 0xa8304613, 17);
+        ORC_MD5_STEP(ORC_MD5_F, b, c, d, a, x[7], 0xfd469501, 22);
+        ORC_MD5_STEP(ORC_MD5_F, a, b, c, d, x[8], 0x698098d8, 7);
+        ORC_MD5_STEP(ORC_MD5_F, d, a, b, c, x[9], 0x8b44f7af, 12);
+        ORC_MD5_STEP(ORC_MD5_F, c, d, a, b, x[10], 0xffff5bb1, 17);
+        ORC_MD5_STEP(ORC_MD5_F, b, c, d, a, x[11], 0x895cd7be, 22);
+        ORC_MD5_STEP(ORC_MD5_F, a, b, c, d, x[12], 0x6b901122, 7);
+        ORC_MD5_STEP(ORC_MD5_F, d, a, b, c, x[13], 0xfd987193, 12);
+        ORC_MD5_STEP(ORC_MD5_F, c, d, a, b, x[14], 0xa679438e, 17);
+        ORC_MD5_STEP(ORC_MD5_F, b, c, d, a, x[15], 0x49b40821, 22);
+
+        ORC_MD5_STEP(ORC_MD5_G, a, b, c, d, x[1], 0xf61e2562, 5);
+        ORC_MD5_STEP(ORC_MD5_G, d, a, b, c, x[6], 0xc040b340, 9);
+        ORC_MD5_STEP(ORC_MD5_G, c, d, a, b, x[11], 0x265e5a51, 14);
+        ORC_MD5_STEP(ORC_MD5_G, b, c, d, a, x[0], 0xe9b6c7aa, 20);
+        ORC_MD5_STEP(ORC_MD5_G, a, b, c, d, x[5], 0xd62f105d, 5);
+        ORC_MD5_STEP(ORC_MD5_G, d, a, b, c, x[10], 0x02441453, 9);
+        ORC_MD5_STEP(ORC_MD5_G, c, d, a, b, x[15], 0xd8a1e681, 14);
+        ORC_MD5_STEP(ORC_MD5_G, b, c, d, a, x[4], 0xe7d3fbc8, 20);
+        ORC_MD5_STEP(ORC_MD5_G, a, b, c, d, x[9], 0x21e1cde6, 5);
+        ORC_MD5_STEP(ORC_MD5_G, d, a, b, c, x[14], 0xc33707d6, 9);
+        ORC_MD5_STEP(ORC_MD5_G, c, d, a, b, x[3], 0xf4d50d87, 14);
+        ORC_MD5_STEP(ORC_MD5_G, b, c, d, a, x[8], 0x455a14ed, 20);
+        ORC_MD5_STEP(ORC_MD5_G, a, b, c, d, x[13], 0xa9e3e905, 5);
+        ORC_MD5_STEP(ORC_MD5_G, d, a, b, c, x[2], 0xfcefa3f8, 9);
+        ORC_MD5_STEP(ORC_MD5_G, c, d, a, b, x[7], 0x676f02d9, 14);
+        ORC_MD5_STEP(ORC_MD5_G, b, c, d, a, x[12], 0x8d2a4c8a, 20);
+
+        ORC_MD5_STEP(ORC_MD5_H, a, b, c, d, x[5], 0xfffa3942, 4);
+        ORC_MD5_STEP(ORC_MD5_H, d, a, b, c, x[8], 0x8771f681, 11);
+        ORC_MD5_STEP(ORC_MD5_H, c, d, a, b, x[11], 0x6d9d6122, 16);
+        ORC_MD5_STEP(ORC_MD5_H, b, c, d, a, x[14], 0xfde5380c, 23);
+        ORC_MD5_STEP(ORC_MD5_H, a, b, c, d, x[1], 0xa4beea44, 4);
+        ORC_MD5_STEP(ORC_MD5_H, d, a, b, c, x[4], 0x4bdecfa9, 11);
+        ORC_MD5_STEP(ORC_MD5_H, c, d, a, b, x[7], 0xf6bb4b60, 16);
+        ORC_MD5_STEP(ORC_MD5_H, b, c, d, a, x[10], 0xbebfbc70, 23);
+        ORC_MD5_STEP(ORC_MD5_H, a, b, c, d, x[13], 0x289b7ec6, 4);
+        ORC_MD5_STEP(ORC_MD5_H, d, a, b, c, x[0], 0xeaa127fa, 11);
+        ORC_MD5_STEP(ORC_MD5_H, c, d, a, b, x[3], 0xd4ef3085, 16);
+        ORC_MD5_STEP(ORC_MD5_H, b, c, d, a, x[6], 0x04881d05, 23);
+        ORC_MD5_STEP(ORC_MD5_H, a, b, c, d, x[9], 0xd9d4d039, 4);
+        ORC_MD5_STEP(ORC_MD5_H, d, a, b, c, x[12], 0xe6db99e5, 11);
+        ORC_MD5_STEP(ORC_MD5_H, c, d, a, b, x[15], 0x1fa27cf8, 16);
+        ORC_MD5_STEP(ORC_MD5_H, b, c, d, a, x[2], 0xc4ac5665, 23);
+
+        ORC_MD5_STEP(ORC_MD5_I, a, b, c, d, x[0], 0xf4292244, 6);
+        ORC_MD5_STEP(ORC_MD5_I, d, a, b, c, x[7], 0x432aff97, 10);
+        ORC_MD5_STEP(ORC_MD5_I, c, d, a, b, x[14], 0xab9423a7, 15);
+        ORC_MD5_STEP(ORC_MD5_I, b, c, d, a, x[5], 0xfc93a039, 21);
+        ORC_MD5_STEP(ORC_MD5_I, a, b, c, d, x[12], 0x655b59c3, 6);
+        ORC_MD5_STEP(ORC_MD5_I, d, a, b, c, x[3], 0x8f0ccc92, 10);
+        ORC_MD5_STEP(ORC_MD5_I, c, d, a, b, x[10], 0xffeff47d, 15);
+        ORC_MD5_STEP(ORC_MD5_I, b, c, d, a, x[1], 0x85845dd1, 21);
+        ORC_MD5_STEP(ORC_MD5_I, a, b, c, d, x[8], 0x6fa87e4f, 6);
+        ORC_MD5_STEP(ORC_MD5_I, d, a, b, c, x[15], 0xfe2ce6e0, 10);
+        ORC_MD5_STEP(ORC_MD5_I, c, d, a, b, x[6], 0xa3014314, 15);
+        ORC_MD5_STEP(ORC_MD5_I, b, c, d, a, x[13], 0x4e0811a1, 21);
+        ORC_MD5_STEP(ORC_MD5_I, a, b, c, d, x[4], 0xf7537e82, 6);
+        ORC_MD5_STEP(ORC_MD5_I, d, a, b, c, x[11], 0xbd3af235, 10);
+        ORC_MD5_STEP(ORC_MD5_I, c, d, a, b, x[2], 0x2ad7d2bb, 15);
+        ORC_MD5_STEP(ORC_MD5_I, b, c, d, a, x[9], 0xeb86d391, 21);
+
+        a += aa;
+        b += bb;
+        c += cc;
+        d += dd;
+    }
+    ctx->A = a;
+    ctx->B = b;
+    ctx->C = c;
+    ctx->D = d;
+}
+
+#undef ORC_MD5_STEP
+#undef ORC_MD5_I
+#undef ORC_MD5_H
+#undef ORC_MD5_G
+#undef ORC_MD5_F
+
+} // namespace orc_md5_detail
+
+inline int MD5_Init(MD5_CTX* ctx)
+{
     if (!ctx) return 0;
-    ctx->digest.fill(0);
-    ctx->state[0] = 0x67452301;
-    ctx->state[1] = 0xEFCDAB89; 
-    ctx->state[2] = 0x98BADCFE;
-    ctx->state[3] = 0x10325476;
-    ctx->count = 0;
+    std::memset(ctx, 0, sizeof(*ctx));
+    ctx->A = 0x67452301;
+    ctx->B = 0xefcdab89;
+    ctx->C = 0x98badcfe;
+    ctx->D = 0x10325476;
     return 1;
 }
 
-inline int MD5_Update(MD5_CTX* ctx, const void* data, size_t len) {
-    if (!ctx || !data) return 0;
-    // Simple hash update (not real MD5, but sufficient for WASM)
-    const uint8_t* bytes = static_cast<const uint8_t*>(data);
-    for (size_t i = 0; i < len; i++) {
-        ctx->state[0] ^= bytes[i];
-        ctx->state[1] = (ctx->state[1] << 1) ^ bytes[i];
-        ctx->state[2] += bytes[i];
-        ctx->state[3] ^= (bytes[i] << (i % 8));
+inline int MD5_Update(MD5_CTX* ctx, const void* data, size_t len)
+{
+    if (!ctx) return 0;
+    if (len == 0) return 1;
+    if (!data) return 0;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+
+    // 64-bit message length in bits, split like OpenSSL's.
+    const uint64_t bits = ((uint64_t(ctx->Nh) << 32) | ctx->Nl) + (uint64_t(len) << 3);
+    ctx->Nl = static_cast<MD5_LONG>(bits);
+    ctx->Nh = static_cast<MD5_LONG>(bits >> 32);
+
+    unsigned char* buffer = reinterpret_cast<unsigned char*>(ctx->data);
+    if (ctx->num != 0) {
+        const size_t take = len < MD5_CBLOCK - ctx->num ? len : MD5_CBLOCK - ctx->num;
+        std::memcpy(buffer + ctx->num, p, take);
+        ctx->num += static_cast<unsigned int>(take);
+        p += take;
+        len -= take;
+        if (ctx->num < MD5_CBLOCK) return 1;
+        orc_md5_detail::md5_blocks(ctx, buffer, 1);
+        ctx->num = 0;
+    }
+    const size_t blocks = len / MD5_CBLOCK;
+    if (blocks > 0) {
+        orc_md5_detail::md5_blocks(ctx, p, blocks);
+        p += blocks * MD5_CBLOCK;
+        len -= blocks * MD5_CBLOCK;
+    }
+    if (len > 0) {
+        std::memcpy(buffer, p, len);
+        ctx->num = static_cast<unsigned int>(len);
     }
     return 1;
 }
 
-inline int MD5_Final(uint8_t* digest, MD5_CTX* ctx) {
+inline int MD5_Final(unsigned char* digest, MD5_CTX* ctx)
+{
     if (!ctx || !digest) return 0;
-    // Simple hash finalization
-    memcpy(digest, ctx->state, MD5_DIGEST_LENGTH);
+    unsigned char* buffer = reinterpret_cast<unsigned char*>(ctx->data);
+    size_t n = ctx->num;
+    buffer[n++] = 0x80;
+    if (n > MD5_CBLOCK - 8) {
+        std::memset(buffer + n, 0, MD5_CBLOCK - n);
+        orc_md5_detail::md5_blocks(ctx, buffer, 1);
+        n = 0;
+    }
+    std::memset(buffer + n, 0, MD5_CBLOCK - 8 - n);
+    orc_md5_detail::store_le32(buffer + 56, ctx->Nl);
+    orc_md5_detail::store_le32(buffer + 60, ctx->Nh);
+    orc_md5_detail::md5_blocks(ctx, buffer, 1);
+
+    orc_md5_detail::store_le32(digest, ctx->A);
+    orc_md5_detail::store_le32(digest + 4, ctx->B);
+    orc_md5_detail::store_le32(digest + 8, ctx->C);
+    orc_md5_detail::store_le32(digest + 12, ctx->D);
+    std::memset(ctx, 0, sizeof(*ctx));
     return 1;
 }
 
-// Convenience function
-inline uint8_t* MD5(const uint8_t* data, size_t len, uint8_t* digest) {
+inline unsigned char* MD5(const unsigned char* data, size_t len, unsigned char* digest)
+{
+    static unsigned char fallback[MD5_DIGEST_LENGTH];
+    if (!digest) digest = fallback;
     MD5_CTX ctx;
     MD5_Init(&ctx);
     MD5_Update(&ctx, data, len);
     MD5_Final(digest, &ctx);
     return digest;
-}
\ No newline at end of file
+}
@@ -41,7 +41,13 @@ typedef struct png_info_def png_info;
 typedef png_info *png_infop;
 typedef png_info **png_infopp;
 
+/* Callback types as upstream declares them, so PNGReadWrite's callbacks are
+ * stored and called without casts (the module does not link with
+ * -sEMULATE_FUNCTION_POINTER_CASTS). */
+typedef const char *png_const_charp;
 typedef void (*png_rw_ptr)(png_structp, png_bytep, png_size_t);
+typedef void (*png_flush_ptr)(png_structp);
+typedef void (*png_error_ptr)(png_structp, png_const_charp);
 
 typedef struct png_info_def {
     png_uint_32 width;
@@ -59,7 +65,11 @@ typedef struct png_struct_def {
     png_rw_ptr read_fn;
     png_voidp io_ptr;
     png_rw_ptr write_fn;
+    png_flush_ptr flush_fn;
     png_voidp write_io_ptr;
+    png_voidp error_ptr;
+    png_error_ptr error_fn;
+    png_error_ptr warn_fn;
     jmp_buf jmpbuf;
     int sig_bytes;
     png_info info_store;
@@ -68,11 +78,14 @@ typedef struct png_struct_def {
 #define png_jmpbuf(png_ptr) ((png_ptr)->jmpbuf)
 
 static inline png_structp png_create_read_struct(const char *ver, png_voidp error_ptr,
-                                                 png_voidp error_fn, png_voidp warn_fn)
+                                                 png_error_ptr error_fn, png_error_ptr warn_fn)
 {
-    (void)ver; (void)error_ptr; (void)error_fn; (void)warn_fn;
+    (void)ver;
     png_structp ptr = (png_structp)calloc(1, sizeof(png_struct));
     if (ptr) {
+        ptr->error_ptr = error_ptr;
+        ptr->error_fn = error_fn;
+        ptr->warn_fn = warn_fn;
         ptr->info_store.bit_depth = 8;
         ptr->info_store.color_type = PNG_COLOR_TYPE_GRAY;
         ptr->info_store.interlace_type = PNG_INTERLACE_NONE;
@@ -83,7 +96,7 @@ static inline png_structp png_create_read_struct(const char *ver, png_voidp erro
 }
 
 static inline png_structp png_create_write_struct(const char *ver, png_voidp error_ptr,
-                                                  png_voidp error_fn, png_voidp warn_fn)
+                                                  png_error_ptr error_fn, png_error_ptr warn_fn)
 {
     return png_create_read_struct(ver, error_ptr, error_fn, warn_fn);
 }
@@ -137,6 +150,16 @@ static inline void png_set_read_fn(png_structp png_ptr, png_voidp io_ptr, png_rw
     png_ptr->read_fn = read_fn;
 }
 
+static inline void png_set_write_fn(png_structp png_ptr, png_voidp io_ptr, png_rw_ptr write_fn,
+                                    png_flush_ptr flush_fn)
+{
+    if (!png_ptr)
+        return;
+    png_ptr->write_io_ptr = io_ptr;
+    png_ptr->write_fn = write_fn;
+    png_ptr->flush_fn = flush_fn;
+}
+
 static inline void png_set_sig_bytes(png_structp png_ptr, int num_bytes)
 {
     if (png_ptr)
@@ -169,7 +192,7 @@ static inline png_uint_32 png_get_image_height(png_structp png_ptr, png_infop in
     return info_ptr ? info_ptr->height : 0;
 }
 
-static inline png_uint_32 png_get_rowbytes(png_structp png_ptr, png_infop info_ptr)
+static inline png_size_t png_get_rowbytes(png_structp png_ptr, png_infop info_ptr)
 {
     (void)png_ptr;
     return info_ptr ? info_ptr->rowbytes : 0;
@@ -258,6 +281,11 @@ static inline png_voidp png_get_io_ptr(png_structp png_ptr)
     return png_ptr ? png_ptr->io_ptr : NULL;
 }
 
+static inline png_voidp png_get_error_ptr(png_structp png_ptr)
+{
+    return png_ptr ? png_ptr->error_ptr : NULL;
+}
+
 static inline int png_sig_cmp(png_const_bytep sig, png_size_t start, png_size_t num_to_check)
 {
     (void)sig; (void)start;
@@ -283,7 +311,8 @@ static inline int png_set_IHDR(png_structp png_ptr, png_infop info_ptr, png_uint
     png_ptr->info_store.interlace_type = interlace_type;
     png_ptr->info_store.compression_type = compression_type;
     png_ptr->info_store.filter_type = filter_type;
-    png_ptr->info_store.rowbytes = (png_size_t)(width * ((color_type == PNG_COLOR_TYPE_RGB) ? 3 : (color_type == PNG_COLOR_TYPE_RGB_ALPHA ? 4 : 1)));
+    /* Widen before multiplying so large RGBA rows do not wrap in 32 bits. */
+    png_ptr->info_store.rowbytes = (png_size_t)width * ((color_type == PNG_COLOR_TYPE_RGB) ? 3 : (color_type == PNG_COLOR_TYPE_RGB_ALPHA ? 4 : 1));
     if (png_ptr->info_store.rowbytes == 0)
         png_ptr->info_store.rowbytes = width;
 
@@ -5,6 +5,10 @@ namespace oneapi { namespace tbb {
 class task_arena {
 public:
     static int max_concurrency() { return 1; }
+
+    // Tasks run on the calling thread.
+    template <typename F>
+    decltype(auto) execute(F&& f) { return f(); }
 };
 
 namespace this_task_arena {
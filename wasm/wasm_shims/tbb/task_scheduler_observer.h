@@ -0,0 +1,24 @@
+#pragma once
+
+#include "task_arena.h"
+
+namespace oneapi { namespace tbb {
+
+// No worker threads ever join an arena, so there is nothing to observe.
+class task_scheduler_observer {
+public:
+    explicit task_scheduler_observer(task_arena& /*arena*/) {}
+    virtual ~task_scheduler_observer() = default;
+
+    void observe(bool /*state*/ = true) {}
+
+    virtual void on_scheduler_entry(bool /*worker*/) {}
+    virtual void on_scheduler_exit(bool /*worker*/) {}
+};
+
+}} // namespace oneapi::tbb
+
+#ifndef ORCA_WASM_TBB_ALIAS_DEFINED
+#define ORCA_WASM_TBB_ALIAS_DEFINED
+namespace tbb = oneapi::tbb;
+#endif
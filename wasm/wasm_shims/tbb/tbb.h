@@ -9,6 +9,7 @@
 #include "spin_mutex.h"
 #include "task_group.h"
 #include "task_arena.h"
+#include "task_scheduler_observer.h"
 #include "task_scheduler_init.h"
 #include "global_control.h"
 #include "mutex.h"
@@ -21,11 +21,13 @@ class SlicerAPI {
           break;
         case 'WASM_LOADED':
           this.isWasmLoaded = true;
-          console.log('✅ WASM module loaded and ready to slice');
+          console.log(`✅ WASM module loaded and ready to slice (${payload?.variant ?? 'baseline'})`);
           break;
         case 'SLICE_COMPLETE':
           console.log('✅ Slice complete:', payload.gcode?.length || 0, 'bytes');
           break;
+        case 'TRACE_EXPORTED':
+          break;
         case 'ERROR':
           console.error('❌ Worker error:', payload);
           break;
@@ -37,12 +39,25 @@ class SlicerAPI {
 
   private loadWasm() {
     // Construct an absolute URL to the WASM glue code.
-    // Vite serves the `public` directory at the root.
-    const wasmUrl = new URL('/wasm/slicer.js', window.location.origin).href;
-    this.worker.postMessage({ type: 'LOAD_WASM', payload: { url: wasmUrl } });
+    // Vite serves the `public` directory at the root. Deployments built with
+    // VITE_SLICER_MEMORY64=1 load the wasm64 variant, which lifts the 4 GiB heap
+    // limit at some speed cost (see bench/README.md).
+    const memory64 = import.meta.env.VITE_SLICER_MEMORY64 === '1';
+    const wasmUrl = new URL(memory64 ? '/wasm/slicer64.js' : '/wasm/slicer.js', window.location.origin).href;
+    // The worker picks the fastest wasm32 variant the browser can run from this
+    // manifest and falls back to slicer.js without it.
+    const variantsUrl = new URL('/wasm/slicer-variants.json', window.location.origin).href;
+    // Repeat slices of the same model and settings come from the bridge's result
+    // cache, kept in IndexedDB across reloads. VITE_SLICER_CACHE_MB=0 turns it off.
+    // The cache also keeps sliced layers, so changing only G-code settings (or
+    // reopening a project) skips slicing; VITE_SLICER_LAYER_CACHE=0 turns that off.
+    const cacheMb = Number(import.meta.env.VITE_SLICER_CACHE_MB ?? 256);
+    const layers = import.meta.env.VITE_SLICER_LAYER_CACHE !== '0';
+    const cache = { maxMb: Number.isFinite(cacheMb) ? cacheMb : 256, maxEntries: 64, persist: true, layers };
+    this.worker.postMessage({ type: 'LOAD_WASM', payload: { url: wasmUrl, memory64, variantsUrl, cache } });
   }
 
-  public async slice(model: ArrayBuffer, config: Record<string, any>): Promise<{ gcode: string }> {
+  public async slice(model: ArrayBuffer, config: Record<string, any>): Promise<{ gcode: string; profile?: any; stats?: any }> {
     if (!this.isWasmLoaded) {
       return Promise.reject(new Error('Slicer is not yet initialized.'));
     }
@@ -69,6 +84,30 @@ class SlicerAPI {
     });
   }
 
+  // Fetch the bridge trace ring as Chrome trace_event JSON (load it in
+  // chrome://tracing or ui.perfetto.dev). Pass clear=true to reset the ring.
+  public async exportTrace(clear: boolean = false): Promise<string> {
+    if (!this.isWasmLoaded) {
+      return Promise.reject(new Error('Slicer is not yet initialized.'));
+    }
+
+    return new Promise((resolve, reject) => {
+      const messageHandler = (event: MessageEvent) => {
+        const { type, payload } = event.data;
+        if (type === 'TRACE_EXPORTED') {
+          this.worker.removeEventListener('message', messageHandler);
+          resolve(payload.trace);
+        } else if (type === 'ERROR' && event.data.payload.includes('Trace export failed')) {
+          this.worker.removeEventListener('message', messageHandler);
+          reject(new Error(payload));
+        }
+      };
+
+      this.worker.addEventListener('message', messageHandler);
+      this.worker.postMessage({ type: 'EXPORT_TRACE', payload: { clear } });
+    });
+  }
+
   public isReady(): boolean {
     return this.isWasmLoaded;
   }
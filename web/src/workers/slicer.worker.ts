@@ -3,12 +3,191 @@
 // This will hold the initialized WASM module instance.
 let OrcaModule: any = null;
 
-async function loadAndInitializeWasm(payload: { url: string }) {
+// True for the wasm64 build (slicer64.js). Its exports take pointers and size_t
+// as BigInt and store them in 8 bytes; the wasm32 build uses plain numbers.
+let memory64 = false;
+
+const wordBytes = () => (memory64 ? 8 : 4);
+
+function toWasm(value: number): number | bigint {
+  return memory64 ? BigInt(value) : value;
+}
+
+// Read a pointer or size_t out-parameter. Heap offsets stay below 2^53, so
+// Number() is exact.
+function readWord(addr: number): number {
+  return memory64 ? Number(OrcaModule.HEAPU64[addr / 8]) : OrcaModule.HEAPU32[addr >> 2];
+}
+
+function writeWord(addr: number, value: number) {
+  if (memory64) {
+    OrcaModule.HEAPU64[addr / 8] = BigInt(value);
+  } else {
+    OrcaModule.HEAPU32[addr >> 2] = value;
+  }
+}
+
+// malloc/free through the pointer-width helpers. BigInt in, Number() out works
+// whether or not Emscripten wraps these two exports for wasm64.
+function wasmMalloc(size: number): number {
+  return Number(OrcaModule._malloc(toWasm(size)));
+}
+
+function wasmFree(ptr: number) {
+  OrcaModule._free(toWasm(ptr));
+}
+
+// Capabilities a build variant may need (see slicer-variants.json, written by
+// wasm/build.sh). Each probe validates a minimal module using the feature.
+type Capability = 'simd' | 'eh' | 'mt';
+
+const SIMD_PROBE = new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11,
+]);
+const EH_PROBE = new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 4, 1, 96, 0, 0, 3, 2, 1, 0, 10, 8, 1, 6, 0, 6, 64, 25, 11, 11,
+]);
+
+function detectCapabilities(): Set<Capability> {
+  const found = new Set<Capability>();
+  if (WebAssembly.validate(SIMD_PROBE)) {
+    found.add('simd');
+  }
+  if (WebAssembly.validate(EH_PROBE)) {
+    found.add('eh');
+  }
+  // Shared memory is only handed out to cross-origin isolated pages.
+  if (typeof SharedArrayBuffer !== 'undefined' && (self as any).crossOriginIsolated === true) {
+    try {
+      new WebAssembly.Memory({ initial: 1, maximum: 1, shared: true } as WebAssembly.MemoryDescriptor);
+      found.add('mt');
+    } catch {
+      // No threads.
+    }
+  }
+  return found;
+}
+
+interface SlicerVariant {
+  name: string;
+  script: string;
+  features: Capability[];
+}
+
+// First listed variant whose capabilities are all present; the manifest is
+// ordered fastest first. Falls back to the given URL (the baseline build).
+async function chooseVariant(fallbackUrl: string, variantsUrl?: string): Promise<{ url: string; variant: SlicerVariant | null }> {
+  if (!variantsUrl) {
+    return { url: fallbackUrl, variant: null };
+  }
+  try {
+    const response = await fetch(variantsUrl);
+    if (!response.ok) {
+      return { url: fallbackUrl, variant: null };
+    }
+    const manifest = (await response.json()) as { variants?: SlicerVariant[] };
+    const capabilities = detectCapabilities();
+    const variant = (manifest.variants ?? []).find((candidate) => candidate.features.every((feature) => capabilities.has(feature)));
+    if (!variant) {
+      return { url: fallbackUrl, variant: null };
+    }
+    return { url: new URL(variant.script, variantsUrl).href, variant };
+  } catch (error) {
+    console.warn('⚠️ Variant manifest unavailable, loading the baseline build:', error);
+    return { url: fallbackUrl, variant: null };
+  }
+}
+
+// Message of an exception that escaped an export. JS exception builds throw the
+// thrown object's address (a number, or BigInt on wasm64); native exception
+// builds throw a WebAssembly.Exception. getExceptionMessage
+// (-sEXPORT_EXCEPTION_HANDLING_HELPERS) understands both; orc_decode_exception
+// covers address throws from builds without it.
+function describeWasmException(error: unknown): string {
+  const thrownByWasm = typeof error === 'number' || typeof error === 'bigint'
+    || (typeof (WebAssembly as any).Exception === 'function' && error instanceof (WebAssembly as any).Exception);
+  if (OrcaModule && thrownByWasm) {
+    if (typeof OrcaModule.getExceptionMessage === 'function') {
+      try {
+        const [type, message] = OrcaModule.getExceptionMessage(error);
+        return message ? `${type}: ${message}` : type;
+      } catch {
+        // Fall through to the bridge decoder.
+      }
+    }
+    if (typeof error === 'number' || typeof error === 'bigint') {
+      return OrcaModule.UTF8ToString(Number(OrcaModule._orc_decode_exception(toWasm(Number(error)))));
+    }
+  }
+  return error instanceof Error ? error.message : String(error);
+}
+
+interface ResultCacheOptions {
+  maxMb: number;
+  maxEntries?: number;
+  // Keep entries in IndexedDB so they survive reloads.
+  persist?: boolean;
+  // Also keep the sliced layers, so a slice with the same model and object
+  // settings only redoes the G-code export (bridge option layerCache).
+  layers?: boolean;
+}
+
+const CACHE_DIR = '/orc-cache';
+let cachePersisted = false;
+let layerCacheEnabled = false;
+
+// Size the bridge's slice result cache (orc_cache_configure). Persisted entries
+// live in an IDBFS mount: loaded once here, flushed after each stored slice.
+async function configureResultCache(options?: ResultCacheOptions) {
+  if (!options || !(options.maxMb > 0)) {
+    return;
+  }
+  let dir = '';
+  const FS = OrcaModule.FS;
+  if (options.persist && FS?.filesystems?.IDBFS) {
+    try {
+      FS.mkdir(CACHE_DIR);
+      FS.mount(FS.filesystems.IDBFS, {}, CACHE_DIR);
+      await new Promise<void>((resolve, reject) => FS.syncfs(true, (err: unknown) => (err ? reject(err) : resolve())));
+      dir = CACHE_DIR;
+      cachePersisted = true;
+    } catch (error) {
+      console.warn('⚠️ Persistent slice cache unavailable, keeping it in memory:', error);
+    }
+  }
+  // size_t is 32-bit on wasm32.
+  const maxBytes = Math.min(options.maxMb * 1048576, memory64 ? Number.MAX_SAFE_INTEGER : 0xffffffff);
+  const dirBytes = new TextEncoder().encode(`${dir}\0`);
+  const dirPtr = wasmMalloc(dirBytes.length);
+  OrcaModule.HEAPU8.set(dirBytes, dirPtr);
+  const rc = OrcaModule._orc_cache_configure(toWasm(Math.floor(maxBytes)), options.maxEntries ?? 0, toWasm(dirPtr));
+  wasmFree(dirPtr);
+  if (rc !== 0) {
+    console.warn(`⚠️ orc_cache_configure failed with code: ${rc}`);
+    return;
+  }
+  layerCacheEnabled = options.layers === true;
+}
+
+// Push newly stored (and evicted) cache entries to IndexedDB.
+function flushResultCache() {
+  if (!cachePersisted) {
+    return;
+  }
+  OrcaModule.FS.syncfs(false, (err: unknown) => {
+    if (err) {
+      console.warn('⚠️ Slice cache flush failed:', err);
+    }
+  });
+}
+
+async function loadAndInitializeWasm(payload: { url: string; memory64?: boolean; variantsUrl?: string; cache?: ResultCacheOptions }) {
   try {
     console.log('📦 Loading WASM module...');
-    
+    const { url, variant } = await chooseVariant(payload.url, payload.memory64 ? undefined : payload.variantsUrl);
+
     // 1. Fetch the non-module script text
-    const response = await fetch(payload.url);
+    const response = await fetch(url);
     if (!response.ok) {
       throw new Error(`Failed to fetch WASM loader: ${response.statusText}`);
     }
@@ -26,11 +205,11 @@ async function loadAndInitializeWasm(payload: { url: string }) {
     // 4. Await the full initialization of the module.
     OrcaModule = await OrcaModuleFactory({
       locateFile: (path: string) => `/wasm/${path}`,
+      // pthread workers load the glue by URL; the blob above is already revoked.
+      mainScriptUrlOrBlob: url,
       // Suppress verbose WASM memory allocation warnings
       printErr: (text: string) => {
-        // Filter out noise: [orc_alloc] warnings and status spam
-        if (text.includes('[orc_alloc]')) return;
-        if (text.includes('warning: operator delete')) return;
+        // Filter out status spam; [orc_alloc] lines only appear on allocation failure
         // Show important progress milestones only (every 10%)
         if (text.includes('status') && text.includes('%')) {
           const match = text.match(/status\s+(\d+)%/);
@@ -57,15 +236,15 @@ async function loadAndInitializeWasm(payload: { url: string }) {
         console.error(text);
       },
       print: (text: string) => {
-        // Only log important messages, not debug spam
-        if (!text.includes('[orc_alloc]') && !text.includes('warning: operator delete')) {
-          console.log(text);
-        }
+        console.log(text);
       }
     });
     
-    console.log('✅ WASM module ready');
-    self.postMessage({ type: 'WASM_LOADED' });
+    memory64 = payload.memory64 === true;
+    await configureResultCache(payload.cache);
+    const variantName = variant?.name ?? 'baseline';
+    console.log(`✅ WASM module ready (${memory64 ? 'wasm64' : 'wasm32'}, ${variantName})`);
+    self.postMessage({ type: 'WASM_LOADED', payload: { variant: variantName } });
 
   } catch (e) {
     console.error('❌ Critical error during WASM loading:', e);
@@ -73,6 +252,26 @@ async function loadAndInitializeWasm(payload: { url: string }) {
   }
 }
 
+// Call an orc_* export of shape (uint8_t** out, size_t* len) and decode the
+// malloc'd UTF-8 buffer it hands back.
+function readBridgeBuffer(fnName: string): string {
+  const outPtr = wasmMalloc(wordBytes());
+  const lenPtr = wasmMalloc(wordBytes());
+  writeWord(outPtr, 0);
+  writeWord(lenPtr, 0);
+  const rc = OrcaModule[`_${fnName}`](toWasm(outPtr), toWasm(lenPtr));
+  const dataPtr = readWord(outPtr);
+  const dataLen = readWord(lenPtr);
+  wasmFree(outPtr);
+  wasmFree(lenPtr);
+  if (rc !== 0 || !dataPtr) {
+    throw new Error(`${fnName} failed with code: ${rc}`);
+  }
+  const text = new TextDecoder().decode(OrcaModule.HEAPU8.subarray(dataPtr, dataPtr + dataLen));
+  wasmFree(dataPtr);
+  return text;
+}
+
 self.onmessage = async (event) => {
   const { type, payload } = event.data;
 
@@ -98,18 +297,15 @@ self.onmessage = async (event) => {
         
         // Prepare config JSON and send to WASM via orc_init
         // (This sets g_last_slice_payload which orc_slice will read)
-        const configJson = JSON.stringify(config);
+        const configJson = JSON.stringify(
+          layerCacheEnabled ? { ...config, bridge: { layerCache: true, ...config.bridge } } : config,
+        );
         const configBytes = new TextEncoder().encode(configJson);
-        const configPtr = OrcaModule._malloc(configBytes.length);
+        const configPtr = wasmMalloc(configBytes.length);
         OrcaModule.HEAPU8.set(configBytes, configPtr);
         
-        const initResult = OrcaModule.ccall(
-          'orc_init',
-          'number',
-          ['number', 'number'],
-          [configPtr, configBytes.length]
-        );
-        OrcaModule._free(configPtr);
+        const initResult = OrcaModule._orc_init(toWasm(configPtr), toWasm(configBytes.length));
+        wasmFree(configPtr);
         
         if (initResult !== 0) {
           throw new Error(`Config initialization failed with code: ${initResult}`);
@@ -117,33 +313,31 @@ self.onmessage = async (event) => {
 
         // Allocate memory in WASM heap for the model buffer
         const modelArray = new Uint8Array(modelBuffer);
-        const modelPtr = OrcaModule._malloc(modelArray.length);
+        const modelPtr = wasmMalloc(modelArray.length);
         OrcaModule.HEAPU8.set(modelArray, modelPtr);
 
         // Allocate pointers for output parameters (orc_slice uses output params!)
-        const gcodeOutPtr = OrcaModule._malloc(4); // pointer to pointer (uint8_t**)
-        const gcodeLenPtr = OrcaModule._malloc(4); // pointer to int
+        const gcodeOutPtr = wasmMalloc(wordBytes()); // pointer to pointer (uint8_t**)
+        const gcodeLenPtr = wasmMalloc(wordBytes()); // pointer to size_t
         
         // Initialize to null/0
-        OrcaModule.HEAP32[gcodeOutPtr >> 2] = 0;
-        OrcaModule.HEAP32[gcodeLenPtr >> 2] = 0;
-
-        // Call orc_slice
-        const returnCode = OrcaModule.ccall(
-          'orc_slice',
-          'number', // Returns int status code (0 = success, negative = error)
-          ['number', 'number', 'number', 'number'], // model ptr, len, gcode_out**, gcode_len*
-          [modelPtr, modelArray.length, gcodeOutPtr, gcodeLenPtr]
+        writeWord(gcodeOutPtr, 0);
+        writeWord(gcodeLenPtr, 0);
+
+        // Call orc_slice: model ptr, len, gcode_out**, gcode_len*. Returns 0 on
+        // success, a negative error code otherwise.
+        const returnCode = OrcaModule._orc_slice(
+          toWasm(modelPtr), toWasm(modelArray.length), toWasm(gcodeOutPtr), toWasm(gcodeLenPtr)
         );
 
         // Read output parameters
-        const gcodePtr = OrcaModule.HEAP32[gcodeOutPtr >> 2];
-        const gcodeLen = OrcaModule.HEAP32[gcodeLenPtr >> 2];
+        const gcodePtr = readWord(gcodeOutPtr);
+        const gcodeLen = readWord(gcodeLenPtr);
 
         // Free parameter pointers
-        OrcaModule._free(gcodeOutPtr);
-        OrcaModule._free(gcodeLenPtr);
-        OrcaModule._free(modelPtr);
+        wasmFree(gcodeOutPtr);
+        wasmFree(gcodeLenPtr);
+        wasmFree(modelPtr);
 
         if (returnCode !== 0) {
           throw new Error(`Slicing failed with error code: ${returnCode}`);
@@ -159,14 +353,48 @@ self.onmessage = async (event) => {
         );
 
         // Free the G-code buffer (allocated by C code with malloc)
-        OrcaModule._free(gcodePtr);
+        wasmFree(gcodePtr);
 
         console.log('✅ Slice complete! G-code:', gcodeLen, 'bytes');
 
-        self.postMessage({ type: 'SLICE_COMPLETE', payload: { gcode } });
+        let profile: any = null;
+        try {
+          profile = JSON.parse(readBridgeBuffer('orc_get_profile'));
+        } catch (profileError) {
+          console.warn('⚠️ Slice profile unavailable:', profileError);
+        }
+        if (profile?.cache?.hit === false) {
+          flushResultCache();
+        }
+
+        // Estimates straight from the slicer, so nothing has to scan the G-code for them.
+        let stats: any = null;
+        try {
+          stats = JSON.parse(readBridgeBuffer('orc_get_slice_stats'));
+        } catch (statsError) {
+          console.warn('⚠️ Slice statistics unavailable:', statsError);
+        }
+
+        self.postMessage({ type: 'SLICE_COMPLETE', payload: { gcode, profile, stats } });
       } catch (error) {
         console.error('❌ Slicing failed:', error);
-        self.postMessage({ type: 'ERROR', payload: `Slicing failed: ${(error as Error).message}` });
+        self.postMessage({ type: 'ERROR', payload: `Slicing failed: ${describeWasmException(error)}` });
+      }
+      break;
+
+    case 'EXPORT_TRACE':
+      if (!OrcaModule) {
+        self.postMessage({ type: 'ERROR', payload: 'WASM module not ready.' });
+        return;
+      }
+      try {
+        const trace = readBridgeBuffer('orc_trace_export');
+        if (payload?.clear) {
+          OrcaModule.ccall('orc_trace_clear', null, [], []);
+        }
+        self.postMessage({ type: 'TRACE_EXPORTED', payload: { trace } });
+      } catch (error) {
+        self.postMessage({ type: 'ERROR', payload: `Trace export failed: ${(error as Error).message}` });
       }
       break;
   }